@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+/*
+ * Benchmark of the per prefix hash_id cost
+ *
+ *      Builds unicast prefix hash keys the same way as msgBus_kafka::update_unicastPrefix()
+ *      (prefix, prefix length, peer hash string) and measures the cost per prefix of:
+ *
+ *          md5         - one MD5 context per prefix (original)
+ *          md5-multi   - HashId::digestBatch() with hash_algorithm md5
+ *          xxh3-128    - HashId::digestBatch() with hash_algorithm xxh3-128
+ *
+ *      Usage: hash_bench [number of prefixes]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include "hash_id.h"
+#include "md5_multi.h"
+
+#define BENCH_KEY_SIZE          96
+#define BENCH_BATCH_SIZE        1024        // Prefixes per update message batch
+
+static const char *peer_hash_str = "8b3e2f7a0c9d4e6f1a2b3c4d5e6f7a8b";
+
+/**
+ * Print the result of a run
+ */
+static void printResult(const char *name, size_t count, std::chrono::steady_clock::time_point start) {
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("  %-12s %8.1f ns/prefix  %8.2f M prefixes/sec\n", name, ns / count, count / ns * 1000.0);
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 4000000;
+
+    if (count < BENCH_BATCH_SIZE)
+        count = BENCH_BATCH_SIZE;
+
+    count -= count % BENCH_BATCH_SIZE;
+
+    std::vector<unsigned char> keys(count * BENCH_KEY_SIZE);
+    std::vector<const unsigned char *> key_ptrs(count);
+    std::vector<size_t> key_lens(count);
+    std::vector<unsigned char> digests(count * 16);
+    std::vector<unsigned char *> digest_ptrs(count);
+
+    for (size_t i = 0; i < count; i++) {
+        unsigned char *key = &keys[i * BENCH_KEY_SIZE];
+        size_t len;
+
+        if (i % 4 == 0)
+            len = snprintf((char *)key, BENCH_KEY_SIZE, "2001:db8:%x:%x::", (unsigned)(i >> 16) & 0xffff, (unsigned)i & 0xffff);
+        else
+            len = snprintf((char *)key, BENCH_KEY_SIZE, "%u.%u.%u.0", (unsigned)(i >> 16) & 0xff,
+                           (unsigned)(i >> 8) & 0xff, (unsigned)i & 0xff);
+
+        key[len++] = i % 4 == 0 ? 48 : 24;
+        memcpy(key + len, peer_hash_str, 32);
+        len += 32;
+
+        key_ptrs[i] = key;
+        key_lens[i] = len;
+        digest_ptrs[i] = &digests[i * 16];
+    }
+
+    printf("Hashing %lu prefixes, MD5 multi-buffer implementation is %s\n", count, MD5Multi::implementation());
+
+    // Original - one MD5 context per prefix
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        MD5 hash;
+        hash.update(const_cast<unsigned char *>(key_ptrs[i]), key_lens[i]);
+        hash.finalize();
+        hash.raw_digest(digest_ptrs[i]);
+    }
+    printResult("md5", count, start);
+
+    HashId::setAlgorithm(HashId::HASH_ALG_MD5);
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i += BENCH_BATCH_SIZE)
+        HashId::digestBatch(&key_ptrs[i], &key_lens[i], BENCH_BATCH_SIZE, &digest_ptrs[i]);
+    printResult("md5-multi", count, start);
+
+    HashId::setAlgorithm(HashId::HASH_ALG_XXH3_128);
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i += BENCH_BATCH_SIZE)
+        HashId::digestBatch(&key_ptrs[i], &key_lens[i], BENCH_BATCH_SIZE, &digest_ptrs[i]);
+    printResult("xxh3-128", count, start);
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "BufferPool.h"
+
+BufferPool::BufferPool() {
+    for (int i=0; i < BUFFER_POOL_CLASSES; i++) {
+        size_t class_size = (size_t)1 << (BUFFER_POOL_MIN_SHIFT + i);
+
+        classes[i].free_list = NULL;
+        classes[i].free_count = 0;
+        classes[i].max_free = BUFFER_POOL_MAX_FREE_BYTES / class_size;
+    }
+}
+
+BufferPool::~BufferPool() {
+    for (int i=0; i < BUFFER_POOL_CLASSES; i++) {
+        while (classes[i].free_list != NULL) {
+            pool_buffer *buf = classes[i].free_list;
+            classes[i].free_list = buf->next;
+            free(buf);
+        }
+    }
+}
+
+/**
+ * Allocate a new buffer
+ *
+ * \param [in] size         Size of the data in bytes
+ * \param [in] size_class   Size class, -1 if none
+ */
+pool_buffer *BufferPool::allocate(size_t size, int size_class) {
+    pool_buffer *buf = (pool_buffer *)malloc(sizeof(pool_buffer) + size);
+
+    if (buf == NULL)
+        throw std::bad_alloc();
+
+    buf->next = NULL;
+    buf->size_class = size_class;
+    buf->size = size;
+    buf->data = (char *)(buf + 1);
+
+    return buf;
+}
+
+/**
+ * Get a buffer of at least size bytes
+ *
+ * \param [in] size         Minimum size of the buffer in bytes
+ *
+ * \return Buffer - release() must be called when no longer used
+ */
+pool_buffer *BufferPool::acquire(size_t size) {
+    int idx = 0;
+
+    while (idx < BUFFER_POOL_CLASSES and ((size_t)1 << (BUFFER_POOL_MIN_SHIFT + idx)) < size)
+        idx++;
+
+    if (idx >= BUFFER_POOL_CLASSES)
+        return allocate(size, -1);
+
+    size_class &sc = classes[idx];
+    {
+        std::lock_guard<std::mutex> lock(sc.mutex);
+
+        if (sc.free_list != NULL) {
+            pool_buffer *buf = sc.free_list;
+            sc.free_list = buf->next;
+            sc.free_count--;
+            return buf;
+        }
+    }
+
+    return allocate((size_t)1 << (BUFFER_POOL_MIN_SHIFT + idx), idx);
+}
+
+/**
+ * Return a buffer to the pool
+ *
+ * \param [in] buf          Buffer from acquire(), NULL is ignored
+ */
+void BufferPool::release(pool_buffer *buf) {
+    if (buf == NULL)
+        return;
+
+    if (buf->size_class >= 0) {
+        size_class &sc = classes[buf->size_class];
+        std::lock_guard<std::mutex> lock(sc.mutex);
+
+        if (sc.free_count < sc.max_free) {
+            buf->next = sc.free_list;
+            sc.free_list = buf;
+            sc.free_count++;
+            return;
+        }
+    }
+
+    free(buf);
+}
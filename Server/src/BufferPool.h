@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef BUFFERPOOL_H_
+#define BUFFERPOOL_H_
+
+#include <cstddef>
+#include <mutex>
+
+#define BUFFER_POOL_MIN_SHIFT       12                  ///< Smallest size class is 4KB
+#define BUFFER_POOL_CLASSES         10                  ///< Size classes 4KB to 2MB, doubling
+#define BUFFER_POOL_MAX_FREE_BYTES  (32 * 1024 * 1024)  ///< Max bytes of free buffers kept per size class
+
+/**
+ * Pooled buffer - the data follows the structure in the same allocation
+ */
+struct pool_buffer {
+    pool_buffer     *next;                      ///< Free list link
+    int             size_class;                 ///< Size class, -1 if larger than the largest class
+    size_t          size;                       ///< Size of data in bytes
+    char            *data;                      ///< Buffer data
+};
+
+/**
+ * \class   BufferPool
+ *
+ * \brief   Pool of message buffers in power of two size classes
+ * \details Buffers are allocated once and reused.  A buffer acquired by one thread may be
+ *          released by another, e.g. the producer delivery report callback.  Buffers larger
+ *          than the largest class are allocated and freed on each use.
+ *
+ *          All methods are thread safe.
+ */
+class BufferPool {
+public:
+    BufferPool();
+    ~BufferPool();
+
+    /**
+     * Get a buffer of at least size bytes
+     *
+     * \param [in] size         Minimum size of the buffer in bytes
+     *
+     * \return Buffer - release() must be called when no longer used
+     */
+    pool_buffer *acquire(size_t size);
+
+    /**
+     * Return a buffer to the pool
+     *
+     * \param [in] buf          Buffer from acquire(), NULL is ignored
+     */
+    void release(pool_buffer *buf);
+
+private:
+    struct size_class {
+        std::mutex      mutex;                  ///< Protects the free list
+        pool_buffer     *free_list;             ///< Free buffers of the class
+        size_t          free_count;             ///< Number of buffers in free_list
+        size_t          max_free;               ///< Max buffers kept in free_list
+    };
+
+    size_class      classes[BUFFER_POOL_CLASSES];
+
+    /**
+     * Allocate a new buffer
+     *
+     * \param [in] size         Size of the data in bytes
+     * \param [in] size_class   Size class, -1 if none
+     */
+    static pool_buffer *allocate(size_t size, int size_class);
+};
+
+#endif /* BUFFERPOOL_H_ */
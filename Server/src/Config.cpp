@@ -22,6 +22,10 @@
 
 #include "Config.h"
 #include "kafka/KafkaTopicSelector.h"
+#include "kafka/SpillLog.h"
+#include "kafka/MsgBusV2.h"
+#include "sink/MsgBusSink.h"
+#include "hash_id.h"
 
 /*********************************************************************//**
  * Constructor for class
@@ -48,6 +52,29 @@ Config::Config() {
     q_buf_max_msgs      = 100000;
     q_buf_max_kbytes    = 1048576;
     q_buf_max_ms        = 1000;         // Default is 1 sec
+    prod_queue_max_msgs = 100000;
+    prod_queue_max_kbytes = 262144;     // Default is 256MB
+    ctrl_queue_max_msgs = 10000;
+    ctrl_queue_max_kbytes = 16384;      // Default is 16MB
+    ctrl_buf_max_ms     = 5;
+    ctrl_compression    = "none";
+    coalesce_max_rows   = 1000;
+    coalesce_max_kbytes = 512;
+    coalesce_linger_ms  = 100;
+    spill_enabled       = false;
+    spill_dir           = "/var/spool/openbmp";
+    spill_segment_mbytes = 64;
+    spill_max_mbytes    = 4096;
+    spill_watermark     = 80;
+    spill_fsync         = SpillLog::SPILL_FSYNC_NEVER;
+    spill_fsync_interval = 1000;        // Default is 1 sec
+    sink_type           = MsgBusSink::SINK_KAFKA;
+    sink_file_path      = "/var/lib/openbmp/openbmp.msgs";
+    sink_file_rotate_mbytes = 1024;
+    sink_file_rotate_count = 10;
+    sink_unix_path      = "/var/run/openbmp/forwarder.sock";
+    sink_shm_name       = "openbmp";
+    sink_shm_mbytes     = 256;
     msg_send_max_retry  = 2;
     retry_backoff_ms    = 100;
     compression         = "snappy";
@@ -55,6 +82,13 @@ Config::Config() {
     initial_router_time = 60;
     calculate_baseline  = true;
     pat_enabled		= false;
+    reactor_mode        = false;
+    reactor_threads     = 2;
+    parser_threads      = 4;
+    hash_algorithm      = HashId::HASH_ALG_MD5;
+    dns_threads         = 2;
+    dns_ttl             = 3600;         // Default is 1 hour
+    dns_negative_ttl    = 300;          // Default is 5 minutes
     bzero(admin_id, sizeof(admin_id));
 
     /*
@@ -106,6 +140,8 @@ void Config::load(const char *cfg_filename) {
                         parseKafka(node);
                     else if (key.compare("mapping") == 0)
                         parseMapping(node);
+                    else if (key.compare("sink") == 0)
+                        parseSink(node);
 
                     else if (debug_general)
                         std::cout << "   Config: Key " << key << " Type " << node.Type() << std::endl;
@@ -208,6 +244,25 @@ void Config::parseBase(const YAML::Node &node) {
         }
     }
 
+    if (node["hash_algorithm"]) {
+        try {
+            value = node["hash_algorithm"].as<std::string>();
+
+            if (value.compare("md5") == 0)
+                hash_algorithm = HashId::HASH_ALG_MD5;
+            else if (value.compare("xxh3-128") == 0)
+                hash_algorithm = HashId::HASH_ALG_XXH3_128;
+            else
+                throw "invalid hash_algorithm, must be md5 or xxh3-128";
+
+            if (debug_general)
+                std::cout << "   Config: hash_algorithm: " << value << std::endl;
+
+        } catch (YAML::TypedBadConversion<std::string> err) {
+            printWarning("hash_algorithm is not of type string", node["hash_algorithm"]);
+        }
+    }
+
     if (node["buffers"]) {
         if (node["buffers"]["router"]) {
             try {
@@ -227,6 +282,53 @@ void Config::parseBase(const YAML::Node &node) {
         }
     }
 
+    if (node["dns"]) {
+        if (node["dns"]["threads"]) {
+            try {
+                dns_threads = node["dns"]["threads"].as<int>();
+
+                if (dns_threads < 1 || dns_threads > 32)
+                    throw "invalid dns threads, not within range of 1 - 32";
+
+                if (debug_general)
+                    std::cout << "   Config: dns threads: " << dns_threads << std::endl;
+
+            } catch (YAML::TypedBadConversion<int> err) {
+                printWarning("dns.threads is not of type int", node["dns"]["threads"]);
+            }
+        }
+
+        if (node["dns"]["ttl"]) {
+            try {
+                dns_ttl = node["dns"]["ttl"].as<int>();
+
+                if (dns_ttl < 1 || dns_ttl > 604800)
+                    throw "invalid dns ttl, not within range of 1 - 604800";
+
+                if (debug_general)
+                    std::cout << "   Config: dns ttl: " << dns_ttl << std::endl;
+
+            } catch (YAML::TypedBadConversion<int> err) {
+                printWarning("dns.ttl is not of type int", node["dns"]["ttl"]);
+            }
+        }
+
+        if (node["dns"]["negative_ttl"]) {
+            try {
+                dns_negative_ttl = node["dns"]["negative_ttl"].as<int>();
+
+                if (dns_negative_ttl < 1 || dns_negative_ttl > 86400)
+                    throw "invalid dns negative_ttl, not within range of 1 - 86400";
+
+                if (debug_general)
+                    std::cout << "   Config: dns negative ttl: " << dns_negative_ttl << std::endl;
+
+            } catch (YAML::TypedBadConversion<int> err) {
+                printWarning("dns.negative_ttl is not of type int", node["dns"]["negative_ttl"]);
+            }
+        }
+    }
+
     if (node["heartbeat"]) {
         if (node["heartbeat"]["interval"]) {
             try {
@@ -305,6 +407,57 @@ void Config::parseBase(const YAML::Node &node) {
         }
     }
 
+    if (node["ingest"]) {
+        if (node["ingest"]["mode"]) {
+            try {
+                value = node["ingest"]["mode"].as<std::string>();
+
+                if (value.compare("reactor") == 0)
+                    reactor_mode = true;
+                else if (value.compare("thread") == 0)
+                    reactor_mode = false;
+                else
+                    throw "invalid ingest mode, must be thread or reactor";
+
+                if (debug_general)
+                    std::cout << "   Config: ingest mode: " << value << std::endl;
+
+            } catch (YAML::TypedBadConversion<std::string> err) {
+                printWarning("ingest.mode is not of type string", node["ingest"]["mode"]);
+            }
+        }
+
+        if (node["ingest"]["reactor_threads"]) {
+            try {
+                reactor_threads = node["ingest"]["reactor_threads"].as<int>();
+
+                if (reactor_threads < 1 || reactor_threads > 64)
+                    throw "invalid ingest reactor threads, not within range of 1 - 64";
+
+                if (debug_general)
+                    std::cout << "   Config: ingest reactor threads: " << reactor_threads << std::endl;
+
+            } catch (YAML::TypedBadConversion<int> err) {
+                printWarning("ingest.reactor_threads is not of type int", node["ingest"]["reactor_threads"]);
+            }
+        }
+
+        if (node["ingest"]["parser_threads"]) {
+            try {
+                parser_threads = node["ingest"]["parser_threads"].as<int>();
+
+                if (parser_threads < 1 || parser_threads > 256)
+                    throw "invalid ingest parser threads, not within range of 1 - 256";
+
+                if (debug_general)
+                    std::cout << "   Config: ingest parser threads: " << parser_threads << std::endl;
+
+            } catch (YAML::TypedBadConversion<int> err) {
+                printWarning("ingest.parser_threads is not of type int", node["ingest"]["parser_threads"]);
+            }
+        }
+    }
+
 }
 
 /**
@@ -500,6 +653,42 @@ void Config::parseKafka(const YAML::Node &node) {
     }
 
 
+    if (node["producer.queue.max.messages"]  &&
+        node["producer.queue.max.messages"].Type() == YAML::NodeType::Scalar) {
+        try {
+            prod_queue_max_msgs = node["producer.queue.max.messages"].as<int>();
+
+            if (prod_queue_max_msgs < 1 || prod_queue_max_msgs > 10000000)
+                throw "invalid producer queue max messages, should be "
+                        "in range 1 - 10000000";
+            if (debug_general)
+                std::cout << "   Config: producer queue max messages: " <<
+                          prod_queue_max_msgs << std::endl;
+
+        } catch (YAML::TypedBadConversion<int> err) {
+            printWarning("prod_queue_max_msgs is not of type int",
+                         node["producer.queue.max.messages"]);
+        }
+    }
+
+    if (node["producer.queue.max.kbytes"]  &&
+        node["producer.queue.max.kbytes"].Type() == YAML::NodeType::Scalar) {
+        try {
+            prod_queue_max_kbytes = node["producer.queue.max.kbytes"].as<int>();
+
+            if (prod_queue_max_kbytes < 1024 || prod_queue_max_kbytes > 2097151)
+                throw "invalid producer queue max kbytes, should be "
+                        "in range 1024 - 2097151";
+            if (debug_general)
+                std::cout << "   Config: producer queue max kbytes: " <<
+                          prod_queue_max_kbytes << std::endl;
+
+        } catch (YAML::TypedBadConversion<int> err) {
+            printWarning("prod_queue_max_kbytes is not of type int",
+                         node["producer.queue.max.kbytes"]);
+        }
+    }
+
     if (node["queue.buffering.max.ms"]  && 
         node["queue.buffering.max.ms"].Type() == YAML::NodeType::Scalar) {
         try {
@@ -573,11 +762,411 @@ void Config::parseKafka(const YAML::Node &node) {
         }
     }
 
+    if (node["coalesce.max.rows"]  &&
+        node["coalesce.max.rows"].Type() == YAML::NodeType::Scalar) {
+        try {
+            coalesce_max_rows = node["coalesce.max.rows"].as<int>();
+
+            if (coalesce_max_rows < 1 || coalesce_max_rows > 100000)
+                throw "invalid coalesce max rows, should be "
+                        "in range 1 - 100000";
+            if (debug_general)
+                std::cout << "   Config: coalesce max rows: " <<
+                          coalesce_max_rows << std::endl;
+
+        } catch (YAML::TypedBadConversion<int> err) {
+            printWarning("coalesce_max_rows is not of type int",
+                         node["coalesce.max.rows"]);
+        }
+    }
+
+    if (node["coalesce.max.kbytes"]  &&
+        node["coalesce.max.kbytes"].Type() == YAML::NodeType::Scalar) {
+        try {
+            coalesce_max_kbytes = node["coalesce.max.kbytes"].as<int>();
+
+            if (coalesce_max_kbytes < 1 || coalesce_max_kbytes > 1700)
+                throw "invalid coalesce max kbytes, should be "
+                        "in range 1 - 1700";
+            if (debug_general)
+                std::cout << "   Config: coalesce max kbytes: " <<
+                          coalesce_max_kbytes << std::endl;
+
+        } catch (YAML::TypedBadConversion<int> err) {
+            printWarning("coalesce_max_kbytes is not of type int",
+                         node["coalesce.max.kbytes"]);
+        }
+    }
+
+    if (node["coalesce.linger.ms"]  &&
+        node["coalesce.linger.ms"].Type() == YAML::NodeType::Scalar) {
+        try {
+            coalesce_linger_ms = node["coalesce.linger.ms"].as<int>();
+
+            if (coalesce_linger_ms < 0 || coalesce_linger_ms > 10000)
+                throw "invalid coalesce linger ms, should be "
+                        "in range 0 - 10000";
+            if (debug_general)
+                std::cout << "   Config: coalesce linger ms: " <<
+                          coalesce_linger_ms << std::endl;
+
+        } catch (YAML::TypedBadConversion<int> err) {
+            printWarning("coalesce_linger_ms is not of type int",
+                         node["coalesce.linger.ms"]);
+        }
+    }
+
+    if (node["control"] && node["control"].Type() == YAML::NodeType::Map) {
+        parseControl(node["control"]);
+    }
+
+    if (node["spill"] && node["spill"].Type() == YAML::NodeType::Map) {
+        parseSpill(node["spill"]);
+    }
+
     if (node["topics"] && node["topics"].Type() == YAML::NodeType::Map) {
         parseTopics(node["topics"]);
     }
 }
 
+/**
+ * Parse the kafka control lane configuration
+ *
+ * \param [in] node     Reference to the yaml NODE
+ */
+void Config::parseControl(const YAML::Node &node) {
+
+    if (node["producer.queue.max.messages"]  &&
+        node["producer.queue.max.messages"].Type() == YAML::NodeType::Scalar) {
+        try {
+            ctrl_queue_max_msgs = node["producer.queue.max.messages"].as<int>();
+
+            if (ctrl_queue_max_msgs < 1 || ctrl_queue_max_msgs > 10000000)
+                throw "invalid control producer queue max messages, should be "
+                        "in range 1 - 10000000";
+            if (debug_general)
+                std::cout << "   Config: control producer queue max messages: " <<
+                          ctrl_queue_max_msgs << std::endl;
+
+        } catch (YAML::TypedBadConversion<int> err) {
+            printWarning("control producer.queue.max.messages is not of type int",
+                         node["producer.queue.max.messages"]);
+        }
+    }
+
+    if (node["producer.queue.max.kbytes"]  &&
+        node["producer.queue.max.kbytes"].Type() == YAML::NodeType::Scalar) {
+        try {
+            ctrl_queue_max_kbytes = node["producer.queue.max.kbytes"].as<int>();
+
+            if (ctrl_queue_max_kbytes < 1024 || ctrl_queue_max_kbytes > 2097151)
+                throw "invalid control producer queue max kbytes, should be "
+                        "in range 1024 - 2097151";
+            if (debug_general)
+                std::cout << "   Config: control producer queue max kbytes: " <<
+                          ctrl_queue_max_kbytes << std::endl;
+
+        } catch (YAML::TypedBadConversion<int> err) {
+            printWarning("control producer.queue.max.kbytes is not of type int",
+                         node["producer.queue.max.kbytes"]);
+        }
+    }
+
+    if (node["queue.buffering.max.ms"]  &&
+        node["queue.buffering.max.ms"].Type() == YAML::NodeType::Scalar) {
+        try {
+            ctrl_buf_max_ms = node["queue.buffering.max.ms"].as<int>();
+
+            if (ctrl_buf_max_ms < 0 || ctrl_buf_max_ms > 900000)
+                throw "invalid control queue buffering max ms, should be "
+                        "in range 0 - 900000";
+            if (debug_general)
+                std::cout << "   Config: control queue buffering max time in ms: " <<
+                          ctrl_buf_max_ms << std::endl;
+
+        } catch (YAML::TypedBadConversion<int> err) {
+            printWarning("control queue.buffering.max.ms is not of type int",
+                         node["queue.buffering.max.ms"]);
+        }
+    }
+
+    if (node["compression.codec"]  &&
+        node["compression.codec"].Type() == YAML::NodeType::Scalar) {
+        try {
+            ctrl_compression = node["compression.codec"].as<std::string>();
+
+            if (ctrl_compression != "none" && ctrl_compression != "snappy" &&
+                ctrl_compression != "gzip" && ctrl_compression != "lz4")
+                throw "invalid value for control compression, should be one of none,"
+                        " gzip, snappy, or lz4";
+            if (debug_general)
+                std::cout << "   Config: control compression: " <<
+                          ctrl_compression << std::endl;
+
+        } catch (YAML::TypedBadConversion<std::string> err) {
+            printWarning("control compression.codec is not of type string",
+                         node["compression.codec"]);
+        }
+    }
+}
+
+/**
+ * Parse the message bus sink configuration
+ *
+ * \param [in] node     Reference to the yaml NODE
+ */
+void Config::parseSink(const YAML::Node &node) {
+    std::string value;
+
+    if (node["type"]) {
+        try {
+            value = node["type"].as<std::string>();
+
+            if (value.compare("kafka") == 0)
+                sink_type = MsgBusSink::SINK_KAFKA;
+            else if (value.compare("null") == 0)
+                sink_type = MsgBusSink::SINK_NULL;
+            else if (value.compare("file") == 0)
+                sink_type = MsgBusSink::SINK_FILE;
+            else if (value.compare("unix") == 0)
+                sink_type = MsgBusSink::SINK_UNIX;
+            else if (value.compare("shm") == 0)
+                sink_type = MsgBusSink::SINK_SHM;
+            else
+                throw "invalid sink type, must be kafka, null, file, unix or shm";
+
+            if (debug_general)
+                std::cout << "   Config: sink type: " << value << std::endl;
+
+        } catch (YAML::TypedBadConversion<std::string> err) {
+            printWarning("sink.type is not of type string", node["type"]);
+        }
+    }
+
+    if (node["file"] && node["file"].Type() == YAML::NodeType::Map) {
+        const YAML::Node &file = node["file"];
+
+        if (file["path"]) {
+            try {
+                sink_file_path = file["path"].as<std::string>();
+
+                if (sink_file_path.size() == 0)
+                    throw "invalid sink file path, cannot be empty";
+
+                if (debug_general)
+                    std::cout << "   Config: sink file path: " << sink_file_path << std::endl;
+
+            } catch (YAML::TypedBadConversion<std::string> err) {
+                printWarning("sink.file.path is not of type string", file["path"]);
+            }
+        }
+
+        if (file["rotate_mbytes"]) {
+            try {
+                sink_file_rotate_mbytes = file["rotate_mbytes"].as<int>();
+
+                if (sink_file_rotate_mbytes < 1 || sink_file_rotate_mbytes > 1048576)
+                    throw "invalid sink file rotate_mbytes, not within range of 1 - 1048576";
+
+                if (debug_general)
+                    std::cout << "   Config: sink file rotate mbytes: " << sink_file_rotate_mbytes << std::endl;
+
+            } catch (YAML::TypedBadConversion<int> err) {
+                printWarning("sink.file.rotate_mbytes is not of type int", file["rotate_mbytes"]);
+            }
+        }
+
+        if (file["rotate_count"]) {
+            try {
+                sink_file_rotate_count = file["rotate_count"].as<int>();
+
+                if (sink_file_rotate_count < 1 || sink_file_rotate_count > 1000)
+                    throw "invalid sink file rotate_count, not within range of 1 - 1000";
+
+                if (debug_general)
+                    std::cout << "   Config: sink file rotate count: " << sink_file_rotate_count << std::endl;
+
+            } catch (YAML::TypedBadConversion<int> err) {
+                printWarning("sink.file.rotate_count is not of type int", file["rotate_count"]);
+            }
+        }
+    }
+
+    if (node["unix"] && node["unix"].Type() == YAML::NodeType::Map) {
+        const YAML::Node &unix_node = node["unix"];
+
+        if (unix_node["path"]) {
+            try {
+                sink_unix_path = unix_node["path"].as<std::string>();
+
+                if (sink_unix_path.size() == 0 || sink_unix_path.size() > 107)
+                    throw "invalid sink unix path, must be 1 - 107 characters";
+
+                if (debug_general)
+                    std::cout << "   Config: sink unix path: " << sink_unix_path << std::endl;
+
+            } catch (YAML::TypedBadConversion<std::string> err) {
+                printWarning("sink.unix.path is not of type string", unix_node["path"]);
+            }
+        }
+    }
+
+    if (node["shm"] && node["shm"].Type() == YAML::NodeType::Map) {
+        const YAML::Node &shm = node["shm"];
+
+        if (shm["name"]) {
+            try {
+                sink_shm_name = shm["name"].as<std::string>();
+
+                if (sink_shm_name.size() == 0 || sink_shm_name.size() > 200 ||
+                        sink_shm_name.find('/') != std::string::npos)
+                    throw "invalid sink shm name, must be 1 - 200 characters without /";
+
+                if (debug_general)
+                    std::cout << "   Config: sink shm name: " << sink_shm_name << std::endl;
+
+            } catch (YAML::TypedBadConversion<std::string> err) {
+                printWarning("sink.shm.name is not of type string", shm["name"]);
+            }
+        }
+
+        if (shm["size_mbytes"]) {
+            try {
+                sink_shm_mbytes = shm["size_mbytes"].as<int>();
+
+                if (sink_shm_mbytes < 4 || sink_shm_mbytes > 65536)
+                    throw "invalid sink shm size_mbytes, not within range of 4 - 65536";
+
+                if (debug_general)
+                    std::cout << "   Config: sink shm size mbytes: " << sink_shm_mbytes << std::endl;
+
+            } catch (YAML::TypedBadConversion<int> err) {
+                printWarning("sink.shm.size_mbytes is not of type int", shm["size_mbytes"]);
+            }
+        }
+    }
+}
+
+/**
+ * Parse the kafka spill log configuration
+ *
+ * \param [in] node     Reference to the yaml NODE
+ */
+void Config::parseSpill(const YAML::Node &node) {
+    std::string value;
+
+    if (node["enable"]) {
+        try {
+            spill_enabled = node["enable"].as<bool>();
+
+            if (debug_general)
+                std::cout << "   Config: spill enable: " << spill_enabled << std::endl;
+
+        } catch (YAML::TypedBadConversion<bool> err) {
+            printWarning("spill.enable is not of type bool", node["enable"]);
+        }
+    }
+
+    if (node["directory"]) {
+        try {
+            spill_dir = node["directory"].as<std::string>();
+
+            if (spill_dir.size() == 0)
+                throw "invalid spill directory, cannot be empty";
+
+            if (debug_general)
+                std::cout << "   Config: spill directory: " << spill_dir << std::endl;
+
+        } catch (YAML::TypedBadConversion<std::string> err) {
+            printWarning("spill.directory is not of type string", node["directory"]);
+        }
+    }
+
+    if (node["segment_mbytes"]) {
+        try {
+            spill_segment_mbytes = node["segment_mbytes"].as<int>();
+
+            if (spill_segment_mbytes < 4 || spill_segment_mbytes > 1024)
+                throw "invalid spill segment_mbytes, not within range of 4 - 1024";
+
+            if (debug_general)
+                std::cout << "   Config: spill segment mbytes: " << spill_segment_mbytes << std::endl;
+
+        } catch (YAML::TypedBadConversion<int> err) {
+            printWarning("spill.segment_mbytes is not of type int", node["segment_mbytes"]);
+        }
+    }
+
+    if (node["max_mbytes"]) {
+        try {
+            spill_max_mbytes = node["max_mbytes"].as<int>();
+
+            if (spill_max_mbytes < 8 || spill_max_mbytes > 1048576)
+                throw "invalid spill max_mbytes, not within range of 8 - 1048576";
+
+            if (debug_general)
+                std::cout << "   Config: spill max mbytes: " << spill_max_mbytes << std::endl;
+
+        } catch (YAML::TypedBadConversion<int> err) {
+            printWarning("spill.max_mbytes is not of type int", node["max_mbytes"]);
+        }
+    }
+
+    if (node["watermark"]) {
+        try {
+            spill_watermark = node["watermark"].as<int>();
+
+            if (spill_watermark < 1 || spill_watermark > 100)
+                throw "invalid spill watermark, not within range of 1 - 100";
+
+            if (debug_general)
+                std::cout << "   Config: spill watermark: " << spill_watermark << std::endl;
+
+        } catch (YAML::TypedBadConversion<int> err) {
+            printWarning("spill.watermark is not of type int", node["watermark"]);
+        }
+    }
+
+    if (node["fsync"]) {
+        try {
+            value = node["fsync"].as<std::string>();
+
+            if (value.compare("never") == 0)
+                spill_fsync = SpillLog::SPILL_FSYNC_NEVER;
+            else if (value.compare("interval") == 0)
+                spill_fsync = SpillLog::SPILL_FSYNC_INTERVAL;
+            else if (value.compare("always") == 0)
+                spill_fsync = SpillLog::SPILL_FSYNC_ALWAYS;
+            else
+                throw "invalid spill fsync, must be never, interval or always";
+
+            if (debug_general)
+                std::cout << "   Config: spill fsync: " << value << std::endl;
+
+        } catch (YAML::TypedBadConversion<std::string> err) {
+            printWarning("spill.fsync is not of type string", node["fsync"]);
+        }
+    }
+
+    if (node["fsync_interval_ms"]) {
+        try {
+            spill_fsync_interval = node["fsync_interval_ms"].as<int>();
+
+            if (spill_fsync_interval < 10 || spill_fsync_interval > 60000)
+                throw "invalid spill fsync_interval_ms, not within range of 10 - 60000";
+
+            if (debug_general)
+                std::cout << "   Config: spill fsync interval ms: " << spill_fsync_interval << std::endl;
+
+        } catch (YAML::TypedBadConversion<int> err) {
+            printWarning("spill.fsync_interval_ms is not of type int", node["fsync_interval_ms"]);
+        }
+    }
+
+    if (spill_max_mbytes < spill_segment_mbytes * 2)
+        throw "invalid spill max_mbytes, must be at least two segments";
+}
+
 
 
 /**
@@ -635,6 +1224,35 @@ void Config::parseTopics(const YAML::Node &node) {
         }
     }
 
+    if (node["format"] and node["format"].Type() == YAML::NodeType::Map) {
+        for (YAML::const_iterator it = node["format"].begin(); it != node["format"].end(); ++it) {
+            try {
+                const std::string &topic = it->first.as<std::string>();
+                const std::string &format = it->second.as<std::string>();
+                size_t field_count;
+
+                if (format.compare("binary") == 0) {
+                    if (msgbusV2Schema(topic, field_count) == NULL)
+                        throw "invalid kafka.topics.format, binary is supported by base_attribute, "
+                              "unicast_prefix, l3vpn, evpn and bmp_stat";
+
+                    binary_topics.insert(topic);
+
+                } else if (format.compare("tsv") == 0)
+                    binary_topics.erase(topic);
+
+                else
+                    throw "invalid kafka.topics.format, should be tsv or binary";
+
+                if (debug_general)
+                    std::cout << "   Config: kafka.topics.format: " << topic << " = " << format << std::endl;
+
+            } catch (YAML::TypedBadConversion<std::string> err) {
+                printWarning("kafka.topics.format error in map.  Make sure to define topic: <tsv or binary>", it->second);
+            }
+        }
+    }
+
     // Update the topics based on user-defined variables
     topicSubstitutions();
 
@@ -670,7 +1288,7 @@ void Config::parseMapping(const YAML::Node &node) {
                     if (cur_node["regexp_hostname"] and
                         cur_node["regexp_hostname"].Type() == YAML::NodeType::Sequence) {
 
-                        parseRegexpList(cur_node["regexp_hostname"], name, match_router_group_by_name);
+                        parseRegexpList(cur_node["regexp_hostname"], name, match_router_group);
 
                     } else if (cur_node["regexp_hostname"])
                         throw "Invalid mapping.groups.router_group.regexp_hostname, should be of type list/sequence";
@@ -679,7 +1297,7 @@ void Config::parseMapping(const YAML::Node &node) {
                     if (debug_general) std::cout << "   Config: getting prefix_range list" << std::endl;
                     if (cur_node["prefix_range"] and cur_node["prefix_range"].Type() == YAML::NodeType::Sequence) {
 
-                        parsePrefixList(cur_node["prefix_range"], name, match_router_group_by_ip);
+                        parsePrefixList(cur_node["prefix_range"], name, match_router_group);
 
                     } else if (cur_node["prefix_range"])
                         throw "Invalid mapping.groups.router_group.prefix_range, should be of type list/sequence";
@@ -704,7 +1322,7 @@ void Config::parseMapping(const YAML::Node &node) {
                     if (cur_node["regexp_hostname"] and
                         cur_node["regexp_hostname"].Type() == YAML::NodeType::Sequence) {
 
-                        parseRegexpList(cur_node["regexp_hostname"], name, match_peer_group_by_name);
+                        parseRegexpList(cur_node["regexp_hostname"], name, match_peer_group);
 
                     } else if (cur_node["regexp_hostname"])
                         throw "Invalid mapping.groups.peer_group.regexp_hostname, should be of type list/sequence";
@@ -713,7 +1331,7 @@ void Config::parseMapping(const YAML::Node &node) {
                     if (debug_general) std::cout << "   Config: getting prefix_range list" << std::endl;
                     if (cur_node["prefix_range"] and cur_node["prefix_range"].Type() == YAML::NodeType::Sequence) {
 
-                        parsePrefixList(cur_node["prefix_range"], name, match_peer_group_by_ip);
+                        parsePrefixList(cur_node["prefix_range"], name, match_peer_group);
 
                     } else if (cur_node["prefix_range"])
                         throw "Invalid mapping.groups.peer_group.prefix_range, should be of type list/sequence";
@@ -726,7 +1344,7 @@ void Config::parseMapping(const YAML::Node &node) {
                             if (cur_node["asn"][i].Type() == YAML::NodeType::Scalar) {
                                 try {
                                     uint32_t asn = cur_node["asn"][i].as<std::uint32_t>();
-                                    match_peer_group_by_asn[name].push_back(asn);
+                                    match_peer_group.addAsn(asn, name);
                                 } catch (YAML::TypedBadConversion<std::string> err) {
                                     printWarning(
                                             "mapping.groups.peer_group.asn int parse error. ASN must be uint32: ",
@@ -742,33 +1360,25 @@ void Config::parseMapping(const YAML::Node &node) {
             }
         }
 
+        // Compile the hostname expressions of all groups
+        match_router_group.compile();
+        match_peer_group.compile();
     }
 }
 
 /**
- * Parse matching regexp list and update the provided map with compiled expressions
+ * Parse matching regexp list and add the expressions to the group matcher
  *
  * \param [in]  node     regex list node - should be of type sequence
- * \param [in]  name     group name, used as the map key
- * \param [out] map      Reference to the map that will be updated with the compiled expressions
+ * \param [in]  name     group name
+ * \param [out] matcher  Reference to the group matcher that will be updated with the expressions
  */
-void Config::parseRegexpList(const YAML::Node &node, std::string name,
-                             std::map<std::string, std::list<match_type_regex>> &map) {
-
-    match_type_regex value;
+void Config::parseRegexpList(const YAML::Node &node, std::string name, GroupMatcher &matcher) {
 
     for (std::size_t i = 0; i < node.size(); i++) {
         if (node[i].Type() == YAML::NodeType::Scalar) {
 
-            try {
-                value.regexp = sregex::compile(node[i].as<std::string>(),
-                                               regex_constants::icase | regex_constants::not_dot_newline
-                                               | regex_constants::optimize | regex_constants::nosubs);
-                map[name].push_back(value);
-
-            } catch (boost::exception_detail::clone_impl<boost::xpressive::regex_error> err) {
-                throw "Invalid regular expression pattern";
-            }
+            matcher.addRegexp(node[i].as<std::string>(), name);
 
             if (debug_general)
                 std::cout << "   Config: compiled regexp hostname: " << node[i].as<std::string>() << std::endl;
@@ -777,16 +1387,20 @@ void Config::parseRegexpList(const YAML::Node &node, std::string name,
 }
 
 /**
- * Parse matching prefix_range list and update the provided map with compiled expressions
+ * Parse matching prefix_range list and add the prefixes to the group matcher
  *
  * \param [in]  node     prefix_range list node - should be of type sequence
- * \param [in]  name     group name, used as the map key
- * \param [out] map      Reference to the map that will be updated with ip addresses
+ * \param [in]  name     group name
+ * \param [out] matcher  Reference to the group matcher that will be updated with the prefixes
  */
-void Config::parsePrefixList(const YAML::Node &node, std::string name,
-                             std::map<std::string, std::list<match_type_ip>> &map) {
+void Config::parsePrefixList(const YAML::Node &node, std::string name, GroupMatcher &matcher) {
+
+    struct {
+        bool        isIPv4;                     ///< Indicates if IPv4 or IPv6
+        u_char      prefix[16];                 ///< IP/network prefix to match
+        uint8_t     bits;                       ///< bits to match
+    } value;
 
-    match_type_ip value;
     char *prefix_full;
     char *prefix, *bits;
 
@@ -824,9 +1438,9 @@ void Config::parsePrefixList(const YAML::Node &node, std::string name,
 
 
             // add the inet address
-            inet_pton((value.isIPv4 ? AF_INET : AF_INET6), prefix, &value.prefix);
+            inet_pton((value.isIPv4 ? AF_INET : AF_INET6), prefix, value.prefix);
 
-            map[name].push_back(value);
+            matcher.addPrefix(value.isIPv4, value.prefix, value.bits, name);
 
             if (debug_general)
                 printf("   Config: added prefix: %s %s/%d\n", (value.isIPv4 ? "IPv4" : "IPv6"), prefix,
@@ -13,10 +13,13 @@
 #include <string>
 #include <list>
 #include <map>
+#include <set>
 #include <yaml-cpp/yaml.h>
 #include <boost/xpressive/xpressive.hpp>
 #include <boost/exception/all.hpp>
 
+#include "GroupMatcher.h"
+
 #define MAX_THREADS 200
 
 using namespace boost::xpressive;
@@ -55,6 +58,29 @@ public:
     int         q_buf_max_msgs;      ///< Max msgs allowed in producer queue
     int         q_buf_max_kbytes;    ///< Max kbytes allowed in producer queue
     int         q_buf_max_ms;		 ///< Max time for buffering msgs in queue
+    int         prod_queue_max_msgs;     ///< Max msgs queued for the producer thread
+    int         prod_queue_max_kbytes;   ///< Max kbytes queued for the producer thread
+    int         ctrl_queue_max_msgs;     ///< Max control lane msgs queued for the producer thread
+    int         ctrl_queue_max_kbytes;   ///< Max control lane kbytes queued for the producer thread
+    int         ctrl_buf_max_ms;         ///< Max time for buffering control lane msgs in queue
+    std::string ctrl_compression;        ///< Compression of the control lane: none, gzip, snappy, lz4
+    int         coalesce_max_rows;       ///< Max rows coalesced into one message
+    int         coalesce_max_kbytes;     ///< Max kbytes of rows coalesced into one message
+    int         coalesce_linger_ms;      ///< Max time rows wait to be coalesced, 0 to disable coalescing
+    bool        spill_enabled;           ///< Spill messages to disk when the producer queue is above the watermark
+    std::string spill_dir;               ///< Directory of the spill segment files
+    int         spill_segment_mbytes;    ///< Size of a spill segment file in MB
+    int         spill_max_mbytes;        ///< Max size of all spill segment files in MB
+    int         spill_watermark;         ///< Percent of the producer queue max at which spilling starts
+    int         spill_fsync;             ///< When spilled messages are flushed to disk (SpillLog::fsync_policy)
+    int         spill_fsync_interval;    ///< Milliseconds between flushes (SpillLog::SPILL_FSYNC_INTERVAL)
+    int         sink_type;               ///< Message bus sink (MsgBusSink::sink_type)
+    std::string sink_file_path;          ///< File of the file sink
+    int         sink_file_rotate_mbytes; ///< Size in MB at which the sink file is rotated
+    int         sink_file_rotate_count;  ///< Number of rotated sink files kept
+    std::string sink_unix_path;          ///< UNIX domain socket path of the unix sink
+    std::string sink_shm_name;           ///< Shared memory ring name of the shm sink (/dev/shm/<name>)
+    int         sink_shm_mbytes;         ///< Size in MB of the shared memory ring
     int         msg_send_max_retry;      ///< No. of times to resend failed msgs
     int         retry_backoff_ms;        ///< Backoff time before resending msgs  
     std::string compression;		 ///< Compression to use :none, gzip, snappy
@@ -62,41 +88,23 @@ public:
     int         initial_router_time;     ///<Initial time in allowing another concurrent router
     bool        calculate_baseline;      ///<Indicates if router baseline time should be calculated
     bool        pat_enabled;             ///<Indicates if router hash needs to be based on INIT message instead of source IP
+    bool        reactor_mode;            ///< Indicates if routers are handled by epoll reactor threads instead of a thread per router
+    int         reactor_threads;         ///< Number of epoll reactor threads (reactor mode)
+    int         parser_threads;          ///< Number of BMP parser worker threads (reactor mode)
+    int         hash_algorithm;          ///< Algorithm used to generate hash IDs (HashId::algorithm)
+    int         dns_threads;             ///< Number of reverse DNS resolver threads
+    int         dns_ttl;                 ///< Seconds a resolved hostname is cached
+    int         dns_negative_ttl;        ///< Seconds a failed reverse lookup is cached
 
     /**
-     * matching structs and maps
+     * Matching router group rules - used to regex/ip match the router to group name
      */
-    struct match_type_regex {
-        boost::xpressive::sregex  regexp;    ///< Compiled regular expression
-    };
-
-    struct match_type_ip {
-        bool        isIPv4;                                     ///< Indicates if IPv4 or IPv6
-        uint32_t    prefix[4]  __attribute__ ((aligned));       ///< IP/network prefix to match (host bits are zeroed)
-        uint8_t     bits;                                       ///< bits to match
-    };
-
-    /**
-     * Matching router group map - used to regex/ip match the router to group name
-     */
-    std::map<std::string, std::list<match_type_regex>> match_router_group_by_name;
-    typedef std::map<std::string, std::list<match_type_regex>>::iterator match_router_group_by_name_iter;
-
-    std::map<std::string, std::list<match_type_ip>> match_router_group_by_ip;
-    typedef std::map<std::string, std::list<match_type_ip>>::iterator match_router_group_by_ip_iter;
-
+    GroupMatcher match_router_group;
 
     /**
-     * Matching peer group map - used to regex/ip match the peer to group name
+     * Matching peer group rules - used to regex/ip/asn match the peer to group name
      */
-    std::map<std::string, std::list<match_type_regex>> match_peer_group_by_name;
-    typedef std::map<std::string, std::list<match_type_regex>>::iterator match_peer_group_by_name_iter;
-
-    std::map<std::string,  std::list<match_type_ip>> match_peer_group_by_ip;
-    typedef std::map<std::string, std::list<match_type_ip>>::iterator match_peer_group_by_ip_iter;
-
-    std::map<std::string,  std::list<uint32_t>> match_peer_group_by_asn;
-    typedef std::map<std::string, std::list<uint32_t>>::iterator match_peer_group_by_asn_iter;
+    GroupMatcher match_peer_group;
 
     /**
      * kafka topic variables
@@ -110,6 +118,11 @@ public:
     std::map<std::string, std::string> topic_names_map;
     typedef std::map<std::string, std::string>::iterator topic_names_map_iter;
 
+    /**
+     * kafka topics (topic_names_map keys) produced in the binary format (API 2.0) instead of TSV
+     */
+    std::set<std::string> binary_topics;
+
     /**
      * map for router baseline times
      */
@@ -157,6 +170,27 @@ private:
      */
     void parseTopics(const YAML::Node &node);
 
+    /**
+     * Parse the kafka control lane configuration
+     *
+     * \param [in] node     Reference to the yaml NODE
+     */
+    void parseControl(const YAML::Node &node);
+
+    /**
+     * Parse the kafka spill log configuration
+     *
+     * \param [in] node     Reference to the yaml NODE
+     */
+    void parseSpill(const YAML::Node &node);
+
+    /**
+     * Parse the message bus sink configuration
+     *
+     * \param [in] node     Reference to the yaml NODE
+     */
+    void parseSink(const YAML::Node &node);
+
     /**
      * Parse the mapping configuration
      *
@@ -165,23 +199,23 @@ private:
     void parseMapping(const YAML::Node &node);
 
     /**
-     * Parse matching prefix_range list and update the provided map with compiled expressions
+     * Parse matching prefix_range list and add the prefixes to the group matcher
      *
      * \param [in]  node     prefix_range list node - should be of type sequence
-     * \param [in]  name     group name, used as the map key
-     * \param [out] map      Reference to the map that will be updated with ip addresses
+     * \param [in]  name     group name
+     * \param [out] matcher  Reference to the group matcher that will be updated with the prefixes
      */
-    void parsePrefixList(const YAML::Node &node, std::string name, std::map<std::string, std::list<match_type_ip>> &map);
+    void parsePrefixList(const YAML::Node &node, std::string name, GroupMatcher &matcher);
 
 
     /**
-     * Parse matching regexp list and update the provided map with compiled expressions
+     * Parse matching regexp list and add the expressions to the group matcher
      *
      * \param [in]  node     regex list node - should be of type sequence
-     * \param [in]  name     group name, used as the map key
-     * \param [out] map      Reference to the map that will be updated with the compiled expressions
+     * \param [in]  name     group name
+     * \param [out] matcher  Reference to the group matcher that will be updated with the expressions
      */
-    void parseRegexpList(const YAML::Node &node, std::string name, std::map<std::string, std::list<match_type_regex>> &map);
+    void parseRegexpList(const YAML::Node &node, std::string name, GroupMatcher &matcher);
 
     /**
      * print warning message for parsing node
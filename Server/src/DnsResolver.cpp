@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include <sys/socket.h>
+#include <netdb.h>
+
+#include "DnsResolver.h"
+
+/*********************************************************************//**
+ * Constructor for class - starts the resolver threads
+ *
+ * \param [in] logPtr   Pointer to Logger instance
+ * \param [in] cfg      Pointer to the config instance
+ ***********************************************************************/
+DnsResolver::DnsResolver(Logger *logPtr, Config *cfg) {
+    logger = logPtr;
+    this->cfg = cfg;
+    run = true;
+
+    for (int i=0; i < cfg->dns_threads; i++)
+        threads.push_back(new std::thread(&DnsResolver::resolverLoop, this));
+
+    LOG_INFO("DNS resolver started with %d threads, ttl %d seconds, negative ttl %d seconds",
+             cfg->dns_threads, cfg->dns_ttl, cfg->dns_negative_ttl);
+}
+
+/*********************************************************************//**
+ * Destructor for class - stops the resolver threads
+ ***********************************************************************/
+DnsResolver::~DnsResolver() {
+    std::unique_lock<std::mutex> lock(mutex);
+    run = false;
+    lock.unlock();
+
+    queue_cond.notify_all();
+
+    // Threads may be blocked in getaddrinfo/getnameinfo, which is bounded by the system resolver timeout
+    for (size_t i=0; i < threads.size(); i++) {
+        if (threads[i]->joinable())
+            threads[i]->join();
+
+        delete threads[i];
+    }
+
+    threads.clear();
+}
+
+/*********************************************************************//**
+ * Get the hostname of an IP address from the cache
+ *
+ * \param [in]  ip          IP address in printed form
+ * \param [out] hostname    Hostname, empty if not known
+ *
+ * \return true if the address has been resolved, false if the lookup is pending
+ ***********************************************************************/
+bool DnsResolver::lookup(const std::string &ip, std::string &hostname) {
+    hostname.clear();
+
+    if (ip.empty())
+        return true;
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    time_t now = time(NULL);
+    cache_iter it = cache.find(ip);
+
+    if (it != cache.end()) {
+        dns_entry &entry = it->second;
+
+        hostname = entry.hostname;
+
+        // Refresh the entry once expired - the expired name is returned meanwhile
+        if (entry.expires <= now and not entry.queued and queue.size() < DNS_QUEUE_MAX) {
+            entry.queued = true;
+            queue.push_back(ip);
+            queue_cond.notify_one();
+        }
+
+        return entry.resolved;
+    }
+
+    if (queue.size() >= DNS_QUEUE_MAX)
+        return false;                           // Try again on a later message
+
+    if (cache.size() >= DNS_CACHE_MAX_ENTRIES)
+        purgeExpired();
+
+    dns_entry &entry = cache[ip];
+    entry.expires = 0;
+    entry.resolved = false;
+    entry.queued = true;
+
+    queue.push_back(ip);
+    queue_cond.notify_one();
+
+    return false;
+}
+
+/**
+ * Resolver thread loop
+ */
+void DnsResolver::resolverLoop() {
+    std::string ip;
+    std::string hostname;
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (run and queue.empty())
+            queue_cond.wait(lock);
+
+        if (not run)
+            break;
+
+        ip.swap(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        bool found = resolve(ip, hostname);
+
+        lock.lock();
+
+        dns_entry &entry = cache[ip];
+        entry.resolved = true;
+        entry.queued = false;
+
+        if (found) {
+            entry.hostname = hostname;
+            entry.expires = time(NULL) + cfg->dns_ttl;
+
+        } else {
+            // A previously resolved name is kept if the refresh failed; retried after the negative ttl
+            entry.expires = time(NULL) + cfg->dns_negative_ttl;
+        }
+    }
+}
+
+/**
+ * Resolve an IP address to a hostname (blocking)
+ *
+ * \param [in]  ip          IP address in printed form
+ * \param [out] hostname    Hostname
+ *
+ * \return true if resolved, false if the address has no name or the lookup failed
+ */
+bool DnsResolver::resolve(const std::string &ip, std::string &hostname) {
+    addrinfo hints = {};
+    addrinfo *ai;
+    char host[255];
+    bool found = false;
+
+    hints.ai_flags = AI_NUMERICHOST;
+
+    if (!getaddrinfo(ip.c_str(), NULL, &hints, &ai)) {
+
+        if (!getnameinfo(ai->ai_addr,ai->ai_addrlen, host, sizeof(host), NULL, 0, NI_NAMEREQD)) {
+            hostname.assign(host);
+            found = true;
+            LOG_INFO("resolve: %s to %s", ip.c_str(), hostname.c_str());
+        }
+
+        freeaddrinfo(ai);
+    }
+
+    return found;
+}
+
+/**
+ * Remove expired entries that are not queued
+ */
+void DnsResolver::purgeExpired() {
+    time_t now = time(NULL);
+
+    for (cache_iter it = cache.begin(); it != cache.end(); ) {
+        if (it->second.expires <= now and not it->second.queued)
+            it = cache.erase(it);
+        else
+            ++it;
+    }
+}
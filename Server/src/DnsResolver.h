@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef DNSRESOLVER_H_
+#define DNSRESOLVER_H_
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <ctime>
+
+#include "Logger.h"
+#include "Config.h"
+
+#define DNS_CACHE_MAX_ENTRIES       200000      ///< Expired entries are purged when the cache exceeds this size
+#define DNS_QUEUE_MAX               10000       ///< Max pending lookups, new lookups are dropped when full
+
+/**
+ * \class   DnsResolver
+ *
+ * \brief   Asynchronous reverse DNS resolver with a collector wide cache
+ * \details A single instance is created by the server and shared by all routers.
+ *          lookup() never blocks; names that are not cached are queued and resolved
+ *          by a pool of resolver threads.  Both names and failed lookups (negative
+ *          entries) are cached with a TTL.  Expired names continue to be returned
+ *          while they are refreshed.
+ *
+ *          All public methods are thread safe.
+ */
+class DnsResolver {
+public:
+    /*********************************************************************//**
+     * Constructor for class - starts the resolver threads
+     *
+     * \param [in] logPtr   Pointer to Logger instance
+     * \param [in] cfg      Pointer to the config instance
+     ***********************************************************************/
+    DnsResolver(Logger *logPtr, Config *cfg);
+
+    /*********************************************************************//**
+     * Destructor for class - stops the resolver threads
+     ***********************************************************************/
+    ~DnsResolver();
+
+    /*********************************************************************//**
+     * Get the hostname of an IP address from the cache
+     *
+     * \details The lookup is queued if the address is not cached or the entry
+     *          has expired.
+     *
+     * \param [in]  ip          IP address in printed form
+     * \param [out] hostname    Hostname, empty if not known
+     *
+     * \return true if the address has been resolved (hostname may be empty if
+     *         the address has no name), false if the lookup is pending
+     ***********************************************************************/
+    bool lookup(const std::string &ip, std::string &hostname);
+
+private:
+    /**
+     * Cache entry
+     */
+    struct dns_entry {
+        std::string     hostname;               ///< Resolved name - empty if negative
+        time_t          expires;                ///< Time the entry expires
+        bool            resolved;               ///< Entry has been resolved at least once
+        bool            queued;                 ///< Lookup is queued or in progress
+    };
+
+    Logger          *logger;                    ///< Logging class pointer
+    Config          *cfg;                       ///< Config pointer
+    bool            run;                        ///< Indicates if the threads should continue running
+
+    std::unordered_map<std::string, dns_entry> cache;  ///< Cache keyed by printed IP address
+    typedef std::unordered_map<std::string, dns_entry>::iterator cache_iter;
+
+    std::deque<std::string>     queue;          ///< Addresses waiting to be resolved
+    std::mutex                  mutex;          ///< Protects cache and queue
+    std::condition_variable     queue_cond;     ///< Signaled when an address is queued
+
+    std::vector<std::thread *>  threads;        ///< Resolver threads
+
+    /**
+     * Resolver thread loop
+     */
+    void resolverLoop();
+
+    /**
+     * Resolve an IP address to a hostname (blocking)
+     *
+     * \param [in]  ip          IP address in printed form
+     * \param [out] hostname    Hostname
+     *
+     * \return true if resolved, false if the address has no name or the lookup failed
+     */
+    bool resolve(const std::string &ip, std::string &hostname);
+
+    /**
+     * Remove expired entries that are not queued
+     *
+     * \details mutex must be held
+     */
+    void purgeExpired();
+};
+
+#endif /* DNSRESOLVER_H_ */
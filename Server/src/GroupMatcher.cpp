@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include <arpa/inet.h>
+#include <cstring>
+
+#include "GroupMatcher.h"
+
+using namespace boost::xpressive;
+
+#define GROUP_REGEX_FLAGS   (regex_constants::icase | regex_constants::not_dot_newline | regex_constants::optimize)
+
+GroupMatcher::GroupMatcher() {
+    trie_node root = { {0, 0}, -1 };
+
+    trie.push_back(root);                       // IPv4 root
+    trie.push_back(root);                       // IPv6 root
+}
+
+/**
+ * Get the index of a group, adding the group if new
+ */
+int32_t GroupMatcher::getGroupIndex(const std::string &group) {
+    std::unordered_map<std::string, int32_t>::iterator it = group_index.find(group);
+
+    if (it != group_index.end())
+        return it->second;
+
+    groups.push_back(group);
+    group_index[group] = groups.size() - 1;
+
+    return groups.size() - 1;
+}
+
+/**
+ * Check if a regular expression has a back reference
+ *
+ * \details Back references are \1-\9, \g and \k outside of a character class, and (?P=name).
+ *
+ * \param [in] pattern      Regular expression
+ *
+ * \return true if the pattern has a back reference
+ */
+static bool hasBackReference(const std::string &pattern) {
+    bool in_class = false;
+
+    for (size_t i=0; i < pattern.size(); i++) {
+        char c = pattern[i];
+
+        if (c == '\\' and i + 1 < pattern.size()) {
+            char n = pattern[++i];
+
+            if (not in_class and ((n >= '1' and n <= '9') or n == 'g' or n == 'k'))
+                return true;
+
+        } else if (in_class) {
+            if (c == ']')
+                in_class = false;
+
+        } else if (c == '[') {
+            in_class = true;
+
+            // A ']' first in the class is a literal
+            if (i + 1 < pattern.size() and pattern[i + 1] == '^')
+                i++;
+            if (i + 1 < pattern.size() and pattern[i + 1] == ']')
+                i++;
+
+        } else if (pattern.compare(i, 4, "(?P=") == 0)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * Add a hostname regular expression rule
+ *
+ * \param [in] pattern      Regular expression
+ * \param [in] group        Group name
+ */
+void GroupMatcher::addRegexp(const std::string &pattern, const std::string &group) {
+
+    // Group numbers change when the patterns are combined, so back references would refer to other groups
+    if (hasBackReference(pattern))
+        throw "Invalid regular expression pattern, back references are not supported";
+
+    // Validate the pattern on its own so that errors refer to the offending pattern
+    try {
+        sregex::compile(pattern, GROUP_REGEX_FLAGS);
+
+    } catch (regex_error &err) {
+        throw "Invalid regular expression pattern";
+    }
+
+    patterns.push_back(pattern);
+    pattern_groups.push_back(getGroupIndex(group));
+}
+
+/**
+ * Add a prefix range rule
+ *
+ * \param [in] isIPv4       True if IPv4, false if IPv6
+ * \param [in] prefix       Prefix in network byte order (4 or 16 bytes)
+ * \param [in] bits         Prefix length
+ * \param [in] group        Group name
+ */
+void GroupMatcher::addPrefix(bool isIPv4, const unsigned char *prefix, uint8_t bits, const std::string &group) {
+    int32_t node = isIPv4 ? 0 : 1;
+
+    for (int i=0; i < bits; i++) {
+        int bit = (prefix[i >> 3] >> (7 - (i & 7))) & 1;
+
+        if (trie[node].child[bit] == 0) {
+            trie_node child = { {0, 0}, -1 };
+
+            trie.push_back(child);
+            trie[node].child[bit] = trie.size() - 1;
+        }
+
+        node = trie[node].child[bit];
+    }
+
+    if (trie[node].group < 0)
+        trie[node].group = getGroupIndex(group);
+}
+
+/**
+ * Add an ASN rule
+ *
+ * \param [in] asn          ASN
+ * \param [in] group        Group name
+ */
+void GroupMatcher::addAsn(uint32_t asn, const std::string &group) {
+    if (asns.find(asn) == asns.end())
+        asns[asn] = getGroupIndex(group);
+}
+
+/**
+ * Compile the hostname rules - must be called after all rules are added
+ */
+void GroupMatcher::compile() {
+    std::string all;
+    int mark = 1;
+
+    pattern_marks.clear();
+
+    /*
+     * Each pattern becomes a marked alternative, anchored at the start of the hostname with a
+     *      lazy prefix.  The search then only moves past the first alternative if the pattern does
+     *      not match anywhere, so the first rule that matches wins (not the leftmost match).
+     *      Marks within the pattern itself shift the mark number of the following alternatives.
+     */
+    for (size_t i=0; i < patterns.size(); i++) {
+        if (i > 0)
+            all += '|';
+
+        all += "^(?:.*?(";
+        all += patterns[i];
+        all += "))";
+
+        pattern_marks.push_back(mark);
+        mark += 1 + sregex::compile(patterns[i], GROUP_REGEX_FLAGS).mark_count();
+    }
+
+    if (patterns.size() > 0) {
+        try {
+            combined = sregex::compile(all, GROUP_REGEX_FLAGS);
+
+        } catch (regex_error &err) {
+            throw "Failed to compile the combined hostname regular expression";
+        }
+    }
+}
+
+/**
+ * Match hostname against the regexp rules
+ *
+ * \param [in] hostname     Hostname/fqdn
+ *
+ * \return Group name or NULL if not matched
+ */
+const std::string *GroupMatcher::matchHostname(const std::string &hostname) const {
+    smatch what;
+
+    if (pattern_marks.size() == 0 or hostname.size() == 0 or not regex_search(hostname, what, combined))
+        return NULL;
+
+    for (size_t i=0; i < pattern_marks.size(); i++) {
+        if (what[pattern_marks[i]].matched)
+            return &groups[pattern_groups[i]];
+    }
+
+    return NULL;
+}
+
+/**
+ * Match IP address against the prefix range rules
+ *
+ * \param [in] ip_addr      IP address in printed form
+ *
+ * \return Group name or NULL if not matched
+ */
+const std::string *GroupMatcher::matchIp(const std::string &ip_addr) const {
+    bool isIPv4 = ip_addr.find_first_of(':') == std::string::npos;
+    unsigned char addr[16];
+
+    if (inet_pton(isIPv4 ? AF_INET : AF_INET6, ip_addr.c_str(), addr) != 1)
+        return NULL;
+
+    int32_t node = isIPv4 ? 0 : 1;
+    int32_t group = trie[node].group;
+    int addr_bits = isIPv4 ? 32 : 128;
+
+    // Walk the address bits, remembering the longest prefix that has a group
+    for (int i=0; i < addr_bits; i++) {
+        node = trie[node].child[(addr[i >> 3] >> (7 - (i & 7))) & 1];
+
+        if (node == 0)
+            break;
+
+        if (trie[node].group >= 0)
+            group = trie[node].group;
+    }
+
+    return group >= 0 ? &groups[group] : NULL;
+}
+
+/**
+ * Match ASN against the ASN rules
+ *
+ * \param [in] asn          ASN
+ *
+ * \return Group name or NULL if not matched
+ */
+const std::string *GroupMatcher::matchAsn(uint32_t asn) const {
+    std::unordered_map<uint32_t, int32_t>::const_iterator it = asns.find(asn);
+
+    return it != asns.end() ? &groups[it->second] : NULL;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef GROUPMATCHER_H_
+#define GROUPMATCHER_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <boost/xpressive/xpressive.hpp>
+
+/**
+ * \class   GroupMatcher
+ *
+ * \brief   Compiled router/peer group matching rules
+ * \details Rules are added while parsing the configuration and compiled once by compile().
+ *          Lookups do not depend on the number of rules:
+ *
+ *          - Hostname regexps are combined into a single alternation, so the hostname is
+ *            searched once.  The rule added first that matches anywhere in the hostname wins.
+ *          - Prefix ranges are stored in a binary trie per address family.  The longest
+ *            matching prefix wins; for equal prefixes the rule added first wins.
+ *          - ASNs are stored in a hash map.  The rule added first wins.
+ */
+class GroupMatcher {
+public:
+    GroupMatcher();
+
+    /**
+     * Add a hostname regular expression rule
+     *
+     * \details Patterns are case insensitive and cannot use back references, as the
+     *          group numbers change when the patterns are combined.
+     *
+     * \param [in] pattern      Regular expression
+     * \param [in] group        Group name
+     *
+     * \throws char const* if the pattern is not valid or has a back reference
+     */
+    void addRegexp(const std::string &pattern, const std::string &group);
+
+    /**
+     * Add a prefix range rule
+     *
+     * \param [in] isIPv4       True if IPv4, false if IPv6
+     * \param [in] prefix       Prefix in network byte order (4 or 16 bytes)
+     * \param [in] bits         Prefix length
+     * \param [in] group        Group name
+     */
+    void addPrefix(bool isIPv4, const unsigned char *prefix, uint8_t bits, const std::string &group);
+
+    /**
+     * Add an ASN rule
+     *
+     * \param [in] asn          ASN
+     * \param [in] group        Group name
+     */
+    void addAsn(uint32_t asn, const std::string &group);
+
+    /**
+     * Compile the hostname rules - must be called after all rules are added
+     *
+     * \throws char const* if the combined expression cannot be compiled
+     */
+    void compile();
+
+    /**
+     * Match hostname against the regexp rules
+     *
+     * \param [in] hostname     Hostname/fqdn
+     *
+     * \return Group name or NULL if not matched
+     */
+    const std::string *matchHostname(const std::string &hostname) const;
+
+    /**
+     * Match IP address against the prefix range rules
+     *
+     * \param [in] ip_addr      IP address in printed form
+     *
+     * \return Group name or NULL if not matched
+     */
+    const std::string *matchIp(const std::string &ip_addr) const;
+
+    /**
+     * Match ASN against the ASN rules
+     *
+     * \param [in] asn          ASN
+     *
+     * \return Group name or NULL if not matched
+     */
+    const std::string *matchAsn(uint32_t asn) const;
+
+private:
+    /**
+     * Prefix trie node - one level per prefix bit
+     */
+    struct trie_node {
+        int32_t     child[2];                   ///< Index of the child nodes, zero if none
+        int32_t     group;                      ///< Group index of a prefix ending here, -1 if none
+    };
+
+    std::vector<std::string>    groups;         ///< Group names, rules refer to them by index
+    std::unordered_map<std::string, int32_t> group_index;  ///< Group name to index
+
+    std::vector<std::string>    patterns;       ///< Hostname patterns in the order added
+    std::vector<int32_t>        pattern_groups; ///< Group index of each pattern
+    std::vector<int>            pattern_marks;  ///< Combined expression mark number of each pattern
+    boost::xpressive::sregex    combined;       ///< All hostname patterns as one alternation
+
+    std::vector<trie_node>      trie;           ///< Prefix trie nodes, 0 is the IPv4 root and 1 the IPv6 root
+
+    std::unordered_map<uint32_t, int32_t> asns; ///< ASN to group index
+
+    /**
+     * Get the index of a group, adding the group if new
+     */
+    int32_t getGroupIndex(const std::string &group);
+};
+
+#endif /* GROUPMATCHER_H_ */
@@ -105,6 +105,8 @@ public:
         char        peer_rd[32];            ///< Peer distinguisher ID (string/printed format)
         char        peer_addr[46];          ///< Peer IP address in printed form
         char        peer_bgp_id[16];        ///< Peer BGP ID in printed form
+        u_char      peer_addr_bin[16];      ///< Peer IP address in binary form (BMP per peer header)
+        u_char      peer_rd_bin[8];         ///< Peer distinguisher in binary form (BMP per peer header)
         uint32_t    peer_as;                ///< Peer ASN
         bool        isL3VPN;                ///< true if peer is L3VPN, otherwise it is Global
         bool        isPrePolicy;            ///< True if the routes are pre-policy, false if not
@@ -599,6 +601,17 @@ public:
      *****************************************************************/
     virtual void send_bmp_raw(u_char *r_hash, obj_bgp_peer &peer, u_char *data, size_t data_len) = 0;
 
+    /*****************************************************************//**
+     * \brief       Send pending messages
+     *
+     * \details     Implementations may coalesce the rows of several updates into one
+     *              message.  This sends the pending messages, for example when the
+     *              router is idle.
+     *
+     * \param[in]    expired_only   Only send messages pending for longer than the linger time
+     *****************************************************************/
+    virtual void flush(bool /*expired_only*/) { }
+
 
     /* ---------------------------------------------------------------------------
      * Commonly used methods
@@ -616,16 +629,29 @@ public:
      *
      */
     static void hash_toStr(const u_char *hash_bin, std::string &hash_str){
+        char s[32];
 
-        int i;
-        char s[33];
-
-        for (i=0; i<16; i++)
-            sprintf(s+i*2, "%02x", hash_bin[i]);
+        hash_toStr(hash_bin, s);
+        hash_str.assign(s, sizeof(s));
+    }
 
-        s[32]='\0';
+    /**
+     * \brief       binary hash to printed string format
+     *
+     * \details     Converts a hash unsigned char bytes to HEX string, writing
+     *              directly to the caller's buffer.  The string is not null terminated.
+     *
+     * \param[in]   hash_bin      16 byte binary/unsigned value
+     * \param[out]  hash_str      Buffer of at least 32 bytes
+     *
+     */
+    static void hash_toStr(const u_char *hash_bin, char *hash_str){
+        static const char hex[] = "0123456789abcdef";
 
-        hash_str = s;
+        for (int i=0; i < 16; i++) {
+            hash_str[i * 2]     = hex[hash_bin[i] >> 4];
+            hash_str[i * 2 + 1] = hex[hash_bin[i] & 0x0f];
+        }
     }
 
     /**
@@ -267,6 +267,7 @@ namespace bgp_msg {
             tuple.mpls_label_2 = 0;
             tuple.mac_len = 0;
             tuple.ip_len = 0;
+            tuple.label_count = 0;
 
 
             // TODO: Keep an eye on this, as we might need to support add-paths for evpn
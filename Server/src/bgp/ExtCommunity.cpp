@@ -40,19 +40,19 @@ namespace bgp_msg {
      * Parse the extended communities path attribute (8 byte as per RFC4360)
      *
      * \details
-     *     Will parse the EXTENDED COMMUNITIES data passed. Parsed data will be stored
-     *     in parsed_data.
+     *     Will parse the EXTENDED COMMUNITIES data passed. The printed form of the
+     *     communities is stored in decodeStr.
      *
      * \param [in]   attr_len       Length of the attribute data
      * \param [in]   data           Pointer to the attribute data
-     * \param [out]  parsed_data    Reference to parsed_update_data; will be updated with all parsed data
+     * \param [out]  decodeStr      Space delimited list of extended communities
      *
      */
-    void ExtCommunity::parseExtCommunities(int attr_len, u_char *data, bgp_msg::UpdateMsg::parsed_update_data &parsed_data) {
-
-        std::string decodeStr = "";
+    void ExtCommunity::parseExtCommunities(int attr_len, u_char *data, std::string &decodeStr) {
         extcomm_hdr ec_hdr;
 
+        decodeStr.clear();
+
         if ( (attr_len % 8) ) {
             LOG_NOTICE("%s: Parsing extended community len=%d is invalid, expecting divisible by 8", peer_addr.c_str(), attr_len);
             return;
@@ -116,8 +116,6 @@ namespace bgp_msg {
             if ((i + 8) < attr_len)
                 decodeStr.append(" ");
         }
-
-        parsed_data.attrs[ATTR_TYPE_EXT_COMMUNITY] = decodeStr;
     }
 
     /**
@@ -166,15 +166,15 @@ public:
      * Parse the extended communities path attribute (8 byte as per RFC4360)
      *
      * \details
-     *     Will parse the EXTENDED COMMUNITIES data passed. Parsed data will be stored
-     *     in parsed_data.
+     *     Will parse the EXTENDED COMMUNITIES data passed. The printed form of the
+     *     communities is stored in decodeStr.
      *
      * \param [in]   attr_len       Length of the attribute data
      * \param [in]   data           Pointer to the attribute data
-     * \param [out]  parsed_data    Reference to parsed_update_data; will be updated with all parsed data
+     * \param [out]  decodeStr      Space delimited list of extended communities
      *
      */
-    void parseExtCommunities(int attr_len, u_char *data, UpdateMsg::parsed_update_data &parsed_data);
+    void parseExtCommunities(int attr_len, u_char *data, std::string &decodeStr);
 
     /**
      * Parse the extended communities path attribute (20 byte as per RFC5701)
@@ -112,20 +112,8 @@ void MPReachAttr::parseAfi(mp_reach_nlri &nlri, UpdateMsg::parsed_update_data &p
 
         case bgp::BGP_AFI_L2VPN :
         {
-            u_char      ip_raw[16];
-            char        ip_char[40];
-
-            bzero(ip_raw, sizeof(ip_raw));
-
             // Next-hop is an IP address - Change/set the next-hop attribute in parsed data to use this next-hop
-            if (nlri.nh_len > 16)
-                memcpy(ip_raw, nlri.next_hop, 16);
-            else
-                memcpy(ip_raw, nlri.next_hop, nlri.nh_len);
-
-            inet_ntop(nlri.nh_len == 4 ? AF_INET : AF_INET6, ip_raw, ip_char, sizeof(ip_char));
-
-            parsed_data.attrs[ATTR_TYPE_NEXT_HOP] = std::string(ip_char);
+            parsed_data.attrs.setNextHop(nlri.next_hop, nlri.nh_len, nlri.nh_len == 4);
 
             // parse by safi
             switch (nlri.safi) {
@@ -160,11 +148,6 @@ void MPReachAttr::parseAfi(mp_reach_nlri &nlri, UpdateMsg::parsed_update_data &p
  * \param [out]  parsed_data    Reference to parsed_update_data; will be updated with all parsed data
  */
 void MPReachAttr::parseAfi_IPv4IPv6(bool isIPv4, mp_reach_nlri &nlri, UpdateMsg::parsed_update_data &parsed_data) {
-    u_char      ip_raw[16];
-    char        ip_char[40];
-
-    bzero(ip_raw, sizeof(ip_raw));
-    
     /*
      * Decode based on SAFI
      */
@@ -172,14 +155,7 @@ void MPReachAttr::parseAfi_IPv4IPv6(bool isIPv4, mp_reach_nlri &nlri, UpdateMsg:
         case bgp::BGP_SAFI_UNICAST: // Unicast IP address prefix
 
             // Next-hop is an IP address - Change/set the next-hop attribute in parsed data to use this next-hop
-            if (nlri.nh_len > 16)
-                memcpy(ip_raw, nlri.next_hop, 16);
-            else
-                memcpy(ip_raw, nlri.next_hop, nlri.nh_len);
-
-            inet_ntop(isIPv4 ? AF_INET : AF_INET6, ip_raw, ip_char, sizeof(ip_char));
-
-            parsed_data.attrs[ATTR_TYPE_NEXT_HOP] = std::string(ip_char);
+            parsed_data.attrs.setNextHop(nlri.next_hop, nlri.nh_len, isIPv4);
 
             // Data is an IP address - parse the address and save it
             parseNlriData_IPv4IPv6(isIPv4, nlri.nlri_data, nlri.nlri_len, peer_info, parsed_data.advertised);
@@ -187,14 +163,7 @@ void MPReachAttr::parseAfi_IPv4IPv6(bool isIPv4, mp_reach_nlri &nlri, UpdateMsg:
 
         case bgp::BGP_SAFI_NLRI_LABEL:
             // Next-hop is an IP address - Change/set the next-hop attribute in parsed data to use this next-hop
-            if (nlri.nh_len > 16)
-                memcpy(ip_raw, nlri.next_hop, 16);
-            else
-                memcpy(ip_raw, nlri.next_hop, nlri.nh_len);
-
-            inet_ntop(isIPv4 ? AF_INET : AF_INET6, ip_raw, ip_char, sizeof(ip_char));
-
-            parsed_data.attrs[ATTR_TYPE_NEXT_HOP] = std::string(ip_char);
+            parsed_data.attrs.setNextHop(nlri.next_hop, nlri.nh_len, isIPv4);
 
             // Data is an Label, IP address tuple parse and save it
             parseNlriData_LabelIPv4IPv6(isIPv4, nlri.nlri_data, nlri.nlri_len, peer_info, parsed_data.advertised);
@@ -209,14 +178,7 @@ void MPReachAttr::parseAfi_IPv4IPv6(bool isIPv4, mp_reach_nlri &nlri, UpdateMsg:
             }
 
             // Next-hop is an IP address - Change/set the next-hop attribute in parsed data to use this next-hop
-            if (nlri.nh_len > 16)
-                memcpy(ip_raw, nlri.next_hop, 16);
-            else
-                memcpy(ip_raw, nlri.next_hop, nlri.nh_len);
-
-            inet_ntop(isIPv4 ? AF_INET : AF_INET6, ip_raw, ip_char, sizeof(ip_char));
-
-            parsed_data.attrs[ATTR_TYPE_NEXT_HOP] = std::string(ip_char);
+            parsed_data.attrs.setNextHop(nlri.next_hop, nlri.nh_len, isIPv4);
 
             parseNlriData_LabelIPv4IPv6(isIPv4, nlri.nlri_data, nlri.nlri_len, peer_info, parsed_data.vpn);
 
@@ -240,31 +202,32 @@ void MPReachAttr::parseAfi_IPv4IPv6(bool isIPv4, mp_reach_nlri &nlri, UpdateMsg:
  * \param [in]   data                   Pointer to the start of the prefixes to be parsed
  * \param [in]   len                    Length of the data in bytes to be read
  * \param [in]   peer_info              Persistent Peer info pointer
- * \param [out]  prefixes               Reference to a list<prefix_tuple> to be updated with entries
+ * \param [out]  prefixes               Reference to a prefix batch to be updated with entries
  */
 void MPReachAttr::parseNlriData_IPv4IPv6(bool isIPv4, u_char *data, uint16_t len,
                                          BMPReader::peer_info * peer_info,
-                                         std::list<bgp::prefix_tuple> &prefixes) {
-    u_char            ip_raw[16];
-    char              ip_char[40];
+                                         std::vector<bgp::prefix_tuple> &prefixes) {
     u_char            addr_bytes;
-    bgp::prefix_tuple tuple;
 
     if (len <= 0 or data == NULL)
         return;
 
-    // TODO: Can extend this to support multicast, but right now we set it to unicast v4/v6
-    tuple.type = isIPv4 ? bgp::PREFIX_UNICAST_V4 : bgp::PREFIX_UNICAST_V6;
-    tuple.isIPv4 = isIPv4;
-
     bool add_path_enabled = peer_info->add_path_capability.isAddPathEnabled(isIPv4 ? bgp::BGP_AFI_IPV4 : bgp::BGP_AFI_IPV6,
                                                                             bgp::BGP_SAFI_UNICAST);
 
     // Loop through all prefixes
     for (size_t read_size=0; read_size < len; read_size++) {
-        tuple.path_id = 0;
 
-        bzero(ip_raw, sizeof(ip_raw));
+        // Fill the next entry of the batch in place
+        prefixes.resize(prefixes.size() + 1);
+        bgp::prefix_tuple &tuple = prefixes.back();
+
+        // TODO: Can extend this to support multicast, but right now we set it to unicast v4/v6
+        tuple.type = isIPv4 ? bgp::PREFIX_UNICAST_V4 : bgp::PREFIX_UNICAST_V6;
+        tuple.isIPv4 = isIPv4;
+        tuple.label_count = 0;
+
+        bzero(tuple.prefix_bin, sizeof(tuple.prefix_bin));
 
         // Parse add-paths if enabled
         if (add_path_enabled and (len - read_size) >= 4) {
@@ -282,20 +245,13 @@ void MPReachAttr::parseNlriData_IPv4IPv6(bool isIPv4, u_char *data, uint16_t len
         if (tuple.len % 8)
            ++addr_bytes;
 
-        memcpy(ip_raw, data, addr_bytes);
-        data += addr_bytes;
-        read_size += addr_bytes;
-
-        // Convert the IP to string printed format
-        inet_ntop(isIPv4 ? AF_INET : AF_INET6, ip_raw, ip_char, sizeof(ip_char));
-
-        tuple.prefix.assign(ip_char);
+        if (addr_bytes > sizeof(tuple.prefix_bin))
+            addr_bytes = sizeof(tuple.prefix_bin);
 
         // set the raw/binary address
-        memcpy(tuple.prefix_bin, ip_raw, sizeof(ip_raw));
-
-        // Add tuple to prefix list
-        prefixes.push_back(tuple);
+        memcpy(tuple.prefix_bin, data, addr_bytes);
+        data += addr_bytes;
+        read_size += addr_bytes;
     }
 }
 
@@ -309,24 +265,18 @@ void MPReachAttr::parseNlriData_IPv4IPv6(bool isIPv4, u_char *data, uint16_t len
  * \param [in]   data                   Pointer to the start of the label + prefixes to be parsed
  * \param [in]   len                    Length of the data in bytes to be read
  * \param [in]   peer_info              Persistent Peer info pointer
- * \param [out]  prefixes               Reference to a list<label, prefix_tuple> to be updated with entries
+ * \param [out]  prefixes               Reference to a label prefix batch to be updated with entries
  */
 template <typename PREFIX_TUPLE>
 void MPReachAttr::parseNlriData_LabelIPv4IPv6(bool isIPv4, u_char *data, uint16_t len,
                                               BMPReader::peer_info * peer_info,
-                                              std::list<PREFIX_TUPLE> &prefixes) {
-    u_char            ip_raw[16];
-    char              ip_char[40];
+                                              std::vector<PREFIX_TUPLE> &prefixes) {
     int               addr_bytes;
-    PREFIX_TUPLE      tuple;
 
     if (len <= 0 or data == NULL)
         return;
 
-    tuple.type = isIPv4 ? bgp::PREFIX_LABEL_UNICAST_V4 : bgp::PREFIX_LABEL_UNICAST_V6;
-    tuple.isIPv4 = isIPv4;
-
-    bool isVPN = typeid(bgp::vpn_tuple) == typeid(tuple);
+    bool isVPN = typeid(bgp::vpn_tuple) == typeid(PREFIX_TUPLE);
     uint16_t label_bytes;
 
     bool add_path_enabled = peer_info->add_path_capability.isAddPathEnabled(isIPv4 ? bgp::BGP_AFI_IPV4 : bgp::BGP_AFI_IPV6,
@@ -335,6 +285,13 @@ void MPReachAttr::parseNlriData_LabelIPv4IPv6(bool isIPv4, u_char *data, uint16_
     // Loop through all prefixes
     for (size_t read_size=0; read_size < len; read_size++) {
 
+        // Fill the next entry of the batch in place
+        prefixes.resize(prefixes.size() + 1);
+        PREFIX_TUPLE &tuple = prefixes.back();
+
+        tuple.type = isIPv4 ? bgp::PREFIX_LABEL_UNICAST_V4 : bgp::PREFIX_LABEL_UNICAST_V6;
+        tuple.isIPv4 = isIPv4;
+
         // Only check for add-paths if not mpls/vpn
         if (not isVPN and add_path_enabled and (len - read_size) >= 4) {
             memcpy(&tuple.path_id, data, 4);
@@ -345,7 +302,7 @@ void MPReachAttr::parseNlriData_LabelIPv4IPv6(bool isIPv4, u_char *data, uint16_
         } else
             tuple.path_id = 0;
 
-        bzero(ip_raw, sizeof(ip_raw));
+        bzero(tuple.prefix_bin, sizeof(tuple.prefix_bin));
 
         // set the address in bits length
         tuple.len = *data++;
@@ -355,7 +312,7 @@ void MPReachAttr::parseNlriData_LabelIPv4IPv6(bool isIPv4, u_char *data, uint16_
         if (tuple.len % 8)
            ++addr_bytes;
 
-        label_bytes = decodeLabel(data, addr_bytes, tuple.labels);
+        label_bytes = decodeLabel(data, addr_bytes, tuple);
 
         tuple.len -= (8 * label_bytes);      // Update prefix len to not include the label(s)
         data += label_bytes;               // move data pointer past labels
@@ -375,23 +332,14 @@ void MPReachAttr::parseNlriData_LabelIPv4IPv6(bool isIPv4, u_char *data, uint16_
 
         // Parse the prefix if it isn't a default route
         if (addr_bytes > 0) {
-            memcpy(ip_raw, data, addr_bytes);
-            data += addr_bytes;
-            read_size += addr_bytes;
-
-            // Convert the IP to string printed format
-            inet_ntop(isIPv4 ? AF_INET : AF_INET6, ip_raw, ip_char, sizeof(ip_char));
-
-            tuple.prefix.assign(ip_char);
+            if (addr_bytes > (int)sizeof(tuple.prefix_bin))
+                addr_bytes = sizeof(tuple.prefix_bin);
 
             // set the raw/binary address
-            memcpy(tuple.prefix_bin, ip_raw, sizeof(ip_raw));
-
-        } else {
-            tuple.prefix.assign(isIPv4 ? "0.0.0.0" : "::");
+            memcpy(tuple.prefix_bin, data, addr_bytes);
+            data += addr_bytes;
+            read_size += addr_bytes;
         }
-
-        prefixes.push_back(tuple);
     }
 }
 
@@ -399,16 +347,15 @@ void MPReachAttr::parseNlriData_LabelIPv4IPv6(bool isIPv4, u_char *data, uint16_
  * Decode label from NLRI data
  *
  * \details
- *      Decodes the labels from the NLRI data into labels string
+ *      Decodes the labels from the NLRI data into the label stack of the tuple
  *
  * \param [in]   data                   Pointer to the start of the label + prefixes to be parsed
  * \param [in]   len                    Length of the data in bytes to be read
- * \param [out]  labels                 Reference to string that will be updated with labels delimited by comma
- *
- * \returns number of bytes read to decode the label(s) and updates string labels
+ * \param [out]  tuple                  Reference to prefix tuple that will be updated with the labels
  *
+ * \returns number of bytes read to decode the label(s) and updates the tuple labels
  */
-inline uint16_t MPReachAttr::decodeLabel(u_char *data, uint16_t len, std::string &labels) {
+inline uint16_t MPReachAttr::decodeLabel(u_char *data, uint16_t len, bgp::prefix_tuple &tuple) {
     int read_size = 0;
     typedef union {
         struct {
@@ -422,7 +369,7 @@ inline uint16_t MPReachAttr::decodeLabel(u_char *data, uint16_t len, std::string
 
     mpls_label label;
 
-    labels.clear();
+    tuple.label_count = 0;
 
     u_char *data_ptr = data;
 
@@ -437,17 +384,13 @@ inline uint16_t MPReachAttr::decodeLabel(u_char *data, uint16_t len, std::string
         data_ptr += 3;
         read_size += 3;
 
-        ostringstream convert;
-        convert << label.decode.value;
-        labels.append(convert.str());
+        if (tuple.label_count < BGP_MAX_LABELS)
+            tuple.labels[tuple.label_count++] = label.decode.value;
 
         //printf("label data = %x\n", label.data);
         if (label.decode.bos == 1 or label.data == 0x80000000 /* withdrawn label as 32bits instead of 24 */
                 or label.data == 0 /* l3vpn seems to use zero instead of rfc3107 suggested value */) {
             break;               // Reached EoS
-
-        } else {
-            labels.append(",");
         }
     }
 
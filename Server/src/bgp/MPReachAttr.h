@@ -12,6 +12,7 @@
 #include "bgp_common.h"
 #include "Logger.h"
 #include <list>
+#include <vector>
 #include <string>
 
 #include "UpdateMsg.h"
@@ -79,11 +80,11 @@ public:
      * \param [in]   data                       Pointer to the start of the prefixes to be parsed
      * \param [in]   len                        Length of the data in bytes to be read
      * \param [in]   peer_info                  Persistent Peer info pointer
-     * \param [out]  prefixes                   Reference to a list<prefix_tuple> to be updated with entries
+     * \param [out]  prefixes                   Reference to a prefix batch to be updated with entries
      */
     static void parseNlriData_IPv4IPv6(bool isIPv4, u_char *data, uint16_t len,
                                        BMPReader::peer_info *peer_info,
-                                       std::list<bgp::prefix_tuple> &prefixes);
+                                       std::vector<bgp::prefix_tuple> &prefixes);
 
     /**
      * Parses mp_reach_nlri and mp_unreach_nlri (IPv4/IPv6)
@@ -95,27 +96,27 @@ public:
      * \param [in]   data                   Pointer to the start of the label + prefixes to be parsed
      * \param [in]   len                    Length of the data in bytes to be read
      * \param [in]   peer_info              Persistent Peer info pointer
-     * \param [out]  prefixes               Reference to a list<label, prefix_tuple> to be updated with entries
+     * \param [out]  prefixes               Reference to a label prefix batch to be updated with entries
      */
     template <typename PREFIX_TUPLE>
     static void parseNlriData_LabelIPv4IPv6(bool isIPv4, u_char *data, uint16_t len,
                                             BMPReader::peer_info *peer_info,
-                                            std::list<PREFIX_TUPLE> &prefixes);
+                                            std::vector<PREFIX_TUPLE> &prefixes);
 
     /**
      * Decode label from NLRI data
      *
      * \details
-     *      Decodes the labels from the NLRI data into labels string
+     *      Decodes the labels from the NLRI data into the label stack of the tuple
      *
      * \param [in]   data                   Pointer to the start of the label + prefixes to be parsed
      * \param [in]   len                    Length of the data in bytes to be read
-     * \param [out]  labels                 Reference to string that will be updated with labels delimited by comma
+     * \param [out]  tuple                  Reference to prefix tuple that will be updated with the labels
      *
-     * \returns number of bytes read to decode the label(s) and updates string labels
+     * \returns number of bytes read to decode the label(s) and updates the tuple labels
      *
      */
-    static inline uint16_t decodeLabel(u_char *data, uint16_t len, std::string &labels);
+    static inline uint16_t decodeLabel(u_char *data, uint16_t len, bgp::prefix_tuple &tuple);
 
 private:
     bool                    debug;                  ///< debug flag to indicate debugging
@@ -70,9 +70,7 @@ size_t UpdateMsg::parseUpdateMsg(u_char *data, size_t size, parsed_update_data &
     u_char      *bufPtr         = data;
 
     // Clear the parsed_data
-    parsed_data.advertised.clear();
-    parsed_data.attrs.clear();
-    parsed_data.withdrawn.clear();
+    parsed_data.clear();
 
 
     /* ---------------------------------------------------------
@@ -168,32 +166,33 @@ size_t UpdateMsg::parseUpdateMsg(u_char *data, size_t size, parsed_update_data &
  *
  * \param [in]   data       Pointer to the start of the prefixes to be parsed
  * \param [in]   len        Length of the data in bytes to be read
- * \param [out]  prefixes   Reference to a list<prefix_tuple> to be updated with entries
+ * \param [out]  prefixes   Reference to a prefix batch to be updated with entries
  */
-void UpdateMsg::parseNlriData_v4(u_char *data, uint16_t len, std::list<bgp::prefix_tuple> &prefixes) {
-    u_char       ipv4_raw[4];
-    char         ipv4_char[16];
+void UpdateMsg::parseNlriData_v4(u_char *data, uint16_t len, std::vector<bgp::prefix_tuple> &prefixes) {
     u_char       addr_bytes;
 
-    bgp::prefix_tuple tuple;
-
     if (len <= 0 or data == NULL)
         return;
 
-    // TODO: Can extend this to support multicast, but right now we set it to unicast v4
-    // Set the type for all to be unicast V4
-    tuple.type = bgp::PREFIX_UNICAST_V4;
-    tuple.isIPv4 = true;
+    bool add_path_enabled = peer_info->add_path_capability.isAddPathEnabled(bgp::BGP_AFI_IPV4, bgp::BGP_SAFI_UNICAST);
 
     // Loop through all prefixes
     for (size_t read_size=0; read_size < len; read_size++) {
 
-        bzero(ipv4_raw, sizeof(ipv4_raw));
+        // Fill the next entry of the batch in place
+        prefixes.resize(prefixes.size() + 1);
+        bgp::prefix_tuple &tuple = prefixes.back();
+
+        // TODO: Can extend this to support multicast, but right now we set it to unicast v4
+        // Set the type for all to be unicast V4
+        tuple.type = bgp::PREFIX_UNICAST_V4;
+        tuple.isIPv4 = true;
+        tuple.label_count = 0;
+
         bzero(tuple.prefix_bin, sizeof(tuple.prefix_bin));
 
         // Parse add-paths if enabled
-        if (peer_info->add_path_capability.isAddPathEnabled(bgp::BGP_AFI_IPV4, bgp::BGP_SAFI_UNICAST)
-                and (len - read_size) >= 4) {
+        if (add_path_enabled and (len - read_size) >= 4) {
             memcpy(&tuple.path_id, data, 4);
             bgp::SWAP_BYTES(&tuple.path_id);
             data += 4; read_size += 4;
@@ -212,25 +211,15 @@ void UpdateMsg::parseNlriData_v4(u_char *data, uint16_t len, std::list<bgp::pref
                     router_addr.c_str(), tuple.len, addr_bytes);
 
         if (addr_bytes <= 4) {
-            memcpy(ipv4_raw, data, addr_bytes);
+            // set the raw/binary address
+            memcpy(tuple.prefix_bin, data, addr_bytes);
             read_size += addr_bytes;
             data += addr_bytes;
 
-            // Convert the IP to string printed format
-            inet_ntop(AF_INET, ipv4_raw, ipv4_char, sizeof(ipv4_char));
-            tuple.prefix.assign(ipv4_char);
-            SELF_DEBUG("%s: rtr=%s: Adding prefix %s len %d", peer_addr.c_str(),
-                        router_addr.c_str(), ipv4_char, tuple.len);
-
-            // set the raw/binary address
-            memcpy(tuple.prefix_bin, ipv4_raw, sizeof(ipv4_raw));
-
-            // Add tuple to prefix list
-            prefixes.push_back(tuple);
-
         } else if (addr_bytes > 4) {
             LOG_NOTICE("%s: rtr=%s: NRLI v4 address is larger than 4 bytes bytes=%d len=%d",
                        peer_addr.c_str(), router_addr.c_str(), addr_bytes, tuple.len);
+            prefixes.pop_back();
         }
     }
 }
@@ -291,6 +280,7 @@ void UpdateMsg::parseAttributes(u_char *data, uint16_t len, parsed_update_data &
             /*
              * Parse data based on attribute type
              */
+            parsed_data.attrs.set(attr_type, data, attr_len);
             parseAttrData(attr_type, attr_len, data, parsed_data);
             data        += attr_len;
             read_size   += attr_len;
@@ -320,11 +310,7 @@ void UpdateMsg::parseAttributes(u_char *data, uint16_t len, parsed_update_data &
  * \param [out]  parsed_data    Reference to parsed_update_data; will be updated with all parsed data
  */
 void UpdateMsg::parseAttrData(u_char attr_type, uint16_t attr_len, u_char *data, parsed_update_data &parsed_data) {
-    std::string decodeStr       = "";
-    u_char      ipv4_raw[4];
-    char        ipv4_char[16];
     uint32_t    value32bit;
-    uint16_t    value16bit;
 
     /*
      * Parse based on attribute type
@@ -332,13 +318,7 @@ void UpdateMsg::parseAttrData(u_char attr_type, uint16_t attr_len, u_char *data,
     switch (attr_type) {
 
         case ATTR_TYPE_ORIGIN : // Origin
-            switch (data[0]) {
-               case 0 : decodeStr.assign("igp"); break;
-               case 1 : decodeStr.assign("egp"); break;
-               case 2 : decodeStr.assign("incomplete"); break;
-            }
-
-            parsed_data.attrs[ATTR_TYPE_ORIGIN] = decodeStr;
+            parsed_data.attrs.origin = data[0];
             break;
 
         case ATTR_TYPE_AS_PATH : // AS_PATH
@@ -346,90 +326,36 @@ void UpdateMsg::parseAttrData(u_char attr_type, uint16_t attr_len, u_char *data,
             break;
 
         case ATTR_TYPE_NEXT_HOP : // Next hop v4
-            memcpy(ipv4_raw, data, 4);
-            inet_ntop(AF_INET, ipv4_raw, ipv4_char, sizeof(ipv4_char));
-            parsed_data.attrs[ATTR_TYPE_NEXT_HOP] = std::string(ipv4_char);
+            parsed_data.attrs.setNextHop(data, 4, true);
             break;
 
         case ATTR_TYPE_MED : // MED value
-        {
             memcpy(&value32bit, data, 4);
             bgp::SWAP_BYTES(&value32bit);
-            std::ostringstream numString;
-            numString << value32bit;
-            parsed_data.attrs[ATTR_TYPE_MED] = numString.str();
+            parsed_data.attrs.med = value32bit;
             break;
-        }
+
         case ATTR_TYPE_LOCAL_PREF : // local pref value
-        {
             memcpy(&value32bit, data, 4);
             bgp::SWAP_BYTES(&value32bit);
-            std::ostringstream numString;
-            numString << value32bit;
-            parsed_data.attrs[ATTR_TYPE_LOCAL_PREF] = numString.str();
+            parsed_data.attrs.local_pref = value32bit;
             break;
-        }
+
         case ATTR_TYPE_ATOMIC_AGGREGATE : // Atomic aggregate
-            parsed_data.attrs[ATTR_TYPE_ATOMIC_AGGREGATE] = std::string("1");
             break;
 
         case ATTR_TYPE_AGGEGATOR : // Aggregator
             parseAttr_Aggegator(attr_len, data, parsed_data.attrs);
             break;
 
-        case ATTR_TYPE_ORIGINATOR_ID : // Originator ID
-            memcpy(ipv4_raw, data, 4);
-            inet_ntop(AF_INET, ipv4_raw, ipv4_char, sizeof(ipv4_char));
-            parsed_data.attrs[ATTR_TYPE_ORIGINATOR_ID] = std::string(ipv4_char);
+        case ATTR_TYPE_ORIGINATOR_ID :  // Originator ID
+        case ATTR_TYPE_CLUSTER_LIST :   // Cluster List (RFC 4456)
+        case ATTR_TYPE_COMMUNITIES :    // Community list
+        case ATTR_TYPE_EXT_COMMUNITY :  // extended community list (RFC 4360)
+        case ATTR_TYPE_LARGE_COMMUNITY: // RFC8092
+            // Raw data is rendered when added to the message bus
             break;
 
-        case ATTR_TYPE_CLUSTER_LIST : // Cluster List (RFC 4456)
-            // According to RFC 4456, the value is a sequence of cluster id's
-            for (int i=0; i < attr_len; i += 4) {
-                memcpy(ipv4_raw, data, 4);
-                data += 4;
-                inet_ntop(AF_INET, ipv4_raw, ipv4_char, sizeof(ipv4_char));
-                decodeStr.append(ipv4_char);
-                decodeStr.append(" ");
-            }
-
-            parsed_data.attrs[ATTR_TYPE_CLUSTER_LIST] = decodeStr;
-            break;
-
-        case ATTR_TYPE_COMMUNITIES : // Community list
-        {
-            for (int i = 0; i < attr_len; i += 4) {
-                std::ostringstream numString;
-
-                // Add space between entries
-                if (i)
-                    decodeStr.append(" ");
-
-                // Add entry
-                memcpy(&value16bit, data, 2);
-                data += 2;
-                bgp::SWAP_BYTES(&value16bit);
-                numString << value16bit;
-                numString << ":";
-
-                memcpy(&value16bit, data, 2);
-                data += 2;
-                bgp::SWAP_BYTES(&value16bit);
-                numString << value16bit;
-                decodeStr.append(numString.str());
-            }
-
-            parsed_data.attrs[ATTR_TYPE_COMMUNITIES] = decodeStr;
-
-            break;
-        }
-        case ATTR_TYPE_EXT_COMMUNITY : // extended community list (RFC 4360)
-        {
-            ExtCommunity ec(logger, peer_addr, debug);
-            ec.parseExtCommunities(attr_len, data, parsed_data);
-            break;
-        }
-
         case ATTR_TYPE_IPV6_EXT_COMMUNITY : // IPv6 specific extended community list (RFC 5701)
         {
             ExtCommunity ec6(logger, peer_addr, debug);
@@ -477,45 +403,6 @@ void UpdateMsg::parseAttrData(u_char attr_type, uint16_t attr_len, u_char *data,
             break;
         }
 
-        case ATTR_TYPE_LARGE_COMMUNITY: {
-            // RFC8092
-            if (attr_len >= 12) {
-                for (int i = 0; i < attr_len; i += 12) {
-                    std::ostringstream numString;
-
-                    // Add space between entries
-                    if (i)
-                        decodeStr.append(" ");
-
-                    // Global Administrator
-                    memcpy(&value32bit, data, 4);
-                    data += 4;
-                    bgp::SWAP_BYTES(&value32bit);
-                    numString << value32bit;
-                    numString << ":";
-
-                    // Local Data Part 1
-                    memcpy(&value32bit, data, 4);
-                    data += 4;
-                    bgp::SWAP_BYTES(&value32bit);
-                    numString << value32bit;
-                    numString << ":";
-
-                    // Local Data Part 2
-                    memcpy(&value32bit, data, 4);
-                    data += 4;
-                    bgp::SWAP_BYTES(&value32bit);
-                    numString << value32bit;
-
-                    decodeStr.append(numString.str());
-                }
-
-                parsed_data.attrs[ATTR_TYPE_LARGE_COMMUNITY] = decodeStr;
-            }
-
-            break;
-        }
-
         default:
             LOG_INFO("%s: rtr=%s: attribute type %d is not yet implemented or intentionally ignored, skipping for now.",
                     peer_addr.c_str(), router_addr.c_str(), attr_type);
@@ -531,50 +418,41 @@ void UpdateMsg::parseAttrData(u_char attr_type, uint16_t attr_len, u_char *data,
  * \param [in]   data           Pointer to the attribute data
  * \param [out]  attrs          Reference to the parsed attr map - will be updated
  */
-void UpdateMsg::parseAttr_Aggegator(uint16_t attr_len, u_char *data, parsed_attrs_map &attrs) {
-    std::string decodeStr;
+void UpdateMsg::parseAttr_Aggegator(uint16_t attr_len, u_char *data, parsed_attrs &attrs) {
     uint32_t    value32bit = 0;
     uint16_t    value16bit = 0;
-    u_char      ipv4_raw[4];
-    char        ipv4_char[16];
 
     // If using RFC6793, the len will be 8 instead of 6
      if (attr_len == 8) { // RFC6793 ASN of 4 octets
          memcpy(&value32bit, data, 4); data += 4;
          bgp::SWAP_BYTES(&value32bit);
-         std::ostringstream numString;
-         numString << value32bit;
-         decodeStr.assign(numString.str());
+         attrs.aggregator_asn = value32bit;
 
      } else if (attr_len == 6) {
          memcpy(&value16bit, data, 2); data += 2;
          bgp::SWAP_BYTES(&value16bit);
-         std::ostringstream numString;
-         numString << value16bit;
-         decodeStr.assign(numString.str());
+         attrs.aggregator_asn = value16bit;
 
      } else {
          LOG_ERR("%s: rtr=%s: path attribute is not the correct size of 6 or 8 octets.", peer_addr.c_str(), router_addr.c_str());
          return;
      }
 
-     decodeStr.append(" ");
-     memcpy(ipv4_raw, data, 4);
-     inet_ntop(AF_INET, ipv4_raw, ipv4_char, sizeof(ipv4_char));
-     decodeStr.append(ipv4_char);
-
-     attrs[ATTR_TYPE_AGGEGATOR] = decodeStr;
+     memcpy(attrs.aggregator_ip, data, 4);
+     attrs.aggregator_valid = true;
 }
 
 /**
  * Parse attribute AS_PATH data
  *
+ * \details The path is validated and the count and origin AS are updated.  The printed form of the
+ *      path is rendered by renderAsPath() using the ASN size found here.
+ *
  * \param [in]   attr_len       Length of the attribute data
  * \param [in]   data           Pointer to the attribute data
- * \param [out]  attrs          Reference to the parsed attr map - will be updated
+ * \param [out]  attrs          Reference to the parsed attributes - will be updated
  */
-void UpdateMsg::parseAttr_AsPath(uint16_t attr_len, u_char *data, parsed_attrs_map &attrs) {
-    std::string decoded_path;
+void UpdateMsg::parseAttr_AsPath(uint16_t attr_len, u_char *data, parsed_attrs &attrs) {
     int         path_len    = attr_len;
     uint16_t    as_path_cnt = 0;
 
@@ -584,6 +462,9 @@ void UpdateMsg::parseAttr_AsPath(uint16_t attr_len, u_char *data, parsed_attrs_m
 
     u_char *data_ptr = data;
 
+    // Path is only present once it has been validated
+    attrs.present.reset(ATTR_TYPE_AS_PATH);
+
     /*
      * We first must try to parse using four octet since the RFC says that the peer header
      *     defines the encoding and not the capabilities.  four_octet_asn represents
@@ -603,10 +484,6 @@ void UpdateMsg::parseAttr_AsPath(uint16_t attr_len, u_char *data, parsed_attrs_m
         seg_len  = *data++;                  // Count of AS's, not bytes
         path_len -= 2;
 
-        if (seg_type == 1) {                 // If AS-SET open with a brace
-            decoded_path.append(" {");
-        }
-
         SELF_DEBUG("%s: rtr=%s: as_path seg_len = %d seg_type = %d, path_len = %d total_len = %d as_octet_size = %d",
                    peer_addr.c_str(), router_addr.c_str(),
                    seg_len, seg_type, path_len, attr_len, asn_octet_size);
@@ -628,48 +505,153 @@ void UpdateMsg::parseAttr_AsPath(uint16_t attr_len, u_char *data, parsed_attrs_m
         }
 
         // The rest of the data is the as path sequence, in blocks of 2 or 4 bytes
-        for (; seg_len > 0; seg_len--) {
+        if (seg_len > 0) {
+            data += (seg_len - 1) * asn_octet_size;
             seg_asn = 0;
             memcpy(&seg_asn, data, asn_octet_size);  data += asn_octet_size;
-            path_len -= asn_octet_size;                               // Adjust the path length for what was read
-
             bgp::SWAP_BYTES(&seg_asn, asn_octet_size);
-            decoded_path.append(" ");
-            std::ostringstream numString;
-            numString << seg_asn;
-            decoded_path.append(numString.str());
 
-            // Increase the as path count
-            ++as_path_cnt;
-        }
-
-        if (seg_type == 1) {            // If AS-SET close with a brace
-            decoded_path.append(" }");
+            path_len -= seg_len * asn_octet_size;     // Adjust the path length for what was read
+            as_path_cnt += seg_len;                   // Increase the as path count
         }
     }
 
-    SELF_DEBUG("%s: rtr=%s: Parsed AS_PATH count %hu : %s", peer_addr.c_str(), router_addr.c_str(), as_path_cnt, decoded_path.c_str());
+    SELF_DEBUG("%s: rtr=%s: Parsed AS_PATH count %hu", peer_addr.c_str(), router_addr.c_str(), as_path_cnt);
 
     /*
-     * Update the attributes map
+     * Update the attributes
      */
-    attrs[ATTR_TYPE_AS_PATH] = decoded_path;
+    attrs.set(ATTR_TYPE_AS_PATH, data_ptr, attr_len);
+    attrs.as_path_octets = asn_octet_size;
+    attrs.as_path_count = as_path_cnt;
+    attrs.origin_as = seg_asn;                  // The last ASN is the origin
+}
 
-    {
-        std::ostringstream numString;
-        numString << as_path_cnt;
-        attrs[ATTR_TYPE_INTERNAL_AS_COUNT] = numString.str();
+/**
+ * Render the AS_PATH attribute in printed form
+ *
+ * \param [in]   attrs          Reference to the parsed attributes
+ * \param [out]  decoded        Printed form of the AS path, empty if not present
+ */
+void UpdateMsg::renderAsPath(const parsed_attrs &attrs, std::string &decoded) {
+    char        buf[16];
+    uint32_t    seg_asn;
+
+    decoded.clear();
+
+    if (not attrs.has(ATTR_TYPE_AS_PATH))
+        return;
+
+    u_char *data    = attrs.raw[ATTR_TYPE_AS_PATH].data;
+    int    path_len = attrs.raw[ATTR_TYPE_AS_PATH].len;
+
+    while (path_len > 0) {
+        u_char seg_type = *data++;
+        u_char seg_len  = *data++;
+        path_len -= 2 + seg_len * attrs.as_path_octets;
+
+        if (seg_type == 1)                  // If AS-SET open with a brace
+            decoded.append(" {");
+
+        for (; seg_len > 0; seg_len--) {
+            seg_asn = 0;
+            memcpy(&seg_asn, data, attrs.as_path_octets);  data += attrs.as_path_octets;
+            bgp::SWAP_BYTES(&seg_asn, attrs.as_path_octets);
+
+            decoded.append(buf, snprintf(buf, sizeof(buf), " %u", seg_asn));
+        }
+
+        if (seg_type == 1)                  // If AS-SET close with a brace
+            decoded.append(" }");
     }
+}
 
-    /*
-     * Get the last ASN and update the attributes map
-     */
-    {
-        std::ostringstream numString;
-        numString << seg_asn;
-        attrs[ATTR_TYPE_INTERNAL_AS_ORIGIN] = numString.str();
+/**
+ * Render the COMMUNITIES attribute in printed form
+ *
+ * \param [in]   attrs          Reference to the parsed attributes
+ * \param [out]  decoded        Space delimited list of communities, empty if not present
+ */
+void UpdateMsg::renderCommunities(const parsed_attrs &attrs, std::string &decoded) {
+    char        buf[16];
+    uint16_t    high, low;
+
+    decoded.clear();
+
+    if (not attrs.has(ATTR_TYPE_COMMUNITIES))
+        return;
+
+    const attr_span &attr = attrs.raw[ATTR_TYPE_COMMUNITIES];
+
+    for (int i = 0; i + 4 <= attr.len; i += 4) {
+        memcpy(&high, attr.data + i, 2);
+        memcpy(&low, attr.data + i + 2, 2);
+        bgp::SWAP_BYTES(&high);
+        bgp::SWAP_BYTES(&low);
+
+        // Add space between entries
+        if (i)
+            decoded.append(" ");
+
+        decoded.append(buf, snprintf(buf, sizeof(buf), "%hu:%hu", high, low));
     }
+}
+
+/**
+ * Render the LARGE_COMMUNITY attribute in printed form
+ *
+ * \param [in]   attrs          Reference to the parsed attributes
+ * \param [out]  decoded        Space delimited list of large communities, empty if not present
+ */
+void UpdateMsg::renderLargeCommunities(const parsed_attrs &attrs, std::string &decoded) {
+    char        buf[40];
+    uint32_t    global_admin, local_1, local_2;
+
+    decoded.clear();
 
+    if (not attrs.has(ATTR_TYPE_LARGE_COMMUNITY))
+        return;
+
+    const attr_span &attr = attrs.raw[ATTR_TYPE_LARGE_COMMUNITY];
+
+    for (int i = 0; i + 12 <= attr.len; i += 12) {
+        memcpy(&global_admin, attr.data + i, 4);
+        memcpy(&local_1, attr.data + i + 4, 4);
+        memcpy(&local_2, attr.data + i + 8, 4);
+        bgp::SWAP_BYTES(&global_admin);
+        bgp::SWAP_BYTES(&local_1);
+        bgp::SWAP_BYTES(&local_2);
+
+        // Add space between entries
+        if (i)
+            decoded.append(" ");
+
+        decoded.append(buf, snprintf(buf, sizeof(buf), "%u:%u:%u", global_admin, local_1, local_2));
+    }
+}
+
+/**
+ * Render the CLUSTER_LIST attribute in printed form
+ *
+ * \param [in]   attrs          Reference to the parsed attributes
+ * \param [out]  decoded        Space delimited list of cluster id's, empty if not present
+ */
+void UpdateMsg::renderClusterList(const parsed_attrs &attrs, std::string &decoded) {
+    char        ipv4_char[16];
+
+    decoded.clear();
+
+    if (not attrs.has(ATTR_TYPE_CLUSTER_LIST))
+        return;
+
+    const attr_span &attr = attrs.raw[ATTR_TYPE_CLUSTER_LIST];
+
+    // According to RFC 4456, the value is a sequence of cluster id's
+    for (int i = 0; i + 4 <= attr.len; i += 4) {
+        inet_ntop(AF_INET, attr.data + i, ipv4_char, sizeof(ipv4_char));
+        decoded.append(ipv4_char);
+        decoded.append(" ");
+    }
 }
 
 } /* namespace bgp_msg */
@@ -16,9 +16,12 @@
 #include "AddPathDataContainer.h"
 
 #include <string>
+#include <cstring>
 #include <list>
+#include <vector>
 #include <array>
 #include <map>
+#include <bitset>
 #include <bmp/BMPReader.h>
 
 namespace bgp_msg {
@@ -113,11 +116,76 @@ public:
     };
 
     /**
-     * parsed path attributes map
+     * View of raw attribute data in the update message
      */
-    std::map<bgp_msg::UPDATE_ATTR_TYPES, std::string>            parsed_attrs;
-    typedef std::pair<bgp_msg::UPDATE_ATTR_TYPES, std::string>   parsed_attrs_pair;
-    typedef std::map<bgp_msg::UPDATE_ATTR_TYPES, std::string>    parsed_attrs_map;
+    struct attr_span {
+        u_char          *data;              ///< Pointer to the attribute data
+        uint16_t        len;                ///< Length of the attribute data in bytes
+    };
+
+    /**
+     * Parsed path attributes - typed fixed slot record
+     *
+     * \details Fixed size attributes are stored in binary form.  The raw data of every attribute
+     *      is kept as a view, indexed by attribute type, into the update message. Views are only
+     *      valid while the update message data is valid.  Text is not rendered while parsing,
+     *      it is rendered when the attributes are added to the message bus.
+     */
+    struct parsed_attrs {
+        std::bitset<256>    present;            ///< Attribute types present, indexed by attribute type
+        attr_span           raw[256];           ///< Raw attribute data indexed by attribute type
+
+        uint8_t             origin;             ///< ORIGIN code (0=igp, 1=egp, 2=incomplete)
+        uint32_t            med;                ///< MED value
+        uint32_t            local_pref;         ///< LOCAL_PREF value
+
+        uint8_t             as_path_octets;     ///< ASN size in bytes used to decode the AS_PATH
+        uint16_t            as_path_count;      ///< Internal - number of ASN's in the AS_PATH
+        uint32_t            origin_as;          ///< Internal - AS that originated the entry
+
+        bool                nexthop_isIPv4;     ///< True if the next-hop is IPv4, false if IPv6
+        u_char              next_hop[16];       ///< Next-hop address, IPv4 uses the first 4 bytes
+
+        bool                aggregator_valid;   ///< True if the AGGREGATOR attribute was decoded
+        uint32_t            aggregator_asn;     ///< AGGREGATOR ASN
+        u_char              aggregator_ip[4];   ///< AGGREGATOR IPv4 address
+
+        /**
+         * Check if an attribute type is present
+         */
+        inline bool has(UPDATE_ATTR_TYPES type) const {
+            return type < 256 and present.test(type);
+        }
+
+        /**
+         * Record the raw data of an attribute
+         */
+        inline void set(u_char type, u_char *data, uint16_t len) {
+            present.set(type);
+            raw[type].data = data;
+            raw[type].len  = len;
+        }
+
+        /**
+         * Set the next-hop address
+         */
+        inline void setNextHop(u_char *addr, uint16_t len, bool isIPv4) {
+            bzero(next_hop, sizeof(next_hop));
+            memcpy(next_hop, addr, len > sizeof(next_hop) ? sizeof(next_hop) : len);
+            nexthop_isIPv4 = isIPv4;
+            set(ATTR_TYPE_NEXT_HOP, addr, len);
+        }
+
+        /**
+         * Clear the record for the next update
+         */
+        inline void reset() {
+            present.reset();
+            as_path_count = 0;
+            origin_as = 0;
+            aggregator_valid = false;
+        }
+    };
 
     // Parsed bgp-ls attributes map
     typedef  std::map<uint16_t, std::array<uint8_t, 255>>        parsed_ls_attrs_map;
@@ -135,16 +203,39 @@ public:
      * Parsed update data - decoded data from complete update parse
      */
     struct parsed_update_data {
-        parsed_attrs_map              attrs;              ///< Parsed attrbutes
-        std::list<bgp::prefix_tuple>  withdrawn;          ///< List of withdrawn prefixes
-        std::list<bgp::prefix_tuple>  advertised;         ///< List of advertised prefixes
-        parsed_ls_attrs_map           ls_attrs;           ///< BGP-LS specific attributes
-        parsed_data_ls                ls;                 ///< REACH: Link state parsed data
-        parsed_data_ls                ls_withdrawn;       ///< UNREACH: Parsed Withdrawn data
-        std::list<bgp::vpn_tuple>     vpn;                ///< List of vpn prefixes advertised
-        std::list<bgp::vpn_tuple>     vpn_withdrawn;      ///< List of vpn prefixes withdrawn
-        std::list<bgp::evpn_tuple>    evpn;               ///< List of evpn nlris advertised
-        std::list<bgp::evpn_tuple>    evpn_withdrawn;     ///< List of evpn nlris withdrawn
+        parsed_attrs                  attrs;              ///< Parsed attrbutes
+        std::vector<bgp::prefix_tuple>  withdrawn;        ///< Batch of withdrawn prefixes
+        std::vector<bgp::prefix_tuple>  advertised;       ///< Batch of advertised prefixes
+        parsed_ls_attrs_map             ls_attrs;         ///< BGP-LS specific attributes
+        parsed_data_ls                  ls;               ///< REACH: Link state parsed data
+        parsed_data_ls                  ls_withdrawn;     ///< UNREACH: Parsed Withdrawn data
+        std::vector<bgp::vpn_tuple>     vpn;              ///< Batch of vpn prefixes advertised
+        std::vector<bgp::vpn_tuple>     vpn_withdrawn;    ///< Batch of vpn prefixes withdrawn
+        std::vector<bgp::evpn_tuple>    evpn;             ///< Batch of evpn nlris advertised
+        std::vector<bgp::evpn_tuple>    evpn_withdrawn;   ///< Batch of evpn nlris withdrawn
+
+        /**
+         * Clear the parsed data for the next update
+         *
+         * \details The prefix batches keep their capacity so that they can be reused
+         *      without allocating for every update.
+         */
+        void clear() {
+            attrs.reset();
+            withdrawn.clear();
+            advertised.clear();
+            ls_attrs.clear();
+            ls.nodes.clear();
+            ls.links.clear();
+            ls.prefixes.clear();
+            ls_withdrawn.nodes.clear();
+            ls_withdrawn.links.clear();
+            ls_withdrawn.prefixes.clear();
+            vpn.clear();
+            vpn_withdrawn.clear();
+            evpn.clear();
+            evpn_withdrawn.clear();
+        }
     };
 
 
@@ -178,6 +269,38 @@ public:
       */
      size_t parseUpdateMsg(u_char *data, size_t size, parsed_update_data &parsed_data);
 
+     /**
+      * Render the AS_PATH attribute in printed form
+      *
+      * \param [in]   attrs          Reference to the parsed attributes
+      * \param [out]  decoded        Printed form of the AS path, empty if not present
+      */
+     static void renderAsPath(const parsed_attrs &attrs, std::string &decoded);
+
+     /**
+      * Render the COMMUNITIES attribute in printed form
+      *
+      * \param [in]   attrs          Reference to the parsed attributes
+      * \param [out]  decoded        Space delimited list of communities, empty if not present
+      */
+     static void renderCommunities(const parsed_attrs &attrs, std::string &decoded);
+
+     /**
+      * Render the LARGE_COMMUNITY attribute in printed form
+      *
+      * \param [in]   attrs          Reference to the parsed attributes
+      * \param [out]  decoded        Space delimited list of large communities, empty if not present
+      */
+     static void renderLargeCommunities(const parsed_attrs &attrs, std::string &decoded);
+
+     /**
+      * Render the CLUSTER_LIST attribute in printed form
+      *
+      * \param [in]   attrs          Reference to the parsed attributes
+      * \param [out]  decoded        Space delimited list of cluster id's, empty if not present
+      */
+     static void renderClusterList(const parsed_attrs &attrs, std::string &decoded);
+
 
 private:
     bool                    debug;                           ///< debug flag to indicate debugging
@@ -197,9 +320,9 @@ private:
      *
      * \param [in]   data       Pointer to the start of the prefixes to be parsed
      * \param [in]   len        Length of the data in bytes to be read
-     * \param [out]  prefixes   Reference to a list<prefix_tuple> to be updated with entries
+     * \param [out]  prefixes   Reference to a prefix batch to be updated with entries
      */
-    void parseNlriData_v4(u_char *data, uint16_t len, std::list<bgp::prefix_tuple> &prefixes);
+    void parseNlriData_v4(u_char *data, uint16_t len, std::vector<bgp::prefix_tuple> &prefixes);
 
     /**
      * Parses the BGP attributes in the update
@@ -232,18 +355,18 @@ private:
      *
      * \param [in]   attr_len       Length of the attribute data
      * \param [in]   data           Pointer to the attribute data
-     * \param [out]  attrs          Reference to the parsed attr map - will be updated
+     * \param [out]  attrs          Reference to the parsed attributes - will be updated
      */
-    void parseAttr_AsPath(uint16_t attr_len, u_char *data, parsed_attrs_map &attrs);
+    void parseAttr_AsPath(uint16_t attr_len, u_char *data, parsed_attrs &attrs);
 
     /**
      * Parse attribute AGGEGATOR data
      *
      * \param [in]   attr_len       Length of the attribute data
      * \param [in]   data           Pointer to the attribute data
-     * \param [out]  attrs          Reference to the parsed attr map - will be updated
+     * \param [out]  attrs          Reference to the parsed attributes - will be updated
      */
-    void parseAttr_Aggegator(uint16_t attr_len, u_char *data, parsed_attrs_map &attrs);
+    void parseAttr_Aggegator(uint16_t attr_len, u_char *data, parsed_attrs &attrs);
 
 };
 
@@ -9,7 +9,7 @@
 #include <arpa/inet.h>
 
 #include "MPLinkState.h"
-#include "md5.h"
+#include "hash_id.h"
 
 namespace bgp_msg {
     /**
@@ -45,18 +45,7 @@ namespace bgp_msg {
 
         // Process the next hop
         // Next-hop is an IPv6 address - Change/set the next-hop attribute in parsed data to use this next-hop
-        u_char ip_raw[16];
-        char ip_char[40];
-
-        if (nlri.nh_len == 4) {
-            memcpy(ip_raw, nlri.next_hop, nlri.nh_len);
-            inet_ntop(AF_INET, ip_raw, ip_char, sizeof(ip_char));
-        } else if (nlri.nh_len > 4) {
-            memcpy(ip_raw, nlri.next_hop, nlri.nh_len);
-            inet_ntop(AF_INET6, ip_raw, ip_char, sizeof(ip_char));
-        }
-
-        parsed_data->attrs[ATTR_TYPE_NEXT_HOP] = std::string(ip_char);
+        parsed_data->attrs.setNextHop(nlri.next_hop, nlri.nh_len, nlri.nh_len == 4);
 
         /*
          * Decode based on SAFI
@@ -1026,7 +1015,7 @@ namespace bgp_msg {
      * \param [out]  hash_bin       Node descriptor information returned/updated
      */
     void MPLinkState::genNodeHashId(node_descriptor &info) {
-        MD5 hash;
+        HashId hash;
 
         hash.update(info.igp_router_id, sizeof(info.igp_router_id));
         hash.update((unsigned char *)&info.bgp_ls_id, sizeof(info.bgp_ls_id));
@@ -1035,9 +1024,7 @@ namespace bgp_msg {
         hash.finalize();
 
         // Save the hash
-        unsigned char *hash_bin = hash.raw_digest();
-        memcpy(info.hash_bin, hash_bin, 16);
-        delete[] hash_bin;
+        hash.raw_digest(info.hash_bin);
     }
 
 } /* namespace bgp_msg */
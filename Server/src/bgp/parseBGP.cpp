@@ -28,6 +28,7 @@
 #include "NotificationMsg.h"
 #include "OpenMsg.h"
 #include "UpdateMsg.h"
+#include "ExtCommunity.h"
 #include "bgp_common.h"
 
 using namespace std;
@@ -53,6 +54,25 @@ parseBGP::parseBGP(Logger *logPtr, MsgBusInterface *mbus_ptr, MsgBusInterface::o
 
     logger = logPtr;
 
+    // Set our peer entry
+    p_entry = peer_entry;
+
+    router_addr = routerAddr;
+
+    update_data.advertised.reserve(BGP_PREFIX_BATCH_RESERVE);
+    update_data.withdrawn.reserve(BGP_PREFIX_BATCH_RESERVE);
+    rib_list.reserve(BGP_PREFIX_BATCH_RESERVE);
+
+    reset(mbus_ptr, peer_info);
+}
+
+/**
+ * Reset the parser for the next BGP message
+ *
+ * \param [in]     mbus_ptr     Pointer to exiting dB implementation
+ * \param [in,out] peer_info   Persistent peer information
+ */
+void parseBGP::reset(MsgBusInterface *mbus_ptr, BMPReader::peer_info *peer_info) {
     data_bytes_remaining = 0;
     data = NULL;
 
@@ -61,11 +81,7 @@ parseBGP::parseBGP(Logger *logPtr, MsgBusInterface *mbus_ptr, MsgBusInterface::o
     // Set our mysql pointer
     this->mbus_ptr = mbus_ptr;
 
-    // Set our peer entry
-    p_entry = peer_entry;
     p_info = peer_info;
-
-    router_addr = routerAddr;
 }
 
 /**
@@ -85,18 +101,17 @@ parseBGP::~parseBGP() {
  * \returns True if error, false if no error.
  */
 bool parseBGP::handleUpdate(u_char *data, size_t size) {
-    bgp_msg::UpdateMsg::parsed_update_data parsed_data;
     int read_size = 0;
 
     if (parseBgpHeader(data, size) == BGP_MSG_UPDATE) {
         data += BGP_MSG_HDR_LEN;
 
         /*
-         * Parse the update message - stored results will be in parsed_data
+         * Parse the update message - stored results will be in update_data
          */
         bgp_msg::UpdateMsg uMsg(logger, p_entry->peer_addr, router_addr, p_info, debug);
 
-        if ((read_size=uMsg.parseUpdateMsg(data, data_bytes_remaining, parsed_data)) != (size - BGP_MSG_HDR_LEN)) {
+        if ((read_size=uMsg.parseUpdateMsg(data, data_bytes_remaining, update_data)) != (size - BGP_MSG_HDR_LEN)) {
             LOG_NOTICE("%s: rtr=%s: Failed to parse the update message, read %d expected %d", p_entry->peer_addr,
                         router_addr.c_str(), read_size, (size - read_size));
             return true;
@@ -107,7 +122,7 @@ bool parseBGP::handleUpdate(u_char *data, size_t size) {
         /*
          * Update the DB with the update data
          */
-        UpdateDB(parsed_data);
+        UpdateDB(update_data);
     }
 
     return false;
@@ -127,10 +142,11 @@ bool parseBGP::handleUpdate(u_char *data, size_t size) {
  * \returns True if error, false if no error.
  */
 bool parseBGP::handleDownEvent(u_char *data, size_t size, MsgBusInterface::obj_peer_down_event &down_event) {
-    bool        rval;
+    bool        rval = true;
+    u_char      type = parseBgpHeader(data, size);
 
     // Process the BGP message normally
-    if (parseBgpHeader(data, size) == BGP_MSG_NOTIFICATION) {
+    if (type == BGP_MSG_NOTIFICATION) {
         data += BGP_MSG_HDR_LEN;
 
         bgp_msg::parsed_notify_msg parsed_msg;
@@ -147,6 +163,11 @@ bool parseBGP::handleDownEvent(u_char *data, size_t size, MsgBusInterface::obj_p
             strncpy(down_event.error_text, parsed_msg.error_text, sizeof(down_event.error_text));
         }
     }
+    else if (type == 0) {
+        // Invalid BGP message - the down event is kept without the notification
+        LOG_NOTICE("%s: rtr=%s: Skipping invalid BGP notification of the down event",
+                   p_entry->peer_addr, router_addr.c_str());
+    }
     else {
         LOG_ERR("%s: rtr=%s: BGP message type is not a BGP notification, cannot parse the notification",
                 p_entry->peer_addr, router_addr.c_str());
@@ -165,7 +186,7 @@ bool parseBGP::handleDownEvent(u_char *data, size_t size, MsgBusInterface::obj_p
  * \param [in]     data             Pointer to the raw BGP message header
  * \param [in]     size             length of the data buffer (used to prevent overrun)
  *
- * \returns size of data read from buffer, zero if error
+ * \returns size of data read from buffer, zero if the open messages are invalid
  */
 int parseBGP::handleUpEvent(u_char *data, size_t size, MsgBusInterface::obj_peer_up_event *up_event) {
     bgp_msg::OpenMsg    oMsg(logger, p_entry->peer_addr, this->p_info, debug);
@@ -173,6 +194,8 @@ int parseBGP::handleUpEvent(u_char *data, size_t size, MsgBusInterface::obj_peer
     string              local_bgp_id, remote_bgp_id;
     size_t              read_size;
     int                 total_read_size = 0;
+    u_char              *start = data;
+    u_char              type;
 
     p_info->recv_four_octet_asn = false;
     p_info->sent_four_octet_asn = false;
@@ -183,7 +206,10 @@ int parseBGP::handleUpEvent(u_char *data, size_t size, MsgBusInterface::obj_peer
     /*
      * Process the sent open message
      */
-    if (parseBgpHeader(data, size) == BGP_MSG_OPEN) {
+    if ((type = parseBgpHeader(data, size)) == 0)
+        return 0;
+
+    if (type == BGP_MSG_OPEN) {
         data += BGP_MSG_HDR_LEN;
 
         read_size = oMsg.parseOpenMsg(data, data_bytes_remaining, true, up_event->local_asn, up_event->local_hold_time,
@@ -228,7 +254,10 @@ int parseBGP::handleUpEvent(u_char *data, size_t size, MsgBusInterface::obj_peer
      */
     cap_list.clear();
 
-    if (parseBgpHeader(data, size) == BGP_MSG_OPEN) {
+    if ((type = parseBgpHeader(data, size - (data - start))) == 0)
+        return 0;
+
+    if (type == BGP_MSG_OPEN) {
         data += BGP_MSG_HDR_LEN;
 
         read_size = oMsg.parseOpenMsg(data, data_bytes_remaining, false, up_event->remote_asn,
@@ -283,7 +312,7 @@ int parseBGP::handleUpEvent(u_char *data, size_t size, MsgBusInterface::obj_peer
  * \param [in]      data            Pointer to the raw BGP message header
  * \param [in]      size            length of the data buffer (used to prevent overrun)
  *
- * \returns BGP message type
+ * \returns BGP message type, zero if the message is invalid and must be skipped
  */
 u_char parseBGP::parseBgpHeader(u_char *data, size_t size) {
     bzero(&common_hdr, sizeof(common_hdr));
@@ -302,18 +331,20 @@ u_char parseBGP::parseBgpHeader(u_char *data, size_t size) {
     // Change length to host byte order
     bgp::SWAP_BYTES(&common_hdr.len);
 
-    // Update remaining bytes left of the message
-    data_bytes_remaining = common_hdr.len - BGP_MSG_HDR_LEN;
-
     /*
-     * Error out if the remaining size of the BGP message is grater than passed bgp message buffer
-     *      It is expected that the passed bgp message buffer holds the complete BGP message to be parsed
+     * Error out if the size of the BGP message is invalid or greater than passed bgp message buffer
+     *      It is expected that the passed bgp message buffer holds the complete BGP message to be parsed.
+     *      The buffer is the exact size of the BMP message, so the message cannot be parsed past it.
      */
-    if (common_hdr.len > size) {
-        LOG_WARN("%s: rtr=%s: BGP message size of %hu is greater than passed data buffer, cannot parse the BGP message",
+    if (common_hdr.len < BGP_MSG_HDR_LEN or common_hdr.len > size) {
+        LOG_WARN("%s: rtr=%s: BGP message size of %hu is invalid for passed data buffer of %lu, cannot parse the BGP message",
                 p_entry->peer_addr, router_addr.c_str(), common_hdr.len, size);
+        return 0;
     }
 
+    // Update remaining bytes left of the message
+    data_bytes_remaining = common_hdr.len - BGP_MSG_HDR_LEN;
+
     SELF_DEBUG("%s: rtr=%s: BGP hdr len = %u, type = %d", p_entry->peer_addr, router_addr.c_str(), common_hdr.len, common_hdr.type);
 
     /*
@@ -361,13 +392,13 @@ void parseBGP::UpdateDB(bgp_msg::UpdateMsg::parsed_update_data &parsed_data) {
     /*
      * Update the advertised prefixes (both ipv4 and ipv6)
      */
-    UpdateDBAdvPrefixes(parsed_data.advertised, parsed_data.attrs);
+    UpdateDBAdvPrefixes(parsed_data.advertised);
 
-    UpdateDBL3Vpn(false,parsed_data.vpn, parsed_data.attrs);
-    UpdateDBL3Vpn(true,parsed_data.vpn_withdrawn, parsed_data.attrs);
+    UpdateDBL3Vpn(false,parsed_data.vpn);
+    UpdateDBL3Vpn(true,parsed_data.vpn_withdrawn);
 
-    UpdateDBeVPN(false, parsed_data.evpn, parsed_data.attrs);
-    UpdateDBeVPN(true, parsed_data.evpn_withdrawn, parsed_data.attrs);
+    UpdateDBeVPN(false, parsed_data.evpn);
+    UpdateDBeVPN(true, parsed_data.evpn_withdrawn);
 
     /*
      * Update withdraws (both ipv4 and ipv6)
@@ -381,67 +412,62 @@ void parseBGP::UpdateDB(bgp_msg::UpdateMsg::parsed_update_data &parsed_data) {
  *
  * \details This method will update the database for the supplied path attributes
  *
- * \param  attrs            Reference to the parsed attributes map
+ * \param  attrs            Reference to the parsed attributes
  */
-void parseBGP::UpdateDBAttrs(bgp_msg::UpdateMsg::parsed_attrs_map &attrs) {
+void parseBGP::UpdateDBAttrs(bgp_msg::UpdateMsg::parsed_attrs &attrs) {
 
     /*
-     * Setup the record
+     * Setup the record - text is rendered from the binary attributes here
      */
-    base_attr.as_path                  = (string)attrs[bgp_msg::ATTR_TYPE_AS_PATH];
-    base_attr.cluster_list             = (string)attrs[bgp_msg::ATTR_TYPE_CLUSTER_LIST];
-    base_attr.community_list           = (string)attrs[bgp_msg::ATTR_TYPE_COMMUNITIES];
-    base_attr.ext_community_list       = (string)attrs[bgp_msg::ATTR_TYPE_EXT_COMMUNITY];
-    base_attr.large_community_list     = (string)attrs[bgp_msg::ATTR_TYPE_LARGE_COMMUNITY];
-
-    base_attr.atomic_agg               = ((string)attrs[bgp_msg::ATTR_TYPE_ATOMIC_AGGREGATE]).compare("1") == 0 ? true : false;
-
-    if (((string)attrs[bgp_msg::ATTR_TYPE_LOCAL_PREF]).length() > 0)
-        base_attr.local_pref = std::stoul(((string)attrs[bgp_msg::ATTR_TYPE_LOCAL_PREF]));
-    else
-        base_attr.local_pref = 0;
-
-    if (((string)attrs[bgp_msg::ATTR_TYPE_MED]).length() > 0)
-        base_attr.med = std::stoul(((string)attrs[bgp_msg::ATTR_TYPE_MED]));
-    else
-        base_attr.med = 0;
-
-    if (((string)attrs[bgp_msg::ATTR_TYPE_INTERNAL_AS_COUNT]).length() > 0)
-        base_attr.as_path_count = std::stoi(((string)attrs[bgp_msg::ATTR_TYPE_INTERNAL_AS_COUNT]));
-    else
-        base_attr.as_path_count = 0;
-
-    if (((string)attrs[bgp_msg::ATTR_TYPE_INTERNAL_AS_ORIGIN]).length() > 0)
-        base_attr.origin_as = std::stoul(((string)attrs[bgp_msg::ATTR_TYPE_INTERNAL_AS_ORIGIN]));
-    else
-        base_attr.origin_as = 0;
-
-    if (((string)attrs[bgp_msg::ATTR_TYPE_ORIGINATOR_ID]).length() > 0)
-        strncpy(base_attr.originator_id, ((string)attrs[bgp_msg::ATTR_TYPE_ORIGINATOR_ID]).c_str(), sizeof(base_attr.originator_id));
+    bgp_msg::UpdateMsg::renderAsPath(attrs, base_attr.as_path);
+    bgp_msg::UpdateMsg::renderClusterList(attrs, base_attr.cluster_list);
+    bgp_msg::UpdateMsg::renderCommunities(attrs, base_attr.community_list);
+    bgp_msg::UpdateMsg::renderLargeCommunities(attrs, base_attr.large_community_list);
+
+    if (attrs.has(bgp_msg::ATTR_TYPE_EXT_COMMUNITY)) {
+        bgp_msg::ExtCommunity ec(logger, p_entry->peer_addr, debug);
+        ec.parseExtCommunities(attrs.raw[bgp_msg::ATTR_TYPE_EXT_COMMUNITY].len,
+                               attrs.raw[bgp_msg::ATTR_TYPE_EXT_COMMUNITY].data, base_attr.ext_community_list);
+    } else
+        base_attr.ext_community_list.clear();
+
+    base_attr.atomic_agg               = attrs.has(bgp_msg::ATTR_TYPE_ATOMIC_AGGREGATE);
+    base_attr.local_pref               = attrs.has(bgp_msg::ATTR_TYPE_LOCAL_PREF) ? attrs.local_pref : 0;
+    base_attr.med                      = attrs.has(bgp_msg::ATTR_TYPE_MED) ? attrs.med : 0;
+    base_attr.as_path_count            = attrs.as_path_count;
+    base_attr.origin_as                = attrs.origin_as;
+
+    if (attrs.has(bgp_msg::ATTR_TYPE_ORIGINATOR_ID) and attrs.raw[bgp_msg::ATTR_TYPE_ORIGINATOR_ID].len >= 4)
+        inet_ntop(AF_INET, attrs.raw[bgp_msg::ATTR_TYPE_ORIGINATOR_ID].data, base_attr.originator_id,
+                  sizeof(base_attr.originator_id));
     else
         bzero(base_attr.originator_id, sizeof(base_attr.originator_id));
 
-    if ( ((string)attrs[bgp_msg::ATTR_TYPE_NEXT_HOP]).find_first_of(':') ==  string::npos)
-        base_attr.nexthop_isIPv4 = true;
-    else // is IPv6
-        base_attr.nexthop_isIPv4 = false;
-
-    if ( ((string)attrs[bgp_msg::ATTR_TYPE_AGGEGATOR]).length() > 0)
-        strncpy(base_attr.aggregator, ((string)attrs[bgp_msg::ATTR_TYPE_AGGEGATOR]).c_str(), sizeof(base_attr.aggregator));
-    else
+    if (attrs.aggregator_valid) {
+        char ipv4_char[16];
+        inet_ntop(AF_INET, attrs.aggregator_ip, ipv4_char, sizeof(ipv4_char));
+        snprintf(base_attr.aggregator, sizeof(base_attr.aggregator), "%u %s", attrs.aggregator_asn, ipv4_char);
+    } else
         bzero(base_attr.aggregator, sizeof(base_attr.aggregator));
 
-    if ( ((string)attrs[bgp_msg::ATTR_TYPE_ORIGIN]).length() > 0)
-            strncpy(base_attr.origin, ((string)attrs[bgp_msg::ATTR_TYPE_ORIGIN]).c_str(), sizeof(base_attr.origin));
-    else
-        bzero(base_attr.origin, sizeof(base_attr.origin));
+    bzero(base_attr.origin, sizeof(base_attr.origin));
+    if (attrs.has(bgp_msg::ATTR_TYPE_ORIGIN)) {
+        switch (attrs.origin) {
+            case 0 : strncpy(base_attr.origin, "igp", sizeof(base_attr.origin)); break;
+            case 1 : strncpy(base_attr.origin, "egp", sizeof(base_attr.origin)); break;
+            case 2 : strncpy(base_attr.origin, "incomplete", sizeof(base_attr.origin)); break;
+        }
+    }
 
-    if ( ((string)attrs[bgp_msg::ATTR_TYPE_NEXT_HOP]).length() > 0)
-        strncpy(base_attr.next_hop, ((string)attrs[bgp_msg::ATTR_TYPE_NEXT_HOP]).c_str(), sizeof(base_attr.next_hop));
+    if (attrs.has(bgp_msg::ATTR_TYPE_NEXT_HOP)) {
+        base_attr.nexthop_isIPv4 = attrs.nexthop_isIPv4;
+        inet_ntop(attrs.nexthop_isIPv4 ? AF_INET : AF_INET6, attrs.next_hop, base_attr.next_hop,
+                  sizeof(base_attr.next_hop));
 
-    else {
+    } else {
         // Skip adding path attributes if next hop is missing
         SELF_DEBUG("%s: no next-hop, must be unreach; not sending attributes to message bus", p_entry->peer_addr);
+        base_attr.nexthop_isIPv4 = true;
         bzero(base_attr.next_hop, sizeof(base_attr.next_hop));
         bzero(path_hash_id, sizeof(path_hash_id));
         return;
@@ -462,101 +488,34 @@ void parseBGP::UpdateDBAttrs(bgp_msg::UpdateMsg::parsed_attrs_map &attrs) {
  * \details This method will update the database for the supplied advertised prefixes
  *
  * \param [in] remove          True if the records should be deleted, false if they are to be added/updated
- * \param [in] prefixes        Reference to the list<vpn_tuple> of advertised vpns
- * \param [in] attrs           Reference to the parsed attributes map
+ * \param [in] prefixes        Reference to the batch of advertised vpns
  */
-void parseBGP::UpdateDBL3Vpn(bool remove, std::list<bgp::vpn_tuple> &prefixes,
-                             bgp_msg::UpdateMsg::parsed_attrs_map &attrs) {
-    vector<MsgBusInterface::obj_vpn> rib_list;
-    MsgBusInterface::obj_vpn         rib_entry;
-    uint32_t                         value_32bit;
-    uint64_t                         value_64bit;
+void parseBGP::UpdateDBL3Vpn(bool remove, std::vector<bgp::vpn_tuple> &prefixes) {
+    if (prefixes.size() == 0)
+        return;
+
+    vpn_list.resize(prefixes.size());
 
     /*
      * Loop through all vpn and add/update them in the DB
      */
-    for (std::list<bgp::vpn_tuple>::iterator it = prefixes.begin();
-                                                it != prefixes.end();
-                                                it++) {
-        bgp::vpn_tuple &tuple = (*it);
-
-        memcpy(rib_entry.path_attr_hash_id, path_hash_id, sizeof(rib_entry.path_attr_hash_id));
-        memcpy(rib_entry.peer_hash_id, p_entry->hash_id, sizeof(rib_entry.peer_hash_id));
+    for (size_t i=0; i < prefixes.size(); i++) {
+        bgp::vpn_tuple &tuple = prefixes[i];
+        MsgBusInterface::obj_vpn &rib_entry = vpn_list[i];
 
         rib_entry.rd_type = tuple.rd_type;
         rib_entry.rd_assigned_number = tuple.rd_assigned_number;
         rib_entry.rd_administrator_subfield = tuple.rd_administrator_subfield;
 
-        strncpy(rib_entry.prefix, tuple.prefix.c_str(), sizeof(rib_entry.prefix));
-        
-        rib_entry.prefix_len = tuple.len;
-
-        snprintf(rib_entry.labels, sizeof(rib_entry.labels), "%s", tuple.labels.c_str());
-        
-        rib_entry.isIPv4 = tuple.isIPv4 ? 1 : 0;
-
-        memcpy(rib_entry.prefix_bin, tuple.prefix_bin, sizeof(rib_entry.prefix_bin));
-
-        // Add the ending IP for the prefix based on bits
-        if (rib_entry.isIPv4) {
-            if (tuple.len < 32) {
-                memcpy(&value_32bit, tuple.prefix_bin, 4);
-                bgp::SWAP_BYTES(&value_32bit);
-
-                value_32bit |= 0xFFFFFFFF >> tuple.len;
-                bgp::SWAP_BYTES(&value_32bit);
-                memcpy(rib_entry.prefix_bcast_bin, &value_32bit, 4);
-
-            } else
-                memcpy(rib_entry.prefix_bcast_bin, tuple.prefix_bin, sizeof(tuple.prefix_bin));
-
-        } else {
-            if (tuple.len < 128) {
-                if (tuple.len >= 64) {
-                    // High order bytes are left alone
-                    memcpy(rib_entry.prefix_bcast_bin, tuple.prefix_bin, 8);
-
-                    // Low order bytes are updated
-                    memcpy(&value_64bit, &tuple.prefix_bin[8], 8);
-                    bgp::SWAP_BYTES(&value_64bit);
-
-                    value_64bit |= 0xFFFFFFFFFFFFFFFF >> (tuple.len - 64);
-                    bgp::SWAP_BYTES(&value_64bit);
-                    memcpy(&rib_entry.prefix_bcast_bin[8], &value_64bit, 8);
-
-                } else {
-                    // Low order types are all ones
-                    value_64bit = 0xFFFFFFFFFFFFFFFF;
-                    memcpy(&rib_entry.prefix_bcast_bin[8], &value_64bit, 8);
-
-                    // High order bypes are updated
-                    memcpy(&value_64bit, tuple.prefix_bin, 8);
-                    bgp::SWAP_BYTES(&value_64bit);
-
-                    value_64bit |= 0xFFFFFFFFFFFFFFFF >> tuple.len;
-                    bgp::SWAP_BYTES(&value_64bit);
-                    memcpy(rib_entry.prefix_bcast_bin, &value_64bit, 8);
-                }
-            } else
-                memcpy(rib_entry.prefix_bcast_bin, tuple.prefix_bin, sizeof(tuple.prefix_bin));
-        }
-
-        rib_entry.path_id = tuple.path_id;
-        snprintf(rib_entry.labels, sizeof(rib_entry.labels), "%s", tuple.labels.c_str());
+        setRibPrefix(tuple, rib_entry);
 
         SELF_DEBUG("%s: %s vpn=%s len=%d", p_entry->peer_addr, remove ? "removing" : "adding",
                    rib_entry.prefix, rib_entry.prefix_len);
-
-        // Add entry to the list
-        rib_list.insert(rib_list.end(), rib_entry);
     }
 
-    if (rib_list.size() > 0) {
-        mbus_ptr->update_L3Vpn(*p_entry, rib_list, &base_attr,
-                             remove ? mbus_ptr->VPN_ACTION_DEL : mbus_ptr->VPN_ACTION_ADD);
-    }
+    mbus_ptr->update_L3Vpn(*p_entry, vpn_list, &base_attr,
+                           remove ? mbus_ptr->VPN_ACTION_DEL : mbus_ptr->VPN_ACTION_ADD);
 
-    rib_list.clear();
     prefixes.clear();
 }
 
@@ -564,22 +523,20 @@ void parseBGP::UpdateDBL3Vpn(bool remove, std::list<bgp::vpn_tuple> &prefixes,
  * Updates for either advertised or withdrawn Evpn NLRI's
  *
  * \param [in] remove          True if the records should be deleted, false if they are to be added/updated
- * \param [in] nlris           Reference to the list<evpn_tuple>
- * \param [in] attrs           Reference to the parsed attributes map
+ * \param [in] nlris           Reference to the batch of evpn_tuple's
  */
-void parseBGP::UpdateDBeVPN(bool remove, std::list<bgp::evpn_tuple> &nlris,
-                           bgp_msg::UpdateMsg::parsed_attrs_map &attrs) {
+void parseBGP::UpdateDBeVPN(bool remove, std::vector<bgp::evpn_tuple> &nlris) {
+    if (nlris.size() == 0)
+        return;
 
-    vector<MsgBusInterface::obj_evpn> rib_list;
-    MsgBusInterface::obj_evpn         rib_entry;
+    evpn_list.resize(nlris.size());
 
     /*
      * Loop through all vpn and add/update them in the DB
      */
-    for (std::list<bgp::evpn_tuple>::iterator it = nlris.begin();
-         it != nlris.end();
-         it++) {
-        bgp::evpn_tuple &tuple = (*it);
+    for (size_t i=0; i < nlris.size(); i++) {
+        bgp::evpn_tuple &tuple = nlris[i];
+        MsgBusInterface::obj_evpn &rib_entry = evpn_list[i];
 
         memcpy(rib_entry.path_attr_hash_id, path_hash_id, sizeof(rib_entry.path_attr_hash_id));
         memcpy(rib_entry.peer_hash_id, p_entry->hash_id, sizeof(rib_entry.peer_hash_id));
@@ -604,17 +561,12 @@ void parseBGP::UpdateDBeVPN(bool remove, std::list<bgp::evpn_tuple> &nlris,
 
         SELF_DEBUG("%s: %s evpn mac=%s ip=%s", p_entry->peer_addr,
                    remove ? "removing" : "adding", rib_entry.mac, rib_entry.ip);
-
-        // Add entry to the list
-        rib_list.insert(rib_list.end(), rib_entry);
     }
 
     // Update the DB
-    if (rib_list.size() > 0)
-        mbus_ptr->update_eVPN(*p_entry, rib_list, &base_attr,
-                              remove ? mbus_ptr->VPN_ACTION_DEL : mbus_ptr->VPN_ACTION_ADD);
+    mbus_ptr->update_eVPN(*p_entry, evpn_list, &base_attr,
+                          remove ? mbus_ptr->VPN_ACTION_DEL : mbus_ptr->VPN_ACTION_ADD);
 
-    rib_list.clear();
     nlris.clear();
 }
 
@@ -624,93 +576,27 @@ void parseBGP::UpdateDBeVPN(bool remove, std::list<bgp::evpn_tuple> &nlris,
  *
  * \details This method will update the database for the supplied advertised prefixes
  *
- * \param  adv_prefixes         Reference to the list<prefix_tuple> of advertised prefixes
- * \param  attrs            Reference to the parsed attributes map
+ * \param  adv_prefixes         Reference to the batch of advertised prefixes
  */
-void parseBGP::UpdateDBAdvPrefixes(std::list<bgp::prefix_tuple> &adv_prefixes,
-                                   bgp_msg::UpdateMsg::parsed_attrs_map &attrs) {
-    vector<MsgBusInterface::obj_rib> rib_list;
-    MsgBusInterface::obj_rib         rib_entry;
-    uint32_t                         value_32bit;
-    uint64_t                         value_64bit;
+void parseBGP::UpdateDBAdvPrefixes(std::vector<bgp::prefix_tuple> &adv_prefixes) {
+    if (adv_prefixes.size() == 0)
+        return;
+
+    // Rib entries are filled in place, the list keeps its capacity between updates
+    rib_list.resize(adv_prefixes.size());
 
     /*
      * Loop through all prefixes and add/update them in the DB
      */
-    for (std::list<bgp::prefix_tuple>::iterator it = adv_prefixes.begin();
-                                                it != adv_prefixes.end();
-                                                it++) {
-        bgp::prefix_tuple &tuple = (*it);
-
-        memcpy(rib_entry.path_attr_hash_id, path_hash_id, sizeof(rib_entry.path_attr_hash_id));
-        memcpy(rib_entry.peer_hash_id, p_entry->hash_id, sizeof(rib_entry.peer_hash_id));
-
-        strncpy(rib_entry.prefix, tuple.prefix.c_str(), sizeof(rib_entry.prefix));
-
-        rib_entry.prefix_len     = tuple.len;
-
-        rib_entry.isIPv4 = tuple.isIPv4 ? 1 : 0;
-
-        memcpy(rib_entry.prefix_bin, tuple.prefix_bin, sizeof(rib_entry.prefix_bin));
-
-        // Add the ending IP for the prefix based on bits
-        if (rib_entry.isIPv4) {
-            if (tuple.len < 32) {
-                memcpy(&value_32bit, tuple.prefix_bin, 4);
-                bgp::SWAP_BYTES(&value_32bit);
-
-                value_32bit |= 0xFFFFFFFF >> tuple.len;
-                bgp::SWAP_BYTES(&value_32bit);
-                memcpy(rib_entry.prefix_bcast_bin, &value_32bit, 4);
-
-            } else
-                memcpy(rib_entry.prefix_bcast_bin, tuple.prefix_bin, sizeof(tuple.prefix_bin));
-
-        } else {
-            if (tuple.len < 128) {
-                if (tuple.len >= 64) {
-                    // High order bytes are left alone
-                    memcpy(rib_entry.prefix_bcast_bin, tuple.prefix_bin, 8);
-
-                    // Low order bytes are updated
-                    memcpy(&value_64bit, &tuple.prefix_bin[8], 8);
-                    bgp::SWAP_BYTES(&value_64bit);
-
-                    value_64bit |= 0xFFFFFFFFFFFFFFFF >> (tuple.len - 64);
-                    bgp::SWAP_BYTES(&value_64bit);
-                    memcpy(&rib_entry.prefix_bcast_bin[8], &value_64bit, 8);
-
-                } else {
-                    // Low order types are all ones
-                    value_64bit = 0xFFFFFFFFFFFFFFFF;
-                    memcpy(&rib_entry.prefix_bcast_bin[8], &value_64bit, 8);
-
-                    // High order bypes are updated
-                    memcpy(&value_64bit, tuple.prefix_bin, 8);
-                    bgp::SWAP_BYTES(&value_64bit);
-
-                    value_64bit |= 0xFFFFFFFFFFFFFFFF >> tuple.len;
-                    bgp::SWAP_BYTES(&value_64bit);
-                    memcpy(rib_entry.prefix_bcast_bin, &value_64bit, 8);
-                }
-            } else
-                memcpy(rib_entry.prefix_bcast_bin, tuple.prefix_bin, sizeof(tuple.prefix_bin));
-        }
-
-        rib_entry.path_id = tuple.path_id;
-        snprintf(rib_entry.labels, sizeof(rib_entry.labels), "%s", tuple.labels.c_str());
-
-        SELF_DEBUG("%s: Adding prefix=%s len=%d", p_entry->peer_addr, rib_entry.prefix, rib_entry.prefix_len);
+    for (size_t i=0; i < adv_prefixes.size(); i++) {
+        setRibPrefix(adv_prefixes[i], rib_list[i]);
 
-        // Add entry to the list
-        rib_list.insert(rib_list.end(), rib_entry);
+        SELF_DEBUG("%s: Adding prefix=%s len=%d", p_entry->peer_addr, rib_list[i].prefix, rib_list[i].prefix_len);
     }
 
     // Update the DB
-    if (rib_list.size() > 0)
-        mbus_ptr->update_unicastPrefix(*p_entry, rib_list, &base_attr, mbus_ptr->UNICAST_PREFIX_ACTION_ADD);
+    mbus_ptr->update_unicastPrefix(*p_entry, rib_list, &base_attr, mbus_ptr->UNICAST_PREFIX_ACTION_ADD);
 
-    rib_list.clear();
     adv_prefixes.clear();
 }
 
@@ -719,45 +605,105 @@ void parseBGP::UpdateDBAdvPrefixes(std::list<bgp::prefix_tuple> &adv_prefixes,
  *
  * \details This method will update the database for the supplied advertised prefixes
  *
- * \param  wdrawn_prefixes         Reference to the list<prefix_tuple> of withdrawn prefixes
+ * \param  wdrawn_prefixes         Reference to the batch of withdrawn prefixes
  */
-void parseBGP::UpdateDBWdrawnPrefixes(std::list<bgp::prefix_tuple> &wdrawn_prefixes) {
-    vector<MsgBusInterface::obj_rib> rib_list;
-    MsgBusInterface::obj_rib         rib_entry;
+void parseBGP::UpdateDBWdrawnPrefixes(std::vector<bgp::prefix_tuple> &wdrawn_prefixes) {
+    if (wdrawn_prefixes.size() == 0)
+        return;
+
+    rib_list.resize(wdrawn_prefixes.size());
 
     /*
      * Loop through all prefixes and add/update them in the DB
      */
-    for (std::list<bgp::prefix_tuple>::iterator it = wdrawn_prefixes.begin();
-                                                it != wdrawn_prefixes.end();
-                                                it++) {
+    for (size_t i=0; i < wdrawn_prefixes.size(); i++) {
+        setRibPrefix(wdrawn_prefixes[i], rib_list[i]);
 
-        bgp::prefix_tuple &tuple = (*it);
-        memcpy(rib_entry.path_attr_hash_id, path_hash_id, sizeof(rib_entry.path_attr_hash_id));
-        memcpy(rib_entry.peer_hash_id, p_entry->hash_id, sizeof(rib_entry.peer_hash_id));
-        strncpy(rib_entry.prefix, tuple.prefix.c_str(), sizeof(rib_entry.prefix));
+        SELF_DEBUG("%s: Removing prefix=%s len=%d", p_entry->peer_addr, rib_list[i].prefix, rib_list[i].prefix_len);
+    }
+
+    // Update the DB
+    mbus_ptr->update_unicastPrefix(*p_entry, rib_list, NULL, mbus_ptr->UNICAST_PREFIX_ACTION_DEL);
+
+    wdrawn_prefixes.clear();
+}
+
+/**
+ * Set the prefix fields of a rib entry from a parsed prefix
+ *
+ * \details Renders the printed form of the prefix and labels and sets the broadcast address.
+ *
+ * \param [in]  tuple          Reference to the parsed prefix
+ * \param [out] rib_entry      Reference to the rib entry to update
+ */
+void parseBGP::setRibPrefix(const bgp::prefix_tuple &tuple, MsgBusInterface::obj_rib &rib_entry) {
+    uint32_t                         value_32bit;
+    uint64_t                         value_64bit;
 
-        rib_entry.prefix_len     = tuple.len;
+    memcpy(rib_entry.path_attr_hash_id, path_hash_id, sizeof(rib_entry.path_attr_hash_id));
+    memcpy(rib_entry.peer_hash_id, p_entry->hash_id, sizeof(rib_entry.peer_hash_id));
 
-        rib_entry.isIPv4 = tuple.isIPv4 ? 1 : 0;
+    inet_ntop(tuple.isIPv4 ? AF_INET : AF_INET6, tuple.prefix_bin, rib_entry.prefix, sizeof(rib_entry.prefix));
 
-        memcpy(rib_entry.prefix_bin, tuple.prefix_bin, sizeof(rib_entry.prefix_bin));
+    rib_entry.prefix_len     = tuple.len;
 
-        rib_entry.path_id = tuple.path_id;
-        snprintf(rib_entry.labels, sizeof(rib_entry.labels), "%s", tuple.labels.c_str());
+    rib_entry.isIPv4 = tuple.isIPv4 ? 1 : 0;
+
+    memcpy(rib_entry.prefix_bin, tuple.prefix_bin, sizeof(rib_entry.prefix_bin));
 
-        SELF_DEBUG("%s: Removing prefix=%s len=%d", p_entry->peer_addr, rib_entry.prefix, rib_entry.prefix_len);
+    // Add the ending IP for the prefix based on bits
+    if (rib_entry.isIPv4) {
+        if (tuple.len < 32) {
+            memcpy(&value_32bit, tuple.prefix_bin, 4);
+            bgp::SWAP_BYTES(&value_32bit);
 
-        // Add entry to the list
-        rib_list.insert(rib_list.end(), rib_entry);
+            value_32bit |= 0xFFFFFFFF >> tuple.len;
+            bgp::SWAP_BYTES(&value_32bit);
+            memcpy(rib_entry.prefix_bcast_bin, &value_32bit, 4);
+
+        } else
+            memcpy(rib_entry.prefix_bcast_bin, tuple.prefix_bin, sizeof(tuple.prefix_bin));
+
+    } else {
+        if (tuple.len < 128) {
+            if (tuple.len >= 64) {
+                // High order bytes are left alone
+                memcpy(rib_entry.prefix_bcast_bin, tuple.prefix_bin, 8);
+
+                // Low order bytes are updated
+                memcpy(&value_64bit, &tuple.prefix_bin[8], 8);
+                bgp::SWAP_BYTES(&value_64bit);
+
+                value_64bit |= 0xFFFFFFFFFFFFFFFF >> (tuple.len - 64);
+                bgp::SWAP_BYTES(&value_64bit);
+                memcpy(&rib_entry.prefix_bcast_bin[8], &value_64bit, 8);
+
+            } else {
+                // Low order types are all ones
+                value_64bit = 0xFFFFFFFFFFFFFFFF;
+                memcpy(&rib_entry.prefix_bcast_bin[8], &value_64bit, 8);
+
+                // High order bypes are updated
+                memcpy(&value_64bit, tuple.prefix_bin, 8);
+                bgp::SWAP_BYTES(&value_64bit);
+
+                value_64bit |= 0xFFFFFFFFFFFFFFFF >> tuple.len;
+                bgp::SWAP_BYTES(&value_64bit);
+                memcpy(rib_entry.prefix_bcast_bin, &value_64bit, 8);
+            }
+        } else
+            memcpy(rib_entry.prefix_bcast_bin, tuple.prefix_bin, sizeof(tuple.prefix_bin));
     }
 
-    // Update the DB
-    if (rib_list.size() > 0)
-        mbus_ptr->update_unicastPrefix(*p_entry, rib_list, NULL, mbus_ptr->UNICAST_PREFIX_ACTION_DEL);
+    rib_entry.path_id = tuple.path_id;
 
-    rib_list.clear();
-    wdrawn_prefixes.clear();
+    // Labels in the format of label,label,...
+    size_t labels_len = 0;
+    rib_entry.labels[0] = 0;
+    for (int i=0; i < tuple.label_count and labels_len < sizeof(rib_entry.labels); i++) {
+        labels_len += snprintf(rib_entry.labels + labels_len, sizeof(rib_entry.labels) - labels_len,
+                               i ? ",%u" : "%u", tuple.labels[i]);
+    }
 }
 
 /**
@@ -21,6 +21,8 @@
 
 using namespace std;
 
+#define BGP_PREFIX_BATCH_RESERVE    1024        ///< Initial number of prefixes reserved in the prefix batches
+
 /**
  * \class   parseBGP
  *
@@ -84,6 +86,17 @@ public:
 
     virtual ~parseBGP();
 
+    /**
+     * Reset the parser for the next BGP message
+     *
+     * \details The parser is reused for each BGP message of a router connection.  The
+     *          peer entry and router address are kept from construction.
+     *
+     * \param [in]     mbus_ptr     Pointer to exiting dB implementation
+     * \param [in,out] peer_info   Persistent peer information
+     */
+    void reset(MsgBusInterface *mbus_ptr, BMPReader::peer_info *peer_info);
+
     /**
      * handle BGP update message and store in DB
      *
@@ -157,6 +170,14 @@ private:
 
     unsigned char path_hash_id[16];                  ///< current path hash ID
 
+    /*
+     * Reusable batches - cleared but not freed between updates to avoid per prefix allocations
+     */
+    bgp_msg::UpdateMsg::parsed_update_data  update_data;    ///< Parsed update data
+    std::vector<MsgBusInterface::obj_rib>   rib_list;       ///< Unicast rib entries for the message bus
+    std::vector<MsgBusInterface::obj_vpn>   vpn_list;       ///< L3VPN rib entries for the message bus
+    std::vector<MsgBusInterface::obj_evpn>  evpn_list;      ///< EVPN rib entries for the message bus
+
     bool            debug;                           ///< debug flag to indicate debugging
     Logger          *logger;                         ///< Logging class pointer
 
@@ -189,28 +210,27 @@ private:
      *
      * \details This method will update the database for the supplied path attributes
      *
-     * \param  attrs            Reference to the parsed attributes map
+     * \param  attrs            Reference to the parsed attributes
      */
-    void UpdateDBAttrs(bgp_msg::UpdateMsg::parsed_attrs_map &attrs);
+    void UpdateDBAttrs(bgp_msg::UpdateMsg::parsed_attrs &attrs);
 
     /**
      * Update the Database advertised prefixes
      *
      * \details This method will update the database for the supplied advertised prefixes
      *
-     * \param  adv_prefixes         Reference to the list<prefix_tuple> of advertised prefixes
-     * \param  attrs            Reference to the parsed attributes map
+     * \param  adv_prefixes         Reference to the batch of advertised prefixes
      */
-    void UpdateDBAdvPrefixes(std::list<bgp::prefix_tuple> &adv_prefixes, bgp_msg::UpdateMsg::parsed_attrs_map &attrs);
+    void UpdateDBAdvPrefixes(std::vector<bgp::prefix_tuple> &adv_prefixes);
 
     /**
      * Update the Database withdrawn prefixes
      *
      * \details This method will update the database for the supplied advertised prefixes
      *
-     * \param  wdrawn_prefixes         Reference to the list<prefix_tuple> of withdrawn prefixes
+     * \param  wdrawn_prefixes         Reference to the batch of withdrawn prefixes
      */
-    void UpdateDBWdrawnPrefixes(std::list<bgp::prefix_tuple> &wdrawn_prefixes);
+    void UpdateDBWdrawnPrefixes(std::vector<bgp::prefix_tuple> &wdrawn_prefixes);
 
     /**
      * Update the Database advertised l3vpn 
@@ -218,19 +238,17 @@ private:
      * \details This method will update the database for the supplied advertised prefixes
      *
      * \param [in] remove       True if the records should be deleted, false if they are to be added/updated
-     * \param [in] adv_vpn      Reference to the list<vpn_tuple> of advertised vpns
-     * \param [in] attrs        Reference to the parsed attributes map
+     * \param [in] adv_vpn      Reference to the batch of advertised vpns
      */ 
-    void UpdateDBL3Vpn(bool remove, std::list<bgp::vpn_tuple> &adv_vpn, bgp_msg::UpdateMsg::parsed_attrs_map &attrs);
+    void UpdateDBL3Vpn(bool remove, std::vector<bgp::vpn_tuple> &adv_vpn);
 
     /**
      * Updates for either advertised or withdrawn Evpn NLRI's
      *
      * \param [in] remove          True if the records should be deleted, false if they are to be added/updated
-     * \param [in] nlris           Reference to the list<evpn_tuple>
-     * \param [in] attrs           Reference to the parsed attributes map
+     * \param [in] nlris           Reference to the batch of evpn_tuple's
      */
-    void UpdateDBeVPN(bool remove, std::list<bgp::evpn_tuple> &nlris, bgp_msg::UpdateMsg::parsed_attrs_map &attrs);
+    void UpdateDBeVPN(bool remove, std::vector<bgp::evpn_tuple> &nlris);
 
     /**
      * Update the Database for bgp-ls
@@ -244,6 +262,16 @@ private:
     void UpdateDbBgpLs(bool remove, bgp_msg::UpdateMsg::parsed_data_ls ls_data,
                                  bgp_msg::UpdateMsg::parsed_ls_attrs_map &ls_attrs);
 
+    /**
+     * Set the prefix fields of a rib entry from a parsed prefix
+     *
+     * \details Renders the printed form of the prefix and labels and sets the broadcast address.
+     *
+     * \param [in]  tuple          Reference to the parsed prefix
+     * \param [out] rib_entry      Reference to the rib entry to update
+     */
+    void setRibPrefix(const bgp::prefix_tuple &tuple, MsgBusInterface::obj_rib &rib_entry);
+
 
 };
 
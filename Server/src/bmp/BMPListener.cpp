@@ -23,7 +23,7 @@
 #include <MsgBusInterface.hpp>
 
 #include "BMPListener.h"
-#include "md5.h"
+#include "hash_id.h"
 
 using namespace std;
 
@@ -294,15 +294,13 @@ void BMPListener::hashRouter(ClientInfo &client) {
     string c_hash_str;
     MsgBusInterface::hash_toStr(cfg->c_hash_id, c_hash_str);
 
-    MD5 hash;
+    HashId hash;
     hash.update((unsigned char *)client.c_ip, strlen(client.c_ip));
     hash.update((unsigned char *)c_hash_str.c_str(), c_hash_str.length());
     hash.finalize();
 
     // Save the hash
-    unsigned char *hash_bin = hash.raw_digest();
-    memcpy(client.hash_id, hash_bin, 16);
-    delete[] hash_bin;
+    hash.raw_digest(client.hash_id);
 }
 
 /*
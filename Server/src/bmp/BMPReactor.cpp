@@ -0,0 +1,486 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <chrono>
+
+#include "BMPReactor.h"
+#include "parseBMP.h"
+
+/**
+ * Class constructor - starts the reactor and parser threads
+ *
+ *  \param [in] logPtr      Pointer to existing Logger for app logging
+ *  \param [in] config      Pointer to the loaded configuration
+ *  \param [in] producer    Pointer to the shared message bus sink
+ *  \param [in] resolver    Pointer to the shared DNS resolver
+ */
+BMPReactor::BMPReactor(Logger *logPtr, Config *config, MsgBusSink *producer, DnsResolver *resolver) {
+    logger = logPtr;
+    cfg = config;
+    this->producer = producer;
+    this->resolver = resolver;
+    debug = cfg->debug_bmp;
+    run = true;
+    next_reactor = 0;
+
+    for (int i=0; i < cfg->reactor_threads; i++) {
+        int epfd = epoll_create1(0);
+
+        if (epfd < 0) {
+            LOG_ERR("Failed to create epoll instance: %s", strerror(errno));
+            throw "ERROR: Failed to create epoll instance";
+        }
+
+        epoll_fds.push_back(epfd);
+        reactor_threads.push_back(new std::thread(&BMPReactor::reactorLoop, this, epfd));
+    }
+
+    for (int i=0; i < cfg->parser_threads; i++)
+        parser_threads.push_back(new std::thread(&BMPReactor::parserLoop, this));
+
+    LOG_INFO("BMP reactor started with %d reactor threads and %d parser threads",
+             cfg->reactor_threads, cfg->parser_threads);
+}
+
+/**
+ * Destructor - stops and joins the reactor and parser threads, then closes the
+ *      remaining router connections
+ */
+BMPReactor::~BMPReactor() {
+    std::unique_lock<std::mutex> lock(ready_mutex);
+    run = false;
+    ready_cond.notify_all();
+    lock.unlock();
+
+    for (size_t i=0; i < reactor_threads.size(); i++) {
+        if (reactor_threads[i]->joinable())
+            reactor_threads[i]->join();
+
+        delete reactor_threads[i];
+    }
+
+    for (size_t i=0; i < parser_threads.size(); i++) {
+        if (parser_threads[i]->joinable())
+            parser_threads[i]->join();
+
+        delete parser_threads[i];
+    }
+
+    /*
+     * Close the connections that are still open.  Freeing the connection sends the router
+     *      term message and the coalesced rows of the router.  Messages not parsed yet are dropped.
+     */
+    while (not conns.empty()) {
+        RouterConn *conn = *conns.begin();
+
+        lock = std::unique_lock<std::mutex>(conn->mutex);
+        closeSocket(conn);
+        lock.unlock();
+
+        freeConnection(conn);
+    }
+
+    for (size_t i=0; i < epoll_fds.size(); i++)
+        close(epoll_fds[i]);
+
+    reactor_threads.clear();
+    parser_threads.clear();
+    epoll_fds.clear();
+}
+
+/**
+ * Add a newly accepted router connection
+ *
+ * \param [in] client       Client information pointer
+ * \param [in] running      Pointer to running flag of the connection
+ */
+void BMPReactor::addConnection(BMPListener::ClientInfo *client, bool *running) {
+    RouterConn *conn = new RouterConn;
+
+    conn->client = client;
+    conn->running = running;
+    conn->fd = client->c_sock;
+    conn->epfd = epoll_fds[next_reactor++ % epoll_fds.size()];
+
+    conn->rbuf = new u_char[BMP_PACKET_BUF_SIZE * 2];
+    conn->rbuf_len = 0;
+
+    conn->queued_bytes = 0;
+    conn->paused = false;
+    conn->scheduled = false;
+    conn->eof = false;
+    conn->closing = false;
+    conn->lingering = false;
+
+    /*
+     * The reactor owns the socket.  The BMP reader parses in memory messages, so
+     * the client socket is cleared to make any close by the reader a no-op.
+     */
+    client->c_sock = -1;
+    client->pipe_sock = -1;
+
+    conn->mbus = new msgBus_kafka(logger, cfg, producer, resolver, cfg->c_hash_id);
+
+    if (cfg->debug_msgbus)
+        conn->mbus->enableDebug();
+
+    conn->reader = new BMPReader(logger, cfg);
+
+    {
+        std::lock_guard<std::mutex> guard(ready_mutex);
+        conns.insert(conn);
+    }
+
+    fcntl(conn->fd, F_SETFL, fcntl(conn->fd, F_GETFL, 0) | O_NONBLOCK);
+
+    LOG_INFO("%s: Reactor monitoring BMP from router using socket %d buffer in bytes = %u",
+             client->c_ip, conn->fd, cfg->bmp_buffer_size);
+
+    epoll_event ev;
+    bzero(&ev, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = conn;
+
+    if (epoll_ctl(conn->epfd, EPOLL_CTL_ADD, conn->fd, &ev) < 0) {
+        LOG_ERR("%s: Failed to add socket %d to epoll: %s", client->c_ip, conn->fd, strerror(errno));
+
+        std::unique_lock<std::mutex> lock(conn->mutex);
+        closeSocket(conn);
+        conn->scheduled = true;
+        lock.unlock();
+
+        schedule(conn);
+    }
+}
+
+/**
+ * Reactor thread loop - reads sockets that are ready
+ *
+ * \param [in] epfd     epoll fd of the reactor thread
+ */
+void BMPReactor::reactorLoop(int epfd) {
+    epoll_event events[REACTOR_MAX_EVENTS];
+    std::chrono::milliseconds linger(cfg->coalesce_linger_ms);
+    std::chrono::steady_clock::time_point last_linger = std::chrono::steady_clock::now();
+
+    // Wake at least once per linger time to produce the coalesced rows of idle routers
+    int wait_ms = REACTOR_WAIT_MS;
+    if (cfg->coalesce_linger_ms > 0 and cfg->coalesce_linger_ms < wait_ms)
+        wait_ms = cfg->coalesce_linger_ms;
+
+    while (run) {
+        int n = epoll_wait(epfd, events, REACTOR_MAX_EVENTS, wait_ms);
+
+        if (n < 0) {
+            if (errno != EINTR)
+                LOG_ERR("epoll wait failed: %s", strerror(errno));
+            continue;
+        }
+
+        for (int i=0; i < n; i++)
+            readConnection((RouterConn *)events[i].data.ptr);
+
+        if (cfg->coalesce_linger_ms > 0 and std::chrono::steady_clock::now() - last_linger >= linger) {
+            scheduleLingering(epfd);
+            last_linger = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+/**
+ * Schedule the idle connections of a reactor thread that have coalesced rows waiting
+ *
+ * \details The message bus of a connection is only used by the parser thread that has it
+ *      scheduled, so the rows past the linger time are produced by parseConnection().
+ *
+ * \param [in] epfd     epoll fd of the reactor thread
+ */
+void BMPReactor::scheduleLingering(int epfd) {
+    std::vector<RouterConn *> ready;
+
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex);
+
+        for (std::set<RouterConn *>::iterator it = conns.begin(); it != conns.end(); ++it) {
+            RouterConn *conn = *it;
+
+            if (conn->epfd != epfd)
+                continue;
+
+            // A connection is only freed while scheduled, so it stays valid once marked
+            std::lock_guard<std::mutex> conn_lock(conn->mutex);
+            if (conn->lingering and not conn->scheduled and not conn->eof and not conn->closing) {
+                conn->scheduled = true;
+                ready.push_back(conn);
+            }
+        }
+    }
+
+    for (size_t i=0; i < ready.size(); i++)
+        schedule(ready[i]);
+}
+
+/**
+ * Parser thread loop - parses messages of ready connections
+ */
+void BMPReactor::parserLoop() {
+    RouterConn *conn;
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(ready_mutex);
+
+        while (run and ready_queue.empty())
+            ready_cond.wait(lock);
+
+        if (not run)
+            break;
+
+        conn = ready_queue.front();
+        ready_queue.pop_front();
+        lock.unlock();
+
+        parseConnection(conn);
+    }
+}
+
+/**
+ * Add a connection to the ready queue and wake a parser thread
+ *
+ * \param [in] conn     Router connection
+ */
+void BMPReactor::schedule(RouterConn *conn) {
+    std::lock_guard<std::mutex> lock(ready_mutex);
+
+    ready_queue.push_back(conn);
+    ready_cond.notify_one();
+}
+
+/**
+ * Read the router socket and queue complete BMP messages
+ *
+ * \param [in] conn     Router connection
+ */
+void BMPReactor::readConnection(RouterConn *conn) {
+    std::vector<std::string> frames;
+    size_t frames_bytes = 0;
+    bool failed = false;
+
+    ssize_t bytes_read = read(conn->fd, conn->rbuf + conn->rbuf_len, BMP_PACKET_BUF_SIZE * 2 - conn->rbuf_len);
+
+    if (bytes_read > 0) {
+        conn->rbuf_len += bytes_read;
+
+        // Frame the complete BMP messages
+        size_t pos = 0;
+        try {
+            while (pos < conn->rbuf_len) {
+                uint32_t frame_len = parseBMP::getFrameLength(conn->rbuf + pos, conn->rbuf_len - pos);
+
+                if (frame_len == 0 or frame_len > conn->rbuf_len - pos)
+                    break;                      // Need more data
+
+                frames.push_back(std::string((char *)conn->rbuf + pos, frame_len));
+                frames_bytes += frame_len;
+                pos += frame_len;
+            }
+
+        } catch (char const *str) {
+            LOG_INFO("%s: Caught: %s", conn->client->c_ip, str);
+            failed = true;
+        }
+
+        // Move the remaining partial message to the start of the buffer
+        if (pos > 0) {
+            conn->rbuf_len -= pos;
+            memmove(conn->rbuf, conn->rbuf + pos, conn->rbuf_len);
+        }
+
+    } else if (bytes_read == 0) {
+        LOG_INFO("%s: Connection closed by router", conn->client->c_ip);
+        failed = true;
+
+    } else if (errno != EAGAIN and errno != EWOULDBLOCK and errno != EINTR) {
+        LOG_INFO("%s: Error reading socket %d: %s", conn->client->c_ip, conn->fd, strerror(errno));
+        failed = true;
+    }
+
+    std::unique_lock<std::mutex> lock(conn->mutex);
+
+    for (size_t i=0; i < frames.size(); i++)
+        conn->frames.push_back(std::move(frames[i]));
+
+    conn->queued_bytes += frames_bytes;
+
+    if (failed) {
+        closeSocket(conn);
+
+    } else if (conn->queued_bytes >= (size_t)cfg->bmp_buffer_size and not conn->paused) {
+        SELF_DEBUG("%s: Pausing read, %lu bytes queued", conn->client->c_ip, conn->queued_bytes);
+        conn->paused = true;
+        epoll_ctl(conn->epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+    }
+
+    if ((failed or frames.size() > 0) and not conn->scheduled) {
+        conn->scheduled = true;
+        lock.unlock();
+
+        schedule(conn);
+    }
+}
+
+/**
+ * Parse queued BMP messages of a router connection
+ *
+ * \param [in] conn     Router connection
+ */
+void BMPReactor::parseConnection(RouterConn *conn) {
+    std::string frame;
+
+    for (int i=0; i < REACTOR_PARSE_BATCH; i++) {
+        std::unique_lock<std::mutex> lock(conn->mutex);
+
+        if (conn->frames.empty())
+            break;
+
+        frame.swap(conn->frames.front());
+        conn->frames.pop_front();
+        conn->queued_bytes -= frame.size();
+
+        // Resume reading once the queue has drained below half of the buffer size
+        if (conn->paused and not conn->eof and conn->queued_bytes < (size_t)cfg->bmp_buffer_size / 2) {
+            epoll_event ev;
+            bzero(&ev, sizeof(ev));
+            ev.events = EPOLLIN;
+            ev.data.ptr = conn;
+
+            SELF_DEBUG("%s: Resuming read, %lu bytes queued", conn->client->c_ip, conn->queued_bytes);
+            conn->paused = false;
+            epoll_ctl(conn->epfd, EPOLL_CTL_ADD, conn->fd, &ev);
+        }
+
+        bool closing = conn->closing;
+        lock.unlock();
+
+        if (closing)
+            continue;                           // Discard messages once closing
+
+        try {
+            if (not conn->reader->ReadIncomingMsg(conn->client, conn->mbus,
+                                                  (const u_char *)frame.data(), frame.size()))
+                requestClose(conn);
+
+        } catch (char const *str) {
+            requestClose(conn);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(conn->mutex);
+
+    /*
+     * Send the coalesced messages that have waited the linger time once the queued messages
+     *      are parsed.  The reactor thread schedules the connection again while rows are waiting.
+     */
+    if (conn->frames.empty() and not conn->eof and not conn->closing) {
+        lock.unlock();
+        conn->mbus->flush(true);
+        bool lingering = conn->mbus->hasPendingRows();
+        lock.lock();
+
+        conn->lingering = lingering;
+    }
+
+    if (not conn->frames.empty()) {
+        lock.unlock();
+        schedule(conn);                         // Yield to other routers, still scheduled
+
+    } else if (conn->eof) {
+        lock.unlock();
+        freeConnection(conn);
+
+    } else
+        conn->scheduled = false;
+}
+
+/**
+ * Socket is closed or in error - stop reading and close the socket
+ *
+ * \details conn->mutex must be held
+ *
+ * \param [in] conn     Router connection
+ */
+void BMPReactor::closeSocket(RouterConn *conn) {
+    if (not conn->eof) {
+        if (not conn->paused)
+            epoll_ctl(conn->epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+
+        close(conn->fd);
+        conn->eof = true;
+    }
+}
+
+/**
+ * Request the connection to close - the router will be disconnected
+ *
+ * \details The socket is shutdown so that the reactor thread detects the close.
+ *
+ * \param [in] conn     Router connection
+ */
+void BMPReactor::requestClose(RouterConn *conn) {
+    std::unique_lock<std::mutex> lock(conn->mutex);
+
+    conn->closing = true;
+
+    if (not conn->eof) {
+        shutdown(conn->fd, SHUT_RDWR);
+
+        // Reading must be resumed in order to detect the close
+        if (conn->paused) {
+            epoll_event ev;
+            bzero(&ev, sizeof(ev));
+            ev.events = EPOLLIN;
+            ev.data.ptr = conn;
+
+            conn->paused = false;
+            epoll_ctl(conn->epfd, EPOLL_CTL_ADD, conn->fd, &ev);
+        }
+    }
+}
+
+/**
+ * Free the connection after the socket is closed and all messages are processed
+ *
+ * \param [in] conn     Router connection
+ */
+void BMPReactor::freeConnection(RouterConn *conn) {
+    LOG_INFO("%s: Reactor connection for sock [%d] ended", conn->client->c_ip, conn->fd);
+
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex);
+        conns.erase(conn);
+    }
+
+    delete conn->reader;
+
+    // Deleting the message bus sends the router term message if not already sent
+    delete conn->mbus;
+
+    delete [] conn->rbuf;
+
+    // Indicate that we are no longer running - client info is no longer referenced after this
+    *conn->running = false;
+
+    delete conn;
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef BMPREACTOR_H_
+#define BMPREACTOR_H_
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "BMPListener.h"
+#include "BMPReader.h"
+#include "MsgBusImpl_kafka.h"
+#include "MsgBusSink.h"
+#include "DnsResolver.h"
+#include "Logger.h"
+#include "Config.h"
+
+#define REACTOR_MAX_EVENTS          64          ///< Max number of epoll events returned per wait
+#define REACTOR_WAIT_MS             500         ///< epoll wait timeout in milliseconds
+#define REACTOR_PARSE_BATCH         32          ///< Max messages parsed for a router before yielding to other routers
+
+/**
+ * \class   BMPReactor
+ *
+ * \brief   Event driven (epoll) reader and parser for BMP router connections
+ * \details A fixed number of reactor threads read all router sockets using epoll.
+ *          Complete BMP messages are framed and queued per router.  A fixed pool of
+ *          parser threads parse the queued messages.  A router is only handled by one
+ *          parser thread at a time, which maintains the message order of the router.
+ *
+ *          Reading from a router is paused when the queued messages of the router
+ *          exceed the router buffer size (cfg->bmp_buffer_size).
+ */
+class BMPReactor {
+public:
+    /**
+     * Class constructor - starts the reactor and parser threads
+     *
+     *  \param [in] logPtr      Pointer to existing Logger for app logging
+     *  \param [in] config      Pointer to the loaded configuration
+     *  \param [in] producer    Pointer to the shared message bus sink
+     *  \param [in] resolver    Pointer to the shared DNS resolver
+     */
+    BMPReactor(Logger *logPtr, Config *config, MsgBusSink *producer, DnsResolver *resolver);
+
+    /**
+     * Destructor - stops and joins the reactor and parser threads
+     */
+    virtual ~BMPReactor();
+
+    /**
+     * Add a newly accepted router connection
+     *
+     * \details The reactor takes ownership of the client socket.  The running flag
+     *          is set to false once the connection is closed and all of its messages
+     *          have been processed.  The client info must remain valid until then.
+     *
+     * \param [in] client       Client information pointer
+     * \param [in] running      Pointer to running flag of the connection
+     */
+    void addConnection(BMPListener::ClientInfo *client, bool *running);
+
+private:
+    /**
+     * Router connection state
+     */
+    struct RouterConn {
+        BMPListener::ClientInfo *client;        ///< Client information
+        bool            *running;               ///< Running flag of the connection (owned by caller)
+        int             fd;                     ///< Client socket
+        int             epfd;                   ///< epoll fd of the reactor thread handling the socket
+
+        msgBus_kafka    *mbus;                  ///< Per router message bus
+        BMPReader       *reader;                ///< Per router BMP reader/parser
+
+        u_char          *rbuf;                  ///< Read buffer for partial BMP messages
+        size_t          rbuf_len;               ///< Number of bytes in the read buffer
+
+        std::mutex      mutex;                  ///< Protects the below members
+        std::deque<std::string> frames;         ///< Complete BMP messages waiting to be parsed
+        size_t          queued_bytes;           ///< Number of bytes in frames
+        bool            paused;                 ///< Reading is paused (socket removed from epoll)
+        bool            scheduled;              ///< Connection is in the ready queue or being parsed
+        bool            eof;                    ///< Socket is closed, no more messages will be queued
+        bool            closing;                ///< Connection is closing, remaining messages are discarded
+        bool            lingering;              ///< Coalesced rows are waiting for the linger time
+    };
+
+    Logger      *logger;                    ///< Logging class pointer
+    Config      *cfg;                       ///< Config pointer
+    MsgBusSink  *producer;                  ///< Shared message bus sink
+    DnsResolver *resolver;                  ///< Shared DNS resolver
+    bool        debug;                      ///< debug flag to indicate debugging
+    bool        run;                        ///< Indicates if the threads should continue running
+
+    std::vector<int>            epoll_fds;          ///< epoll fd per reactor thread
+    std::vector<std::thread *>  reactor_threads;    ///< Reactor (socket read) threads
+    std::vector<std::thread *>  parser_threads;     ///< Parser worker threads
+    uint32_t                    next_reactor;       ///< Next reactor to assign a connection to (round robin)
+
+    std::mutex                  ready_mutex;        ///< Protects ready_queue and conns
+    std::condition_variable     ready_cond;         ///< Signaled when a connection is added to ready_queue
+    std::deque<RouterConn *>    ready_queue;        ///< Connections that have messages to parse
+    std::set<RouterConn *>      conns;              ///< Connections not yet freed
+
+    /**
+     * Add a connection to the ready queue and wake a parser thread
+     *
+     * \param [in] conn     Router connection
+     */
+    void schedule(RouterConn *conn);
+
+    /**
+     * Reactor thread loop - reads sockets that are ready
+     *
+     * \param [in] epfd     epoll fd of the reactor thread
+     */
+    void reactorLoop(int epfd);
+
+    /**
+     * Schedule the idle connections of a reactor thread that have coalesced rows waiting
+     *
+     * \param [in] epfd     epoll fd of the reactor thread
+     */
+    void scheduleLingering(int epfd);
+
+    /**
+     * Parser thread loop - parses messages of ready connections
+     */
+    void parserLoop();
+
+    /**
+     * Read the router socket and queue complete BMP messages
+     *
+     * \param [in] conn     Router connection
+     */
+    void readConnection(RouterConn *conn);
+
+    /**
+     * Parse queued BMP messages of a router connection
+     *
+     * \param [in] conn     Router connection
+     */
+    void parseConnection(RouterConn *conn);
+
+    /**
+     * Socket is closed or in error - stop reading and close the socket
+     *
+     * \param [in] conn     Router connection
+     */
+    void closeSocket(RouterConn *conn);
+
+    /**
+     * Request the connection to close - the router will be disconnected
+     *
+     * \param [in] conn     Router connection
+     */
+    void requestClose(RouterConn *conn);
+
+    /**
+     * Free the connection after the socket is closed and all messages are processed
+     *
+     * \param [in] conn     Router connection
+     */
+    void freeConnection(RouterConn *conn);
+};
+
+#endif /* BMPREACTOR_H_ */
@@ -25,7 +25,7 @@
 #include "parseBGP.h"
 #include "MsgBusInterface.hpp"
 #include "Logger.h"
-#include "md5.h"
+#include "hash_id.h"
 
 using namespace std;
 
@@ -43,8 +43,15 @@ BMPReader::BMPReader(Logger *logPtr, Config *config) {
 
     logger = logPtr;
 
-    if (cfg->debug_bmp)
+    bzero(&r_object, sizeof(r_object));
+
+    pBMP = new parseBMP(logger, &p_entry);
+    pBGP = NULL;
+
+    if (cfg->debug_bmp) {
         enableDebug();
+        pBMP->enableDebug();
+    }
     
     hasPrevRIBdumpTime = false;
     maxRIBdumpRate = 0;
@@ -54,7 +61,42 @@ BMPReader::BMPReader(Logger *logPtr, Config *config) {
  * Destructor
  */
 BMPReader::~BMPReader() {
+    delete pBMP;
 
+    if (pBGP != NULL)
+        delete pBGP;
+}
+
+/**
+ * Get the BGP parser reset for the next BGP message
+ *
+ * \param [in]  mbus_ptr     The database pointer referencer - DB should be already initialized
+ * \param [in]  p_info       Persistent peer information
+ *
+ * \return Pointer to the BGP parser
+ */
+parseBGP *BMPReader::getBGPParser(MsgBusInterface *mbus_ptr, peer_info *p_info) {
+    if (pBGP == NULL) {
+        pBGP = new parseBGP(logger, mbus_ptr, &p_entry, (char *)r_object.ip_addr, p_info);
+
+        if (cfg->debug_bgp)
+            pBGP->enableDebug();
+
+    } else
+        pBGP->reset(mbus_ptr, p_info);
+
+    return pBGP;
+}
+
+/**
+ * Reset the router entry to the router hash and address only
+ *
+ * \param [in]  client      Client information pointer
+ */
+void BMPReader::resetRouterEntry(BMPListener::ClientInfo *client) {
+    bzero(&r_object, sizeof(r_object));
+    memcpy(r_object.hash_id, router_hash_id, sizeof(r_object.hash_id));
+    memcpy(r_object.ip_addr, client->c_ip, sizeof(client->c_ip));
 }
 
 
@@ -69,18 +111,85 @@ BMPReader::~BMPReader() {
  *
  * \throw (char const *str) message indicate error
  */
-void BMPReader::readerThreadLoop(bool &run, BMPListener::ClientInfo *client, MsgBusInterface *mbus_ptr) {
+void BMPReader::readerThreadLoop(bool &run, BMPListener::ClientInfo *client, MsgBusInterface *mbus_ptr,
+                                 BMPRingBuffer *ring) {
+    u_char *scratch = new u_char[BMP_PACKET_BUF_SIZE + 1];     // Used only if a message wraps the end of the ring
+
+    // Wake up at least once per linger time to send coalesced messages while the router is idle
+    int wait_ms = BMP_RING_WAIT_MS;
+    if (cfg->coalesce_linger_ms > 0 and cfg->coalesce_linger_ms < wait_ms)
+        wait_ms = cfg->coalesce_linger_ms;
+
     while (run) {
+        uint32_t frame_len = 0;
+        const u_char *frame = NULL;
+
+        // Check eof before the available data so that the last bytes written are not missed
+        bool eof = ring->isEof();
+        size_t avail = ring->size();
 
         try {
-            if (not ReadIncomingMsg(client, mbus_ptr))
+            /*
+             * Frame the next BMP message in place.  The message is only copied if the
+             * header or message wraps the end of the ring.
+             */
+            size_t contig = ring->contiguous();
+
+            if (contig > 0) {
+                frame = ring->peek(contig, scratch);
+                frame_len = parseBMP::getFrameLength(frame, contig);
+            }
+
+            if ((frame_len == 0 or frame_len > contig) and avail > contig) {
+                size_t len = avail > BMP_PACKET_BUF_SIZE ? BMP_PACKET_BUF_SIZE : avail;
+                frame = ring->peek(len, scratch);
+                frame_len = parseBMP::getFrameLength(frame, len);
+
+                if (frame_len > len)
+                    frame_len = 0;
+
+            } else if (frame_len > contig)
+                frame_len = 0;
+
+        } catch (char const *str) {
+            LOG_INFO("%s: Caught: %s", client->c_ip, str);
+            disconnect(client, mbus_ptr, parseBMP::TERM_REASON_OPENBMP_CONN_ERR, str);
+            run = false;
+            break;
+        }
+
+        // Need more data
+        if (frame_len == 0) {
+            if (eof) {
+                LOG_INFO("%s: Connection closed by router", client->c_ip);
+                disconnect(client, mbus_ptr, parseBMP::TERM_REASON_OPENBMP_CONN_CLOSED, "Connection closed");
+                run = false;
                 break;
+            }
+
+            // Send coalesced messages that have waited the linger time while the router is idle
+            mbus_ptr->flush(true);
+
+            ring->waitData(avail, wait_ms);
+            continue;
+        }
+
+        try {
+            bool more = ReadIncomingMsg(client, mbus_ptr, frame, frame_len);
+            ring->consume(frame_len);
+
+            if (not more) {
+                run = false;
+                break;
+            }
 
         } catch (char const *str) {
             run = false;
             break;
         }
     }
+
+    delete [] scratch;
 }
 
 /**
@@ -90,42 +199,37 @@ void BMPReader::readerThreadLoop(bool &run, BMPListener::ClientInfo *client, Msg
  *
  * \param [in]  client      Client information pointer
  * \param [in]  mbus_ptr     The database pointer referencer - DB should be already initialized
+ * \param [in]  frame       Complete BMP message to parse instead of reading the socket - NULL to read the socket
+ * \param [in]  frame_len   Length of the BMP message in frame
  *
  * \return true if more to read, false if the connection is done/closed
  *
  * \throw (char const *str) message indicate error
  */
-bool BMPReader::ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface *mbus_ptr) {
+bool BMPReader::ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface *mbus_ptr,
+                                const u_char *frame, size_t frame_len) {
     bool rval = true;
     string peer_info_key;
+    peer_info *p_info = NULL;
 
-    parseBGP *pBGP;                                 // Pointer to BGP parser
-
-    int read_fd = client->pipe_sock > 0 ? client->pipe_sock : client->c_sock;
-
-    // Data storage structures
-    MsgBusInterface::obj_bgp_peer p_entry;
-
-    // Initialize the parser for BMP messages
-    parseBMP *pBMP = new parseBMP(logger, &p_entry);    // handler for BMP messages
-
-    if (cfg->debug_bmp) {
-        enableDebug();
-        pBMP->enableDebug();
-    }
+    // Reset the parser for the BMP message, which also clears the peer entry
+    pBMP->reset();
 
     char bmp_type = 0;
 
-    MsgBusInterface::obj_router r_object;
     memcpy(router_hash_id, client->hash_id, sizeof(router_hash_id));    // Cache the router hash ID (hash is generated by BMPListener)
-    bzero(&r_object, sizeof(r_object));
-    memcpy(r_object.hash_id, router_hash_id, sizeof(r_object.hash_id));
 
-    // Setup the router record table object
-    memcpy(r_object.ip_addr, client->c_ip, sizeof(client->c_ip));
+    /*
+     * Setup the router record table object. Only init and term messages update the router
+     *    details, so the entry is only fully reset for those.
+     */
+    if (r_object.ip_addr[0] == 0)
+        resetRouterEntry(client);
+    else
+        memcpy(r_object.hash_id, router_hash_id, sizeof(r_object.hash_id));
 
     try {
-        bmp_type = pBMP->handleMessage(read_fd);
+        bmp_type = pBMP->handleMessage(frame, frame_len);
 
         /*
          * Now that we have parsed the BMP message...
@@ -145,8 +249,10 @@ bool BMPReader::ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface
             if (bmp_type != parseBMP::TYPE_PEER_UP)
                 mbus_ptr->update_Peer(p_entry, NULL, NULL, mbus_ptr->PEER_ACTION_FIRST);     // add the peer entry
 
-            if (not peer_info_map[peer_info_key].using_2_octet_asn and p_entry.isTwoOctet) {
-                peer_info_map[peer_info_key].using_2_octet_asn = true;
+            p_info = &peer_info_map[peer_info_key];
+
+            if (not p_info->using_2_octet_asn and p_entry.isTwoOctet) {
+                p_info->using_2_octet_asn = true;
             }
         }
 
@@ -159,16 +265,12 @@ bool BMPReader::ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface
 
                 MsgBusInterface::obj_peer_down_event down_event = {};
 
-                if (pBMP->parsePeerDownEventHdr(read_fd,down_event)) {
-                    pBMP->bufferBMPMessage(read_fd);
+                if (pBMP->parsePeerDownEventHdr(down_event)) {
+                    pBMP->bufferBMPMessage();
 
 
                     // Prepare the BGP parser
-                    pBGP = new parseBGP(logger, mbus_ptr, &p_entry, (char *)r_object.ip_addr,
-                                        &peer_info_map[peer_info_key]);
-
-                    if (cfg->debug_bgp)
-                       pBGP->enableDebug();
+                    pBGP = getBGPParser(mbus_ptr, p_info);
 
                     // Check if the reason indicates we have a BGP message that follows
                     switch (down_event.bmp_reason) {
@@ -183,8 +285,10 @@ bool BMPReader::ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface
                         {
                             // Read two byte code corresponding to the FSM event
                             uint16_t fsm_event = 0 ;
-                            memcpy(&fsm_event, pBMP->bmp_data, 2);
-                            bgp::SWAP_BYTES(&fsm_event);
+                            if (pBMP->bmp_data_len >= 2) {
+                                memcpy(&fsm_event, pBMP->bmp_data, 2);
+                                bgp::SWAP_BYTES(&fsm_event);
+                            }
 
                             snprintf(down_event.error_text, sizeof(down_event.error_text),
                                     "Local (%s) closed peer (%s) session: fsm_event=%d, No BGP notify message.",
@@ -201,15 +305,13 @@ bool BMPReader::ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface
                         }
                     }
 
-                    delete pBGP;            // Free the bgp parser after each use.
-
                     // Add event to the database
                     mbus_ptr->update_Peer(p_entry, NULL, &down_event, mbus_ptr->PEER_ACTION_DOWN);
 
                 } else {
-                    LOG_ERR("Error with client socket %d", read_fd);
+                    LOG_ERR("%s: Unable to parse the BMP peer down header", client->c_ip);
                     // Make sure to free the resource
-                    throw "BMPReader: Unable to read from client socket";
+                    throw "BMPReader: Unable to parse BMP peer down message";
                 }
                 break;
             }
@@ -218,24 +320,22 @@ bool BMPReader::ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface
             {
                 MsgBusInterface::obj_peer_up_event up_event = {};
 
-                if (pBMP->parsePeerUpEventHdr(read_fd, up_event)) {
+                if (pBMP->parsePeerUpEventHdr(up_event)) {
                     LOG_INFO("%s: PEER UP Received, local addr=%s:%hu remote addr=%s:%hu", client->c_ip,
                             up_event.local_ip, up_event.local_port, p_entry.peer_addr, up_event.remote_port);
 
-                    pBMP->bufferBMPMessage(read_fd);
+                    pBMP->bufferBMPMessage();
 
                     // Prepare the BGP parser
-                    pBGP = new parseBGP(logger, mbus_ptr, &p_entry, (char *)r_object.ip_addr,
-                                        &peer_info_map[peer_info_key]);
-
-                    if (cfg->debug_bgp)
-                       pBGP->enableDebug();
+                    pBGP = getBGPParser(mbus_ptr, p_info);
 
                     // Parse the BGP sent/received open messages
                     int read = pBGP->handleUpEvent(pBMP->bmp_data, pBMP->bmp_data_len, &up_event);
 
-                                        // Free the bgp parser
-                    delete pBGP;
+                    if (read == 0) {
+                        LOG_NOTICE("%s: PEER UP Received but the BGP open messages are invalid, skipping.", client->c_ip);
+                        break;
+                    }
 
                     // Read info TLV data
                     if (((int)pBMP->bmp_data_len - read) > 0) {
@@ -253,17 +353,13 @@ bool BMPReader::ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface
             }
 
             case parseBMP::TYPE_ROUTE_MON : { // Route monitoring type
-                pBMP->bufferBMPMessage(read_fd);
+                pBMP->bufferBMPMessage();
 
                 /*
                  * Read and parse the the BGP message from the client.
                  *     parseBGP will update mysql directly
                  */
-                pBGP = new parseBGP(logger, mbus_ptr, &p_entry, (char *)r_object.ip_addr,
-                                    &peer_info_map[peer_info_key]);
-
-                if (cfg->debug_bgp)
-                    pBGP->enableDebug();
+                pBGP = getBGPParser(mbus_ptr, p_info);
 
                 pBGP->handleUpdate(pBMP->bmp_data, pBMP->bmp_data_len);
    		
@@ -281,14 +377,13 @@ bool BMPReader::ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface
 		        cfg->router_baseline_time[str] = 1.2 * (now.tv_sec - client->startTime.tv_sec);  //20% buffer for baseline time 
 		    }		
 		}
-                delete pBGP;
 
                 break;
             }
 
             case parseBMP::TYPE_STATS_REPORT : { // Stats Report
                 MsgBusInterface::obj_stats_report stats = {};
-                if (! pBMP->handleStatsReport(read_fd, stats))
+                if (! pBMP->handleStatsReport(stats))
                     // Add to mysql
                     mbus_ptr->add_StatReport(p_entry, stats);
 
@@ -298,7 +393,8 @@ bool BMPReader::ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface
             case parseBMP::TYPE_INIT_MSG : { // Initiation Message
                 client->initRec = true; 		//indicating that init message is received for the router/client.
 		LOG_INFO("%s: Init message received with length of %u", client->c_ip, pBMP->getBMPLength());
-                pBMP->handleInitMsg(read_fd, r_object);
+                resetRouterEntry(client);
+                pBMP->handleInitMsg(r_object);
 		
                 if(cfg->pat_enabled && r_object.hash_type)
 			hashRouter(client, r_object);
@@ -313,7 +409,8 @@ bool BMPReader::ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface
                 LOG_INFO("%s: Term message received with length of %u", client->c_ip, pBMP->getBMPLength());
 
 
-                pBMP->handleTermMsg(read_fd, r_object);
+                resetRouterEntry(client);
+                pBMP->handleTermMsg(r_object);
 
                 LOG_INFO("Proceeding to disconnect router");
                 mbus_ptr->update_Router(r_object, mbus_ptr->ROUTER_ACTION_TERM);
@@ -329,16 +426,12 @@ bool BMPReader::ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface
         LOG_INFO("%s: Caught: %s", client->c_ip, str);
         disconnect(client, mbus_ptr, parseBMP::TERM_REASON_OPENBMP_CONN_ERR, str);
 
-        delete pBMP;                    // Make sure to free the resource
         throw str;
     }
     
     // Send BMP RAW packet data
     mbus_ptr->send_bmp_raw(router_hash_id, p_entry, pBMP->bmp_packet, pBMP->bmp_packet_len);
 
-    // Free the bmp parser
-    delete pBMP;
-
     return rval;
 }
 
@@ -419,15 +512,13 @@ void BMPReader::hashRouter(BMPListener::ClientInfo *client,MsgBusInterface::obj_
     string c_hash_str;
     MsgBusInterface::hash_toStr(cfg->c_hash_id, c_hash_str);
 
-    MD5 hash;
+    HashId hash;
     hash.update((unsigned char *)hash_val, strlen(hash_val));
     hash.update((unsigned char *)c_hash_str.c_str(), c_hash_str.length());
     hash.finalize();
 
     // Save the hash
-    unsigned char *hash_bin = hash.raw_digest();
-    memcpy(client->hash_id, hash_bin, 16);
-    delete[] hash_bin;
+    hash.raw_digest(client->hash_id);
     memcpy(router_hash_id, client->hash_id, sizeof(router_hash_id));
     memcpy(r_object.hash_id, router_hash_id, sizeof(r_object.hash_id));
     LOG_INFO("Router ID hashed with hash_type: %d", r_object.hash_type);
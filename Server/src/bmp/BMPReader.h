@@ -12,6 +12,7 @@
 
 #include "BMPListener.h"
 #include "BMPReader.h"
+#include "BMPRingBuffer.h"
 #include "AddPathDataContainer.h"
 #include "MsgBusInterface.hpp"
 #include "Logger.h"
@@ -20,6 +21,9 @@
 #include <map>
 #include <memory>
 
+class parseBMP;
+class parseBGP;
+
 /**
  * \class   BMPReader
  *
@@ -62,9 +66,12 @@ public:
      *
      * \param [in]  client      Client information pointer
      * \param [in]  mbus_ptr     The database pointer referencer - DB should be already initialized
+     * \param [in]  frame       Complete BMP message to parse
+     * \param [in]  frame_len   Length of the BMP message in frame
      * \return true if more to read, false if the connection is done/closed
      */
-    bool ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface *mbus_ptr);
+    bool ReadIncomingMsg(BMPListener::ClientInfo *client, MsgBusInterface *mbus_ptr,
+                         const u_char *frame, size_t frame_len);
 
     /**
      * Checks if End-of-RIB is reached for all peers by checking the rate of RIB dumps
@@ -78,15 +85,17 @@ public:
     /**
      * Read messages from BMP stream in a loop
      *
+     * \details BMP messages are parsed in place from the ring that is filled by the
+     *          client socket reader.  The loop ends when the connection is closed or
+     *          the ring is at eof and all complete messages have been parsed.
+     *
      * \param [in]  run         Reference to bool to indicate if loop should continue or not
      * \param [in]  client      Client information pointer
      * \param [in]  mbus_ptr     The database pointer referencer - DB should be already initialized
-     *
-     * \return true if more to read, false if the connection is done/closed
-     *
-     * \throw (char const *str) message indicate error
+     * \param [in]  ring        Ring buffer filled by the client socket reader
      */
-    void readerThreadLoop(bool &run, BMPListener::ClientInfo *client, MsgBusInterface *mbus_ptr);
+    void readerThreadLoop(bool &run, BMPListener::ClientInfo *client, MsgBusInterface *mbus_ptr,
+                          BMPRingBuffer *ring);
 
     /**
      * disconnect/close bmp stream
@@ -135,6 +144,31 @@ private:
     std::map<std::string, peer_info> peer_info_map;
     typedef std::map<std::string, peer_info>::iterator peer_info_map_iter;
 
+    /*
+     * Parsers and entries are reused for each message of the router connection
+     */
+    MsgBusInterface::obj_bgp_peer   p_entry;    ///< Peer entry of the current message
+    MsgBusInterface::obj_router     r_object;   ///< Router entry - only fully reset for init/term messages
+    parseBMP    *pBMP;                      ///< BMP parser
+    parseBGP    *pBGP;                      ///< BGP parser - created on first use
+
+    /**
+     * Get the BGP parser reset for the next BGP message
+     *
+     * \param [in]  mbus_ptr     The database pointer referencer - DB should be already initialized
+     * \param [in]  p_info       Persistent peer information
+     *
+     * \return Pointer to the BGP parser
+     */
+    parseBGP *getBGPParser(MsgBusInterface *mbus_ptr, peer_info *p_info);
+
+    /**
+     * Reset the router entry to the router hash and address only
+     *
+     * \param [in]  client      Client information pointer
+     */
+    void resetRouterEntry(BMPListener::ClientInfo *client);
+
 };
 
 #endif /* BMPReader_H_ */
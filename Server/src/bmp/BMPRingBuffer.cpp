@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include <chrono>
+#include <cstring>
+
+#include "BMPRingBuffer.h"
+
+/**
+ * Class constructor
+ *
+ * \param [in] size     Size of the ring in bytes
+ */
+BMPRingBuffer::BMPRingBuffer(size_t size) {
+    buf_size = size;
+    buf = new u_char[buf_size];
+
+    write_pos = 0;
+    read_pos = 0;
+    eof = false;
+    data_waiting = false;
+    space_waiting = false;
+}
+
+/**
+ * Destructor
+ */
+BMPRingBuffer::~BMPRingBuffer() {
+    delete [] buf;
+}
+
+/**
+ * Producer: Get the contiguous free space at the write position
+ *
+ * \param [out] len     Number of bytes that can be written to the returned pointer
+ *
+ * \return Pointer to write to, len is zero when the ring is full
+ */
+u_char *BMPRingBuffer::writeSpace(size_t &len) {
+    uint64_t w = write_pos.load(std::memory_order_relaxed);
+    uint64_t r = read_pos.load(std::memory_order_acquire);
+
+    size_t offset = w % buf_size;
+
+    len = buf_size - (size_t)(w - r);               // free bytes
+    if (len > buf_size - offset)
+        len = buf_size - offset;                    // limit to end of ring
+
+    return buf + offset;
+}
+
+/**
+ * Producer: Commit bytes written to the pointer returned by writeSpace()
+ *
+ * \param [in] len      Number of bytes written
+ */
+void BMPRingBuffer::commit(size_t len) {
+    write_pos.store(write_pos.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    wake(data_waiting, data_cond);
+}
+
+/**
+ * Producer: Indicate that no more data will be written
+ */
+void BMPRingBuffer::setEof() {
+    eof.store(true, std::memory_order_release);
+    wake(data_waiting, data_cond);
+}
+
+/**
+ * Producer: Wait until there is free space in the ring
+ *
+ * \param [in] timeout_ms   Max time to wait in milliseconds
+ *
+ * \return true if there is free space, false on timeout
+ */
+bool BMPRingBuffer::waitSpace(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    space_waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    bool ready = space_cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] {
+        return write_pos.load(std::memory_order_relaxed) - read_pos.load(std::memory_order_acquire) < buf_size;
+    });
+
+    space_waiting.store(false, std::memory_order_relaxed);
+    return ready;
+}
+
+/**
+ * Consumer: Check if the producer has indicated that no more data will be written
+ */
+bool BMPRingBuffer::isEof() {
+    return eof.load(std::memory_order_acquire);
+}
+
+/**
+ * Consumer: Number of bytes available to read
+ */
+size_t BMPRingBuffer::size() {
+    return (size_t)(write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_relaxed));
+}
+
+/**
+ * Consumer: Number of bytes available to read without wrapping the end of the ring
+ */
+size_t BMPRingBuffer::contiguous() {
+    size_t avail = size();
+    size_t to_end = buf_size - (size_t)(read_pos.load(std::memory_order_relaxed) % buf_size);
+
+    return avail < to_end ? avail : to_end;
+}
+
+/**
+ * Consumer: Wait until more than len bytes are available to read or eof is set
+ *
+ * \param [in] len          Number of bytes already available, which are not enough
+ * \param [in] timeout_ms   Max time to wait in milliseconds
+ *
+ * \return true if more data is available or eof is set, false on timeout
+ */
+bool BMPRingBuffer::waitData(size_t len, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    data_waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    bool ready = data_cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this, len] {
+        return isEof() or size() > len;
+    });
+
+    data_waiting.store(false, std::memory_order_relaxed);
+    return ready;
+}
+
+/**
+ * Consumer: Get the data at the read position
+ *
+ * \param [in] len      Number of bytes needed - must not be larger than size()
+ * \param [in] scratch  Buffer of at least len bytes, used only if the data wraps
+ *
+ * \return Pointer to len bytes of data
+ */
+const u_char *BMPRingBuffer::peek(size_t len, u_char *scratch) {
+    size_t offset = (size_t)(read_pos.load(std::memory_order_relaxed) % buf_size);
+
+    if (offset + len <= buf_size)
+        return buf + offset;
+
+    // Data wraps the end of the ring
+    size_t first = buf_size - offset;
+    memcpy(scratch, buf + offset, first);
+    memcpy(scratch + first, buf, len - first);
+
+    return scratch;
+}
+
+/**
+ * Consumer: Release bytes that have been read
+ *
+ * \param [in] len      Number of bytes to release
+ */
+void BMPRingBuffer::consume(size_t len) {
+    read_pos.store(read_pos.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    wake(space_waiting, space_cond);
+}
+
+/**
+ * Wake the other side if it is waiting on cond
+ *
+ * \details The fence pairs with the one in the wait methods: either the waiter sees the
+ *          new position, or this sees the waiting flag.  Taking the lock before notifying
+ *          prevents the wake from landing between the waiter's check and its wait.
+ */
+void BMPRingBuffer::wake(std::atomic<bool> &waiting, std::condition_variable &cond) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (waiting.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cond.notify_one();
+    }
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef BMPRINGBUFFER_H_
+#define BMPRINGBUFFER_H_
+
+#include <sys/types.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+
+#define BMP_RING_WAIT_MS    100         ///< Max time a side of the ring blocks before rechecking its run flag
+
+/**
+ * \class   BMPRingBuffer
+ *
+ * \brief   Single producer/single consumer lock free byte ring
+ * \details The socket reader (producer) reads directly into the ring and the
+ *          BMP reader (consumer) parses messages in place from the ring. Only one
+ *          thread may call the producer methods and only one thread may call the
+ *          consumer methods.
+ *
+ *          Data returned by peek() remains valid until consume() is called.
+ *
+ *          Either side can block with waitData()/waitSpace() until the other side
+ *          commits or consumes.  The other side only takes the lock to wake it when
+ *          it is waiting.
+ */
+class BMPRingBuffer {
+public:
+    /**
+     * Class constructor
+     *
+     * \param [in] size     Size of the ring in bytes
+     */
+    BMPRingBuffer(size_t size);
+
+    virtual ~BMPRingBuffer();
+
+    /**
+     * Producer: Get the contiguous free space at the write position
+     *
+     * \param [out] len     Number of bytes that can be written to the returned pointer
+     *
+     * \return Pointer to write to, len is zero when the ring is full
+     */
+    u_char *writeSpace(size_t &len);
+
+    /**
+     * Producer: Commit bytes written to the pointer returned by writeSpace()
+     *
+     * \param [in] len      Number of bytes written
+     */
+    void commit(size_t len);
+
+    /**
+     * Producer: Indicate that no more data will be written
+     */
+    void setEof();
+
+    /**
+     * Producer: Wait until there is free space in the ring
+     *
+     * \param [in] timeout_ms   Max time to wait in milliseconds
+     *
+     * \return true if there is free space, false on timeout
+     */
+    bool waitSpace(int timeout_ms);
+
+    /**
+     * Consumer: Check if the producer has indicated that no more data will be written
+     */
+    bool isEof();
+
+    /**
+     * Consumer: Number of bytes available to read
+     */
+    size_t size();
+
+    /**
+     * Consumer: Number of bytes available to read without wrapping the end of the ring
+     */
+    size_t contiguous();
+
+    /**
+     * Consumer: Wait until more than len bytes are available to read or eof is set
+     *
+     * \param [in] len          Number of bytes already available, which are not enough
+     * \param [in] timeout_ms   Max time to wait in milliseconds
+     *
+     * \return true if more data is available or eof is set, false on timeout
+     */
+    bool waitData(size_t len, int timeout_ms);
+
+    /**
+     * Consumer: Get the data at the read position
+     *
+     * \details A pointer into the ring is returned when the data does not wrap the end of the
+     *          ring.  Otherwise the data is copied to scratch.
+     *
+     * \param [in] len      Number of bytes needed - must not be larger than size()
+     * \param [in] scratch  Buffer of at least len bytes, used only if the data wraps
+     *
+     * \return Pointer to len bytes of data
+     */
+    const u_char *peek(size_t len, u_char *scratch);
+
+    /**
+     * Consumer: Release bytes that have been read
+     *
+     * \param [in] len      Number of bytes to release
+     */
+    void consume(size_t len);
+
+private:
+    u_char                  *buf;           ///< Ring buffer
+    size_t                  buf_size;       ///< Size of the ring buffer in bytes
+
+    std::atomic<uint64_t>   write_pos;      ///< Total bytes written (updated by producer)
+    std::atomic<uint64_t>   read_pos;       ///< Total bytes consumed (updated by consumer)
+    std::atomic<bool>       eof;            ///< No more data will be written
+
+    std::mutex              mutex;          ///< Lock for waiting on the conditions
+    std::condition_variable data_cond;      ///< Signaled on commit/eof when the consumer is waiting
+    std::condition_variable space_cond;     ///< Signaled on consume when the producer is waiting
+    std::atomic<bool>       data_waiting;   ///< Consumer is waiting in waitData()
+    std::atomic<bool>       space_waiting;  ///< Producer is waiting in waitSpace()
+
+    /**
+     * Wake the other side if it is waiting on cond
+     */
+    void wake(std::atomic<bool> &waiting, std::condition_variable &cond);
+};
+
+#endif /* BMPRINGBUFFER_H_ */
@@ -16,7 +16,6 @@
 #include <string>
 #include <sys/time.h>
 #include <unistd.h>
-#include <sys/socket.h>
 #include <arpa/inet.h>
 #include "bgp_common.h"
 
@@ -34,38 +33,157 @@
  */
 parseBMP::parseBMP(Logger *logPtr, MsgBusInterface::obj_bgp_peer *peer_entry) {
     debug = false;
+    logger = logPtr;
+
+    // Set the passed storage for the router entry items.
+    p_entry = peer_entry;
+
+    reset();
+}
+
+parseBMP::~parseBMP() {
+    // clean up
+}
+
+/**
+ * Reset the parser for the next BMP message
+ */
+void parseBMP::reset() {
     bmp_type = -1; // Initially set to error
     bmp_len = 0;
-    logger = logPtr;
 
+    bmp_data = NULL;
     bmp_data_len = 0;
-    bzero(bmp_data, sizeof(bmp_data));
 
+    bmp_packet = NULL;
     bmp_packet_len = 0;
-    bzero(bmp_packet, sizeof(bmp_packet));
 
-    // Set the passed storage for the router entry items.
-    p_entry = peer_entry;
+    frame_data = NULL;
+    frame_len = 0;
+    frame_pos = 0;
+
     bzero(p_entry, sizeof(MsgBusInterface::obj_bgp_peer));
 }
 
-parseBMP::~parseBMP() {
-    // clean up
+/**
+ * Read data from the BMP message
+ *
+ * \details The read position is advanced by len bytes.
+ *
+ * \param [in]  len         Number of bytes to read
+ *
+ * \returns Pointer to len bytes at the current read position, NULL if the message is too short
+ */
+const u_char *parseBMP::readData(size_t len) {
+    if (frame_len - frame_pos < len)
+        return NULL;
+
+    const u_char *data = frame_data + frame_pos;
+    frame_pos += len;
+
+    return data;
 }
 
 /**
- * Recv wrapper for recv() to enable packet buffering
+ * Get the BMP message (frame) length from a buffered stream
+ *
+ * \param [in] buf        Pointer to buffered stream data
+ * \param [in] len        Length of the buffered data in bytes
+ *
+ * \returns Length of the complete BMP message including all headers. Zero is returned
+ *          if more data is needed to determine the length.
+ *
+ * \throws (const char *) on error.   String will detail error message.
  */
-ssize_t parseBMP::Recv(int sockfd, void *buf, size_t len, int flags) {
-    ssize_t read = recv(sockfd, buf, len, flags);
+uint32_t parseBMP::getFrameLength(const u_char *buf, size_t len) {
+    uint32_t frame_len;
+    uint16_t bgp_len;
+
+    if (len < 1 + BMP_HDRv3_LEN)
+        return 0;
+
+    if (buf[0] == 3) {
+        memcpy(&frame_len, buf + 1, 4);
+        bgp::SWAP_BYTES(&frame_len);
+
+        if (frame_len < 1 + BMP_HDRv3_LEN)
+            throw "ERROR: BMP length is smaller than the common header size";
+
+        if (frame_len - 1 - BMP_HDRv3_LEN > BGP_MAX_MSG_SIZE)
+            throw "ERROR: BMP length is larger than max possible BGP size";
+
+        return frame_len;
+    }
+
+    else if (buf[0] == 1 or buf[0] == 2) {
+        /*
+         * Older versions do not include the length, so it's based on the data that follows the header
+         */
+        frame_len = 1 + BMP_HDRv1v2_LEN;
+
+        if (len < frame_len)
+            return 0;
+
+        switch (buf[1]) {
+            case TYPE_ROUTE_MON:
+                if (len < frame_len + 18)
+                    return 0;
+
+                memcpy(&bgp_len, buf + frame_len + 16, 2);
+                bgp::SWAP_BYTES(&bgp_len);
+                frame_len += bgp_len;
+                break;
 
-    if (read > 0)
-        if ((bmp_packet_len + read) < BMP_PACKET_BUF_SIZE) {
-            memcpy(&bmp_packet[bmp_packet_len], buf, read);
-            bmp_packet_len += read;
+            case TYPE_STATS_REPORT: {
+                uint32_t stats_cnt;
+                uint16_t stat_len;
+
+                if (len < frame_len + 4)
+                    return 0;
+
+                memcpy(&stats_cnt, buf + frame_len, 4);
+                bgp::SWAP_BYTES(&stats_cnt);
+                frame_len += 4;
+
+                for (uint32_t i = 0; i < stats_cnt; i++) {
+                    if (len < frame_len + 4)
+                        return 0;
+
+                    memcpy(&stat_len, buf + frame_len + 2, 2);
+                    bgp::SWAP_BYTES(&stat_len);
+                    frame_len += 4 + stat_len;
+
+                    if (frame_len > BMP_PACKET_BUF_SIZE)
+                        throw "ERROR: BMP stats report is larger than max buffer size";
+                }
+                break;
+            }
+
+            case TYPE_PEER_DOWN:
+                if (len < frame_len + 1)
+                    return 0;
+
+                // Reason 1 and 3 include the BGP notification message
+                if (buf[frame_len] == 1 or buf[frame_len] == 3) {
+                    if (len < frame_len + 1 + 18)
+                        return 0;
+
+                    memcpy(&bgp_len, buf + frame_len + 1 + 16, 2);
+                    bgp::SWAP_BYTES(&bgp_len);
+                    frame_len += bgp_len;
+                }
+
+                frame_len++;
+                break;
+
+            default:
+                throw "ERROR: Unsupported v1/v2 BMP message type";
         }
 
-    return read;
+        return frame_len;
+    }
+
+    throw "ERROR: Unsupported BMP message version";
 }
 
 /**
@@ -75,39 +193,40 @@ ssize_t parseBMP::Recv(int sockfd, void *buf, size_t len, int flags) {
  *      returns the BMP message type. A type of >= 0 is normal,
  *      < 0 indicates an error
  *
- * \param [in] sock     Socket to read the BMP message from
+ * \param [in] frame      Pointer to the complete BMP message, starting at the version byte
+ * \param [in] frame_len  Length of the BMP message in bytes
  *
  * \throws (const char *) on error.   String will detail error message.
  */
-char parseBMP::handleMessage(int sock) {
-    unsigned char ver;
-    ssize_t bytes_read;
+char parseBMP::handleMessage(const u_char *frame, size_t frame_len) {
+    const u_char *ver;
+
+    frame_data = frame;
+    this->frame_len = frame_len;
+    frame_pos = 0;
+
+    bmp_packet = (u_char *)frame;
+    bmp_packet_len = frame_len;
 
     // Get the version in order to determine what we read next
     //    As of Junos 10.4R6.5, it supports version 1
-    bytes_read = Recv(sock, &ver, 1, MSG_WAITALL);
-
-    if (bytes_read < 0)
-        throw "(1) Failed to read from socket.";
-    else if (bytes_read == 0)
-        throw "(2) Connection closed";
-    else if (bytes_read != 1)
-        throw "(3) Cannot read the BMP version byte from socket";
+    if ((ver = readData(1)) == NULL)
+        throw "(3) Cannot read the BMP version byte";
 
     // check the version
-    if (ver == 3) { // draft-ietf-grow-bmp-04 - 07
-        parseBMPv3(sock);
+    if (*ver == 3) { // draft-ietf-grow-bmp-04 - 07
+        parseBMPv3();
     }
 
     // Handle the older versions
-    else if (ver == 1 || ver == 2) {
-        SELF_DEBUG("Older BMP version of %d, consider upgrading the router to support BMPv3", ver);
-        parseBMPv2(sock);
+    else if (*ver == 1 || *ver == 2) {
+        SELF_DEBUG("Older BMP version of %d, consider upgrading the router to support BMPv3", *ver);
+        parseBMPv2();
 
     } else
         throw "ERROR: Unsupported BMP message version";
 
-    SELF_DEBUG("BMP version = %d\n", ver);
+    SELF_DEBUG("BMP version = %d\n", *ver);
 
     return bmp_type;
 }
@@ -117,88 +236,58 @@ char parseBMP::handleMessage(int sock) {
 *
 * \details
 *      v2 uses the same common header, but adds the Peer Up message type.
-*
-* \param [in]  sock        Socket to read the message from
 */
-void parseBMP::parseBMPv2(int sock) {
+void parseBMP::parseBMPv2() {
     struct common_hdr_old c_hdr = { 0 };
-    ssize_t i = 0;
-    char buf[256] = {0};
+    const u_char *data;
 
-    SELF_DEBUG("parseBMP: sock=%d: Reading %d bytes", sock, BMP_HDRv1v2_LEN);
+    SELF_DEBUG("parseBMP: Reading %d bytes", BMP_HDRv1v2_LEN);
 
     bmp_len = 0;
 
-    if ((i = Recv(sock, &c_hdr, BMP_HDRv1v2_LEN, MSG_WAITALL))
-            != BMP_HDRv1v2_LEN) {
-        SELF_DEBUG("sock=%d: Couldn't read all bytes, read %zd bytes",
-                sock, i);
+    if ((data = readData(BMP_HDRv1v2_LEN)) == NULL) {
+        SELF_DEBUG("Couldn't read all bytes, message is only %zu bytes", frame_len);
         throw "ERROR: Cannot read v1/v2 BMP common header.";
     }
+    memcpy(&c_hdr, data, BMP_HDRv1v2_LEN);
+
+    /*
+     * Older versions do not include the length. The message is already framed based on the
+     *   data that follows the header, so the remaining length is the rest of the message.
+     */
+    bmp_len = frame_len - frame_pos;
+
     // Process the message based on type
     bmp_type = c_hdr.type;
     switch (c_hdr.type) {
         case 0: // Route monitoring
-            SELF_DEBUG("sock=%d : BMP MSG : route monitor", sock);
-
-            // Get the length of the remaining message by reading the BGP length
-            if ((i=Recv(sock, buf, 18, MSG_PEEK | MSG_WAITALL)) == 18) {
-                uint16_t len;
-                memcpy(&len, (buf+16), 2);
-                bgp::SWAP_BYTES(&len);
-                bmp_len = len;
-
-            } else {
-                LOG_ERR("sock=%d: Failed to read BGP message to get length of BMP message", sock);
-                throw "Failed to read BGP message for BMP length";
-            }
+            SELF_DEBUG("BMP MSG : route monitor");
             break;
 
         case 1: // Statistics Report
-            SELF_DEBUG("sock=%d : BMP MSG : stats report", sock);
-            LOG_INFO("sock=%d : BMP MSG : stats report", sock);
+            SELF_DEBUG("BMP MSG : stats report");
+            LOG_INFO("BMP MSG : stats report");
             break;
 
         case 2: // Peer down notification
-            LOG_INFO("sock=%d: BMP MSG: Peer down", sock);
-
-            // Get the length of the remaining message by reading the BGP length
-            if ((i=Recv(sock, buf, 1, MSG_PEEK)) != 1) {
-
-                // Is there a BGP message
-                if (buf[0] == 1 or buf[0] == 3) {
-                    if ((i = Recv(sock, buf, 18, MSG_PEEK | MSG_WAITALL)) == 18) {
-                        memcpy(&bmp_len, buf + 16, 2);
-                        bgp::SWAP_BYTES(&bmp_len);
-
-                    } else {
-                        LOG_ERR("sock=%d: Failed to read peer down BGP message to get length of BMP message", sock);
-                        throw "Failed to read BGP message for BMP length";
-                    }
-                }
-            } else {
-                LOG_ERR("sock=%d: Failed to read peer down reason", sock);
-                throw "Failed to read BMP peer down reason";
-            }
-
-            SELF_DEBUG("sock=%d : BMP MSG : peer down", sock);
+            LOG_INFO("BMP MSG: Peer down");
             break;
 
         case 3: // Peer Up notification
-            LOG_ERR("sock=%d: Peer UP not supported with older BMP version since no one has implemented it", sock);
+            LOG_ERR("Peer UP not supported with older BMP version since no one has implemented it");
 
-            SELF_DEBUG("sock=%d : BMP MSG : peer up", sock);
+            SELF_DEBUG("BMP MSG : peer up");
             throw "ERROR: Will need to add support for peer up if it's really used.";
             break;
     }
 
-    SELF_DEBUG("sock=%d : Peer Type is %d", sock, c_hdr.peer_type);
+    SELF_DEBUG("Peer Type is %d", c_hdr.peer_type);
 
     if (c_hdr.peer_flags & 0x80) { // V flag of 1 means this is IPv6
         p_entry->isIPv4 = false;
         inet_ntop(AF_INET6, c_hdr.peer_addr, peer_addr, sizeof(peer_addr));
 
-        SELF_DEBUG("sock=%d : Peer address is IPv6", sock);
+        SELF_DEBUG("Peer address is IPv6");
 
     } else {
         p_entry->isIPv4 = true;
@@ -206,13 +295,13 @@ void parseBMP::parseBMPv2(int sock) {
                 c_hdr.peer_addr[12], c_hdr.peer_addr[13], c_hdr.peer_addr[14],
                 c_hdr.peer_addr[15]);
 
-        SELF_DEBUG("sock=%d : Peer address is IPv4", sock);
+        SELF_DEBUG("Peer address is IPv4");
     }
 
     if (c_hdr.peer_flags & 0x40) { // L flag of 1 means this is Loc-RIP and not Adj-RIB-In
-        SELF_DEBUG("sock=%d : Msg is for Loc-RIB", sock);
+        SELF_DEBUG("Msg is for Loc-RIB");
     } else {
-        SELF_DEBUG("sock=%d : Msg is for Adj-RIB-In", sock);
+        SELF_DEBUG("Msg is for Adj-RIB-In");
     }
 
     // convert the BMP byte messages to human readable strings
@@ -253,6 +342,8 @@ void parseBMP::parseBMPv2(int sock) {
     p_entry->peer_as = strtoll(peer_as, NULL, 16);
     strncpy(p_entry->peer_bgp_id, peer_bgp_id, sizeof(peer_bgp_id));
     strncpy(p_entry->peer_rd, peer_rd, sizeof(peer_rd));
+    memcpy(p_entry->peer_addr_bin, c_hdr.peer_addr, sizeof(p_entry->peer_addr_bin));
+    memcpy(p_entry->peer_rd_bin, c_hdr.peer_dist_id, sizeof(p_entry->peer_rd_bin));
 
     // Save the advertised timestamp
     uint32_t ts = c_hdr.ts_secs;
@@ -269,11 +360,11 @@ void parseBMP::parseBMPv2(int sock) {
         // Global Instance
         p_entry->isL3VPN = 0;
 
-    SELF_DEBUG("sock=%d : Peer Address = %s", sock, peer_addr);
-    SELF_DEBUG("sock=%d : Peer AS = (%x-%x)%x:%x", sock,
+    SELF_DEBUG("Peer Address = %s", peer_addr);
+    SELF_DEBUG("Peer AS = (%x-%x)%x:%x",
             c_hdr.peer_as[0], c_hdr.peer_as[1], c_hdr.peer_as[2],
             c_hdr.peer_as[3]);
-    SELF_DEBUG("sock=%d : Peer RD = %s", sock, peer_rd);
+    SELF_DEBUG("Peer RD = %s", peer_rd);
 }
 
 /**
@@ -283,21 +374,25 @@ void parseBMP::parseBMPv2(int sock) {
  *      v3 has a different header structure and changes the peer
  *      header format.
  *
- * \param [in]  sock        Socket to read the message from
  */
-void parseBMP::parseBMPv3(int sock) {
+void parseBMP::parseBMPv3() {
     struct common_hdr_v3 c_hdr = { 0 };
+    const u_char *data;
 
     SELF_DEBUG("Parsing BMP version 3 (rfc7854)");
-    if ((Recv(sock, &c_hdr, BMP_HDRv3_LEN, MSG_WAITALL)) != BMP_HDRv3_LEN) {
+    if ((data = readData(BMP_HDRv3_LEN)) == NULL) {
         throw "ERROR: Cannot read v3 BMP common header.";
     }
+    memcpy(&c_hdr, data, BMP_HDRv3_LEN);
 
     // Change to host order
     bgp::SWAP_BYTES(&c_hdr.len);
 
     SELF_DEBUG("BMP v3: type = %x len=%d", c_hdr.type, c_hdr.len);
 
+    if (c_hdr.len > frame_len)
+        throw "ERROR: BMP length is larger than the message";
+
     // Adjust length to remove common header size
     c_hdr.len -= 1 + BMP_HDRv3_LEN;
 
@@ -311,24 +406,24 @@ void parseBMP::parseBMPv3(int sock) {
     switch (c_hdr.type) {
         case TYPE_ROUTE_MON: // Route monitoring
             SELF_DEBUG("BMP MSG : route monitor");
-            parsePeerHdr(sock);
+            parsePeerHdr();
             break;
 
         case TYPE_STATS_REPORT: // Statistics Report
             SELF_DEBUG("BMP MSG : stats report");
-            parsePeerHdr(sock);
+            parsePeerHdr();
             break;
 
         case TYPE_PEER_UP: // Peer Up notification
         {
             SELF_DEBUG("BMP MSG : peer up");
-            parsePeerHdr(sock);
+            parsePeerHdr();
 
             break;
         }
         case TYPE_PEER_DOWN: // Peer down notification
             SELF_DEBUG("BMP MSG : peer down");
-            parsePeerHdr(sock);
+            parsePeerHdr();
             break;
 
         case TYPE_INIT_MSG:
@@ -409,24 +504,23 @@ void parseBMP::parsePeerFlags(u_char peer_type, u_char peer_flags) {
 /**
  * Parse the v3 peer header
  *
- * \param [in]  sock        Socket to read the message from
  */
-void parseBMP::parsePeerHdr(int sock) {
+void parseBMP::parsePeerHdr() {
     peer_hdr_v3 p_hdr = {0};
-    int i;
+    const u_char *data;
 
     bzero(&p_hdr, sizeof(p_hdr));
 
-    if ((i = Recv(sock, &p_hdr, BMP_PEER_HDR_LEN, MSG_WAITALL))
-        != BMP_PEER_HDR_LEN) {
-        LOG_ERR("sock=%d: Couldn't read all bytes, read %d bytes",
-                sock, i);
-    }
+    if ((data = readData(BMP_PEER_HDR_LEN)) == NULL) {
+        LOG_ERR("Couldn't read all bytes of the peer header, message is only %zu bytes",
+                frame_len);
+    } else
+        memcpy(&p_hdr, data, BMP_PEER_HDR_LEN);
 
     // Adjust the common header length to remove the peer header (as it's been read)
     bmp_len -= BMP_PEER_HDR_LEN;
 
-    SELF_DEBUG("parsePeerHdr: sock=%d : Peer Type is %d", sock,
+    SELF_DEBUG("parsePeerHdr: Peer Type is %d",
                p_hdr.peer_type);
 
     parsePeerFlags(p_hdr.peer_type, p_hdr.peer_flags);
@@ -435,14 +529,14 @@ void parseBMP::parsePeerHdr(int sock) {
         snprintf(peer_addr, sizeof(peer_addr), "%d.%d.%d.%d",
                  p_hdr.peer_addr[12], p_hdr.peer_addr[13], p_hdr.peer_addr[14],
                  p_hdr.peer_addr[15]);
-        SELF_DEBUG("sock=%d : Peer address is IPv4 %s", sock,
+        SELF_DEBUG("Peer address is IPv4 %s",
                    peer_addr);
 
     }
     else {
         inet_ntop(AF_INET6, p_hdr.peer_addr, peer_addr, sizeof(peer_addr));
 
-        SELF_DEBUG("sock=%d : Peer address is IPv6 %s", sock,
+        SELF_DEBUG("Peer address is IPv6 %s",
                    peer_addr);
     }
 
@@ -453,11 +547,11 @@ void parseBMP::parsePeerHdr(int sock) {
              p_hdr.peer_as[2] << 8 | p_hdr.peer_as[3]);
 
     inet_ntop(AF_INET, p_hdr.peer_bgp_id, peer_bgp_id, sizeof(peer_bgp_id));
-    SELF_DEBUG("sock=%d : Peer BGP-ID %x.%x.%x.%x (%s)", sock, p_hdr.peer_bgp_id[0],
+    SELF_DEBUG("Peer BGP-ID %x.%x.%x.%x (%s)", p_hdr.peer_bgp_id[0],
                p_hdr.peer_bgp_id[1],p_hdr.peer_bgp_id[2],p_hdr.peer_bgp_id[3], peer_bgp_id);
 
     // Format based on the type of RD
-    SELF_DEBUG("sock=%d : Peer RD type = %d %d", sock, p_hdr.peer_dist_id[0], p_hdr.peer_dist_id[1]);
+    SELF_DEBUG("Peer RD type = %d %d", p_hdr.peer_dist_id[0], p_hdr.peer_dist_id[1]);
     switch (p_hdr.peer_dist_id[1]) {
         case 1: // admin = 4bytes (IP address), assign number = 2bytes
             snprintf(peer_rd, sizeof(peer_rd), "%d.%d.%d.%d:%d",
@@ -487,6 +581,8 @@ void parseBMP::parsePeerHdr(int sock) {
     p_entry->peer_as = strtoll(peer_as, NULL, 16);
     strncpy(p_entry->peer_bgp_id, peer_bgp_id, sizeof(p_entry->peer_bgp_id));
     strncpy(p_entry->peer_rd, peer_rd, sizeof(p_entry->peer_rd));
+    memcpy(p_entry->peer_addr_bin, p_hdr.peer_addr, sizeof(p_entry->peer_addr_bin));
+    memcpy(p_entry->peer_rd_bin, p_hdr.peer_dist_id, sizeof(p_entry->peer_rd_bin));
 
     // Save the advertised timestamp
     bgp::SWAP_BYTES(&p_hdr.ts_secs);
@@ -509,11 +605,11 @@ void parseBMP::parsePeerHdr(int sock) {
     }
 
 
-    SELF_DEBUG("sock=%d : Peer Address = %s", sock, peer_addr);
-    SELF_DEBUG("sock=%d : Peer AS = (%x-%x)%x:%x", sock,
+    SELF_DEBUG("Peer Address = %s", peer_addr);
+    SELF_DEBUG("Peer AS = (%x-%x)%x:%x",
                 p_hdr.peer_as[0], p_hdr.peer_as[1], p_hdr.peer_as[2],
                 p_hdr.peer_as[3]);
-    SELF_DEBUG("sock=%d : Peer RD = %s", sock, peer_rd);
+    SELF_DEBUG("Peer RD = %s", peer_rd);
 }
 
 /**
@@ -521,17 +617,18 @@ void parseBMP::parsePeerHdr(int sock) {
  *
  * \details This method will update the db peer_down_event struct with BMP header info.
  *
- * \param [in]  sock       Socket to read the message from
  * \param [out] down_event Reference to the peer down event storage (will be updated with bmp info)
  *
  * \returns true if successfully parsed the bmp peer down header, false otherwise
  */
-bool parseBMP::parsePeerDownEventHdr(int sock, MsgBusInterface::obj_peer_down_event &down_event) {
-    char reason;
+bool parseBMP::parsePeerDownEventHdr(MsgBusInterface::obj_peer_down_event &down_event) {
+    const u_char *data;
+
+    if ((data = readData(1)) != NULL) {
+        char reason = *data;
 
-    if (Recv(sock, &reason, 1, 0) == 1) {
-        LOG_NOTICE("sock=%d : %s: BGP peer down notification with reason code: %d",
-                    sock, p_entry->peer_addr, reason);
+        LOG_NOTICE("%s: BGP peer down notification with reason code: %d",
+                    p_entry->peer_addr, reason);
 
         // Indicate that data has been read
         bmp_len--;
@@ -549,32 +646,31 @@ bool parseBMP::parsePeerDownEventHdr(int sock, MsgBusInterface::obj_peer_down_ev
 /**
  * Buffer remaining BMP message
  *
- * \details This method will read the remaining amount of BMP data and store it in the instance variable bmp_data.
- *          Normally this is used to store the BGP message so that it can be parsed.
- *
- * \param [in]  sock       Socket to read the message from
- *
- * \returns true if successfully parsed the bmp peer down header, false otherwise
+ * \details This method will set the instance variable bmp_data to the remaining BMP data.
+ *          Normally this is used for the BGP message so that it can be parsed.
  *
  * \throws String error
  */
-void parseBMP::bufferBMPMessage(int sock) {
+void parseBMP::bufferBMPMessage() {
     if (bmp_len <= 0)
         return;
 
-    if (bmp_len > sizeof(bmp_data)) {
-        LOG_WARN("sock=%d: BMP message is invalid, length of %d is larger than max buffer size of %d",
-                sock, bmp_len, sizeof(bmp_data));
+    if (bmp_len > BMP_PACKET_BUF_SIZE) {
+        LOG_WARN("BMP message is invalid, length of %d is larger than max buffer size of %d",
+                bmp_len, BMP_PACKET_BUF_SIZE);
         throw "BMP message length is too large for buffer, invalid BMP sender";
     }
 
-    SELF_DEBUG("sock=%d: Buffering %d from socket", sock, bmp_len);
-    if ((bmp_data_len=Recv(sock, bmp_data, bmp_len, MSG_WAITALL)) != bmp_len) {
-         LOG_ERR("sock=%d: Couldn't read all %d bytes into buffer",
-                 sock, bmp_len);
+    SELF_DEBUG("Buffering %d bytes of BMP data", bmp_len);
+    if ((bmp_data = (u_char *)readData(bmp_len)) == NULL) {
+         LOG_ERR("Couldn't read all %d bytes, only %zu bytes remain in the message",
+                 bmp_len, frame_len - frame_pos);
+         bmp_data_len = 0;
          throw "Error while reading BMP data into buffer";
     }
 
+    bmp_data_len = bmp_len;
+
     // Indicate no more data is left to read
     bmp_len = 0;
 
@@ -599,6 +695,9 @@ void parseBMP::parsePeerUpInfo(u_char *data, int len) {
      */
     for (int i = 0; i < len; i += BMP_INFO_TLV_HDR_LEN) {
 
+        if (i + BMP_INFO_TLV_HDR_LEN > len)
+            break;                                      // Truncated TLV
+
         memcpy(&info, bufPtr, BMP_INFO_TLV_HDR_LEN);
         info.info = NULL;
         bgp::SWAP_BYTES(&info.len);
@@ -610,6 +709,8 @@ void parseBMP::parsePeerUpInfo(u_char *data, int len) {
 
         if (info.len > 0) {
             infoLen = sizeof(infoBuf) < info.len ? sizeof(infoBuf) : info.len;
+            if (infoLen > len - i - BMP_INFO_TLV_HDR_LEN)
+                infoLen = len - i - BMP_INFO_TLV_HDR_LEN;
             bzero(infoBuf, sizeof(infoBuf));
             memcpy(infoBuf, bufPtr, infoLen);
             bufPtr += infoLen;                     // Move pointer past the info data
@@ -642,20 +743,20 @@ void parseBMP::parsePeerUpInfo(u_char *data, int len) {
  *
  * \details This method will update the db peer_up_event struct with BMP header info.
  *
- * \param [in]  sock     Socket to read the message from
  * \param [out] up_event Reference to the peer up event storage (will be updated with bmp info)
  *
  * \returns true if successfully parsed the bmp peer up header, false otherwise
  */
-bool parseBMP::parsePeerUpEventHdr(int sock, MsgBusInterface::obj_peer_up_event &up_event) {
+bool parseBMP::parsePeerUpEventHdr(MsgBusInterface::obj_peer_up_event &up_event) {
 
 
-    unsigned char local_addr[16];
+    const u_char *local_addr;
+    const u_char *data;
     bool isParseGood = true;
     int bytes_read = 0;
 
     // Get the local address
-    if ( Recv(sock, &local_addr, 16, MSG_WAITALL) != 16)
+    if ((local_addr = readData(16)) == NULL)
         isParseGood = false;
     else
         bytes_read += 16;
@@ -672,20 +773,22 @@ bool parseBMP::parsePeerUpEventHdr(int sock, MsgBusInterface::obj_peer_up_event
     }
 
     // Get the local port
-    if (isParseGood and Recv(sock, &up_event.local_port, 2, MSG_WAITALL) != 2)
+    if (isParseGood and (data = readData(2)) == NULL)
             isParseGood = false;
 
     else if (isParseGood) {
         bytes_read += 2;
+        memcpy(&up_event.local_port, data, 2);
         bgp::SWAP_BYTES(&up_event.local_port);
     }
 
     // Get the remote port
-    if (isParseGood and Recv(sock, &up_event.remote_port, 2, MSG_WAITALL) != 2)
+    if (isParseGood and (data = readData(2)) == NULL)
         isParseGood = false;
 
     else if (isParseGood) {
         bytes_read += 2;
+        memcpy(&up_event.remote_port, data, 2);
         bgp::SWAP_BYTES(&up_event.remote_port);
     }
 
@@ -694,7 +797,7 @@ bool parseBMP::parsePeerUpEventHdr(int sock, MsgBusInterface::obj_peer_up_event
 
 
     // Buffer the remaining data for BMP message
-    bufferBMPMessage(sock);
+    bufferBMPMessage();
 
     // Validate if still good
     if (isParseGood == false) {
@@ -702,7 +805,7 @@ bool parseBMP::parsePeerUpEventHdr(int sock, MsgBusInterface::obj_peer_up_event
                    peer_addr, bytes_read);
 
         // Buffer the remaining data for BMP message
-        bufferBMPMessage(sock);
+        bufferBMPMessage();
     }
 
     return isParseGood;
@@ -712,26 +815,28 @@ bool parseBMP::parsePeerUpEventHdr(int sock, MsgBusInterface::obj_peer_up_event
 /**
  * Parse and return back the stats report
  *
- * \param [in]  sock        Socket to read the stats message from
  * \param [out] stats       Reference to stats report data
  *
  * \return true if error, false if no error
  */
-bool parseBMP::handleStatsReport(int sock, MsgBusInterface::obj_stats_report &stats) {
+bool parseBMP::handleStatsReport(MsgBusInterface::obj_stats_report &stats) {
     unsigned long stats_cnt = 0; // Number of counter stat objects to follow
     unsigned char b[8];
+    const u_char *data;
 
-    if ((Recv(sock, b, 4, MSG_WAITALL)) != 4)
+    if ((data = readData(4)) == NULL)
         throw "ERROR:  Cannot proceed since we cannot read the stats mon counter";
 
+    memcpy(b, data, 4);
+
     bmp_len -= 4;
 
     // Reverse the bytes and update int
     bgp::SWAP_BYTES(b, 4);
     memcpy((void*) &stats_cnt, (void*) b, 4);
 
-    SELF_DEBUG("sock = %d : STATS REPORT Count: %u (%d %d %d %d)",
-                sock, stats_cnt, b[0], b[1], b[2], b[3]);
+    SELF_DEBUG("STATS REPORT Count: %u (%d %d %d %d)",
+                 stats_cnt, b[0], b[1], b[2], b[3]);
 
     // Vars used per counter object
     unsigned short stat_type = 0;
@@ -740,10 +845,13 @@ bool parseBMP::handleStatsReport(int sock, MsgBusInterface::obj_stats_report &st
     // Loop through each stats object
     for (unsigned long i = 0; i < stats_cnt; i++) {
 
-        if ((Recv(sock, &stat_type, 2, MSG_WAITALL)) != 2)
+        if ((data = readData(2)) == NULL)
             throw "ERROR: Cannot proceed since we cannot read the stats type.";
-        if ((Recv(sock, &stat_len, 2, MSG_WAITALL)) != 2)
+        memcpy(&stat_type, data, 2);
+
+        if ((data = readData(2)) == NULL)
             throw "ERROR: Cannot proceed since we cannot read the stats len.";
+        memcpy(&stat_len, data, 2);
 
         bmp_len -= 4;
 
@@ -751,15 +859,16 @@ bool parseBMP::handleStatsReport(int sock, MsgBusInterface::obj_stats_report &st
         bgp::SWAP_BYTES(&stat_type);
         bgp::SWAP_BYTES(&stat_len);
 
-        SELF_DEBUG("sock=%d STATS: %lu : TYPE = %u LEN = %u", sock,
+        SELF_DEBUG("STATS: %lu : TYPE = %u LEN = %u",
                     i, stat_type, stat_len);
 
         // check if this is a 32 bit number  (default)
         if (stat_len == 4 or stat_len == 8) {
 
             // Read the stats counter - 32/64 bits
-            if ((Recv(sock, b, stat_len, MSG_WAITALL)) == stat_len) {
+            if ((data = readData(stat_len)) != NULL) {
                 bmp_len -= stat_len;
+                memcpy(b, data, stat_len);
 
                 // convert the bytes from network to host order
                 bgp::SWAP_BYTES(b, stat_len);
@@ -802,13 +911,13 @@ bool parseBMP::handleStatsReport(int sock, MsgBusInterface::obj_stats_report &st
                         if (stat_len == 8) {
                             memcpy((void*)&value64bit, (void *)b, 8);
 
-                            SELF_DEBUG("%s: sock=%d: stat type %d length of %d value of %lu is not yet implemented",
-                                    p_entry->peer_addr, sock, stat_type, stat_len, value64bit);
+                            SELF_DEBUG("%s: stat type %d length of %d value of %lu is not yet implemented",
+                                    p_entry->peer_addr, stat_type, stat_len, value64bit);
                         } else {
                             memcpy((void*)&value32bit, (void *)b, 4);
 
-                            SELF_DEBUG("%s: sock=%d: stat type %d length of %d value of %lu is not yet implemented",
-                                     p_entry->peer_addr, sock, stat_type, stat_len, value32bit);
+                            SELF_DEBUG("%s: stat type %d length of %d value of %lu is not yet implemented",
+                                     p_entry->peer_addr, stat_type, stat_len, value32bit);
                         }
                     }
                 }
@@ -818,11 +927,11 @@ bool parseBMP::handleStatsReport(int sock, MsgBusInterface::obj_stats_report &st
             }
 
         } else { // stats len not expected, we need to skip it.
-            SELF_DEBUG("sock=%d : skipping stats report '%u' because length of '%u' is not expected.",
-                        sock, stat_type, stat_len);
+            SELF_DEBUG("skipping stats report '%u' because length of '%u' is not expected.",
+                         stat_type, stat_len);
 
-            while (stat_len-- > 0)
-                Recv(sock, &b[0], 1, 0);
+            if (readData(stat_len) == NULL)
+                throw "ERROR: Cannot proceed since we cannot read the stats data.";
         }
     }
 
@@ -832,24 +941,26 @@ bool parseBMP::handleStatsReport(int sock, MsgBusInterface::obj_stats_report &st
 /**
  * handle the initiation message and update the router entry
  *
- * \param [in]     sock        Socket to read the init message from
  * \param [in/out] r_entry     Already defined router entry reference (will be updated)
  */
-void parseBMP::handleInitMsg(int sock, MsgBusInterface::obj_router &r_entry) {
+void parseBMP::handleInitMsg(MsgBusInterface::obj_router &r_entry) {
     info_tlv_msg info;
     char infoBuf[sizeof(r_entry.initiate_data)];
     int infoLen;
     r_entry.hash_type=0;    
 
     // Buffer the init message for parsing
-    bufferBMPMessage(sock);
+    bufferBMPMessage();
 
     u_char *bufPtr = bmp_data;
 
     /*
      * Loop through the init message (in buffer) to parse each TLV
      */
-    for (int i=0; i < bmp_data_len; i += BMP_INFO_TLV_HDR_LEN) {
+    for (size_t i=0; i < bmp_data_len; i += BMP_INFO_TLV_HDR_LEN) {
+        if (i + BMP_INFO_TLV_HDR_LEN > bmp_data_len)
+            break;                                      // Truncated TLV
+
         memcpy(&info, bufPtr, BMP_INFO_TLV_HDR_LEN);
         info.info = NULL;
         bgp::SWAP_BYTES(&info.len);
@@ -862,6 +973,8 @@ void parseBMP::handleInitMsg(int sock, MsgBusInterface::obj_router &r_entry) {
 
         if (info.len > 0) {
             infoLen = sizeof(infoBuf) < info.len ? sizeof(infoBuf) : info.len;
+            if ((size_t)infoLen > bmp_data_len - i - BMP_INFO_TLV_HDR_LEN)
+                infoLen = bmp_data_len - i - BMP_INFO_TLV_HDR_LEN;
             bzero(infoBuf, sizeof(infoBuf));
             memcpy(infoBuf, bufPtr, infoLen);
             bufPtr += infoLen;                     // Move pointer past the info data
@@ -922,23 +1035,25 @@ void parseBMP::handleInitMsg(int sock, MsgBusInterface::obj_router &r_entry) {
 /**
  * handle the termination message, router entry will be updated
  *
- * \param [in]     sock        Socket to read the term message from
  * \param [in/out] r_entry     Already defined router entry reference (will be updated)
  */
-void parseBMP::handleTermMsg(int sock, MsgBusInterface::obj_router &r_entry) {
+void parseBMP::handleTermMsg(MsgBusInterface::obj_router &r_entry) {
     term_msg_v3 termMsg;
     char infoBuf[sizeof(r_entry.term_data)];
     int infoLen;
 
     // Buffer the init message for parsing
-    bufferBMPMessage(sock);
+    bufferBMPMessage();
 
     u_char *bufPtr = bmp_data;
 
     /*
      * Loop through the term message (in buffer) to parse each TLV
      */
-    for (int i=0; i < bmp_data_len; i += BMP_TERM_MSG_LEN) {
+    for (size_t i=0; i < bmp_data_len; i += BMP_TERM_MSG_LEN) {
+        if (i + BMP_TERM_MSG_LEN > bmp_data_len)
+            break;                                      // Truncated TLV
+
         memcpy(&termMsg, bufPtr, BMP_TERM_MSG_LEN);
         termMsg.info = NULL;
         bgp::SWAP_BYTES(&termMsg.len);
@@ -950,6 +1065,8 @@ void parseBMP::handleTermMsg(int sock, MsgBusInterface::obj_router &r_entry) {
 
         if (termMsg.len > 0) {
             infoLen = sizeof(infoBuf) < termMsg.len ? sizeof(infoBuf) : termMsg.len;
+            if ((size_t)infoLen > bmp_data_len - i - BMP_TERM_MSG_LEN)
+                infoLen = bmp_data_len - i - BMP_TERM_MSG_LEN;
             bzero(infoBuf, sizeof(infoBuf));
             memcpy(infoBuf, bufPtr, infoLen);
             bufPtr += infoLen;                     // Move pointer past the info data
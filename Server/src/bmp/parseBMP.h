@@ -31,7 +31,8 @@
  *
  * \brief   Parser for BMP messages
  * \details This class can be used as needed to parse BMP messages. This
- *          class will read directly from the socket to read the BMP message.
+ *          class parses a complete BMP message from memory.  The message is
+ *          normally framed from the buffered router stream using getFrameLength().
  */
 class parseBMP {
 public:
@@ -147,22 +148,21 @@ public:
 
 
     /**
-     * BMP message buffer (normally only contains the BGP message)
-     *      BMP data message is read into this buffer so that it can be passed to the BGP parser for handling.
-     *      Complete BGP message is read, otherwise error is generated.
+     * BMP message data (normally only contains the BGP message)
+     *      Points to the remaining BMP message data within the message being parsed so that it can be
+     *      passed to the BGP parser for handling.  Set by bufferBMPMessage().
+     *
+     * \note The BGP parsers take non-const data, but do not modify it.
      */
-    u_char      bmp_data[BMP_PACKET_BUF_SIZE + 1];
+    u_char      *bmp_data;
     size_t      bmp_data_len;              ///< Length/size of data in the data buffer
 
     /**
-     * BMP packet buffer - This is a copy of the BMP packet.
-     *
-     * Only BMPv3 messages get stored in the packet buffer since it wasn't until
-     * BMPv3 that the length was specified.
+     * BMP packet - Points to the complete BMP message being parsed
      *
-     * Length of packet is the common header message length (bytes)
+     * Length of packet is the complete BMP message length (bytes)
      */
-    u_char      bmp_packet[BMP_PACKET_BUF_SIZE + 1];
+    u_char      *bmp_packet;
     size_t      bmp_packet_len;
 
     /**
@@ -183,83 +183,101 @@ public:
     virtual ~parseBMP();
 
     /**
-     * Recv wrapper for recv() to enable packet buffering
+     * Reset the parser for the next BMP message
+     *
+     * \details The parser is reused for each BMP message of a router connection. The
+     *          peer entry is cleared.
+     */
+    void reset();
+
+    /**
+     * Get the BMP message (frame) length from a buffered stream
+     *
+     * \details The buffer must start at the start of a BMP message (version byte).  The
+     *          length is determined from the common header, or for v1/v2 by reading the
+     *          lengths of the data that follows the header.
+     *
+     * \param [in] buf        Pointer to buffered stream data
+     * \param [in] len        Length of the buffered data in bytes
+     *
+     * \returns Length of the complete BMP message including all headers. Zero is returned
+     *          if more data is needed to determine the length.  The returned length can be larger
+     *          than len, which indicates that more data is needed to read the complete message.
+     *
+     * \throws (const char *) on error.   String will detail error message.
      */
-    ssize_t Recv(int sockfd, void *buf, size_t len, int flags);
+    static uint32_t getFrameLength(const u_char *buf, size_t len);
 
     /**
      * Process the incoming BMP message
      *
+     * \details The message must remain valid until the message has been parsed, including
+     *          the use of bmp_data and bmp_packet.
+     *
      * \returns
      *      returns the BMP message type. A type of >= 0 is normal,
      *      < 0 indicates an error
      *
-     * \param [in] sock     Socket to read the BMP message from
+     * \param [in] frame      Pointer to the complete BMP message, starting at the version byte
+     * \param [in] frame_len  Length of the BMP message in bytes
      *
      * \throws (const char *) on error.   String will detail error message.
      */
-    char handleMessage(int sock);
+    char handleMessage(const u_char *frame, size_t frame_len);
 
     /**
      * Parse and return back the stats report
      *
-     * \param [in]  sock        Socket to read the stats message from
      * \param [out] stats       Reference to stats report data
      *
      * \return true if error, false if no error
      */
-    bool handleStatsReport(int sock, MsgBusInterface::obj_stats_report &stats);
+    bool handleStatsReport(MsgBusInterface::obj_stats_report &stats);
 
     /**
      * handle the initiation message and udpate the router entry
      *
-     * \param [in]     sock        Socket to read the init message from
      * \param [in/out] r_entry     Already defined router entry reference (will be updated)
      */
-    void handleInitMsg(int sock, MsgBusInterface::obj_router &r_entry);
+    void handleInitMsg(MsgBusInterface::obj_router &r_entry);
 
     /**
      * handle the termination message, router entry will be updated
      *
-     * \param [in]     sock        Socket to read the term message from
      * \param [in/out] r_entry     Already defined router entry reference (will be updated)
      */
-    void handleTermMsg(int sock, MsgBusInterface::obj_router &r_entry);
+    void handleTermMsg(MsgBusInterface::obj_router &r_entry);
     /**
      * Buffer remaining BMP message
      *
-     * \details This method will read the remaining amount of BMP data and store it in the instance variable bmp_data.
-     *          Normally this is used to store the BGP message so that it can be parsed.
+     * \details This method will set the instance variable bmp_data to the remaining BMP data.
+     *          Normally this is used for the BGP message so that it can be parsed.
      *
-     * \param [in]  sock       Socket to read the message from
-     *
-     * \returns true if successfully parsed the bmp peer down header, false otherwise
+     * \throws String error
      */
-    void bufferBMPMessage(int sock);
+    void bufferBMPMessage();
 
     /**
      * Parse the v3 peer down BMP header
      *
      *      This method will update the db peer_down_event struct with BMP header info.
      *
-     * \param [in]  sock       Socket to read the message from
      * \param [out] down_event Reference to the peer down event storage (will be updated with bmp info)
      *
      * \returns true if successfully parsed the bmp peer down header, false otherwise
      */
-    bool parsePeerDownEventHdr(int sock, MsgBusInterface::obj_peer_down_event &down_event);
+    bool parsePeerDownEventHdr(MsgBusInterface::obj_peer_down_event &down_event);
 
     /**
      * Parse the v3 peer up BMP header
      *
      *      This method will update the db peer_up_event struct with BMP header info.
      *
-     * \param [in]  sock     Socket to read the message from
      * \param [out] up_event Reference to the peer up event storage (will be updated with bmp info)
      *
      * \returns true if successfully parsed the bmp peer up header, false otherwise
      */
-    bool parsePeerUpEventHdr(int sock, MsgBusInterface::obj_peer_up_event &up_event);
+    bool parsePeerUpEventHdr(MsgBusInterface::obj_peer_up_event &up_event);
 
     /**
      * get current BMP message type
@@ -293,6 +311,10 @@ private:
 
     MsgBusInterface::obj_bgp_peer *p_entry;         ///< peer table entry - will be updated with BMP info
     char            bmp_type;                   ///< The BMP message type
+
+    const u_char    *frame_data;                ///< BMP message being parsed
+    size_t          frame_len;                  ///< Length of the BMP message being parsed
+    size_t          frame_pos;                  ///< Current read position in the BMP message
     uint32_t        bmp_len;                    ///< Length of the BMP message - does not include the common header size
 
     // Storage for the byte converted strings - This must match the MsgBusInterface bgp_peer struct
@@ -301,15 +323,24 @@ private:
     char peer_rd[32];                           ///< Printed format of the peer RD
     char peer_bgp_id[16];                       ///< Printed format of the peer bgp ID
 
+    /**
+     * Read data from the BMP message
+     *
+     * \details The read position is advanced by len bytes.
+     *
+     * \param [in]  len         Number of bytes to read
+     *
+     * \returns Pointer to len bytes at the current read position, NULL if the message is too short
+     */
+    const u_char *readData(size_t len);
+
     /**
      * Parse v1 and v2 BMP header
      *
      * \details
      *      v2 uses the same common header, but adds the Peer Up message type.
-     *
-     * \param [in]  sock        Socket to read the message from
      */
-    void parseBMPv2(int sock);
+    void parseBMPv2();
 
     /**
      * Parse v3 BMP header
@@ -317,18 +348,14 @@ private:
      * \details
      *      v3 has a different header structure and changes the peer
      *      header format.
-     *
-     * \param [in]  sock        Socket to read the message from
      */
-    void parseBMPv3(int sock);
+    void parseBMPv3();
 
 
     /**
      * Parse the v3 peer header
-     *
-     * \param [in]  sock        Socket to read the message from
      */
-    void parsePeerHdr(int sock);
+    void parsePeerHdr();
 
     /**
      * Parse BMP peer header flags by peer type
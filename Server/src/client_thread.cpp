@@ -43,12 +43,14 @@ void ClientThread_cancel(void *arg) {
             close(cInfo->client->c_sock);
         }
 
-        usleep(50000);
+        // Stop the reader thread, eof wakes it if it is waiting for data
+        if (cInfo->bmp_run != NULL)
+            *cInfo->bmp_run = false;
 
-        close(cInfo->client->pipe_sock);
-        close(cInfo->bmp_write_end_sock);
+        if (cInfo->ring != NULL)
+            cInfo->ring->setEof();
 
-        if (cInfo->bmp_reader_thread->joinable())
+        if (cInfo->bmp_reader_thread != NULL and cInfo->bmp_reader_thread->joinable())
             cInfo->bmp_reader_thread->join();
 
         if (cInfo->bmp_reader_thread != NULL) {
@@ -60,6 +62,11 @@ void ClientThread_cancel(void *arg) {
             delete cInfo->mbus;
             cInfo->mbus = NULL;
         }
+
+        if (cInfo->ring != NULL) {
+            delete cInfo->ring;
+            cInfo->ring = NULL;
+        }
     }
 }
 
@@ -82,10 +89,12 @@ void *ClientThread(void *arg) {
     cInfo.client = &thr->client;
     cInfo.log = thr->log;
     cInfo.closing = false;
+    cInfo.bmp_reader_thread = NULL;
+    cInfo.ring = NULL;
+    cInfo.bmp_run = NULL;
 
-    int sock_fds[2];
+    bool bmp_run = true;
     pollfd pfd;
-    unsigned char *sock_buf = NULL;
 
     /*
      * Setup the cleanup routine for when the thread is canceled.
@@ -95,7 +104,7 @@ void *ClientThread(void *arg) {
 
     try {
         // connect to message bus
-        cInfo.mbus = new msgBus_kafka(logger, thr->cfg, thr->cfg->c_hash_id);
+        cInfo.mbus = new msgBus_kafka(logger, thr->cfg, thr->producer, thr->resolver, thr->cfg->c_hash_id);
 
         if (thr->cfg->debug_msgbus)
             cInfo.mbus->enableDebug();
@@ -104,160 +113,67 @@ void *ClientThread(void *arg) {
         LOG_INFO("Thread started to monitor BMP from router %s using socket %d buffer in bytes = %u",
                 cInfo.client->c_ip, cInfo.client->c_sock, thr->cfg->bmp_buffer_size);
 
-        // Buffer client socket using pipe
-        socketpair(PF_LOCAL, SOCK_STREAM, 0, sock_fds);
-        cInfo.bmp_write_end_sock = sock_fds[1];
-        cInfo.client->pipe_sock = sock_fds[0];
+        // Buffer client socket using a ring that is shared with the reader thread
+        cInfo.ring = new BMPRingBuffer(thr->cfg->bmp_buffer_size);
+        cInfo.client->pipe_sock = 0;
 
         /*
-         * Create and start the reader thread to monitor the pipe fd (read end)
+         * Create and start the reader thread to parse the messages in the ring
          */
-        bool bmp_run = true;
-        //cInfo.bmp_reader_thread = new std::thread([&] {rBMP.readerThreadLoop(bmp_run,cInfo.client,
+        cInfo.bmp_run = &bmp_run;
         cInfo.bmp_reader_thread = new std::thread(&BMPReader::readerThreadLoop, &rBMP, std::ref(bmp_run), cInfo.client,
-                                                                             (MsgBusInterface *)cInfo.mbus );
-
-        // Variables to handle circular buffer
-        sock_buf = new unsigned char[thr->cfg->bmp_buffer_size];
-        int bytes_read = 0;
-        int write_buf_pos = 0;
-        int read_buf_pos = 0;
-        bool wrap_state = false;
-        unsigned char *sock_buf_read_ptr = sock_buf;
-        unsigned char *sock_buf_write_ptr = sock_buf;
+                                                  (MsgBusInterface *)cInfo.mbus, cInfo.ring);
 
         /*
          * monitor and buffer the client socket
          */
         while (bmp_run) {
+            size_t space;
+            u_char *write_ptr = cInfo.ring->writeSpace(space);
 
-            if ((wrap_state and (write_buf_pos + 1) < read_buf_pos) or
-                    (not wrap_state and write_buf_pos < thr->cfg->bmp_buffer_size)) {
-
-                pfd.fd = cInfo.client->c_sock;
-                pfd.events = POLLIN | POLLHUP | POLLERR;
-                pfd.revents = 0;
-
-                // Attempt to read from socket
-                if (poll(&pfd, 1, 5)) {
-                    if (pfd.revents & POLLHUP or pfd.revents & POLLERR) {
-                        bytes_read = 0;                     // Indicate to close the connection
-
-                    } else {
-                            if (not wrap_state)     // write is ahead of read in terms of buffer pointer
-                                bytes_read = read(cInfo.client->c_sock, sock_buf_write_ptr,
-                                                  thr->cfg->bmp_buffer_size - write_buf_pos);
-
-                            else if (read_buf_pos > write_buf_pos) // read is ahead of write in terms of buffer pointer
-                                bytes_read = read(cInfo.client->c_sock, sock_buf_write_ptr,
-                                                  read_buf_pos - write_buf_pos - 1);
-                    }
-
-                    if (bytes_read <= 0) {
-                        close(sock_fds[0]);
-                        close(sock_fds[1]);
-                        close(cInfo.client->c_sock);
-
-                        bmp_run = false;
-                        //cInfo.bmp_reader_thread->join();
-                        //delete cInfo.bmp_reader_thread;
-                        //cInfo.bmp_reader_thread = NULL;
-                        break;
-                    }
-                    else {
-                        sock_buf_write_ptr += bytes_read;
-                        write_buf_pos += bytes_read;
-                    }
-
-                }
-
-            } else if (write_buf_pos >= thr->cfg->bmp_buffer_size) { // if reached end of buffer space
-                // Reached end of buffer, wrap to start
-                write_buf_pos = 0;
-                sock_buf_write_ptr = sock_buf;
-                wrap_state = true;
-                //LOG_INFO("write buffer wrapped");
+            if (space == 0) {
+                // Ring is full, wait for reader to catch up
+                cInfo.ring->waitSpace(BMP_RING_WAIT_MS);
+                continue;
             }
 
-            /** DEBUG ONLY
+            pfd.fd = cInfo.client->c_sock;
+            pfd.events = POLLIN | POLLHUP | POLLERR;
+            pfd.revents = 0;
 
-            else {
-                LOG_INFO("%s: buffer stall, waiting for read to catch up  w=%u r=%u",  cInfo.client->c_ipv4,
-                         write_buf_pos, read_buf_pos);
-            }
+            // Attempt to read from socket
+            if (poll(&pfd, 1, BMP_RING_WAIT_MS) > 0) {
+                ssize_t bytes_read = read(cInfo.client->c_sock, write_ptr, space);
 
-            if (write_buf_pos != read_buf_pos)
-                LOG_INFO("%s: CHECK: state=%d w=%u r=%u",  cInfo.client->c_ipv4, wrap_state, write_buf_pos, read_buf_pos);
-            **/
-
-            if ((not wrap_state and read_buf_pos < write_buf_pos) or
-                    (wrap_state and read_buf_pos < thr->cfg->bmp_buffer_size)) {
-
-                pfd.fd = cInfo.bmp_write_end_sock;
-                pfd.events = POLLOUT | POLLHUP | POLLERR;
-                pfd.revents = 0;
-
-                // Attempt to write buffer to bmp reader
-                if (poll(&pfd, 1, 10)) {
-
-                    if (pfd.revents & POLLHUP or pfd.revents & POLLERR) {
-                        close(sock_fds[0]);
-                        close(sock_fds[1]);
-                        close(cInfo.client->c_sock);
-
-                        bmp_run = false;
-                        //cInfo.bmp_reader_thread->join();
-                        //delete cInfo.bmp_reader_thread;
-                        //cInfo.bmp_reader_thread = NULL;
-                        break;
-                    }
-
-                    if (not wrap_state) // Write buffer is a head of read in terms of buffer pointer
-                        bytes_read = write(cInfo.bmp_write_end_sock, sock_buf_read_ptr,
-                                           (write_buf_pos - read_buf_pos) > CLIENT_WRITE_BUFFER_BLOCK_SIZE ?
-                                           CLIENT_WRITE_BUFFER_BLOCK_SIZE : (write_buf_pos - read_buf_pos));
-
-                    else // Read buffer is ahead of write in terms of buffer pointer
-                        bytes_read = write(cInfo.bmp_write_end_sock, sock_buf_read_ptr,
-                                           (thr->cfg->bmp_buffer_size - read_buf_pos) > CLIENT_WRITE_BUFFER_BLOCK_SIZE ?
-                                           CLIENT_WRITE_BUFFER_BLOCK_SIZE : (thr->cfg->bmp_buffer_size - read_buf_pos));
-
-                    if (bytes_read > 0) {
-                        sock_buf_read_ptr += bytes_read;
-                        read_buf_pos += bytes_read;
-                    }
+                if (bytes_read <= 0) {
+                    // Reader thread will parse the remaining messages and disconnect the router
+                    cInfo.ring->setEof();
+                    break;
                 }
-            }
-            else if (read_buf_pos >= thr->cfg->bmp_buffer_size) {
-                read_buf_pos = 0;
-                sock_buf_read_ptr = sock_buf;
-                wrap_state = false;
-                //LOG_INFO("read buffer wrapped");
+
+                cInfo.ring->commit(bytes_read);
             }
         }
 
+        // Wait for the reader to finish with the ring
+        if (cInfo.bmp_reader_thread->joinable())
+            cInfo.bmp_reader_thread->join();
+
         LOG_INFO("%s: Thread for sock [%d] ended normally", cInfo.client->c_ip, cInfo.client->c_sock);
 
     } catch (char const *str) {
         LOG_INFO("%s: %s - Thread for sock [%d] ended", cInfo.client->c_ip, str, cInfo.client->c_sock);
-        close(sock_fds[0]);
-        close(sock_fds[1]);
+        bmp_run = false;
 #ifndef __APPLE__
     } catch (abi::__forced_unwind&) {
-        close(sock_fds[0]);
-        close(sock_fds[1]);
         throw;
 #endif
 
     } catch (...) {
         LOG_INFO("%s: Thread for sock [%d] ended abnormally: ", cInfo.client->c_ip, cInfo.client->c_sock);
-        close(sock_fds[0]);
-        close(sock_fds[1]);
+        bmp_run = false;
     }
 
-    if (sock_buf != NULL)
-        delete[] sock_buf;
-
     pthread_cleanup_pop(0);
 
     // Indicate that we are no longer running
@@ -280,6 +196,11 @@ void *ClientThread(void *arg) {
             delete cInfo.mbus;
             cInfo.mbus = NULL;
         }
+
+        if (cInfo.ring != NULL) {
+            delete cInfo.ring;
+            cInfo.ring = NULL;
+        }
     }
 
     // Exit the thread
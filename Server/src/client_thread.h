@@ -12,17 +12,18 @@
 
 #include "MsgBusImpl_kafka.h"
 #include "BMPListener.h"
+#include "BMPRingBuffer.h"
 #include "Logger.h"
 #include "Config.h"
 #include <thread>
 
-#define CLIENT_WRITE_BUFFER_BLOCK_SIZE    8192        // Number of bytes to write to BMP reader from buffer
-
 struct ThreadMgmt {
     pthread_t thr;
     BMPListener::ClientInfo client;
     Config *cfg;
     Logger *log;
+    MsgBusSink *producer;               // Shared message bus sink
+    DnsResolver *resolver;              // Shared DNS resolver
     bool running;                       // true if running, zero if not running
     bool baselineTimeout;		        // true if past the baseline time of the router
 };
@@ -33,7 +34,8 @@ struct ClientThreadInfo {
     Logger *log;
 
     std::thread *bmp_reader_thread;
-    int bmp_write_end_sock;
+    BMPRingBuffer *ring;               // Ring shared by the socket reader and the BMP reader thread
+    bool *bmp_run;                     // Run flag of the BMP reader thread
 
     bool closing;                      // Indicates if client is closing normally (set when socket is disconnected)
 
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include <cstring>
+
+#include "hash_id.h"
+#include "md5_multi.h"
+#include "xxh3.h"
+
+HashId::algorithm HashId::alg = HashId::HASH_ALG_MD5;
+
+/**
+ * Set the algorithm - must be called before any hash is generated
+ *
+ * \param [in] alg          Algorithm to use
+ */
+void HashId::setAlgorithm(algorithm alg) {
+    HashId::alg = alg;
+}
+
+/**
+ * Get the name of the algorithm in use
+ */
+const char *HashId::algorithmName() {
+    switch (alg) {
+        case HASH_ALG_XXH3_128:
+            return "xxh3-128";
+
+        default:
+            return "md5";
+    }
+}
+
+/**
+ * Compute the hash_id of each message as a batch
+ *
+ * \param [in]  msgs         Array of count message pointers
+ * \param [in]  lens         Array of count message lengths in bytes
+ * \param [in]  count        Number of messages
+ * \param [out] digests      Array of count pointers to 16 byte digest buffers
+ */
+void HashId::digestBatch(const unsigned char * const *msgs, const size_t *lens, size_t count,
+                         unsigned char * const *digests) {
+    if (alg == HASH_ALG_XXH3_128) {
+        for (size_t i = 0; i < count; i++)
+            xxh3_128(msgs[i], lens[i], digests[i]);
+
+    } else
+        MD5Multi::digest(msgs, lens, count, digests);
+}
+
+/**
+ * Constructor
+ */
+HashId::HashId() {
+    buf_len = 0;
+}
+
+/**
+ * Add data to the hash
+ *
+ * \details XXH3 hashes the complete input at once, so the input is buffered until finalize().
+ *
+ * \param [in] input        Data to add
+ * \param [in] len          Length of data in bytes
+ */
+void HashId::update(const unsigned char *input, size_t len) {
+    if (alg == HASH_ALG_MD5) {
+        md5.update(const_cast<unsigned char *>(input), len);
+        return;
+    }
+
+    if (overflow.empty() and buf_len + len <= sizeof(buf)) {
+        memcpy(buf + buf_len, input, len);
+        buf_len += len;
+
+    } else {
+        if (overflow.empty())
+            overflow.assign((char *)buf, buf_len);
+
+        overflow.append((const char *)input, len);
+    }
+}
+
+/**
+ * Finalize the hash - no more data can be added
+ */
+void HashId::finalize() {
+    if (alg == HASH_ALG_MD5) {
+        md5.finalize();
+
+    } else if (overflow.empty())
+        xxh3_128(buf, buf_len, digest);
+
+    else
+        xxh3_128((const unsigned char *)overflow.data(), overflow.size(), digest);
+}
+
+/**
+ * Copy the 16 byte hash to the caller's buffer
+ *
+ * \param [out] dest        16 byte buffer
+ */
+void HashId::raw_digest(unsigned char *dest) {
+    if (alg == HASH_ALG_MD5)
+        md5.raw_digest(dest);
+    else
+        memcpy(dest, digest, sizeof(digest));
+}
+
+/**
+ * Start a new hash, reusing this instance
+ */
+void HashId::reset() {
+    if (alg == HASH_ALG_MD5)
+        md5.reset();
+
+    buf_len = 0;
+    overflow.clear();
+}
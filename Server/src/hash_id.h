@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef HASH_ID_H_
+#define HASH_ID_H_
+
+#include <cstddef>
+#include <string>
+
+#include "md5.h"
+
+#define HASH_ID_BUF_SIZE            1024        ///< Input size buffered without allocation (xxh3)
+
+/**
+ * \class   HashId
+ *
+ * \brief   Generates the 16 byte hash_id of routers, peers and table rows
+ * \details The algorithm is selected once at startup by base.hash_algorithm.  MD5 is the
+ *          default.  XXH3-128 is a faster non-cryptographic hash with the same 16 byte width,
+ *          but it produces different hash IDs than MD5.
+ *
+ *          Usage matches the MD5 class: update(), finalize(), raw_digest() and reset().
+ */
+class HashId {
+public:
+    enum algorithm {
+        HASH_ALG_MD5 = 0,                       ///< MD5 (default)
+        HASH_ALG_XXH3_128                       ///< XXH3 128 bit
+    };
+
+    /**
+     * Set the algorithm - must be called before any hash is generated
+     *
+     * \param [in] alg          Algorithm to use
+     */
+    static void setAlgorithm(algorithm alg);
+
+    /**
+     * Get the name of the algorithm in use
+     */
+    static const char *algorithmName();
+
+    /**
+     * Compute the hash_id of each message as a batch
+     *
+     * \param [in]  msgs         Array of count message pointers
+     * \param [in]  lens         Array of count message lengths in bytes
+     * \param [in]  count        Number of messages
+     * \param [out] digests      Array of count pointers to 16 byte digest buffers
+     */
+    static void digestBatch(const unsigned char * const *msgs, const size_t *lens, size_t count,
+                            unsigned char * const *digests);
+
+    HashId();
+
+    /**
+     * Add data to the hash
+     *
+     * \param [in] input        Data to add
+     * \param [in] len          Length of data in bytes
+     */
+    void update(const unsigned char *input, size_t len);
+
+    /**
+     * Finalize the hash - no more data can be added
+     */
+    void finalize();
+
+    /**
+     * Copy the 16 byte hash to the caller's buffer
+     *
+     * \param [out] dest        16 byte buffer
+     */
+    void raw_digest(unsigned char *dest);
+
+    /**
+     * Start a new hash, reusing this instance
+     */
+    void reset();
+
+private:
+    static algorithm    alg;                    ///< Algorithm in use (process wide)
+
+    MD5                 md5;                    ///< MD5 context (HASH_ALG_MD5)
+
+    unsigned char       buf[HASH_ID_BUF_SIZE];  ///< Buffered input (HASH_ALG_XXH3_128)
+    size_t              buf_len;                ///< Length of the buffered input
+    std::string         overflow;               ///< Buffered input when larger than buf
+
+    unsigned char       digest[16];             ///< Finalized digest (HASH_ALG_XXH3_128)
+};
+
+#endif /* HASH_ID_H_ */
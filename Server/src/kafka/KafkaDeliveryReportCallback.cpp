@@ -8,7 +8,19 @@
  */
 
 #include "KafkaDeliveryReportCallback.h"
+#include "KafkaProducerService.h"
+
+/**
+ * Constructor for class
+ *
+ * \param [in] service  Producer service of the messages
+ */
+KafkaDeliveryReportCallback::KafkaDeliveryReportCallback(KafkaProducerService *service) {
+    this->service = service;
+}
 
 void KafkaDeliveryReportCallback::dr_cb (RdKafka::Message &message) {
     //std::cout << "Message delivery for (" << message.len() << " bytes): " << message.errstr() << std::endl;
-}
\ No newline at end of file
+
+    service->deliveryReport(message);
+}
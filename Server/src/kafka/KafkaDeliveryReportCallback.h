@@ -11,11 +11,28 @@
 #define OPENBMP_KAFKADELIVERYREPORTCALLBACK_H
 
 #include <librdkafka/rdkafkacpp.h>
-#include "Logger.h"
 
+class KafkaProducerService;
+
+/**
+ * \brief Hands the delivery report of each delivered (or failed) message to the producer service
+ *
+ * \details Messages are produced without copy; the message opaque is the queued message
+ *          holding the pool_buffer of the payload.  See KafkaProducerService::deliveryReport()
+ */
 class KafkaDeliveryReportCallback : public RdKafka::DeliveryReportCb {
 public:
+    /**
+     * Constructor for class
+     *
+     * \param [in] service  Producer service of the messages
+     */
+    KafkaDeliveryReportCallback(KafkaProducerService *service);
+
     void dr_cb (RdKafka::Message &message);
+
+private:
+    KafkaProducerService *service;              ///< Producer service of the messages
 };
 
 #endif //OPENBMP_KAFKADELIVERYREPORTCALLBACK_H
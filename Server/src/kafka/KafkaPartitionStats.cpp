@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include "KafkaPartitionStats.h"
+
+/**
+ * Add a delivered message
+ *
+ * \param [in] topic        Topic name
+ * \param [in] partition    Partition
+ * \param [in] bytes        Message length
+ */
+void KafkaPartitionStats::add(const std::string &topic, int32_t partition, size_t bytes) {
+    if (partition < 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<counters> &parts = topics[topic];
+
+    if (parts.size() <= (size_t)partition) {
+        counters zero = { 0, 0 };
+        parts.resize(partition + 1, zero);
+    }
+
+    parts[partition].msgs++;
+    parts[partition].bytes += bytes;
+}
+
+/**
+ * Get the counters
+ *
+ * \param [out] stats       Copy of the counters of all topics
+ */
+void KafkaPartitionStats::get(topic_map &stats) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    stats = topics;
+}
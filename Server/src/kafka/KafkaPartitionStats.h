@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef OPENBMP_KAFKAPARTITIONSTATS_H
+#define OPENBMP_KAFKAPARTITIONSTATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+/**
+ * \class   KafkaPartitionStats
+ *
+ * \brief   Delivered message and byte counters by topic and partition
+ * \details Updated by the delivery report callback.  The counters are kept across
+ *          reconnects.  All methods are thread safe.
+ */
+class KafkaPartitionStats {
+public:
+    /**
+     * Counters of a partition
+     */
+    struct counters {
+        uint64_t        msgs;                   ///< Messages delivered
+        uint64_t        bytes;                  ///< Message bytes delivered
+    };
+
+    typedef std::map<std::string, std::vector<counters> > topic_map;   ///< Partition counters by topic name
+
+    /**
+     * Add a delivered message
+     *
+     * \param [in] topic        Topic name
+     * \param [in] partition    Partition
+     * \param [in] bytes        Message length
+     */
+    void add(const std::string &topic, int32_t partition, size_t bytes);
+
+    /**
+     * Get the counters
+     *
+     * \param [out] stats       Copy of the counters of all topics
+     */
+    void get(topic_map &stats);
+
+private:
+    std::mutex      mutex;                      ///< Protects topics
+    topic_map       topics;                     ///< Counters by topic name
+};
+
+#endif //OPENBMP_KAFKAPARTITIONSTATS_H
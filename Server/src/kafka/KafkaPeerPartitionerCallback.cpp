@@ -11,13 +11,66 @@
 #include <ctime>
 
 KafkaPeerPartitionerCallback::KafkaPeerPartitionerCallback()
-            : RdKafka::PartitionerCb() {
+            : RdKafka::PartitionerKeyPointerCb() {
 }
 
-int32_t KafkaPeerPartitionerCallback::partitioner_cb (const RdKafka::Topic *topic,
-                                                  const std::string *key,
-                                                  int32_t partition_cnt,
-                                                  void *msg_opaque) {
+int32_t KafkaPeerPartitionerCallback::partitioner_cb (const RdKafka::Topic * /*topic*/,
+                                                      const void *key, size_t key_len,
+                                                      int32_t partition_cnt,
+                                                      void * /*msg_opaque*/) {
 
-    return (key->at(0) + key->at(key->size() - 1)) % partition_cnt;
-}
\ No newline at end of file
+    if (key == NULL or key_len == 0)
+        return 0;
+
+    // Same as the Java client: positive hash modulo the partition count
+    return (murmur2((const unsigned char *)key, key_len) & 0x7fffffff) % partition_cnt;
+}
+
+/**
+ * Kafka (Java client compatible) murmur2 hash
+ *
+ * \param [in] data     Data to hash
+ * \param [in] len      Length of data
+ *
+ * \return hash
+ */
+uint32_t KafkaPeerPartitionerCallback::murmur2(const unsigned char *data, size_t len) {
+    const uint32_t seed = 0x9747b28c;
+    const uint32_t m = 0x5bd1e995;
+    const int r = 24;
+
+    uint32_t h = seed ^ (uint32_t)len;
+
+    // Little endian 4 byte blocks
+    while (len >= 4) {
+        uint32_t k = data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h *= m;
+        h ^= k;
+
+        data += 4;
+        len -= 4;
+    }
+
+    switch (len) {
+        case 3:
+            h ^= (uint32_t)data[2] << 16;
+            // fall through
+        case 2:
+            h ^= (uint32_t)data[1] << 8;
+            // fall through
+        case 1:
+            h ^= data[0];
+            h *= m;
+    }
+
+    h ^= h >> 13;
+    h *= m;
+    h ^= h >> 15;
+
+    return h;
+}
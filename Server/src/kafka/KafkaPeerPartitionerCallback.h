@@ -10,17 +10,37 @@
 #ifndef OPENBMP_KAFKAPEERPARTITIONERCALLBACK_H
 #define OPENBMP_KAFKAPEERPARTITIONERCALLBACK_H
 
-#include <map>
+#include <cstdint>
 #include <librdkafka/rdkafkacpp.h>
 
-class KafkaPeerPartitionerCallback : public RdKafka::PartitionerCb{
+/**
+ * \brief Selects the partition of a message by the murmur2 hash of its key
+ *
+ * \details The key is the peer (or router/collector) hash, so all messages of a peer are
+ *          produced to the same partition.  The hash and partition are the same as the
+ *          Kafka Java client default partitioner (and librdkafka murmur2_random), so messages
+ *          produced by other clients with the same key land on the same partition.
+ *
+ *          The key is passed by pointer, so no string is allocated per message.
+ */
+class KafkaPeerPartitionerCallback : public RdKafka::PartitionerKeyPointerCb {
 
 public:
     KafkaPeerPartitionerCallback();
 
-    int32_t partitioner_cb (const RdKafka::Topic *topic, const std::string *key,
+    int32_t partitioner_cb (const RdKafka::Topic *topic, const void *key, size_t key_len,
                             int32_t partition_cnt, void *msg_opaque);
 
+    /**
+     * Kafka (Java client compatible) murmur2 hash
+     *
+     * \param [in] data     Data to hash
+     * \param [in] len      Length of data
+     *
+     * \return hash
+     */
+    static uint32_t murmur2(const unsigned char *data, size_t len);
+
 private:
 };
 
@@ -0,0 +1,1082 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+#include <cstring>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <unistd.h>
+
+#include "KafkaProducerService.h"
+
+using namespace std;
+
+const char * const KafkaProducerService::lane_names[KAFKA_LANE_MAX] = { "control", "bulk" };
+
+/*********************************************************************//**
+ * Get the lane of a topic
+ *
+ * \param [in] topic_id     KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+ *
+ * \return lane_id
+ ***********************************************************************/
+int KafkaProducerService::topicLane(int topic_id) {
+    switch (topic_id) {
+        case KafkaTopicSelector::MSGBUS_TOPIC_ID_COLLECTOR:
+        case KafkaTopicSelector::MSGBUS_TOPIC_ID_ROUTER:
+        case KafkaTopicSelector::MSGBUS_TOPIC_ID_PEER:
+        case KafkaTopicSelector::MSGBUS_TOPIC_ID_BMP_STAT:
+            return KAFKA_LANE_CONTROL;
+
+        default:
+            return KAFKA_LANE_BULK;
+    }
+}
+
+/*********************************************************************//**
+ * Constructor for class
+ *
+ * \details Kafka configuration is applied and the producer is connected.
+ *
+ * \param [in] logPtr   Pointer to Logger instance
+ * \param [in] cfg      Pointer to the config instance
+ ***********************************************************************/
+KafkaProducerService::KafkaProducerService(Logger *logPtr, Config *cfg) : MsgBusSink(cfg) {
+    logger = logPtr;
+    this->cfg = cfg;
+
+    isConnected = false;
+    conf = RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL);
+
+    event_callback       = NULL;
+    delivery_callback    = NULL;
+    topic_generation     = 0;
+    producer_thread      = NULL;
+
+    // Producer lanes
+    for (int i=0; i < KAFKA_LANE_MAX; i++) {
+        std::ostringstream buf_max_ms;
+        lane &ln = lanes[i];
+
+        if (i == KAFKA_LANE_CONTROL) {
+            ln.queue_max_msgs   = cfg->ctrl_queue_max_msgs;
+            ln.queue_max_bytes  = (size_t)cfg->ctrl_queue_max_kbytes * 1024;
+            buf_max_ms << cfg->ctrl_buf_max_ms;
+            ln.compression      = cfg->ctrl_compression;
+        } else {
+            ln.queue_max_msgs   = cfg->prod_queue_max_msgs;
+            ln.queue_max_bytes  = (size_t)cfg->prod_queue_max_kbytes * 1024;
+            buf_max_ms << cfg->q_buf_max_ms;
+            ln.compression      = cfg->compression;
+        }
+
+        ln.buf_max_ms       = buf_max_ms.str();
+        ln.producer         = NULL;
+        ln.topicSel         = NULL;
+        ln.logged_waits     = 0;
+        ln.logged_dropped   = 0;
+        ln.logged_spilled   = 0;
+        bzero(&ln.stats, sizeof(ln.stats));
+    }
+
+    space_waiters       = 0;
+    run                 = true;
+
+    // Spill log - messages left by a previous run are produced before new messages
+    spill               = NULL;
+    spilling            = false;
+    spill_appends       = 0;
+    spill_watermark_msgs  = std::max(lanes[KAFKA_LANE_BULK].queue_max_msgs * cfg->spill_watermark / 100, (size_t)1);
+    spill_watermark_bytes = lanes[KAFKA_LANE_BULK].queue_max_bytes / 100 * cfg->spill_watermark;
+
+    if (cfg->spill_enabled) {
+        spill = new SpillLog(logger, cfg->spill_dir, (size_t)cfg->spill_segment_mbytes << 20,
+                             (size_t)cfg->spill_max_mbytes << 20, cfg->spill_fsync);
+        spilling = spill->getCount() > 0;
+    }
+
+    disableDebug();
+
+    {
+        std::lock_guard<std::mutex> lock(prod_mutex);
+        connect();
+    }
+
+    // Reconnects are handled by the producer thread if the initial connect failed
+    producer_thread = new std::thread(&KafkaProducerService::producerLoop, this);
+}
+
+/*********************************************************************//**
+ * Destructor for class - stops the producer thread and waits for queued messages to be sent
+ ***********************************************************************/
+KafkaProducerService::~KafkaProducerService() {
+    SELF_DEBUG("Destroy Kafka producer service");
+
+    // The producer thread drains the queues before stopping, dropping messages if not connected
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        run = false;
+    }
+
+    queue_cond.notify_all();
+    space_cond.notify_all();
+
+    if (producer_thread != NULL) {
+        if (producer_thread->joinable())
+            producer_thread->join();
+
+        delete producer_thread;
+        producer_thread = NULL;
+    }
+
+    // Undelivered bulk messages are spilled by the delivery reports of the disconnect
+    {
+        std::lock_guard<std::mutex> lock(prod_mutex);
+        disconnect(500);
+
+        for (size_t i=0; i < free_items.size(); i++)
+            delete free_items[i];
+        free_items.clear();
+    }
+
+    for (int i=0; i < KAFKA_LANE_MAX; i++) {
+        if (lanes[i].stats.dropped > 0)
+            LOG_WARN("Producer dropped %lu %s messages", lanes[i].stats.dropped, lane_names[i]);
+    }
+
+    if (spill != NULL) {
+        if (spill->getCount() > 0)
+            LOG_NOTICE("%lu spilled messages will be produced on the next start", spill->getCount());
+
+        delete spill;
+        spill = NULL;
+    }
+
+    delete conf;
+}
+
+/**
+ * Disconnect from Kafka
+ */
+void KafkaProducerService::disconnect(int wait_ms) {
+
+    for (int l=0; l < KAFKA_LANE_MAX; l++) {
+        RdKafka::Producer *producer = lanes[l].producer;
+
+        if (producer == NULL)
+            continue;
+
+        if (isConnected) {
+            int i = 0;
+            while (producer->outq_len() > 0 and i < 8) {
+                LOG_INFO("Waiting for %s producer to finish before disconnecting: outq=%d",
+                         lane_names[l], producer->outq_len());
+                producer->poll(500);
+                i++;
+            }
+        }
+
+        if (producer->outq_len() > 0)
+            LOG_WARN("Disconnecting %s producer with %d undelivered messages", lane_names[l],
+                     producer->outq_len());
+
+        /*
+         * Fail the undelivered messages (queued or in-flight) and serve their delivery reports,
+         *      so the buffers are returned to the pool before the producer is deleted
+         */
+        producer->purge(RdKafka::Producer::PURGE_QUEUE | RdKafka::Producer::PURGE_INFLIGHT);
+
+        int i = 0;
+        do {
+            producer->poll(i == 0 ? 0 : 100);
+        } while (producer->outq_len() > 0 and ++i < 10);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(topic_mutex);
+
+        for (int l=0; l < KAFKA_LANE_MAX; l++) {
+            if (lanes[l].topicSel != NULL) delete lanes[l].topicSel;
+            lanes[l].topicSel = NULL;
+        }
+    }
+
+    for (int l=0; l < KAFKA_LANE_MAX; l++) {
+        if (lanes[l].producer != NULL) delete lanes[l].producer;
+        lanes[l].producer = NULL;
+    }
+
+    // suggested by librdkafka to free memory
+    RdKafka::wait_destroyed(wait_ms);
+
+    if (event_callback != NULL) delete event_callback;
+    event_callback = NULL;
+
+    if (delivery_callback != NULL) delete delivery_callback;
+    delivery_callback = NULL;
+
+    isConnected = false;
+}
+
+/**
+ * Connects to Kafka broker
+ */
+void KafkaProducerService::connect() {
+    string errstr;
+    string value;
+    std::ostringstream rx_bytes, tx_bytes, sess_timeout, socket_timeout;
+    std::ostringstream q_buf_max_msgs, q_buf_max_kbytes,
+		msg_send_max_retry, retry_backoff_ms;
+
+    disconnect();
+
+    /*
+     * Configure Kafka Producer (https://kafka.apache.org/08/configuration.html)
+     */
+    //TODO: Add config options to change these settings
+
+    // Disable logging of connection close/idle timeouts caused by Kafka 0.9.x (connections.max.idle.ms)
+    //    See https://github.com/edenhill/librdkafka/issues/437 for more details.
+    // TODO: change this when librdkafka has better handling of the idle disconnects
+    value = "false";
+    if (conf->set("log.connection.close", value, errstr) != RdKafka::Conf::CONF_OK) {
+        LOG_ERR("Failed to configure log.connection.close=false: %s.", errstr.c_str());
+    }
+
+    value = "true";
+    if (conf->set("api.version.request", value, errstr) != RdKafka::Conf::CONF_OK) {
+        LOG_ERR("Failed to configure api.version.request=true: %s.", errstr.c_str());
+    }
+
+    // TODO: Add config for address family - default is any
+    /*value = "v4";
+    if (conf->set("broker.address.family", value, errstr) != RdKafka::Conf::CONF_OK) {
+        LOG_ERR("Failed to configure broker.address.family: %s.", errstr.c_str());
+    }*/
+
+
+    // Batch message number
+    value = "100";
+    if (conf->set("batch.num.messages", value, errstr) != RdKafka::Conf::CONF_OK) {
+        LOG_ERR("Failed to configure batch.num.messages for kafka: %s.", errstr.c_str());
+        throw "ERROR: Failed to configure kafka batch.num.messages";
+    }
+
+    // broker list
+    if (conf->set("metadata.broker.list", cfg->kafka_brokers, errstr) != RdKafka::Conf::CONF_OK) {
+        LOG_ERR("Failed to configure broker list for kafka: %s", errstr.c_str());
+        throw "ERROR: Failed to configure kafka broker list";
+    }
+
+    // Maximum transmit byte size
+    tx_bytes << cfg->tx_max_bytes;
+    if (conf->set("message.max.bytes", tx_bytes.str(), 
+                             errstr) != RdKafka::Conf::CONF_OK) 
+    {
+       LOG_ERR("Failed to configure transmit max message size for kafka: %s",
+                               errstr.c_str());
+       throw "ERROR: Failed to configure transmit max message size";
+    } 
+ 
+    // Maximum receive byte size
+    rx_bytes << cfg->rx_max_bytes;
+    if (conf->set("receive.message.max.bytes", rx_bytes.str(), 
+                             errstr) != RdKafka::Conf::CONF_OK)
+    {
+       LOG_ERR("Failed to configure receive max message size for kafka: %s",
+                               errstr.c_str());
+       throw "ERROR: Failed to configure receive max message size";
+    }
+
+    // Client group session and failure detection timeout
+    sess_timeout << cfg->session_timeout;
+    if (conf->set("session.timeout.ms", sess_timeout.str(), 
+                             errstr) != RdKafka::Conf::CONF_OK) 
+    {
+       LOG_ERR("Failed to configure session timeout for kafka: %s",
+                               errstr.c_str());
+       throw "ERROR: Failed to configure session timeout ";
+    } 
+    
+    // Timeout for network requests 
+    socket_timeout << cfg->socket_timeout;
+    if (conf->set("socket.timeout.ms", socket_timeout.str(), 
+                             errstr) != RdKafka::Conf::CONF_OK) 
+    {
+       LOG_ERR("Failed to configure socket timeout for kafka: %s",
+                               errstr.c_str());
+       throw "ERROR: Failed to configure socket timeout ";
+    } 
+    
+    // Maximum number of messages allowed on the producer queue 
+    q_buf_max_msgs << cfg->q_buf_max_msgs;
+    if (conf->set("queue.buffering.max.messages", q_buf_max_msgs.str(), 
+                             errstr) != RdKafka::Conf::CONF_OK) 
+    {
+       LOG_ERR("Failed to configure max messages in buffer for kafka: %s",
+                               errstr.c_str());
+       throw "ERROR: Failed to configure max messages in buffer ";
+    }
+
+    // Maximum number of messages allowed on the producer queue
+    q_buf_max_kbytes << cfg->q_buf_max_kbytes;
+    if (conf->set("queue.buffering.max.kbytes", q_buf_max_kbytes.str(),
+                  errstr) != RdKafka::Conf::CONF_OK)
+    {
+        LOG_ERR("Failed to configure max kbytes in buffer for kafka: %s",
+                errstr.c_str());
+        throw "ERROR: Failed to configure max kbytes in buffer ";
+    }
+
+
+    // How many times to retry sending a failing MessageSet
+    msg_send_max_retry << cfg->msg_send_max_retry;
+    if (conf->set("message.send.max.retries", msg_send_max_retry.str(), 
+                             errstr) != RdKafka::Conf::CONF_OK) 
+    {
+       LOG_ERR("Failed to configure max retries for sending "
+               "failed message for kafka: %s",
+                               errstr.c_str());
+       throw "ERROR: Failed to configure max retries for sending failed message";
+    } 
+    
+    // Backoff time in ms before retrying a message send
+    retry_backoff_ms << cfg->retry_backoff_ms;
+    if (conf->set("retry.backoff.ms", retry_backoff_ms.str(), 
+                             errstr) != RdKafka::Conf::CONF_OK) 
+    {
+       LOG_ERR("Failed to configure backoff time before retrying to send"
+               "failed message for kafka: %s",
+                               errstr.c_str());
+       throw "ERROR: Failed to configure backoff time before resending"
+             " failed messages ";
+    } 
+    
+    // Register event callback
+    event_callback = new KafkaEventCallback(&isConnected, logger);
+    if (conf->set("event_cb", event_callback, errstr) != RdKafka::Conf::CONF_OK) {
+        LOG_ERR("Failed to configure kafka event callback: %s", errstr.c_str());
+        throw "ERROR: Failed to configure kafka event callback";
+    }
+
+    // Register delivery report callback - see deliveryReport()
+    delivery_callback = new KafkaDeliveryReportCallback(this);
+
+    if (conf->set("dr_cb", delivery_callback, errstr) != RdKafka::Conf::CONF_OK) {
+        LOG_ERR("Failed to configure kafka delivery report callback: %s", errstr.c_str());
+        throw "ERROR: Failed to configure kafka delivery report callback";
+    }
+
+
+    /*
+     * Create a producer per lane - the configuration only differs by linger and compression
+     */
+    for (int i=0; i < KAFKA_LANE_MAX; i++) {
+        lane &ln = lanes[i];
+
+        // Batch message max wait time (in ms)
+        if (conf->set("queue.buffering.max.ms", ln.buf_max_ms, errstr) != RdKafka::Conf::CONF_OK) {
+            LOG_ERR("Failed to configure queue.buffering.max.ms for kafka %s producer: %s.", lane_names[i],
+                    errstr.c_str());
+            throw "ERROR: Failed to configure kafka queue.buffer.max.ms";
+        }
+
+        // compression
+        if (conf->set("compression.codec", ln.compression, errstr) != RdKafka::Conf::CONF_OK) {
+            LOG_ERR("Failed to configure %s compression for kafka %s producer: %s.", ln.compression.c_str(),
+                    lane_names[i], errstr.c_str());
+            throw "ERROR: Failed to configure kafka compression";
+        }
+
+        // Create producer and connect
+        ln.producer = RdKafka::Producer::create(conf, errstr);
+        if (ln.producer == NULL) {
+            LOG_ERR("Failed to create %s producer: %s", lane_names[i], errstr.c_str());
+            throw "ERROR: Failed to create producer";
+        }
+    }
+
+    isConnected = true;
+
+    for (int i=0; i < KAFKA_LANE_MAX; i++)
+        lanes[i].producer->poll(500);
+
+    if (not isConnected) {
+        LOG_ERR("Failed to connect to Kafka, will try again in a few");
+        return;
+
+    }
+
+    /*
+     * Initialize the topic selector/handler of each lane
+     */
+    try {
+        KafkaTopicSelector *sel[KAFKA_LANE_MAX] = { NULL };
+
+        try {
+            for (int i=0; i < KAFKA_LANE_MAX; i++)
+                sel[i] = new KafkaTopicSelector(logger, cfg, lanes[i].producer);
+
+        } catch (char const *str) {
+            for (int i=0; i < KAFKA_LANE_MAX; i++)
+                if (sel[i] != NULL) delete sel[i];
+            throw;
+        }
+
+        std::lock_guard<std::mutex> lock(topic_mutex);
+        for (int i=0; i < KAFKA_LANE_MAX; i++)
+            lanes[i].topicSel = sel[i];
+
+        // Topic handles resolved with the previous selectors are no longer valid
+        if (++topic_generation == 0)
+            ++topic_generation;
+
+    } catch (char const *str) {
+        LOG_ERR("Failed to create one or more topics, will try again in a few: err=%s", str);
+        isConnected = false;
+        return;
+    }
+
+    for (int i=0; i < KAFKA_LANE_MAX; i++)
+        lanes[i].producer->poll(100);
+}
+
+/*********************************************************************//**
+ * Produce message to Kafka
+ *
+ * \details The message is queued for the producer thread without copying; ownership of buf
+ *      is transferred and it is returned to the buffer pool once the message is delivered
+ *      (or dropped).  This method only blocks if the queue of the topic's lane is full.
+ *
+ * \param [in] topic_id      Topic to produce to, KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+ * \param [in/out] cache     Topic handles (RdKafka::Topic) of the peer/router, updated if not resolved
+ * \param [in] router_group  Router group name - empty/NULL if not set or used
+ * \param [in] peer_group    Peer group name - empty/NULL if not set or used
+ * \param [in] peer_asn      Peer ASN
+ * \param [in] key           Hash key
+ * \param [in] buf           Pooled buffer containing the message (header and body)
+ * \param [in] msg           Start of the message within buf
+ * \param [in] msg_size      Length in bytes of the message
+ * \param [in] router_ip     Router IP address - used for logging
+ ***********************************************************************/
+void KafkaProducerService::produce(int topic_id, topic_cache &cache,
+                                   const std::string *router_group, const std::string *peer_group,
+                                   uint32_t peer_asn, const std::string &key,
+                                   pool_buffer *buf, const char *msg, size_t msg_size,
+                                   const std::string &router_ip) {
+    const char *topic_var = KafkaTopicSelector::topic_vars[topic_id];
+    lane &ln = lanes[topicLane(topic_id)];
+    produce_item item;
+
+    if (msg_size > KAFKA_PRODUCER_BUF_SIZE or key.size() > KAFKA_PRODUCER_KEY_MAX) {
+        LOG_ERR("rtr=%s: Message too large to produce: topic=%s size=%lu key size=%lu", router_ip.c_str(),
+                topic_var, msg_size, key.size());
+        buffer_pool.release(buf);
+        return;
+    }
+
+    item.buf        = buf;
+    item.msg        = msg;
+    item.msg_size   = msg_size;
+    item.topic_id   = topic_id;
+    item.topic      = NULL;
+    item.generation = 0;
+    item.peer_asn   = peer_asn;
+    item.key_len    = key.size();
+    memcpy(item.key, key.data(), key.size());
+
+    if (router_group != NULL)
+        item.router_group = *router_group;
+
+    if (peer_group != NULL)
+        item.peer_group = *peer_group;
+
+    /*
+     * Resolve the topic only if not already resolved for the peer/router.  While reconnecting
+     *      there is no topic selector; the producer thread resolves the topic instead.
+     */
+    {
+        std::lock_guard<std::mutex> lock(topic_mutex);
+
+        if (ln.topicSel != NULL) {
+            if (cache.generation != topic_generation) {
+                bzero(cache.topics, sizeof(cache.topics));
+                cache.generation = topic_generation;
+            }
+
+            if ((item.topic = (RdKafka::Topic *)cache.topics[topic_id]) == NULL) {
+                item.topic = ln.topicSel->getTopic(topic_var, router_group, peer_group, peer_asn);
+                cache.topics[topic_id] = item.topic;
+            }
+            item.generation = topic_generation;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(queue_mutex);
+
+    /*
+     * Spill once the bulk queue is above the watermark, and until the spilled messages are replayed.
+     *      Control messages are never spilled.
+     */
+    if (spill != NULL and &ln == &lanes[KAFKA_LANE_BULK]
+            and (spilling or ln.queue.size() >= spill_watermark_msgs
+                 or (ln.queue.size() > 0 and ln.stats.depth_bytes + msg_size > spill_watermark_bytes))) {
+        if (spillItem(lock, item))
+            return;
+    }
+
+    // Backpressure - wait for room in the queue.  A message is always accepted by an empty queue.
+    if (ln.queue.size() >= ln.queue_max_msgs
+            or (ln.queue.size() > 0 and ln.stats.depth_bytes + msg_size > ln.queue_max_bytes)) {
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        SELF_DEBUG("rtr=%s: Producer %s queue is full, waiting: msgs=%lu bytes=%lu", router_ip.c_str(),
+                   lane_names[topicLane(topic_id)], ln.queue.size(), ln.stats.depth_bytes);
+
+        ln.stats.waits++;
+        space_waiters++;
+
+        while (run and (ln.queue.size() >= ln.queue_max_msgs
+                        or (ln.queue.size() > 0 and ln.stats.depth_bytes + msg_size > ln.queue_max_bytes)))
+            space_cond.wait(lock);
+
+        space_waiters--;
+        ln.stats.wait_usec += std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - start).count();
+    }
+
+    ln.queue.push_back(std::move(item));
+
+    ln.stats.enqueued++;
+    ln.stats.depth_bytes += msg_size;
+
+    if (ln.queue.size() > ln.stats.max_depth_msgs)
+        ln.stats.max_depth_msgs = ln.queue.size();
+
+    // The producer thread only waits when its queues are empty
+    bool wakeup = ln.queue.size() == 1;
+    lock.unlock();
+
+    if (wakeup)
+        queue_cond.notify_one();
+}
+
+/**
+ * Producer thread loop
+ *
+ * \details The control queue is always served first.  A bulk message that does not fit in the
+ *      librdkafka queue of the bulk producer is held and retried, so that control messages
+ *      queued meanwhile are not blocked behind it.
+ */
+void KafkaProducerService::producerLoop() {
+    lane &ctrl = lanes[KAFKA_LANE_CONTROL];
+    lane &bulk = lanes[KAFKA_LANE_BULK];
+    produce_item item;
+    produce_item held;                          // Bulk message waiting for room in librdkafka
+    bool has_held = false;
+    time_t last_stats = time(NULL);
+    std::chrono::steady_clock::time_point last_sync = std::chrono::steady_clock::now();
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+
+        // Spilled messages are replayed once the bulk queue is empty; produceItem() reconnects if needed
+        bool replay = spilling and not has_held;
+
+        if (run and ctrl.queue.empty() and (has_held or (bulk.queue.empty() and not replay)))
+            queue_cond.wait_for(lock, std::chrono::milliseconds(has_held ? 5 : KAFKA_PRODUCER_POLL_MS));
+
+        if (not ctrl.queue.empty()) {
+            item = std::move(ctrl.queue.front());
+            ctrl.queue.pop_front();
+            ctrl.stats.depth_bytes -= item.msg_size;
+
+            bool wakeup = space_waiters > 0;
+            lock.unlock();
+
+            if (wakeup)
+                space_cond.notify_all();
+
+            produceItem(KAFKA_LANE_CONTROL, item, true);
+
+        } else if (has_held) {
+            lock.unlock();
+
+            if (produceItem(KAFKA_LANE_BULK, held, false))
+                has_held = false;
+
+        } else if (not bulk.queue.empty()) {
+            item = std::move(bulk.queue.front());
+            bulk.queue.pop_front();
+            bulk.stats.depth_bytes -= item.msg_size;
+
+            bool wakeup = space_waiters > 0;
+            lock.unlock();
+
+            if (wakeup)
+                space_cond.notify_all();
+
+            if (not produceItem(KAFKA_LANE_BULK, item, false)) {
+                held = std::move(item);
+                has_held = true;
+            }
+
+        } else if (not run) {
+            break;                              // Spilled messages are kept for the next start
+
+        } else if (replay and replayItem(item)) {
+            bool wakeup = space_waiters > 0;
+            lock.unlock();
+
+            if (wakeup)
+                space_cond.notify_all();
+
+            if (not produceItem(KAFKA_LANE_BULK, item, false)) {
+                held = std::move(item);
+                has_held = true;
+            }
+
+        } else {
+            lock.unlock();
+
+            // Serve delivery reports (buffer release) and events while idle
+            std::lock_guard<std::mutex> prod_lock(prod_mutex);
+            for (int i=0; i < KAFKA_LANE_MAX; i++) {
+                if (isConnected and lanes[i].producer != NULL)
+                    lanes[i].producer->poll(0);
+            }
+        }
+
+        if (spill != NULL and cfg->spill_fsync == SpillLog::SPILL_FSYNC_INTERVAL
+                and std::chrono::steady_clock::now() - last_sync >= std::chrono::milliseconds(cfg->spill_fsync_interval)) {
+            spill->sync();
+            last_sync = std::chrono::steady_clock::now();
+        }
+
+        if (time(NULL) - last_stats >= KAFKA_PRODUCER_STATS_INTERVAL) {
+            logQueueStats();
+            logPartitionStats();
+            last_stats = time(NULL);
+        }
+    }
+}
+
+/**
+ * Append a message to the spill log without queue_mutex - queue_mutex must be held by lock
+ *
+ * \details The append may sync the spill log to disk (fsync always), so router threads and the
+ *      producer thread are not blocked on queue_mutex meanwhile.  Spilling does not end while
+ *      an append is in progress, so the message is replayed.
+ *
+ * \param [in] lock     Lock of queue_mutex, released during the append
+ * \param [in] item     Message to append
+ *
+ * \return false if the spill log is full
+ */
+bool KafkaProducerService::spillAppend(std::unique_lock<std::mutex> &lock, produce_item &item) {
+    spill_appends++;
+    lock.unlock();
+
+    bool appended = spill->append(item.topic_id, item.peer_asn, item.router_group, item.peer_group,
+                                  item.key, item.key_len, item.msg, item.msg_size);
+
+    lock.lock();
+    spill_appends--;
+
+    return appended;
+}
+
+/**
+ * Spill a message, waiting if the spill log is full - queue_mutex must be held by lock
+ *
+ * \param [in] lock     Lock of queue_mutex
+ * \param [in] item     Message to spill; the buffer is released if spilled
+ *
+ * \return true if spilled, false if the spill log was replayed meanwhile and the message
+ *      should be queued instead
+ */
+bool KafkaProducerService::spillItem(std::unique_lock<std::mutex> &lock, produce_item &item) {
+    queue_stats &stats = lanes[KAFKA_LANE_BULK].stats;
+    std::chrono::steady_clock::time_point start;
+    bool waited = false;
+    bool spilled = false;
+
+    if (not spilling) {
+        spilling = true;
+        LOG_NOTICE("Producer bulk queue is above the spill watermark, spilling messages to %s: msgs=%lu bytes=%lu",
+                   cfg->spill_dir.c_str(), lanes[KAFKA_LANE_BULK].queue.size(), stats.depth_bytes);
+    }
+
+    while (run and spilling) {
+        if (spillAppend(lock, item)) {
+            spilled = true;
+            break;
+        }
+
+        // Spill log is full - backpressure until the replay frees a segment
+        if (not waited) {
+            waited = true;
+            start = std::chrono::steady_clock::now();
+            stats.waits++;
+            space_waiters++;
+        }
+
+        space_cond.wait(lock);
+    }
+
+    if (waited) {
+        space_waiters--;
+        stats.wait_usec += std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - start).count();
+    }
+
+    if (spilled) {
+        stats.spilled++;
+        lock.unlock();
+
+        buffer_pool.release(item.buf);
+    }
+
+    return spilled;
+}
+
+/**
+ * Get the next message from the spill log - queue_mutex must be held
+ *
+ * \param [out] item    Message, in a newly acquired buffer
+ *
+ * \return true if a message was read, false if the spill log is empty
+ */
+bool KafkaProducerService::replayItem(produce_item &item) {
+    queue_stats &stats = lanes[KAFKA_LANE_BULK].stats;
+    SpillLog::spill_record rec;
+
+    if (not spill->peek(rec)) {
+        // Appends in progress are replayed first
+        if (spill_appends > 0)
+            return false;
+
+        // Checked under queue_mutex, so no message is spilled after this
+        spilling = false;
+        LOG_NOTICE("Spilled messages have been replayed: spilled=%lu", stats.spilled);
+        return false;
+    }
+
+    item.buf        = buffer_pool.acquire(rec.msg_size);
+    item.msg        = item.buf->data;
+    item.msg_size   = rec.msg_size;
+    item.topic_id   = rec.topic_id;
+    item.topic      = NULL;
+    item.generation = 0;
+    item.peer_asn   = rec.peer_asn;
+    item.key_len    = std::min(rec.key_len, (size_t)KAFKA_PRODUCER_KEY_MAX);
+    item.router_group.assign(rec.router_group, rec.router_group_len);
+    item.peer_group.assign(rec.peer_group, rec.peer_group_len);
+    memcpy(item.key, rec.key, item.key_len);
+    memcpy(item.buf->data, rec.msg, rec.msg_size);
+
+    spill->pop();
+    stats.replayed++;
+
+    return true;
+}
+
+/**
+ * Produce a queued message to librdkafka, reconnecting if needed
+ *
+ * \param [in] lane_id  Lane of the message
+ * \param [in] item     Message to produce; the buffer is released if the message is dropped
+ * \param [in] wait     Wait while the librdkafka queue of the lane is full
+ *
+ * \return false if not produced because the librdkafka queue is full (wait is false), true otherwise
+ */
+bool KafkaProducerService::produceItem(int lane_id, produce_item &item, bool wait) {
+    const char *topic_var = KafkaTopicSelector::topic_vars[item.topic_id];
+    lane &ln = lanes[lane_id];
+    bool dropped = false;
+
+    std::unique_lock<std::mutex> lock(prod_mutex);
+
+    while (isConnected == false or ln.topicSel == NULL) {
+        if (not run) {
+            // Stopping - do not wait for Kafka to come back
+            dropped = true;
+            break;
+        }
+
+        LOG_WARN("Not connected to Kafka, attempting to reconnect");
+        connect();
+
+        if (isConnected and ln.topicSel != NULL)
+            break;
+
+        // Allow enableDebug() and delivery reports to make progress while waiting to retry
+        lock.unlock();
+        sleep(1);
+        lock.lock();
+    }
+
+    if (not dropped) {
+        // Handles resolved before a reconnect are no longer valid
+        if (item.topic == NULL or item.generation != topic_generation) {
+            std::lock_guard<std::mutex> topic_lock(topic_mutex);
+            item.topic = ln.topicSel->getTopic(topic_var, &item.router_group, &item.peer_group, item.peer_asn);
+            item.generation = topic_generation;
+        }
+
+        if (item.topic != NULL) {
+            SELF_DEBUG("Producing message: topic=%s key=%.*s, msg size = %lu", item.topic->name().c_str(),
+                       (int)item.key_len, item.key, item.msg_size);
+
+            /*
+             * No copy or free flag: the opaque is a copy of the item, handed to deliveryReport() which
+             *      returns buf to the pool.  Reports are only served by poll() of this thread, so the
+             *      copy is made once the message is accepted.
+             */
+            produce_item *opaque;
+            if (free_items.empty()) {
+                opaque = new produce_item;
+            } else {
+                opaque = free_items.back();
+                free_items.pop_back();
+            }
+
+            RdKafka::ErrorCode resp;
+            while ((resp = ln.producer->produce(item.topic, RdKafka::Topic::PARTITION_UA, 0,
+                                                const_cast<char *>(item.msg), item.msg_size,
+                                                item.key, item.key_len, opaque)) == RdKafka::ERR__QUEUE_FULL
+                    and isConnected) {
+
+                // Let the caller serve other lanes, the message is retried later
+                if (not wait) {
+                    free_items.push_back(opaque);
+                    ln.producer->poll(0);
+                    return false;
+                }
+
+                // librdkafka queue is full - serve delivery reports until there is room
+                ln.producer->poll(KAFKA_PRODUCER_POLL_MS);
+            }
+
+            if (resp == RdKafka::ERR_NO_ERROR) {
+                *opaque = std::move(item);
+            } else {
+                free_items.push_back(opaque);
+
+                LOG_ERR("Failed to produce message: topic=%s: %s", item.topic->name().c_str(),
+                        RdKafka::err2str(resp).c_str());
+                dropped = true;
+                ln.producer->poll(100);
+            }
+        } else {
+            LOG_NOTICE("failed to produce message because topic couldn't be found: topic=%s key=%.*s, msg size = %lu",
+                       topic_var, (int)item.key_len, item.key, item.msg_size);
+            dropped = true;
+        }
+
+        ln.producer->poll(0);
+    }
+
+    lock.unlock();
+
+    if (dropped) {
+        buffer_pool.release(item.buf);
+
+        std::lock_guard<std::mutex> queue_lock(queue_mutex);
+        ln.stats.dropped++;
+    }
+
+    item.buf = NULL;
+    return true;
+}
+
+/**
+ * Log the producer queue counters if there was backpressure or drops since the last log
+ */
+void KafkaProducerService::logQueueStats() {
+    queue_stats cur;
+
+    for (int i=0; i < KAFKA_LANE_MAX; i++) {
+        lane &ln = lanes[i];
+
+        getQueueStats(i, cur);
+
+        if (cur.waits != ln.logged_waits or cur.dropped != ln.logged_dropped or cur.spilled != ln.logged_spilled) {
+            LOG_NOTICE("Producer %s queue: depth=%lu msgs/%lu bytes max_depth=%lu enqueued=%lu"
+                       " blocked=%lu times/%lu ms dropped=%lu", lane_names[i],
+                       cur.depth_msgs, cur.depth_bytes, cur.max_depth_msgs, cur.enqueued,
+                       cur.waits, cur.wait_usec / 1000, cur.dropped);
+
+            if (spill != NULL and i == KAFKA_LANE_BULK)
+                LOG_NOTICE("Producer spill log: %lu msgs/%lu bytes spilled=%lu replayed=%lu",
+                           cur.spill_msgs, cur.spill_bytes, cur.spilled, cur.replayed);
+
+            ln.logged_waits = cur.waits;
+            ln.logged_dropped = cur.dropped;
+            ln.logged_spilled = cur.spilled;
+        }
+    }
+}
+
+/**
+ * Log the partition load of each topic that had deliveries since the last log
+ */
+void KafkaProducerService::logPartitionStats() {
+    KafkaPartitionStats::topic_map cur;
+
+    partition_stats.get(cur);
+
+    for (KafkaPartitionStats::topic_map::iterator it = cur.begin(); it != cur.end(); ++it) {
+        uint64_t msgs = 0, bytes = 0;
+        size_t hot = 0;
+
+        for (size_t i=0; i < it->second.size(); i++) {
+            msgs += it->second[i].msgs;
+            bytes += it->second[i].bytes;
+
+            if (it->second[i].bytes > it->second[hot].bytes)
+                hot = i;
+        }
+
+        uint64_t &logged = logged_partition_msgs[it->first];
+        if (msgs == logged)
+            continue;
+
+        logged = msgs;
+
+        // Partitions that were never delivered to are not in the counters, so avg is an upper bound
+        uint64_t avg_bytes = bytes / it->second.size();
+
+        LOG_INFO("Partition load: topic=%s partitions=%lu msgs=%lu bytes=%lu avg=%lu bytes"
+                 " hottest=%lu (%lu msgs/%lu bytes, %.1fx avg)",
+                 it->first.c_str(), it->second.size(), msgs, bytes, avg_bytes,
+                 hot, it->second[hot].msgs, it->second[hot].bytes,
+                 avg_bytes > 0 ? (double)it->second[hot].bytes / avg_bytes : 0.0);
+    }
+}
+
+/*********************************************************************//**
+ * Get the delivered message and byte counters by topic and partition
+ *
+ * \param [out] stats   Copy of the current counters
+ ***********************************************************************/
+void KafkaProducerService::getPartitionStats(KafkaPartitionStats::topic_map &stats) {
+    partition_stats.get(stats);
+}
+
+/*********************************************************************//**
+ * Delivery report of a produced message - called by the delivery report callback
+ *
+ * \details Reports are served by poll(), with prod_mutex held.  Bulk messages that timed out
+ *      or were purged by a reconnect or shutdown are appended to the spill log, to be produced
+ *      again after the messages already queued.  The buffer is returned to the pool.
+ *
+ * \param [in] message  Delivered or failed message
+ ***********************************************************************/
+void KafkaProducerService::deliveryReport(RdKafka::Message &message) {
+    produce_item *item = (produce_item *)message.msg_opaque();
+    RdKafka::ErrorCode err = message.err();
+
+    if (err == RdKafka::ERR_NO_ERROR) {
+        partition_stats.add(message.topic_name(), message.partition(), message.len());
+
+    } else if (spill != NULL and topicLane(item->topic_id) == KAFKA_LANE_BULK
+               and (err == RdKafka::ERR__MSG_TIMED_OUT or err == RdKafka::ERR__PURGE_QUEUE
+                    or err == RdKafka::ERR__PURGE_INFLIGHT)) {
+        queue_stats &stats = lanes[KAFKA_LANE_BULK].stats;
+        std::unique_lock<std::mutex> lock(queue_mutex);
+
+        if (not spilling) {
+            spilling = true;
+            LOG_NOTICE("Spilling undelivered bulk messages to %s: %s", cfg->spill_dir.c_str(),
+                       RdKafka::err2str(err).c_str());
+        }
+
+        // No waiting if the spill log is full, it is replayed by this thread
+        if (spillAppend(lock, *item))
+            stats.spilled++;
+        else
+            stats.dropped++;
+    }
+
+    // Payload is no longer referenced by the producer
+    buffer_pool.release(item->buf);
+    item->buf = NULL;
+    free_items.push_back(item);
+}
+
+/*********************************************************************//**
+ * Get the producer queue counters of a lane
+ *
+ * \param [in]  lane    lane_id
+ * \param [out] stats   Copy of the current counters
+ ***********************************************************************/
+void KafkaProducerService::getQueueStats(int lane, queue_stats &stats) {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+
+    stats = lanes[lane].stats;
+    stats.depth_msgs = lanes[lane].queue.size();
+
+    if (spill != NULL and lane == KAFKA_LANE_BULK) {
+        stats.spill_msgs = spill->getCount();
+        stats.spill_bytes = spill->getBytes();
+    }
+}
+
+/*********************************************************************//**
+ * Lookup router group - See KafkaTopicSelector::lookupRouterGroup()
+ ***********************************************************************/
+void KafkaProducerService::lookupRouterGroup(std::string hostname, std::string ip_addr,
+                                             std::string &router_group_name) {
+    std::lock_guard<std::mutex> lock(topic_mutex);
+
+    if (lanes[KAFKA_LANE_CONTROL].topicSel != NULL)
+        lanes[KAFKA_LANE_CONTROL].topicSel->lookupRouterGroup(hostname, ip_addr, router_group_name);
+}
+
+/*********************************************************************//**
+ * Lookup peer group - See KafkaTopicSelector::lookupPeerGroup()
+ ***********************************************************************/
+void KafkaProducerService::lookupPeerGroup(std::string hostname, std::string ip_addr, uint32_t peer_asn,
+                                           std::string &peer_group_name) {
+    std::lock_guard<std::mutex> lock(topic_mutex);
+
+    if (lanes[KAFKA_LANE_CONTROL].topicSel != NULL)
+        lanes[KAFKA_LANE_CONTROL].topicSel->lookupPeerGroup(hostname, ip_addr, peer_asn, peer_group_name);
+}
+
+/*
+ * Enable/disable debugs
+ */
+void KafkaProducerService::enableDebug() {
+    string value = "all";
+    string errstr;
+
+    std::lock_guard<std::mutex> lock(prod_mutex);
+
+    disconnect();
+
+    if (conf->set("debug", value, errstr) != RdKafka::Conf::CONF_OK) {
+        LOG_ERR("Failed to enable debug on kafka producer confg: %s", errstr.c_str());
+    }
+
+    connect();
+
+    debug = true;
+}
+
+void KafkaProducerService::disableDebug() {
+    string errstr;
+    string value = "";
+
+    if (conf)
+        conf->set("debug", value, errstr);
+
+    debug = false;
+}
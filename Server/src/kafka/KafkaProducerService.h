@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef OPENBMP_KAFKAPRODUCERSERVICE_H
+#define OPENBMP_KAFKAPRODUCERSERVICE_H
+
+#include <string>
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <map>
+#include <thread>
+#include <condition_variable>
+
+#include <librdkafka/rdkafkacpp.h>
+
+#include "Config.h"
+#include "Logger.h"
+#include "KafkaEventCallback.h"
+#include "KafkaDeliveryReportCallback.h"
+#include "KafkaTopicSelector.h"
+#include "KafkaPartitionStats.h"
+#include "BufferPool.h"
+#include "SpillLog.h"
+#include "MsgBusSink.h"
+
+/**
+ * \class   KafkaProducerService
+ *
+ * \brief   Process wide Kafka producer
+ * \details Message bus sink of type kafka.  A single instance is created by the server and
+ *          shared by the collector and all router (client) threads.  The instance owns the librdkafka producer,
+ *          broker connections, callbacks and topic handles.  All public methods are
+ *          thread safe.
+ *
+ *          Messages are handed to a producer thread through bounded queues.  The producer
+ *          thread produces to librdkafka and handles reconnects, so router threads are not
+ *          blocked by a Kafka outage until a queue is full.  Once full, produce() blocks
+ *          (backpressure) until there is room; the blocked count and time are logged
+ *          periodically and available via getQueueStats().
+ *
+ *          Topics are split in two lanes, each with its own queue, librdkafka producer,
+ *          linger and compression.  The control lane (collector, router, peer and stats
+ *          messages) is always drained first, so peer and router events are not delayed by
+ *          a backlog of bulk (RIB) messages.
+ *
+ *          If the spill log is enabled, bulk messages are appended to it instead once the bulk
+ *          queue is above the spill watermark.  Spilling continues until the producer thread has
+ *          replayed the spill log, so messages are produced in order.  Produce only blocks
+ *          if the spill log is full.  Bulk messages that librdkafka fails to deliver, because
+ *          they timed out or were purged by a reconnect or shutdown, are spilled as well.
+ *
+ *          Per router state, such as the router/peer hashes, peer groups and
+ *          sequence numbers, is maintained by msgBus_kafka.
+ */
+class KafkaProducerService : public MsgBusSink {
+public:
+    #define KAFKA_PRODUCER_BUF_SIZE         1800000     ///< Max message size (header and body)
+    #define KAFKA_PRODUCER_KEY_MAX          64          ///< Max message key length
+    #define KAFKA_PRODUCER_POLL_MS          100         ///< Producer thread poll interval when idle
+    #define KAFKA_PRODUCER_STATS_INTERVAL   60          ///< Seconds between producer queue stats logs
+
+    /**
+     * Producer lanes
+     */
+    enum lane_id {
+        KAFKA_LANE_CONTROL=0,                   ///< collector, router, peer and bmp_stat
+        KAFKA_LANE_BULK,                        ///< base_attribute, unicast_prefix, l3vpn, evpn, ls_* and bmp_raw
+        KAFKA_LANE_MAX
+    };
+
+    static const char * const lane_names[KAFKA_LANE_MAX];      ///< Lane names for logging by lane_id
+
+    /*********************************************************************//**
+     * Get the lane of a topic
+     *
+     * \param [in] topic_id     KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+     *
+     * 
+eturn lane_id
+     ***********************************************************************/
+    static int topicLane(int topic_id);
+
+    /**
+     * Producer queue counters of a lane - see getQueueStats()
+     */
+    struct queue_stats {
+        uint64_t        enqueued;               ///< Messages added to the queue
+        uint64_t        dropped;                ///< Messages dropped by the producer thread
+        uint64_t        waits;                  ///< Number of times produce() blocked on a full queue
+        uint64_t        wait_usec;              ///< Total time produce() was blocked on a full queue
+        size_t          depth_msgs;             ///< Messages currently queued
+        size_t          depth_bytes;            ///< Message bytes currently queued
+        size_t          max_depth_msgs;         ///< Highest number of messages queued
+        uint64_t        spilled;                ///< Messages appended to the spill log (bulk lane)
+        uint64_t        replayed;               ///< Messages replayed from the spill log (bulk lane)
+        uint64_t        spill_msgs;             ///< Messages currently in the spill log (bulk lane)
+        uint64_t        spill_bytes;            ///< Bytes currently in the spill log (bulk lane)
+    };
+
+    /*********************************************************************//**
+     * Constructor for class
+     *
+     * \details Kafka configuration is applied and the producer is connected.
+     *
+     * \param [in] logPtr   Pointer to Logger instance
+     * \param [in] cfg      Pointer to the config instance
+     ***********************************************************************/
+    KafkaProducerService(Logger *logPtr, Config *cfg);
+
+    /*********************************************************************//**
+     * Destructor for class - stops the producer thread and waits for queued messages to be sent
+     ***********************************************************************/
+    ~KafkaProducerService();
+
+    /*********************************************************************//**
+     * Produce message to Kafka
+     *
+     * \details The message is queued for the producer thread without copying; ownership of buf
+     *      is transferred and it is returned to the buffer pool once the message is delivered
+     *      (or dropped).  This method only blocks if the queue of the topic's lane is full.
+     *
+     * \param [in] topic_id      Topic to produce to, KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+     * \param [in/out] cache     Topic handles (RdKafka::Topic) of the peer/router, updated if not resolved
+     * \param [in] router_group  Router group name - empty/NULL if not set or used
+     * \param [in] peer_group    Peer group name - empty/NULL if not set or used
+     * \param [in] peer_asn      Peer ASN
+     * \param [in] key           Hash key
+     * \param [in] buf           Pooled buffer containing the message (header and body)
+     * \param [in] msg           Start of the message within buf
+     * \param [in] msg_size      Length in bytes of the message
+     * \param [in] router_ip     Router IP address - used for logging
+     ***********************************************************************/
+    void produce(int topic_id, topic_cache &cache,
+                 const std::string *router_group, const std::string *peer_group,
+                 uint32_t peer_asn, const std::string &key,
+                 pool_buffer *buf, const char *msg, size_t msg_size,
+                 const std::string &router_ip);
+
+    /*********************************************************************//**
+     * Get the producer queue counters of a lane
+     *
+     * \param [in]  lane    lane_id
+     * \param [out] stats   Copy of the current counters
+     ***********************************************************************/
+    void getQueueStats(int lane, queue_stats &stats);
+
+    /*********************************************************************//**
+     * Get the delivered message and byte counters by topic and partition
+     *
+     * \param [out] stats   Copy of the current counters
+     ***********************************************************************/
+    void getPartitionStats(KafkaPartitionStats::topic_map &stats);
+
+    /*********************************************************************//**
+     * Delivery report of a produced message - called by the delivery report callback
+     *
+     * \param [in] message  Delivered or failed message
+     ***********************************************************************/
+    void deliveryReport(RdKafka::Message &message);
+
+    /*********************************************************************//**
+     * Lookup router group - See KafkaTopicSelector::lookupRouterGroup()
+     ***********************************************************************/
+    void lookupRouterGroup(std::string hostname, std::string ip_addr, std::string &router_group_name);
+
+    /*********************************************************************//**
+     * Lookup peer group - See KafkaTopicSelector::lookupPeerGroup()
+     ***********************************************************************/
+    void lookupPeerGroup(std::string hostname, std::string ip_addr, uint32_t peer_asn,
+                         std::string &peer_group_name);
+
+    // Debug methods
+    void enableDebug();
+    void disableDebug();
+
+private:
+    Config          *cfg;                       ///< Pointer to config instance
+    Logger          *logger;                    ///< Logging class pointer
+    bool            debug;                      ///< debug flag to indicate debugging
+
+    KafkaPartitionStats partition_stats;        ///< Delivered messages by partition, counted by the delivery report callback
+    std::map<std::string, uint64_t> logged_partition_msgs; ///< Delivered messages by topic at the last logPartitionStats()
+
+    /**
+     * Kafka Configuration object (global)
+     */
+    RdKafka::Conf   *conf;
+
+    /**
+     * Callback handlers
+     */
+    KafkaEventCallback              *event_callback;
+    KafkaDeliveryReportCallback     *delivery_callback;
+
+    bool isConnected;                           ///< Indicates if Kafka is connected or not
+
+    uint32_t        topic_generation;           ///< Incremented each time the topic selectors (and topics) are created
+
+    std::mutex      prod_mutex;                 ///< Serializes connect/disconnect and produce to librdkafka
+    std::mutex      topic_mutex;                ///< Protects the lane topicSel and topic_generation changes
+
+    /**
+     * Message queued for the producer thread
+     */
+    struct produce_item {
+        pool_buffer     *buf;                   ///< Buffer containing the message
+        const char      *msg;                   ///< Start of the message within buf
+        size_t          msg_size;               ///< Length of the message
+        int             topic_id;               ///< KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+        RdKafka::Topic  *topic;                 ///< Topic handle, NULL if not resolved
+        uint32_t        generation;             ///< Topic generation of the handle
+        uint32_t        peer_asn;               ///< Peer ASN
+        std::string     router_group;           ///< Router group name, empty if none
+        std::string     peer_group;             ///< Peer group name, empty if none
+        size_t          key_len;                ///< Length of key
+        char            key[KAFKA_PRODUCER_KEY_MAX]; ///< Hash key
+    };
+
+    /**
+     * Lane - queue and librdkafka producer of a set of topics
+     */
+    struct lane {
+        RdKafka::Producer           *producer;  ///< Kafka Producer instance of the lane
+        KafkaTopicSelector          *topicSel;  ///< Topic selector/handler, topics are created on producer
+        std::deque<produce_item>    queue;      ///< Producer queue
+        size_t          queue_max_msgs;         ///< Max messages in the queue
+        size_t          queue_max_bytes;        ///< Max message bytes in the queue
+        std::string     buf_max_ms;             ///< librdkafka queue.buffering.max.ms (linger)
+        std::string     compression;            ///< librdkafka compression.codec
+        queue_stats     stats;                  ///< Producer queue counters
+        uint64_t        logged_waits;           ///< Waits at the last logQueueStats()
+        uint64_t        logged_dropped;         ///< Drops at the last logQueueStats()
+        uint64_t        logged_spilled;         ///< Spilled messages at the last logQueueStats()
+    };
+
+    std::vector<produce_item *> free_items;     ///< Messages not produced, reused as message opaque - prod_mutex
+
+    lane            lanes[KAFKA_LANE_MAX];      ///< Lanes by lane_id, queues are protected by queue_mutex
+    std::mutex      queue_mutex;                ///< Protects the lane queues and stats, run and space_waiters
+    std::condition_variable queue_cond;         ///< Signaled when a message is queued
+    std::condition_variable space_cond;         ///< Signaled when there is room in a queue
+    int             space_waiters;              ///< Number of callers blocked on a full queue
+
+    SpillLog        *spill;                     ///< Spill log, NULL if disabled
+    bool            spilling;                   ///< Messages are appended to the spill log until it is replayed
+    int             spill_appends;              ///< Appends in progress without queue_mutex, spilling ends when 0
+    size_t          spill_watermark_msgs;       ///< Queued bulk messages at which spilling starts
+    size_t          spill_watermark_bytes;      ///< Queued bulk bytes at which spilling starts
+    bool            run;                        ///< False when the producer thread should stop
+
+    std::thread     *producer_thread;           ///< Produces queued messages and handles reconnects
+
+    /**
+     * Producer thread loop
+     */
+    void producerLoop();
+
+    /**
+     * Produce a queued message to librdkafka, reconnecting if needed
+     *
+     * \param [in] lane_id  Lane of the message
+     * \param [in] item     Message to produce; the buffer is released if the message is dropped
+     * \param [in] wait     Wait while the librdkafka queue of the lane is full
+     *
+     * \return false if not produced because the librdkafka queue is full (wait is false), true otherwise
+     */
+    bool produceItem(int lane_id, produce_item &item, bool wait);
+
+    /**
+     * Append a message to the spill log without queue_mutex - queue_mutex must be held by lock
+     *
+     * \param [in] lock     Lock of queue_mutex, released during the append
+     * \param [in] item     Message to append
+     *
+     * \return false if the spill log is full
+     */
+    bool spillAppend(std::unique_lock<std::mutex> &lock, produce_item &item);
+
+    /**
+     * Spill a message, waiting if the spill log is full - queue_mutex must be held by lock
+     *
+     * \param [in] lock     Lock of queue_mutex
+     * \param [in] item     Message to spill; the buffer is released if spilled
+     *
+     * \return true if spilled, false if the spill log was replayed meanwhile and the message
+     *      should be queued instead
+     */
+    bool spillItem(std::unique_lock<std::mutex> &lock, produce_item &item);
+
+    /**
+     * Get the next message from the spill log - queue_mutex must be held
+     *
+     * \param [out] item    Message, in a newly acquired buffer
+     *
+     * \return true if a message was read, false if the spill log is empty and spilling ended
+     */
+    bool replayItem(produce_item &item);
+
+    /**
+     * Log the producer queue counters if there was backpressure or drops since the last log
+     */
+    void logQueueStats();
+
+    /**
+     * Log the partition load of each topic that had deliveries since the last log
+     */
+    void logPartitionStats();
+
+    /**
+     * Connects to kafka broker - prod_mutex must be held
+     */
+    void connect();
+
+    /**
+     * Disconnects from kafka broker - prod_mutex must be held
+     */
+    void disconnect(int wait_ms=2000);
+};
+
+#endif //OPENBMP_KAFKAPRODUCERSERVICE_H
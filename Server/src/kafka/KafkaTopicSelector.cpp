@@ -13,6 +13,21 @@
 #include "KafkaTopicSelector.h"
 #include "kafka/MsgBusImpl_kafka.h"
 
+const char * const KafkaTopicSelector::topic_vars[MSGBUS_TOPIC_ID_MAX] = {
+        MSGBUS_TOPIC_VAR_COLLECTOR,
+        MSGBUS_TOPIC_VAR_ROUTER,
+        MSGBUS_TOPIC_VAR_PEER,
+        MSGBUS_TOPIC_VAR_BASE_ATTRIBUTE,
+        MSGBUS_TOPIC_VAR_UNICAST_PREFIX,
+        MSGBUS_TOPIC_VAR_L3VPN,
+        MSGBUS_TOPIC_VAR_EVPN,
+        MSGBUS_TOPIC_VAR_LS_NODE,
+        MSGBUS_TOPIC_VAR_LS_LINK,
+        MSGBUS_TOPIC_VAR_LS_PREFIX,
+        MSGBUS_TOPIC_VAR_BMP_STAT,
+        MSGBUS_TOPIC_VAR_BMP_RAW
+};
+
 /*********************************************************************//**
  * Constructor for class
  *
@@ -85,14 +100,49 @@ RdKafka::Topic * KafkaTopicSelector::getTopic(const std::string &topic_var,
 }
 
 /*********************************************************************//**
- * Check if a topic is enabled
+ * Get the topic name by topic var name, router and peer group
  *
  * \param [in]  topic_var       MSGBUS_TOPIC_VAR_<name>
+ * \param [in]  router_group    Router group - empty/NULL means no router group
+ * \param [in]  peer_group      Peer group - empty/NULL means no peer group
+ * \param [in]  peer_asn        Peer asn (remote asn)
  *
- * \return bool true if the topic is enabled, false otherwise
-***********************************************************************/
-bool KafkaTopicSelector::topicEnabled(const std::string &topic_var) {
-    return this->cfg->topic_names_map[topic_var].length() > 0;
+ * \return topic name with the variables replaced, empty if the topic is not configured
+ ***********************************************************************/
+std::string KafkaTopicSelector::getTopicName(const std::string &topic_var,
+                                             const std::string *router_group, const std::string *peer_group,
+                                             uint32_t peer_asn) {
+    char uint32_str[12];
+
+    Config::topic_names_map_iter it = cfg->topic_names_map.find(topic_var);
+    if (it == cfg->topic_names_map.end())
+        return "";
+
+    // Get the actual topic name based on var
+    std::string topic_name = it->second;
+
+    // Update the topic name based on app variables
+    if (topic_var.compare(MSGBUS_TOPIC_VAR_COLLECTOR)) {   // if not collector topic
+        if (router_group != NULL and router_group->size() > 0) {
+            boost::replace_all(topic_name, "{router_group}", *router_group);
+        } else
+            boost::replace_all(topic_name, "{router_group}", "default");
+
+        if (topic_var.compare(MSGBUS_TOPIC_VAR_ROUTER)) {    // if not router topic
+            if (peer_group != NULL and peer_group->size() > 0) {
+                boost::replace_all(topic_name, "{peer_group}", *peer_group);
+            } else
+                boost::replace_all(topic_name, "{peer_group}", "default");
+
+            if (peer_asn > 0) {
+                snprintf(uint32_str, sizeof(uint32_str), "%u", peer_asn);
+                boost::replace_all(topic_name, "{peer_asn}", (const char *)uint32_str);
+            } else
+                boost::replace_all(topic_name, "{peer_asn}", "default");
+        }
+    }
+
+    return topic_name;
 }
 
 /*********************************************************************//**
@@ -107,106 +157,25 @@ bool KafkaTopicSelector::topicEnabled(const std::string &topic_var) {
  ***********************************************************************/
 void KafkaTopicSelector::lookupPeerGroup(std::string hostname, std::string ip_addr, uint32_t peer_asn,
                                          std::string &peer_group_name) {
+    const std::string *group;
 
     peer_group_name = "";
 
     /*
-     * Match against hostname regexp
-     */
-    if (hostname.size() > 0) {
-
-        // Loop through all groups and their regular expressions
-        for (Config::match_peer_group_by_name_iter it = cfg->match_peer_group_by_name.begin();
-            it != cfg->match_peer_group_by_name.end(); ++it) {
-
-            // loop through all regexps to see if there is a match
-            for (std::list<Config::match_type_regex>::iterator lit = it->second.begin();
-                    lit != it->second.end(); ++lit) {
-                if (regex_search(hostname, lit->regexp)) {
-                    SELF_DEBUG("Regexp matched hostname %s to peer group '%s'",
-                                hostname.c_str(), it->first.c_str());
-                    peer_group_name = it->first;
-                    return;
-                }
-            }
-        }
-    }
-
-    /*
-     * Match against prefix ranges
+     * Match against hostname regexp, then prefix ranges, then asn
      */
-    bool isIPv4 = ip_addr.find_first_of(':') == std::string::npos ? true : false;
-    uint8_t bits;
-
-    uint32_t prefix[4]  __attribute__ ((aligned));
-    bzero(prefix,sizeof(prefix));
-
-    inet_pton(isIPv4 ? AF_INET : AF_INET6, ip_addr.c_str(), prefix);
-
-    // Loop through all groups and their regular expressions
-    for (Config::match_peer_group_by_ip_iter it = cfg->match_peer_group_by_ip.begin();
-         it != cfg->match_peer_group_by_ip.end(); ++it) {
-
-        // loop through all prefix ranges to see if there is a match
-        for (std::list<Config::match_type_ip>::iterator lit = it->second.begin();
-             lit != it->second.end(); ++lit) {
+    if ((group = cfg->match_peer_group.matchHostname(hostname)) != NULL) {
+        SELF_DEBUG("Regexp matched hostname %s to peer group '%s'", hostname.c_str(), group->c_str());
 
-            if (lit->isIPv4 == isIPv4) { // IPv4
-                bits = 32 - lit->bits;
+    } else if ((group = cfg->match_peer_group.matchIp(ip_addr)) != NULL) {
+        SELF_DEBUG("IP %s matched peer group %s", ip_addr.c_str(), group->c_str());
 
-                // Big endian
-                prefix[0] <<= bits;
-                prefix[0] >>= bits;
-
-                if (prefix[0] == lit->prefix[0]) {
-                    SELF_DEBUG("IP %s matched peer group %s", ip_addr.c_str(), it->first.c_str());
-                    peer_group_name = it->first;
-                    return;
-                }
-            } else { // IPv6
-                uint8_t end_idx = lit->bits / 32;
-                bits = lit->bits - (32 * end_idx);
-
-                if (bits == 0)
-                    end_idx--;
-
-                if (end_idx < 4 and bits < 32) {    // end_idx should be less than 4 and bits less than 32
-
-                    // Big endian
-                    prefix[end_idx] <<= bits;
-                    prefix[end_idx] >>= bits;
-                }
-
-                if (prefix[0] == lit->prefix[0] and prefix[1] == lit->prefix[1]
-                        and prefix[2] == lit->prefix[2] and prefix[3] == lit->prefix[3]) {
-
-                    SELF_DEBUG("IP %s matched peer group %s", ip_addr.c_str(), it->first.c_str());
-                    peer_group_name = it->first;
-                    return;
-                }
-            }
-        }
-    }
-
-    /*
-     * Match against asn list
-     */
-    // Loop through all groups and their regular expressions
-    for (Config::match_peer_group_by_asn_iter it = cfg->match_peer_group_by_asn.begin();
-         it != cfg->match_peer_group_by_asn.end(); ++it) {
-
-        // loop through all prefix ranges to see if there is a match
-        for (std::list<uint32_t>::iterator lit = it->second.begin();
-             lit != it->second.end(); ++lit) {
-
-            if (*lit == peer_asn) {
-                SELF_DEBUG("Peer ASN %u matched peer group %s", peer_asn, it->first.c_str());
-                peer_group_name = it->first;
-                return;
-            }
-        }
+    } else if ((group = cfg->match_peer_group.matchAsn(peer_asn)) != NULL) {
+        SELF_DEBUG("Peer ASN %u matched peer group %s", peer_asn, group->c_str());
     }
 
+    if (group != NULL)
+        peer_group_name = *group;
 }
 
 /*********************************************************************//**
@@ -220,90 +189,24 @@ void KafkaTopicSelector::lookupPeerGroup(std::string hostname, std::string ip_ad
  ***********************************************************************/
 void KafkaTopicSelector::lookupRouterGroup(std::string hostname, std::string ip_addr,
                                          std::string &router_group_name) {
+    const std::string *group;
 
     router_group_name = "";
 
     SELF_DEBUG("router lookup for hostname=%s and ip_addr=%s", hostname.c_str(), ip_addr.c_str());
 
     /*
-     * Match against hostname regexp
+     * Match against hostname regexp, then prefix ranges
      */
-    if (hostname.size() > 0) {
+    if ((group = cfg->match_router_group.matchHostname(hostname)) != NULL) {
+        SELF_DEBUG("Regexp matched hostname %s to router group '%s'", hostname.c_str(), group->c_str());
 
-        // Loop through all groups and their regular expressions
-        for (Config::match_router_group_by_name_iter it = cfg->match_router_group_by_name.begin();
-             it != cfg->match_router_group_by_name.end(); ++it) {
-
-            // loop through all regexps to see if there is a match
-            for (std::list<Config::match_type_regex>::iterator lit = it->second.begin();
-                 lit != it->second.end(); ++lit) {
-
-                if (regex_search(hostname, lit->regexp)) {
-                    SELF_DEBUG("Regexp matched hostname %s to router group '%s'",
-                               hostname.c_str(), it->first.c_str());
-                    router_group_name = it->first;
-                    return;
-                }
-            }
-        }
+    } else if ((group = cfg->match_router_group.matchIp(ip_addr)) != NULL) {
+        SELF_DEBUG("IP %s matched router group %s", ip_addr.c_str(), group->c_str());
     }
 
-    /*
-     * Match against prefix ranges
-     */
-    bool isIPv4 = ip_addr.find_first_of(':') == std::string::npos ? true : false;
-    uint8_t bits;
-
-    uint32_t prefix[4]  __attribute__ ((aligned));
-    bzero(prefix,sizeof(prefix));
-
-    inet_pton(isIPv4 ? AF_INET : AF_INET6, ip_addr.c_str(), prefix);
-
-    // Loop through all groups and their regular expressions
-    for (Config::match_router_group_by_ip_iter it = cfg->match_router_group_by_ip.begin();
-         it != cfg->match_router_group_by_ip.end(); ++it) {
-
-        // loop through all prefix ranges to see if there is a match
-        for (std::list<Config::match_type_ip>::iterator lit = it->second.begin();
-             lit != it->second.end(); ++lit) {
-
-            if (lit->isIPv4 == isIPv4) { // IPv4
-
-                bits = 32 - lit->bits;
-
-                // Big endian
-                prefix[0] <<= bits;
-                prefix[0] >>= bits;
-
-                if (prefix[0] == lit->prefix[0]) {
-                    SELF_DEBUG("IP %s matched router group %s", ip_addr.c_str(), it->first.c_str());
-                    router_group_name = it->first;
-                    return;
-                }
-            } else { // IPv6
-                uint8_t end_idx = lit->bits / 32;
-                bits = lit->bits - (32 * end_idx);
-
-                if (bits == 0)
-                    end_idx--;
-
-                if (end_idx < 4 and bits < 32) {    // end_idx should be less than 4 and bits less than 32
-
-                    // Big endian
-                    prefix[end_idx] <<= bits;
-                    prefix[end_idx] >>= bits;
-                }
-
-                if (prefix[0] == lit->prefix[0] and prefix[1] == lit->prefix[1]
-                    and prefix[2] == lit->prefix[2] and prefix[3] == lit->prefix[3]) {
-
-                    SELF_DEBUG("IP %s matched router group %s", ip_addr.c_str(), it->first.c_str());
-                    router_group_name = it->first;
-                    return;
-                }
-            }
-        }
-    }
+    if (group != NULL)
+        router_group_name = *group;
 }
 
 
@@ -324,44 +227,20 @@ RdKafka::Topic * KafkaTopicSelector::initTopic(const std::string &topic_var,
                                                const std::string *router_group, const std::string *peer_group,
                                                uint32_t peer_asn) {
     std::string errstr;
-    char uint32_str[12];
-
-    // Get the actual topic name based on var
-    std::string topic_name = this->cfg->topic_names_map[topic_var];
 
     /*
      * topics that contain the peer asn need to have the key include the peer asn
      */
-    if (topic_name.find("{peer_asn}") != std::string::npos) {
+    if (this->cfg->topic_names_map[topic_var].find("{peer_asn}") != std::string::npos) {
         topic_flags_map[topic_var].include_peerAsn = true;
-        SELF_DEBUG("peer_asn found in topic %s, setting topic flag to include peer ASN", topic_name.c_str());
+        SELF_DEBUG("peer_asn found in topic %s, setting topic flag to include peer ASN", topic_var.c_str());
     } else {
         topic_flags_map[topic_var].include_peerAsn = false;
     }
 
     // Update the topic key based on the peer_group/router_group
     std::string topic_key = getTopicKey(topic_var, router_group, peer_group, peer_asn);
-
-    // Update the topic name based on app variables
-    if (topic_var.compare(MSGBUS_TOPIC_VAR_COLLECTOR)) {   // if not collector topic
-        if (router_group != NULL and router_group->size() > 0) {
-            boost::replace_all(topic_name, "{router_group}", *router_group);
-        } else
-            boost::replace_all(topic_name, "{router_group}", "default");
-
-        if (topic_var.compare(MSGBUS_TOPIC_VAR_ROUTER)) {    // if not router topic
-            if (peer_group != NULL and peer_group->size() > 0) {
-                boost::replace_all(topic_name, "{peer_group}", *peer_group);
-            } else
-                boost::replace_all(topic_name, "{peer_group}", "default");
-
-            if (peer_asn > 0) {
-                snprintf(uint32_str, sizeof(uint32_str), "%u", peer_asn);
-                boost::replace_all(topic_name, "{peer_asn}", (const char *)uint32_str);
-            } else
-                boost::replace_all(topic_name, "{peer_asn}", "default");
-        }
-    }
+    std::string topic_name = getTopicName(topic_var, router_group, peer_group, peer_asn);
 
     SELF_DEBUG("Creating topic %s (map key=%s)" , topic_name.c_str(), topic_key.c_str());
 
@@ -375,7 +254,7 @@ RdKafka::Topic * KafkaTopicSelector::initTopic(const std::string &topic_var,
     /*
      * Topic configuration
      */
-    if (tconf->set("partitioner_cb", peer_partitioner_callback, errstr) != RdKafka::Conf::CONF_OK) {
+    if (tconf->set("partitioner_key_pointer_cb", peer_partitioner_callback, errstr) != RdKafka::Conf::CONF_OK) {
         LOG_ERR("Failed to configure kafka partitioner callback: %s", errstr.c_str());
         throw "ERROR: Failed to configure kafka partitioner callback";
     }
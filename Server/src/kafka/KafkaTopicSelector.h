@@ -50,13 +50,35 @@ public:
     #define MSGBUS_TOPIC_VAR_BMP_STAT           "bmp_stat"
     #define MSGBUS_TOPIC_VAR_BMP_RAW            "bmp_raw"
 
+    /**
+     * MSGBUS_TOPIC_ID_* defines the topic index used for precomputed topic handles and the
+     *      enabled topics bitmask.  topic_vars[] maps the index to the MSGBUS_TOPIC_VAR_* name.
+     */
+    enum topic_id {
+        MSGBUS_TOPIC_ID_COLLECTOR = 0,
+        MSGBUS_TOPIC_ID_ROUTER,
+        MSGBUS_TOPIC_ID_PEER,
+        MSGBUS_TOPIC_ID_BASE_ATTRIBUTE,
+        MSGBUS_TOPIC_ID_UNICAST_PREFIX,
+        MSGBUS_TOPIC_ID_L3VPN,
+        MSGBUS_TOPIC_ID_EVPN,
+        MSGBUS_TOPIC_ID_LS_NODE,
+        MSGBUS_TOPIC_ID_LS_LINK,
+        MSGBUS_TOPIC_ID_LS_PREFIX,
+        MSGBUS_TOPIC_ID_BMP_STAT,
+        MSGBUS_TOPIC_ID_BMP_RAW,
+        MSGBUS_TOPIC_ID_MAX
+    };
+
+    static const char * const topic_vars[MSGBUS_TOPIC_ID_MAX];     ///< MSGBUS_TOPIC_VAR_* by MSGBUS_TOPIC_ID_*
+
 
     /*********************************************************************//**
      * Constructor for class
      *
      * \param [in] logPtr   Pointer to Logger instance
      * \param [in] cfg      Pointer to the config instance
-     * \param [in] producer Pointer to the kafka producer
+     * \param [in] producer Pointer to the kafka producer, NULL if only used for names and group lookups
      ***********************************************************************/
     KafkaTopicSelector(Logger *logPtr, Config *cfg,  RdKafka::Producer *producer);
 
@@ -81,13 +103,19 @@ public:
                               uint32_t peer_asn);
 
     /*********************************************************************//**
-     * Check if a topic is enabled
+     * Get the topic name by topic var name, router and peer group
+     *
+     * \details Does not create the topic, so can be used without a producer.
      *
      * \param [in]  topic_var       MSGBUS_TOPIC_VAR_<name>
+     * \param [in]  router_group    Router group - empty/NULL means no router group
+     * \param [in]  peer_group      Peer group - empty/NULL means no peer group
+     * \param [in]  peer_asn        Peer asn (remote asn)
      *
-     * \return bool true if the topic is enabled, false otherwise
+     * \return topic name with the variables replaced, empty if the topic is not configured
      ***********************************************************************/
-    bool topicEnabled(const std::string &topic_var);
+    std::string getTopicName(const std::string &topic_var, const std::string *router_group,
+                             const std::string *peer_group, uint32_t peer_asn);
 
     /*********************************************************************//**
      * Lookup router group
@@ -8,9 +8,11 @@
  */
 #include <cstdlib>
 #include <cstring>
+#include <cstdarg>
 #include <iostream>
 
 #include <cinttypes>
+#include <algorithm>
 
 #include <librdkafka/rdkafkacpp.h>
 #include <netdb.h>
@@ -29,33 +31,57 @@
 #include <librdkafka/rdkafka.h>
 
 
-#include "md5.h"
+#include "hash_id.h"
 
 using namespace std;
 
 /******************************************************************//**
- * \brief This function will initialize and connect to Kafka.
+ * \brief This function will initialize the per router message bus state
  *
- * \details It is expected that this class will start off with a new connection.
+ * \details Messages are produced using the shared (process wide) sink.
  *
  *  \param [in] logPtr      Pointer to Logger instance
  *  \param [in] cfg         Pointer to the config instance
+ *  \param [in] producer    Pointer to the shared message bus sink
+ *  \param [in] resolver    Pointer to the shared DNS resolver
  *  \param [in] c_hash_id   Collector Hash ID
  ********************************************************************/
-msgBus_kafka::msgBus_kafka(Logger *logPtr, Config *cfg, u_char *c_hash_id) {
+msgBus_kafka::msgBus_kafka(Logger *logPtr, Config *cfg, MsgBusSink *producer,
+                           DnsResolver *resolver, u_char *c_hash_id) {
     logger = logPtr;
 
-    producer_buf = new unsigned char[MSGBUS_WORKING_BUF_SIZE];
-    prep_buf = new char[MSGBUS_WORKING_BUF_SIZE];
+    pool = producer->getBufferPool();
+
+    // Batch buffers are acquired on first use of the topic
+    for (int i=0; i < KafkaTopicSelector::MSGBUS_TOPIC_ID_MAX; i++) {
+        batches[i].buf = NULL;
+        batches[i].rows = NULL;
+        batches[i].size = 0;
+        batches[i].size_hint = MSGBUS_ROWS_INIT_SIZE;
+        batches[i].len = 0;
+        batches[i].count = 0;
+        batches[i].peer_group = NULL;
+        batches[i].peer_asn = 0;
+        batches[i].topics = NULL;
+    }
+
+    batch_topic_id = KafkaTopicSelector::MSGBUS_TOPIC_ID_COLLECTOR;
+    pending_batches = 0;
+    last_peer_ctx = NULL;
 
     hash_toStr(c_hash_id, collector_hash);
 
-    isConnected = false;
-    conf = RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL);
+    // Message header up to the length, which is the same for all messages of a topic
+    for (int i=0; i < KafkaTopicSelector::MSGBUS_TOPIC_ID_MAX; i++) {
+        topic_binary[i] = cfg->binary_topics.count(KafkaTopicSelector::topic_vars[i]) > 0;
 
-    disableDebug();
+        topic_hdr[i] = topic_binary[i] ? "V: " MSGBUS_V2_VERSION : "V: " MSGBUS_API_VERSION;
+        topic_hdr[i] += "\nC_HASH_ID: " + collector_hash + "\nT: ";
+        topic_hdr[i] += KafkaTopicSelector::topic_vars[i];
+        topic_hdr[i] += "\nL: ";
+    }
 
-    // TODO: Init the topic selector class
+    disableDebug();
 
     router_seq          = 0L;
     collector_seq       = 0L;
@@ -70,17 +96,12 @@ msgBus_kafka::msgBus_kafka(Logger *logPtr, Config *cfg, u_char *c_hash_id) {
     bmp_stat_seq        = 0L;
 
     this->cfg           = cfg;
-
-    // Make the connection to the server
-    event_callback       = NULL;
-    delivery_callback    = NULL;
-    producer             = NULL;
-    topicSel             = NULL;
+    this->producer      = producer;
+    this->resolver      = resolver;
+    router_name_pending = false;
 
     router_ip.assign("");
     bzero(router_hash, sizeof(router_hash));
-
-    connect();
 }
 
 /**
@@ -111,312 +132,487 @@ msgBus_kafka::~msgBus_kafka() {
         update_Router(r_object, msgBus_kafka::ROUTER_ACTION_TERM);
     }
 
-    sleep(2);
-
-    delete [] producer_buf;
-    delete [] prep_buf;
-
-    peer_list.clear();
+    flush(false);
 
-    disconnect(500);
+    for (int i=0; i < KafkaTopicSelector::MSGBUS_TOPIC_ID_MAX; i++)
+        pool->release(batches[i].buf);
 
-    delete conf;
+    peer_ctx_map.clear();
 }
 
 /**
- * Disconnect from Kafka
+ * produce message to Kafka
+ *
+ * \details The message is copied once into a pooled buffer.  Use producePooled() for
+ *          messages that are already in a pooled buffer.
+ *
+ * \param [in] topic_id      Topic to produce to, KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+ * \param [in] msg           message to produce
+ * \param [in] msg_size      Length in bytes of the message
+ * \param [in] rows          Number of rows
+ * \param [in] key           Hash key
+ * \param [in] peer_group    Peer group name - empty/NULL if not set or used
+ * \param [in] peer_asn      Peer ASN
+ * \param [in/out] topics    Topic handles of the peer/router
  */
-void msgBus_kafka::disconnect(int wait_ms) {
-
-    if (isConnected) {
-        int i = 0;
-        while (producer->outq_len() > 0 and i < 8) {
-            LOG_INFO("Waiting for producer to finish before disconnecting: outq=%d", producer->outq_len());
-            producer->poll(500);
-            i++;
-        }
-    }
+void msgBus_kafka::produce(int topic_id, char *msg, size_t msg_size, int rows, const string &key,
+                           const string *peer_group, uint32_t peer_asn, MsgBusSink::topic_cache &topics) {
 
-    if (topicSel != NULL) delete topicSel;
+    // if topic is disabled, don't bother producing the message
+    // TODO: it would be more efficient to move this check to the top of the various update_* methods, but I'm not sure which parts of these methods have side-effects that need to be preserved.
+    if (!producer->topicEnabled(topic_id))
+        return;
 
-    topicSel = NULL;
+    pool_buffer *buf = pool->acquire(MSGBUS_HDR_ROOM + msg_size);
+    memcpy(buf->data + MSGBUS_HDR_ROOM, msg, msg_size);
 
-    if (producer != NULL) delete producer;
-    producer = NULL;
+    producePooled(topic_id, buf, msg_size, rows, key, peer_group, peer_asn, topics);
+}
 
-    // suggested by librdkafka to free memory
-    RdKafka::wait_destroyed(wait_ms);
+/**
+ * produce message in a pooled buffer to Kafka without copying it
+ *
+ * \details The header is written in the room reserved before the message.  Ownership
+ *          of buf is transferred to the producer.
+ *
+ * \param [in] topic_id      Topic to produce to, KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+ * \param [in] buf           Pooled buffer, the message starts at MSGBUS_HDR_ROOM
+ * \param [in] msg_size      Length in bytes of the message
+ * \param [in] rows          Number of rows
+ * \param [in] key           Hash key
+ * \param [in] peer_group    Peer group name - empty/NULL if not set or used
+ * \param [in] peer_asn      Peer ASN
+ * \param [in/out] topics    Topic handles of the peer/router
+ */
+void msgBus_kafka::producePooled(int topic_id, pool_buffer *buf, size_t msg_size, int rows, const string &key,
+                                 const string *peer_group, uint32_t peer_asn,
+                                 MsgBusSink::topic_cache &topics) {
+    size_t len;
+
+    if (!producer->topicEnabled(topic_id)) {
+        pool->release(buf);
+        return;
+    }
+
+    // Header is the precomputed topic header followed by the message length and rows
+    char headers[MSGBUS_HDR_ROOM];
+    const string &hdr = topic_hdr[topic_id];
 
-    if (event_callback != NULL) delete event_callback;
-    event_callback = NULL;
+    memcpy(headers, hdr.data(), hdr.size());
+    len = hdr.size() + snprintf(headers + hdr.size(), sizeof(headers) - hdr.size(), "%lu\nR: %d\n\n",
+                                msg_size, rows);
 
-    if (delivery_callback != NULL) delete delivery_callback;
-    delivery_callback = NULL;
+    char *msg = buf->data + MSGBUS_HDR_ROOM - len;
+    memcpy(msg, headers, len);
 
-    isConnected = false;
+    producer->produce(topic_id, topics, &router_group_name, peer_group, peer_asn, key,
+                      buf, msg, len + msg_size, router_ip);
 }
 
 /**
- * Connects to Kafka broker
+ * Get the context of a peer, creating it if needed
+ *
+ * \param [in/out] peer          Peer entry
+ *
+ * \return Peer context
  */
-void msgBus_kafka::connect() {
-    string errstr;
-    string value;
-    std::ostringstream rx_bytes, tx_bytes, sess_timeout, socket_timeout;
-    std::ostringstream q_buf_max_msgs, q_buf_max_kbytes, q_buf_max_ms,
-		msg_send_max_retry, retry_backoff_ms;
+msgBus_kafka::peer_context &msgBus_kafka::getPeerContext(obj_bgp_peer &peer) {
+    peer_key key;
 
-    disconnect();
+    memcpy(key.addr, peer.peer_addr_bin, sizeof(key.addr));
+    memcpy(key.rd, peer.peer_rd_bin, sizeof(key.rd));
+    key.isIPv4 = peer.isIPv4;
 
-    /*
-     * Configure Kafka Producer (https://kafka.apache.org/08/configuration.html)
-     */
-    //TODO: Add config options to change these settings
-
-    // Disable logging of connection close/idle timeouts caused by Kafka 0.9.x (connections.max.idle.ms)
-    //    See https://github.com/edenhill/librdkafka/issues/437 for more details.
-    // TODO: change this when librdkafka has better handling of the idle disconnects
-    value = "false";
-    if (conf->set("log.connection.close", value, errstr) != RdKafka::Conf::CONF_OK) {
-        LOG_ERR("Failed to configure log.connection.close=false: %s.", errstr.c_str());
-    }
+    peer_context *ctx = last_peer_ctx;
 
-    value = "true";
-    if (conf->set("api.version.request", value, errstr) != RdKafka::Conf::CONF_OK) {
-        LOG_ERR("Failed to configure api.version.request=true: %s.", errstr.c_str());
+    if (ctx == NULL or not (key == last_peer_key)) {
+        peer_ctx_map_iter it = peer_ctx_map.find(key);
+
+        if (it == peer_ctx_map.end()) {
+            ctx = &peer_ctx_map[key];
+            bzero(ctx->router_hash_id, sizeof(ctx->router_hash_id));
+            ctx->active = false;
+            ctx->name_pending = false;
+            ctx->hash_str.clear();
+        } else
+            ctx = &it->second;
+
+        last_peer_ctx = ctx;
+        last_peer_key = key;
     }
 
-    // TODO: Add config for address family - default is any
-    /*value = "v4";
-    if (conf->set("broker.address.family", value, errstr) != RdKafka::Conf::CONF_OK) {
-        LOG_ERR("Failed to configure broker.address.family: %s.", errstr.c_str());
-    }*/
+    // Generate the peer hash if new or the router hash has changed
+    if (ctx->hash_str.empty() or memcmp(ctx->router_hash_id, peer.router_hash_id, sizeof(ctx->router_hash_id)) != 0) {
+        const string &r_hash_str = cachedHashStr(peer.router_hash_id, r_hash_cache);
 
+        HashId hash;
 
-    // Batch message number
-    value = "100";
-    if (conf->set("batch.num.messages", value, errstr) != RdKafka::Conf::CONF_OK) {
-        LOG_ERR("Failed to configure batch.num.messages for kafka: %s.", errstr.c_str());
-        throw "ERROR: Failed to configure kafka batch.num.messages";
-    }
+        hash.update((unsigned char *) peer.peer_addr,
+                    strlen(peer.peer_addr));
+        hash.update((unsigned char *) peer.peer_rd, strlen(peer.peer_rd));
+        hash.update((unsigned char *)r_hash_str.c_str(), r_hash_str.length());
 
-    // Batch message max wait time (in ms)
-    q_buf_max_ms << cfg->q_buf_max_ms;
-    if (conf->set("queue.buffering.max.ms", q_buf_max_ms.str(), errstr) != RdKafka::Conf::CONF_OK) {
-        LOG_ERR("Failed to configure queue.buffering.max.ms for kafka: %s.", errstr.c_str());
-        throw "ERROR: Failed to configure kafka queue.buffer.max.ms";
-    }
+        /* TODO: Uncomment once this is fixed in XR
+         * Disable hashing the bgp peer ID since XR has an issue where it sends 0.0.0.0 on subsequent PEER_UP's
+         *    This will be fixed in XR, but for now we can disable hashing on it.
+         *
+        hash.update((unsigned char *) p_object.peer_bgp_id,
+                strlen(p_object.peer_bgp_id));
+        */
 
+        hash.finalize();
 
-    // compression
-    value = cfg->compression;
-    if (conf->set("compression.codec", value, errstr) != RdKafka::Conf::CONF_OK) {
-        LOG_ERR("Failed to configure %s compression for kafka: %s.", value.c_str(), errstr.c_str());
-        throw "ERROR: Failed to configure kafka compression";
-    }
+        // Save the hash
+        hash.raw_digest(ctx->hash_id);
+        hash_toStr(ctx->hash_id, ctx->hash_str);
 
-    // broker list
-    if (conf->set("metadata.broker.list", cfg->kafka_brokers, errstr) != RdKafka::Conf::CONF_OK) {
-        LOG_ERR("Failed to configure broker list for kafka: %s", errstr.c_str());
-        throw "ERROR: Failed to configure kafka broker list";
+        memcpy(ctx->router_hash_id, peer.router_hash_id, sizeof(ctx->router_hash_id));
+        ctx->active = false;
     }
 
-    // Maximum transmit byte size
-    tx_bytes << cfg->tx_max_bytes;
-    if (conf->set("message.max.bytes", tx_bytes.str(), 
-                             errstr) != RdKafka::Conf::CONF_OK) 
-    {
-       LOG_ERR("Failed to configure transmit max message size for kafka: %s",
-                               errstr.c_str());
-       throw "ERROR: Failed to configure transmit max message size";
-    } 
- 
-    // Maximum receive byte size
-    rx_bytes << cfg->rx_max_bytes;
-    if (conf->set("receive.message.max.bytes", rx_bytes.str(), 
-                             errstr) != RdKafka::Conf::CONF_OK)
-    {
-       LOG_ERR("Failed to configure receive max message size for kafka: %s",
-                               errstr.c_str());
-       throw "ERROR: Failed to configure receive max message size";
-    }
+    memcpy(peer.hash_id, ctx->hash_id, sizeof(peer.hash_id));
 
-    // Client group session and failure detection timeout
-    sess_timeout << cfg->session_timeout;
-    if (conf->set("session.timeout.ms", sess_timeout.str(), 
-                             errstr) != RdKafka::Conf::CONF_OK) 
-    {
-       LOG_ERR("Failed to configure session timeout for kafka: %s",
-                               errstr.c_str());
-       throw "ERROR: Failed to configure session timeout ";
-    } 
-    
-    // Timeout for network requests 
-    socket_timeout << cfg->socket_timeout;
-    if (conf->set("socket.timeout.ms", socket_timeout.str(), 
-                             errstr) != RdKafka::Conf::CONF_OK) 
-    {
-       LOG_ERR("Failed to configure socket timeout for kafka: %s",
-                               errstr.c_str());
-       throw "ERROR: Failed to configure socket timeout ";
-    } 
-    
-    // Maximum number of messages allowed on the producer queue 
-    q_buf_max_msgs << cfg->q_buf_max_msgs;
-    if (conf->set("queue.buffering.max.messages", q_buf_max_msgs.str(), 
-                             errstr) != RdKafka::Conf::CONF_OK) 
-    {
-       LOG_ERR("Failed to configure max messages in buffer for kafka: %s",
-                               errstr.c_str());
-       throw "ERROR: Failed to configure max messages in buffer ";
-    }
+    return *ctx;
+}
 
-    // Maximum number of messages allowed on the producer queue
-    q_buf_max_kbytes << cfg->q_buf_max_kbytes;
-    if (conf->set("queue.buffering.max.kbytes", q_buf_max_kbytes.str(),
-                  errstr) != RdKafka::Conf::CONF_OK)
-    {
-        LOG_ERR("Failed to configure max kbytes in buffer for kafka: %s",
-                errstr.c_str());
-        throw "ERROR: Failed to configure max kbytes in buffer ";
+/**
+ * Get the printed form of a hash, converting it only if it differs from the cached hash
+ *
+ * \param [in]     hash_bin      16 byte binary hash
+ * \param [in/out] cache         Cache to use
+ *
+ * \return Hash in printed form
+ */
+const string &msgBus_kafka::cachedHashStr(const u_char *hash_bin, hash_str_cache &cache) {
+    if (cache.hash_str.empty() or memcmp(cache.hash_bin, hash_bin, sizeof(cache.hash_bin)) != 0) {
+        memcpy(cache.hash_bin, hash_bin, sizeof(cache.hash_bin));
+        hash_toStr(hash_bin, cache.hash_str);
     }
 
+    return cache.hash_str;
+}
 
-    // How many times to retry sending a failing MessageSet
-    msg_send_max_retry << cfg->msg_send_max_retry;
-    if (conf->set("message.send.max.retries", msg_send_max_retry.str(), 
-                             errstr) != RdKafka::Conf::CONF_OK) 
-    {
-       LOG_ERR("Failed to configure max retries for sending "
-               "failed message for kafka: %s",
-                               errstr.c_str());
-       throw "ERROR: Failed to configure max retries for sending failed message";
-    } 
-    
-    // Backoff time in ms before retrying a message send
-    retry_backoff_ms << cfg->retry_backoff_ms;
-    if (conf->set("retry.backoff.ms", retry_backoff_ms.str(), 
-                             errstr) != RdKafka::Conf::CONF_OK) 
-    {
-       LOG_ERR("Failed to configure backoff time before retrying to send"
-               "failed message for kafka: %s",
-                               errstr.c_str());
-       throw "ERROR: Failed to configure backoff time before resending"
-             " failed messages ";
-    } 
-    
-    // Register event callback
-    event_callback = new KafkaEventCallback(&isConnected, logger);
-    if (conf->set("event_cb", event_callback, errstr) != RdKafka::Conf::CONF_OK) {
-        LOG_ERR("Failed to configure kafka event callback: %s", errstr.c_str());
-        throw "ERROR: Failed to configure kafka event callback";
-    }
+/**
+ * Begin adding the rows of an update to the batch of a topic
+ *
+ * \param [in] topic_id      Topic to produce to, KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+ * \param [in] key           Hash key
+ * \param [in] peer_group    Peer group name - empty/NULL if not set or used
+ * \param [in] peer_asn      Peer ASN
+ * \param [in/out] topics    Topic handles of the peer
+ */
+void msgBus_kafka::beginRows(int topic_id, const string &key, const string *peer_group,
+                             uint32_t peer_asn, MsgBusSink::topic_cache &topics) {
+    row_batch &batch = batches[topic_id];
 
-    // Register delivery report callback
-    /*
-    delivery_callback = new KafkaDeliveryReportCallback();
+    batch_topic_id = topic_id;
+
+    // Only rows of the same peer are coalesced
+    if (batch.count > 0 and (batch.topics != &topics or batch.key != key))
+        flushBatch(topic_id);
+
+    if (batch.buf == NULL)
+        batchAcquire(batch, batch.size_hint);
 
-    if (conf->set("dr_cb", delivery_callback, errstr) != RdKafka::Conf::CONF_OK) {
-        LOG_ERR("Failed to configure kafka delivery report callback: %s", errstr.c_str());
-        throw "ERROR: Failed to configure kafka delivery report callback";
+    if (batch.count == 0) {
+        batch.key = key;
+        batch.peer_group = peer_group;
+        batch.peer_asn = peer_asn;
+        batch.topics = &topics;
     }
-    */
+}
+
+/**
+ * Append a formatted row to the current batch
+ *
+ * \param [in] fmt           printf format of the row
+ */
+void msgBus_kafka::appendRow(const char *fmt, ...) {
+    row_batch &batch = batches[batch_topic_id];
+    va_list args;
+
+    // Rows of a disabled topic are not produced, no need to format them
+    if (!producer->topicEnabled(batch_topic_id))
+        return;
+
+    while (true) {
+        size_t avail = batch.size - batch.len;
 
+        va_start(args, fmt);
+        int len = vsnprintf(batch.rows + batch.len, avail, fmt, args);
+        va_end(args);
 
-    // Create producer and connect
-    producer = RdKafka::Producer::create(conf, errstr);
-    if (producer == NULL) {
-        LOG_ERR("rtr=%s: Failed to create producer: %s", router_ip.c_str(), errstr.c_str());
-        throw "ERROR: Failed to create producer";
+        if (len < 0)
+            break;
+
+        if ((size_t)len < avail) {
+            batchAddRow(batch, len);
+            return;
+        }
+
+        // Row does not fit; terminate the batch at the previous row
+        batch.rows[batch.len] = 0;
+
+        if (not batchMakeRoom(batch, len))
+            break;
     }
 
-    isConnected = true;
+    LOG_WARN("%s: Dropping %s row that is larger than the working buffer", router_ip.c_str(),
+             KafkaTopicSelector::topic_vars[batch_topic_id]);
+}
 
-    producer->poll(1000);
+/**
+ * Append a binary row (API 2.0) to the current batch
+ *
+ * \param [in] head          Fields before the peer fields
+ * \param [in] body          Fields after the peer fields, up to the path attributes
+ * \param [in] with_attrs    Row has the path attribute fields (bin_attrs)
+ */
+void msgBus_kafka::appendBinaryRow(const string &head, const string &body, bool with_attrs) {
+    row_batch &batch = batches[batch_topic_id];
 
-    if (not isConnected) {
-        LOG_ERR("rtr=%s: Failed to connect to Kafka, will try again in a few", router_ip.c_str());
+    if (!producer->topicEnabled(batch_topic_id))
         return;
 
+    while (true) {
+        // Each message starts with full rows
+        if (batch.count == 0) {
+            batch.bin_peer.clear();
+            batch.bin_attrs.clear();
+        }
+
+        bool same_peer = bin_peer == batch.bin_peer;
+        bool same_attrs = with_attrs and bin_attrs == batch.bin_attrs;
+
+        size_t row_size = 1 + head.size() + (same_peer ? 0 : bin_peer.size()) + body.size()
+                          + (with_attrs and not same_attrs ? bin_attrs.size() : 0);
+
+        char row_len[MSGBUS_V2_UINT_MAX];
+        size_t row_len_size = MsgBusV2Writer::encodeUint(row_size, row_len);
+        size_t len = row_len_size + row_size;
+
+        if (len < batch.size - batch.len) {
+            char *p = batch.rows + batch.len;
+
+            memcpy(p, row_len, row_len_size);
+            p += row_len_size;
+
+            *p++ = (same_peer ? MSGBUS_V2_ROW_SAME_PEER : 0) | (same_attrs ? MSGBUS_V2_ROW_SAME_ATTRS : 0);
+
+            memcpy(p, head.data(), head.size());
+            p += head.size();
+
+            if (not same_peer) {
+                memcpy(p, bin_peer.data(), bin_peer.size());
+                p += bin_peer.size();
+                batch.bin_peer = bin_peer;
+            }
+
+            memcpy(p, body.data(), body.size());
+            p += body.size();
+
+            if (with_attrs and not same_attrs) {
+                memcpy(p, bin_attrs.data(), bin_attrs.size());
+                batch.bin_attrs = bin_attrs;
+            }
+
+            batchAddRow(batch, len);
+            return;
+        }
+
+        if (not batchMakeRoom(batch, len))
+            break;
     }
 
-    /*
-     * Initialize the topic selector/handler
-     */
-    try {
-        topicSel = new KafkaTopicSelector(logger, cfg, producer);
+    LOG_WARN("%s: Dropping %s row that is larger than the working buffer", router_ip.c_str(),
+             KafkaTopicSelector::topic_vars[batch_topic_id]);
+}
 
-    } catch (char const *str) {
-        LOG_ERR("rtr=%s: Failed to create one or more topics, will try again in a few: err=%s", router_ip.c_str(), str);
-        isConnected = false;
-        return;
+/**
+ * Make room for a row that does not fit in the current batch
+ *
+ * \param [in/out] batch     Batch
+ * \param [in] len           Length of the row
+ *
+ * \return false if the row can never fit (larger than MSGBUS_WORKING_BUF_SIZE)
+ */
+bool msgBus_kafka::batchMakeRoom(row_batch &batch, size_t len) {
+    // Move the batch to a larger buffer if the message can grow
+    if (batch.size < MSGBUS_WORKING_BUF_SIZE and batch.len + len < MSGBUS_WORKING_BUF_SIZE) {
+        batchAcquire(batch, std::max(batch.size * 2, batch.len + len + 1));
+        return true;
     }
 
-    producer->poll(100);
+    if (batch.count == 0)
+        return false;
+
+    // Send the rows so far as one message and start the next message with this row
+    SELF_DEBUG("Splitting %s message at %d rows, %lu bytes", KafkaTopicSelector::topic_vars[batch_topic_id],
+               batch.count, batch.len);
+    flushBatch(batch_topic_id);
+    batchAcquire(batch, batch.size_hint);
+
+    return true;
 }
 
 /**
- * produce message to Kafka
+ * Account for a row written at the end of the current batch
  *
- * \param [in] topic_var     Topic var to use in KafkaTopicSelector::getTopic() MSGBUS_TOPIC_VAR_*
- * \param [in] msg           message to produce
- * \param [in] msg_size      Length in bytes of the message
- * \param [in] rows          Number of rows
- * \param [in] key           Hash key
- * \param [in] peer_group    Peer group name - empty/NULL if not set or used
- * \param [in] peer_asn      Peer ASN
+ * \param [in/out] batch     Batch
+ * \param [in] len           Length of the row
  */
-void msgBus_kafka::produce(const char *topic_var, char *msg, size_t msg_size, int rows, string key,
-                           const string *peer_group, uint32_t peer_asn) {
-    size_t len;
-    RdKafka::Topic *topic = NULL;
+void msgBus_kafka::batchAddRow(row_batch &batch, size_t len) {
+    if (batch.count++ == 0) {
+        batch.first_row = std::chrono::steady_clock::now();
+        pending_batches++;
+    }
 
-    while (isConnected == false or topicSel == NULL) {
-        // Do not attempt to reconnect if this is the main process (router ip is null)
-        // Changed on 10/29/15 to support docker startup delay with kafka
-        /*
-        if (router_ip.size() <= 0) {
-            return;
-        }*/
+    batch.len += len;
+}
 
-        LOG_WARN("rtr=%s: Not connected to Kafka, attempting to reconnect", router_ip.c_str());
-        connect();
+/**
+ * End adding the rows of an update
+ */
+void msgBus_kafka::endRows() {
+    row_batch &batch = batches[batch_topic_id];
+
+    if (batch.count == 0)
+        return;
+
+    if (batch.count >= cfg->coalesce_max_rows or batch.len >= (size_t)cfg->coalesce_max_kbytes * 1024
+            or cfg->coalesce_linger_ms == 0)
+        flushBatch(batch_topic_id);
 
-        sleep(1);
+    // Produce the batches of the other topics that are past the linger time
+    if (pending_batches > 0)
+        flush(true);
+}
+
+/**
+ * Abstract method Implementation - See MsgBusInterface.hpp for details
+ */
+void msgBus_kafka::flush(bool expired_only) {
+    if (pending_batches == 0)
+        return;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::chrono::milliseconds linger(cfg->coalesce_linger_ms);
+
+    for (int i=0; i < KafkaTopicSelector::MSGBUS_TOPIC_ID_MAX; i++) {
+        if (batches[i].count > 0 and (not expired_only or now - batches[i].first_row >= linger))
+            flushBatch(i);
     }
+}
 
-    // if topic is disabled, don't bother producing the message
-    // TODO: it would be more efficient to move this check to the top of the various update_* methods, but I'm not sure which parts of these methods have side-effects that need to be preserved.
-    if (!topicSel->topicEnabled(topic_var))
+/**
+ * Produce the rows of a batch, if any
+ *
+ * \param [in] topic_id      Topic of the batch
+ */
+void msgBus_kafka::flushBatch(int topic_id) {
+    row_batch &batch = batches[topic_id];
+
+    if (batch.count == 0)
         return;
 
-    char headers[256];
-    len = snprintf(headers, sizeof(headers), "V: %s\nC_HASH_ID: %s\nT: %s\nL: %lu\nR: %d\n\n",
-            MSGBUS_API_VERSION, collector_hash.c_str(), topic_var, msg_size, rows);
+    pool_buffer *buf = batch.buf;
+
+    // The next batch acquires a buffer the size of this one once it has a row
+    batch.buf = NULL;
+    batch.size_hint = std::max((size_t)MSGBUS_ROWS_INIT_SIZE, batch.len + 1);
 
-    memcpy(producer_buf, headers, len);
-    memcpy(producer_buf+len, msg, msg_size);
+    producePooled(topic_id, buf, batch.len, batch.count, batch.key, batch.peer_group, batch.peer_asn,
+                  *batch.topics);
 
+    batch.len = 0;
+    batch.count = 0;
+    pending_batches--;
+}
 
-    topic = topicSel->getTopic(topic_var, &router_group_name, peer_group, peer_asn);
-    if (topic != NULL) {
-        SELF_DEBUG("rtr=%s: Producing message: topic=%s key=%s, msg size = %lu", router_ip.c_str(),
-                   topic->name().c_str(), key.c_str(), msg_size);
+/**
+ * Get a pooled buffer with room for size bytes of rows
+ *
+ * \details The rows in the current buffer, if any, are moved to the new buffer.
+ *
+ * \param [in/out] batch     Batch
+ * \param [in] size          Minimum size of the rows
+ */
+void msgBus_kafka::batchAcquire(row_batch &batch, size_t size) {
+    pool_buffer *buf = pool->acquire(MSGBUS_HDR_ROOM + size);
+    char *rows = buf->data + MSGBUS_HDR_ROOM;
 
-        RdKafka::ErrorCode resp = producer->produce(topic, RdKafka::Topic::PARTITION_UA,
-                                                    RdKafka::Producer::RK_MSG_COPY,
-                                                    producer_buf, msg_size + len,
-                                                    (const std::string *) &key, NULL);
-        if (resp != RdKafka::ERR_NO_ERROR) {
-            LOG_ERR("rtr=%s: Failed to produce message: %s", router_ip.c_str(), RdKafka::err2str(resp).c_str());
-            producer->poll(100);
-        }
-    } else {
-        LOG_NOTICE("rtr=%s: failed to produce message because topic couldn't be found: topic=%s key=%s, msg size = %lu", router_ip.c_str(),
-                   topic_var, key.c_str(), msg_size);
+    if (batch.buf != NULL) {
+        memcpy(rows, batch.rows, batch.len);
+        pool->release(batch.buf);
     }
 
-    producer->poll(0);
+    batch.buf = buf;
+    batch.rows = rows;
+    batch.size = std::min(buf->size - MSGBUS_HDR_ROOM, (size_t)MSGBUS_WORKING_BUF_SIZE);
+    batch.rows[batch.len] = 0;
+}
+
+/**
+ * Encode the binary peer fields (MSGBUS_V2_GROUP_PEER) of an update
+ *
+ * \param [in] peer          Peer entry
+ * \param [in] p_ctx         Peer context
+ * \param [out] out          Encoded fields
+ *
+ * \return Timestamp of the update in microseconds, the timestamp field of the rows
+ */
+uint64_t msgBus_kafka::encodePeerFields(obj_bgp_peer &peer, peer_context &p_ctx, string &out) {
+    MsgBusV2Writer w(out);
+    uint64_t ts;
+
+    // Same time as getTimestamp(); the collector time if the BMP header has none
+    if (peer.timestamp_secs <= 1000) {
+        timeval tv;
+        gettimeofday(&tv, NULL);
+        ts = (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    } else
+        ts = (uint64_t)peer.timestamp_secs * 1000000 + peer.timestamp_us;
+
+    out.clear();
+
+    w.putHash(peer.router_hash_id);
+    w.putAddr(router_ip.c_str(), router_ip.find(':') == string::npos);
+    w.putHash(p_ctx.hash_id);
+
+    // IPv4 peer address is in the last 4 bytes of the BMP per peer header address
+    if (peer.isIPv4)
+        w.putAddr(peer.peer_addr_bin + 12, 4);
+    else
+        w.putAddr(peer.peer_addr_bin, 16);
+
+    w.putUint(peer.peer_as);
+
+    return ts;
+}
+
+/**
+ * Encode the binary path attribute fields (MSGBUS_V2_ATTR_FIELDS) of an update
+ *
+ * \param [in] attr          Path attributes
+ * \param [in/out] out       Buffer the fields are appended to
+ */
+void msgBus_kafka::encodeAttrFields(obj_path_attr &attr, string &out) {
+    MsgBusV2Writer w(out);
+
+    w.putString(attr.origin);
+    w.putString(attr.as_path);
+    w.putUint(attr.as_path_count);
+    w.putUint(attr.origin_as);
+    w.putAddr(attr.next_hop, attr.nexthop_isIPv4);
+    w.putUint(attr.med);
+    w.putUint(attr.local_pref);
+    w.putString(attr.aggregator);
+    w.putString(attr.community_list);
+    w.putString(attr.ext_community_list);
+    w.putString(attr.cluster_list);
+    w.putBool(attr.atomic_agg);
+    w.putAddr(attr.originator_id, true);
+    w.putString(attr.large_community_list);
 }
 
 /**
@@ -450,7 +646,7 @@ void msgBus_kafka::update_Collector(obj_collector &c_object, collector_action_co
              action, collector_seq, c_object.admin_id, collector_hash.c_str(),
              c_object.routers, c_object.router_count, ts.c_str());
 
-    produce(MSGBUS_TOPIC_VAR_COLLECTOR, buf, strlen(buf), 1, collector_hash, NULL, 0);
+    produce(KafkaTopicSelector::MSGBUS_TOPIC_ID_COLLECTOR, buf, strlen(buf), 1, collector_hash, NULL, 0, router_topics);
 
     collector_seq++;
 }
@@ -462,8 +658,7 @@ void msgBus_kafka::update_Router(obj_router &r_object, router_action_code code)
     char buf[4096]; // Misc working buffer
 
     // Convert binary hash to string
-    string r_hash_str;
-    hash_toStr(r_object.hash_id, r_hash_str);
+    const string &r_hash_str = cachedHashStr(r_object.hash_id, r_hash_cache);
 
     bool skip_if_defined = true;
 
@@ -489,12 +684,32 @@ void msgBus_kafka::update_Router(obj_router &r_object, router_action_code code)
 
     // Check if we have already processed this entry, if so return
     if (skip_if_defined) {
+        bool defined = false;
         for (int i=0; i < sizeof(router_hash); i++) {
-            if (router_hash[i] != 0)
+            if (router_hash[i] != 0) {
+                defined = true;
+                break;
+            }
+        }
+
+        // Resend the router once the pending hostname is resolved
+        if (defined) {
+            if (not router_name_pending)
+                return;
+
+            string hostname;
+            if (resolveIp((char *) r_object.ip_addr, hostname))
+                return;
+
+            router_name_pending = false;
+            if (hostname.empty())
                 return;
         }
     }
 
+    // Coalesced rows are produced before the router changes
+    flush(false);
+
     if (code != ROUTER_ACTION_TERM)
         memcpy(router_hash, r_object.hash_id, sizeof(router_hash));
 
@@ -518,12 +733,20 @@ void msgBus_kafka::update_Router(obj_router &r_object, router_action_code code)
     // Get the hostname
     string hostname = "";
     if (strlen((char *)r_object.name) <= 0) {
-        resolveIp((char *) r_object.ip_addr, hostname);
+        router_name_pending = resolveIp((char *) r_object.ip_addr, hostname);
         snprintf((char *)r_object.name, sizeof(r_object.name)-1, "%s", hostname.c_str());
     }
 
-    if (topicSel != NULL)
-        topicSel->lookupRouterGroup((char *)r_object.name, (char *)r_object.ip_addr, router_group_name);
+    string prev_router_group = router_group_name;
+    producer->lookupRouterGroup((char *)r_object.name, (char *)r_object.ip_addr, router_group_name);
+
+    // The router group is part of every topic; re-resolve the topic handles if it changed
+    if (prev_router_group != router_group_name) {
+        router_topics.generation = 0;
+
+        for (peer_ctx_map_iter it = peer_ctx_map.begin(); it != peer_ctx_map.end(); ++it)
+            it->second.topics.generation = 0;
+    }
 
     size_t size = snprintf(buf, sizeof(buf),
              "%s\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%" PRIu16 "\t%s\t%s\t%s\t%s\t%s\n", action.c_str(),
@@ -531,7 +754,7 @@ void msgBus_kafka::update_Router(obj_router &r_object, router_action_code code)
              r_object.term_reason_code, r_object.term_reason_text,
              initData.c_str(), termData.c_str(), ts.c_str(), r_object.bgp_id);
 
-    produce(MSGBUS_TOPIC_VAR_ROUTER, buf, size, 1, r_hash_str, NULL, 0);
+    produce(KafkaTopicSelector::MSGBUS_TOPIC_ID_ROUTER, buf, size, 1, r_hash_str, NULL, 0, router_topics);
 
     router_seq++;
 }
@@ -541,39 +764,42 @@ void msgBus_kafka::update_Router(obj_router &r_object, router_action_code code)
  */
 void msgBus_kafka::update_Peer(obj_bgp_peer &peer, obj_peer_up_event *up, obj_peer_down_event *down, peer_action_code code) {
 
-    char buf[4096]; // Misc working buffer
+    // Get the peer context, which generates the peer hash if not already done
+    peer_context &p_ctx = getPeerContext(peer);
 
-    string r_hash_str;
-    hash_toStr(peer.router_hash_id, r_hash_str);
+    string hostname;
+    bool name_pending;
 
-    // Generate the hash
-    MD5 hash;
+    /*
+     * Check if we have already processed this entry, if so return.  The resolver is only
+     *      consulted for a new entry or while its name is pending, not for every message.
+     */
+    if (code == PEER_ACTION_FIRST and p_ctx.active) {
+        if (not p_ctx.name_pending or resolveIp(peer.peer_addr, hostname))
+            return;
 
-    hash.update((unsigned char *) peer.peer_addr,
-                strlen(peer.peer_addr));
-    hash.update((unsigned char *) peer.peer_rd, strlen(peer.peer_rd));
-    hash.update((unsigned char *)r_hash_str.c_str(), r_hash_str.length());
+        // Hostname is now resolved, resend the peer so that it and the peer group are updated
+        p_ctx.name_pending = false;
+        if (hostname.empty())
+            return;
 
-    /* TODO: Uncomment once this is fixed in XR
-     * Disable hashing the bgp peer ID since XR has an issue where it sends 0.0.0.0 on subsequent PEER_UP's
-     *    This will be fixed in XR, but for now we can disable hashing on it.
-     *
-    hash.update((unsigned char *) p_object.peer_bgp_id,
-            strlen(p_object.peer_bgp_id));
-    */
+        name_pending = false;
 
-    hash.finalize();
+    } else {
+        // Get the hostname using DNS - empty until resolved
+        name_pending = resolveIp(peer.peer_addr, hostname);
+    }
 
-    // Save the hash
-    unsigned char *hash_raw = hash.raw_digest();
-    memcpy(peer.hash_id, hash_raw, 16);
-    delete[] hash_raw;
+    p_ctx.name_pending = name_pending;
 
-    // Convert binary hash to string
-    string p_hash_str;
-    hash_toStr(peer.hash_id, p_hash_str);
+    // Coalesced rows are produced before the peer changes
+    flush(false);
+
+    char buf[4096]; // Misc working buffer
+
+    const string &r_hash_str = cachedHashStr(peer.router_hash_id, r_hash_cache);
+    const string &p_hash_str = p_ctx.hash_str;
 
-    bool skip_if_in_cache = true;
     bool add_to_cache = true;
 
     string action = "first";
@@ -585,37 +811,24 @@ void msgBus_kafka::update_Peer(obj_bgp_peer &peer, obj_peer_up_event *up, obj_pe
             break;
 
         case PEER_ACTION_UP :
-            skip_if_in_cache = false;
             action.assign("up");
             break;
 
         case PEER_ACTION_DOWN:
-            skip_if_in_cache = false;
             action.assign("down");
             add_to_cache = false;
-
-            if (peer_list.find(p_hash_str) != peer_list.end())
-                peer_list.erase(p_hash_str);
-
+            p_ctx.active = false;
             break;
     }
 
-    // Check if we have already processed this entry, if so return
-    if (skip_if_in_cache and peer_list.find(p_hash_str) != peer_list.end()) {
-        return;
-    }
-
-    // Get the hostname using DNS
-    string hostname;
-    resolveIp(peer.peer_addr, hostname);
-
     string ts;
     getTimestamp(peer.timestamp_secs, peer.timestamp_us, ts);
 
     // Insert/Update map entry
     if (add_to_cache) {
-        if (topicSel != NULL)
-            topicSel->lookupPeerGroup(hostname, peer.peer_addr, peer.peer_as, peer_list[p_hash_str]);
+        producer->lookupPeerGroup(hostname, peer.peer_addr, peer.peer_as, p_ctx.peer_group);
+        p_ctx.topics.generation = 0;            // Peer group and ASN may have changed
+        p_ctx.active = true;
     }
 
     switch (code) {
@@ -649,7 +862,6 @@ void msgBus_kafka::update_Peer(obj_bgp_peer &peer, obj_peer_up_event *up, obj_pe
                      up->recv_cap, up->remote_hold_time, up->local_hold_time,
                      peer.isL3VPN, peer.isPrePolicy, peer.isIPv4, peer.isLocRib, peer.isLocRibFiltered, peer.table_name);
 
-            skip_if_in_cache = false;
             action.assign("up");
             break;
         }
@@ -667,18 +879,13 @@ void msgBus_kafka::update_Peer(obj_bgp_peer &peer, obj_peer_up_event *up, obj_pe
 
                      peer.isL3VPN, peer.isPrePolicy, peer.isIPv4, peer.isLocRib, peer.isLocRibFiltered);
 
-            skip_if_in_cache = false;
             action.assign("down");
             add_to_cache = false;
-
-            if (peer_list.find(p_hash_str) != peer_list.end())
-                peer_list.erase(p_hash_str);
-
             break;
         }
     }
 
-    produce(MSGBUS_TOPIC_VAR_PEER, buf, strlen(buf), 1, p_hash_str, &peer_list[p_hash_str], peer.peer_as);
+    produce(KafkaTopicSelector::MSGBUS_TOPIC_ID_PEER, buf, strlen(buf), 1, p_hash_str, &p_ctx.peer_group, peer.peer_as, p_ctx.topics);
 
     peer_seq++;
 }
@@ -688,18 +895,14 @@ void msgBus_kafka::update_Peer(obj_bgp_peer &peer, obj_peer_up_event *up, obj_pe
  */
 void msgBus_kafka::update_baseAttribute(obj_bgp_peer &peer, obj_path_attr &attr, base_attr_action_code code) {
 
-    prep_buf[0] = 0;
-    size_t  buf_len;                    // size of the message in buf
-
     string path_hash_str;
-    string p_hash_str;
-    string r_hash_str;
-    hash_toStr(peer.hash_id, p_hash_str);
-    hash_toStr(peer.router_hash_id, r_hash_str);
+    peer_context &p_ctx = getPeerContext(peer);
+    const string &p_hash_str = p_ctx.hash_str;
+    const string &r_hash_str = cachedHashStr(peer.router_hash_id, r_hash_cache);
 
 
     // Generate the hash
-    MD5 hash;
+    HashId hash;
 
     //hash.update(path_object.peer_hash_id, HASH_SIZE);
     hash.update((unsigned char *) attr.as_path.c_str(), attr.as_path.length());
@@ -720,26 +923,46 @@ void msgBus_kafka::update_baseAttribute(obj_bgp_peer &peer, obj_path_attr &attr,
     hash.finalize();
 
     // Save the hash
-    unsigned char *hash_raw = hash.raw_digest();
-    memcpy(attr.hash_id, hash_raw, 16);
-    delete[] hash_raw;
+    hash.raw_digest(attr.hash_id);
+
+    beginRows(KafkaTopicSelector::MSGBUS_TOPIC_ID_BASE_ATTRIBUTE, p_hash_str,
+              &p_ctx.peer_group, peer.peer_as, p_ctx.topics);
+
+    if (topic_binary[KafkaTopicSelector::MSGBUS_TOPIC_ID_BASE_ATTRIBUTE]) {
+        MsgBusV2Writer head(bin_head), body(bin_row);
+
+        bin_head.clear();
+        head.putAction(MSGBUS_V2_ACTION_ADD);
+        head.putUint(base_attr_seq);
+        head.putHash(attr.hash_id);
+
+        bin_row.clear();
+        body.putTime(encodePeerFields(peer, p_ctx, bin_peer));
+
+        bin_attrs.clear();
+        encodeAttrFields(attr, bin_attrs);
+
+        appendBinaryRow(bin_head, bin_row, true);
+        endRows();
+
+        ++base_attr_seq;
+        return;
+    }
 
     hash_toStr(attr.hash_id, path_hash_str);
 
     string ts;
     getTimestamp(peer.timestamp_secs, peer.timestamp_us, ts);
 
-    buf_len =
-            snprintf(prep_buf, MSGBUS_WORKING_BUF_SIZE,
-                     "add\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%s\t%" PRIu16 "\t%" PRIu32
-                             "\t%s\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%s\t%s\t%d\t%d\t%s\t%s\n",
-                     base_attr_seq, path_hash_str.c_str(), r_hash_str.c_str(), router_ip.c_str(), p_hash_str.c_str(),
-                     peer.peer_addr,peer.peer_as, ts.c_str(),
-                     attr.origin, attr.as_path.c_str(), attr.as_path_count, attr.origin_as, attr.next_hop, attr.med,
-                     attr.local_pref, attr.aggregator, attr.community_list.c_str(), attr.ext_community_list.c_str(), attr.cluster_list.c_str(),
-                     attr.atomic_agg, attr.nexthop_isIPv4, attr.originator_id,attr.large_community_list.c_str());
+    appendRow("add\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%s\t%" PRIu16 "\t%" PRIu32
+                      "\t%s\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%s\t%s\t%d\t%d\t%s\t%s\n",
+              base_attr_seq, path_hash_str.c_str(), r_hash_str.c_str(), router_ip.c_str(), p_hash_str.c_str(),
+              peer.peer_addr,peer.peer_as, ts.c_str(),
+              attr.origin, attr.as_path.c_str(), attr.as_path_count, attr.origin_as, attr.next_hop, attr.med,
+              attr.local_pref, attr.aggregator, attr.community_list.c_str(), attr.ext_community_list.c_str(), attr.cluster_list.c_str(),
+              attr.atomic_agg, attr.nexthop_isIPv4, attr.originator_id,attr.large_community_list.c_str());
 
-    produce(MSGBUS_TOPIC_VAR_BASE_ATTRIBUTE, prep_buf, buf_len, 1, p_hash_str, &peer_list[p_hash_str], peer.peer_as);
+    endRows();
 
     ++base_attr_seq;
 }
@@ -750,31 +973,47 @@ void msgBus_kafka::update_baseAttribute(obj_bgp_peer &peer, obj_path_attr &attr,
 void msgBus_kafka::update_L3Vpn(obj_bgp_peer &peer, std::vector<obj_vpn> &vpn,
                                 obj_path_attr *attr, vpn_action_code code) {
 
-    prep_buf[0] = 0;
-
-    char    buf2[80000];                         // Second working buffer
-    size_t  buf_len = 0;                         // query buffer length
-
     string vpn_hash_str;
     string path_hash_str;
-    string p_hash_str;
-    string r_hash_str;
-
-    hash_toStr(peer.router_hash_id, r_hash_str);
 
-    if (attr != NULL)
-        hash_toStr(attr->hash_id, path_hash_str);
+    const string &r_hash_str = cachedHashStr(peer.router_hash_id, r_hash_cache);
 
-    hash_toStr(peer.hash_id, p_hash_str);
+    peer_context &p_ctx = getPeerContext(peer);
+    const string &p_hash_str = p_ctx.hash_str;
 
+    bool binary = topic_binary[KafkaTopicSelector::MSGBUS_TOPIC_ID_L3VPN];
     string ts;
-    getTimestamp(peer.timestamp_secs, peer.timestamp_us, ts);
+    uint64_t ts_us = 0;
+
+    if (binary) {
+        if (code == VPN_ACTION_ADD) {
+            if (attr == NULL)
+                return;
+
+            bin_attrs.clear();
+            MsgBusV2Writer(bin_attrs).putHash(attr->hash_id);
+            encodeAttrFields(*attr, bin_attrs);
+        }
+
+        ts_us = encodePeerFields(peer, p_ctx, bin_peer);
+
+    } else {
+        if (attr != NULL)
+            hash_toStr(attr->hash_id, path_hash_str);
+
+        getTimestamp(peer.timestamp_secs, peer.timestamp_us, ts);
+    }
+
+    beginRows(KafkaTopicSelector::MSGBUS_TOPIC_ID_L3VPN, p_hash_str,
+              &p_ctx.peer_group, peer.peer_as, p_ctx.topics);
+
+    HashId hash;                                // Reused for each entry
 
     // Loop through the vector array of vpn entries
     for (size_t i = 0; i < vpn.size(); i++) {
 
         // Generate the hash
-        MD5 hash;
+        hash.reset();
 
         hash.update((unsigned char *) vpn[i].prefix, strlen(vpn[i].prefix));
         hash.update(&vpn[i].prefix_len, sizeof(vpn[i].prefix_len));
@@ -795,17 +1034,38 @@ void msgBus_kafka::update_L3Vpn(obj_bgp_peer &peer, std::vector<obj_vpn> &vpn,
          *      hash on the label string.  Instead, we has on a constant value of 1.
          */
         if (vpn[i].labels[0] != 0) {
-            buf2[0] = 1;
-            hash.update((unsigned char *) buf2, 1);
-            buf2[0] = 0;
+            unsigned char label_flag = 1;
+            hash.update(&label_flag, 1);
         }
 
         hash.finalize();
 
         // Save the hash
-        unsigned char *hash_raw = hash.raw_digest();
-        memcpy(vpn[i].hash_id, hash_raw, 16);
-        delete[] hash_raw;
+        hash.raw_digest(vpn[i].hash_id);
+
+        if (binary) {
+            MsgBusV2Writer head(bin_head), w(bin_row);
+
+            bin_head.clear();
+            head.putAction(code == VPN_ACTION_ADD ? MSGBUS_V2_ACTION_ADD : MSGBUS_V2_ACTION_DEL);
+            head.putUint(l3vpn_seq);
+            head.putHash(vpn[i].hash_id);
+
+            bin_row.clear();
+            w.putTime(ts_us);
+            w.putPrefix(vpn[i].prefix_bin, vpn[i].isIPv4, vpn[i].prefix_len);
+            w.putUint(vpn[i].path_id);
+            w.putString(vpn[i].labels);
+            w.putBool(peer.isPrePolicy);
+            w.putBool(peer.isAdjIn);
+            w.putString(vpn[i].rd_administrator_subfield + ":" + vpn[i].rd_assigned_number);
+            w.putUint(vpn[i].rd_type);
+
+            appendBinaryRow(bin_head, bin_row, code == VPN_ACTION_ADD);
+
+            ++l3vpn_seq;
+            continue;
+        }
 
         // Build the query
         hash_toStr(vpn[i].hash_id, vpn_hash_str);
@@ -816,48 +1076,41 @@ void msgBus_kafka::update_L3Vpn(obj_bgp_peer &peer, std::vector<obj_vpn> &vpn,
                 if (attr == NULL)
                     return;
 
-                buf_len += snprintf(buf2, sizeof(buf2),
-                                    "add\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%d\t%d\t%s\t%s\t%" PRIu16
-                                            "\t%" PRIu32 "\t%s\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%s\t%s\t%d\t%d\t%s\t%" PRIu32
-                                            "\t%s\t%d\t%d\t%s:%s\t%d\t%s\n",
-                                    l3vpn_seq, vpn_hash_str.c_str(), r_hash_str.c_str(),
-                                    router_ip.c_str(),path_hash_str.c_str(), p_hash_str.c_str(),
-                                    peer.peer_addr, peer.peer_as, ts.c_str(), vpn[i].prefix, vpn[i].prefix_len,
-                                    vpn[i].isIPv4, attr->origin,
-                                    attr->as_path.c_str(), attr->as_path_count, attr->origin_as, attr->next_hop, attr->med, attr->local_pref,
-                                    attr->aggregator,
-                                    attr->community_list.c_str(), attr->ext_community_list.c_str(), attr->cluster_list.c_str(),
-                                    attr->atomic_agg, attr->nexthop_isIPv4,
-                                    attr->originator_id, vpn[i].path_id, vpn[i].labels, peer.isPrePolicy, peer.isAdjIn,
-                                    vpn[i].rd_administrator_subfield.c_str(), vpn[i].rd_assigned_number.c_str(), vpn[i].rd_type,
-                                    attr->large_community_list.c_str());
+                appendRow("add\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%d\t%d\t%s\t%s\t%" PRIu16
+                                  "\t%" PRIu32 "\t%s\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%s\t%s\t%d\t%d\t%s\t%" PRIu32
+                                  "\t%s\t%d\t%d\t%s:%s\t%d\t%s\n",
+                          l3vpn_seq, vpn_hash_str.c_str(), r_hash_str.c_str(),
+                          router_ip.c_str(),path_hash_str.c_str(), p_hash_str.c_str(),
+                          peer.peer_addr, peer.peer_as, ts.c_str(), vpn[i].prefix, vpn[i].prefix_len,
+                          vpn[i].isIPv4, attr->origin,
+                          attr->as_path.c_str(), attr->as_path_count, attr->origin_as, attr->next_hop, attr->med, attr->local_pref,
+                          attr->aggregator,
+                          attr->community_list.c_str(), attr->ext_community_list.c_str(), attr->cluster_list.c_str(),
+                          attr->atomic_agg, attr->nexthop_isIPv4,
+                          attr->originator_id, vpn[i].path_id, vpn[i].labels, peer.isPrePolicy, peer.isAdjIn,
+                          vpn[i].rd_administrator_subfield.c_str(), vpn[i].rd_assigned_number.c_str(), vpn[i].rd_type,
+                          attr->large_community_list.c_str());
 
                 break;
 
             case VPN_ACTION_DEL:
-                buf_len += snprintf(buf2, sizeof(buf2),
-                                    "del\t%" PRIu64 "\t%s\t%s\t%s\t\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%d\t%d\t\t\t"
-                                            "\t\t\t\t\t\t\t\t\t\t\t\t%" PRIu32
-                                            "\t%s\t%d\t%d\t%s:%s\t%d\t\n",
-                                    l3vpn_seq, vpn_hash_str.c_str(), r_hash_str.c_str(),
-                                    router_ip.c_str(), p_hash_str.c_str(),
-                                    peer.peer_addr, peer.peer_as, ts.c_str(), vpn[i].prefix, vpn[i].prefix_len,
-                                    vpn[i].isIPv4, vpn[i].path_id, vpn[i].labels, peer.isPrePolicy, peer.isAdjIn,
-                                    vpn[i].rd_administrator_subfield.c_str(), vpn[i].rd_assigned_number.c_str(),
-                                    vpn[i].rd_type);
+                appendRow("del\t%" PRIu64 "\t%s\t%s\t%s\t\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%d\t%d\t\t\t"
+                                  "\t\t\t\t\t\t\t\t\t\t\t\t%" PRIu32
+                                  "\t%s\t%d\t%d\t%s:%s\t%d\t\n",
+                          l3vpn_seq, vpn_hash_str.c_str(), r_hash_str.c_str(),
+                          router_ip.c_str(), p_hash_str.c_str(),
+                          peer.peer_addr, peer.peer_as, ts.c_str(), vpn[i].prefix, vpn[i].prefix_len,
+                          vpn[i].isIPv4, vpn[i].path_id, vpn[i].labels, peer.isPrePolicy, peer.isAdjIn,
+                          vpn[i].rd_administrator_subfield.c_str(), vpn[i].rd_assigned_number.c_str(),
+                          vpn[i].rd_type);
                 break;
 
         }
 
-        // Cat the entry to the query buff
-        if (buf_len < MSGBUS_WORKING_BUF_SIZE /* size of buf */)
-            strcat(prep_buf, buf2);
-
         ++l3vpn_seq;
     }
 
-    produce(MSGBUS_TOPIC_VAR_L3VPN, prep_buf, strlen(prep_buf), vpn.size(), p_hash_str,
-            &peer_list[p_hash_str], peer.peer_as);
+    endRows();
 }
 
 
@@ -867,31 +1120,47 @@ void msgBus_kafka::update_L3Vpn(obj_bgp_peer &peer, std::vector<obj_vpn> &vpn,
 void msgBus_kafka::update_eVPN(obj_bgp_peer &peer, std::vector<obj_evpn> &vpn,
                               obj_path_attr *attr, vpn_action_code code) {
 
-    prep_buf[0] = 0;
-
-    char    buf2[80000];                         // Second working buffer
-    size_t  buf_len = 0;                         // query buffer length
-
     string vpn_hash_str;
     string path_hash_str;
-    string p_hash_str;
-    string r_hash_str;
 
-    hash_toStr(peer.router_hash_id, r_hash_str);
+    const string &r_hash_str = cachedHashStr(peer.router_hash_id, r_hash_cache);
 
-    if (attr != NULL)
-        hash_toStr(attr->hash_id, path_hash_str);
-
-    hash_toStr(peer.hash_id, p_hash_str);
+    peer_context &p_ctx = getPeerContext(peer);
+    const string &p_hash_str = p_ctx.hash_str;
 
+    bool binary = topic_binary[KafkaTopicSelector::MSGBUS_TOPIC_ID_EVPN];
     string ts;
-    getTimestamp(peer.timestamp_secs, peer.timestamp_us, ts);
+    uint64_t ts_us = 0;
+
+    if (binary) {
+        if (code == VPN_ACTION_ADD) {
+            if (attr == NULL)
+                return;
+
+            bin_attrs.clear();
+            MsgBusV2Writer(bin_attrs).putHash(attr->hash_id);
+            encodeAttrFields(*attr, bin_attrs);
+        }
+
+        ts_us = encodePeerFields(peer, p_ctx, bin_peer);
+
+    } else {
+        if (attr != NULL)
+            hash_toStr(attr->hash_id, path_hash_str);
+
+        getTimestamp(peer.timestamp_secs, peer.timestamp_us, ts);
+    }
+
+    beginRows(KafkaTopicSelector::MSGBUS_TOPIC_ID_EVPN, p_hash_str,
+              &p_ctx.peer_group, peer.peer_as, p_ctx.topics);
+
+    HashId hash;                                // Reused for each entry
 
     // Loop through the vector array of vpn entries
     for (size_t i = 0; i < vpn.size(); i++) {
 
         // Generate the hash
-        MD5 hash;
+        hash.reset();
 
         hash.update((unsigned char *) p_hash_str.c_str(), p_hash_str.length());
 
@@ -911,9 +1180,39 @@ void msgBus_kafka::update_eVPN(obj_bgp_peer &peer, std::vector<obj_evpn> &vpn,
         hash.finalize();
 
         // Save the hash
-        unsigned char *hash_raw = hash.raw_digest();
-        memcpy(vpn[i].hash_id, hash_raw, 16);
-        delete[] hash_raw;
+        hash.raw_digest(vpn[i].hash_id);
+
+        if (binary) {
+            MsgBusV2Writer head(bin_head), w(bin_row);
+
+            bin_head.clear();
+            head.putAction(code == VPN_ACTION_ADD ? MSGBUS_V2_ACTION_ADD : MSGBUS_V2_ACTION_DEL);
+            head.putUint(evpn_seq);
+            head.putHash(vpn[i].hash_id);
+
+            bin_row.clear();
+            w.putTime(ts_us);
+            w.putUint(vpn[i].path_id);
+            w.putBool(peer.isPrePolicy);
+            w.putBool(peer.isAdjIn);
+            w.putString(vpn[i].rd_administrator_subfield + ":" + vpn[i].rd_assigned_number);
+            w.putUint(vpn[i].rd_type);
+            w.putUint(vpn[i].originating_router_ip_len);
+            w.putString(vpn[i].originating_router_ip);
+            w.putString(vpn[i].ethernet_tag_id_hex);
+            w.putString(vpn[i].ethernet_segment_identifier);
+            w.putUint(vpn[i].mac_len);
+            w.putString(vpn[i].mac);
+            w.putUint(vpn[i].ip_len);
+            w.putString(vpn[i].ip);
+            w.putUint((uint32_t)vpn[i].mpls_label_1);
+            w.putUint((uint32_t)vpn[i].mpls_label_2);
+
+            appendBinaryRow(bin_head, bin_row, code == VPN_ACTION_ADD);
+
+            ++evpn_seq;
+            continue;
+        }
 
         // Build the query
         hash_toStr(vpn[i].hash_id, vpn_hash_str);
@@ -924,53 +1223,46 @@ void msgBus_kafka::update_eVPN(obj_bgp_peer &peer, std::vector<obj_evpn> &vpn,
                 if (attr == NULL)
                     return;
 
-                buf_len += snprintf(buf2, sizeof(buf2),
-                                    "add\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%s\t%" PRIu16
-                                        "\t%" PRIu32 "\t%s\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%s\t%s\t%d\t%d\t%s\t%" PRIu32
-                                        "\t%d\t%d\t%s:%s\t%d\t%d\t%s\t%s\t%s\t%d\t%s\t%d\t%s\t%" PRIu32 "\t%" PRIu32 "\n",
-                                    evpn_seq, vpn_hash_str.c_str(), r_hash_str.c_str(),
-                                    router_ip.c_str(),path_hash_str.c_str(), p_hash_str.c_str(),
-                                    peer.peer_addr, peer.peer_as, ts.c_str(),
-                                    attr->origin,
-                                    attr->as_path.c_str(), attr->as_path_count, attr->origin_as, attr->next_hop, attr->med, attr->local_pref,
-                                    attr->aggregator,
-                                    attr->community_list.c_str(), attr->ext_community_list.c_str(), attr->cluster_list.c_str(),
-                                    attr->atomic_agg, attr->nexthop_isIPv4,
-                                    attr->originator_id, vpn[i].path_id, peer.isPrePolicy, peer.isAdjIn,
-                                    vpn[i].rd_administrator_subfield.c_str(), vpn[i].rd_assigned_number.c_str(), vpn[i].rd_type,
-                                    vpn[i].originating_router_ip_len, vpn[i].originating_router_ip, vpn[i].ethernet_tag_id_hex,
-                                    vpn[i].ethernet_segment_identifier, vpn[i].mac_len,
-                                    vpn[i].mac, vpn[i].ip_len, vpn[i].ip, vpn[i].mpls_label_1, vpn[i].mpls_label_2);
+                appendRow("add\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%s\t%" PRIu16
+                              "\t%" PRIu32 "\t%s\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%s\t%s\t%d\t%d\t%s\t%" PRIu32
+                              "\t%d\t%d\t%s:%s\t%d\t%d\t%s\t%s\t%s\t%d\t%s\t%d\t%s\t%" PRIu32 "\t%" PRIu32 "\n",
+                          evpn_seq, vpn_hash_str.c_str(), r_hash_str.c_str(),
+                          router_ip.c_str(),path_hash_str.c_str(), p_hash_str.c_str(),
+                          peer.peer_addr, peer.peer_as, ts.c_str(),
+                          attr->origin,
+                          attr->as_path.c_str(), attr->as_path_count, attr->origin_as, attr->next_hop, attr->med, attr->local_pref,
+                          attr->aggregator,
+                          attr->community_list.c_str(), attr->ext_community_list.c_str(), attr->cluster_list.c_str(),
+                          attr->atomic_agg, attr->nexthop_isIPv4,
+                          attr->originator_id, vpn[i].path_id, peer.isPrePolicy, peer.isAdjIn,
+                          vpn[i].rd_administrator_subfield.c_str(), vpn[i].rd_assigned_number.c_str(), vpn[i].rd_type,
+                          vpn[i].originating_router_ip_len, vpn[i].originating_router_ip, vpn[i].ethernet_tag_id_hex,
+                          vpn[i].ethernet_segment_identifier, vpn[i].mac_len,
+                          vpn[i].mac, vpn[i].ip_len, vpn[i].ip, vpn[i].mpls_label_1, vpn[i].mpls_label_2);
 
                 break;
 
             case VPN_ACTION_DEL:
-                buf_len += snprintf(buf2, sizeof(buf2),
-                                    "del\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t\t\t"
-                                            "\t\t\t\t\t\t\t\t\t\t\t\t%" PRIu32
-                                            "\t%d\t%d\t%s:%s\t%d\t%d\t%s\t%s\t%s\t%d\t%s\t%d\t%s\t%" PRIu32 "\t%" PRIu32 "\n",
-                                    evpn_seq, vpn_hash_str.c_str(), r_hash_str.c_str(),
-                                    router_ip.c_str(),path_hash_str.c_str(), p_hash_str.c_str(),
-                                    peer.peer_addr, peer.peer_as, ts.c_str(),
-                                    vpn[i].path_id, peer.isPrePolicy, peer.isAdjIn,
-                                    vpn[i].rd_administrator_subfield.c_str(), vpn[i].rd_assigned_number.c_str(), vpn[i].rd_type,
-                                    vpn[i].originating_router_ip_len, vpn[i].originating_router_ip, vpn[i].ethernet_tag_id_hex,
-                                    vpn[i].ethernet_segment_identifier, vpn[i].mac_len,
-                                    vpn[i].mac, vpn[i].ip_len, vpn[i].ip, vpn[i].mpls_label_1, vpn[i].mpls_label_2);
+                appendRow("del\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t\t\t"
+                                  "\t\t\t\t\t\t\t\t\t\t\t\t%" PRIu32
+                                  "\t%d\t%d\t%s:%s\t%d\t%d\t%s\t%s\t%s\t%d\t%s\t%d\t%s\t%" PRIu32 "\t%" PRIu32 "\n",
+                          evpn_seq, vpn_hash_str.c_str(), r_hash_str.c_str(),
+                          router_ip.c_str(),path_hash_str.c_str(), p_hash_str.c_str(),
+                          peer.peer_addr, peer.peer_as, ts.c_str(),
+                          vpn[i].path_id, peer.isPrePolicy, peer.isAdjIn,
+                          vpn[i].rd_administrator_subfield.c_str(), vpn[i].rd_assigned_number.c_str(), vpn[i].rd_type,
+                          vpn[i].originating_router_ip_len, vpn[i].originating_router_ip, vpn[i].ethernet_tag_id_hex,
+                          vpn[i].ethernet_segment_identifier, vpn[i].mac_len,
+                          vpn[i].mac, vpn[i].ip_len, vpn[i].ip, vpn[i].mpls_label_1, vpn[i].mpls_label_2);
 
                 break;
 
         }
 
-        // Cat the entry to the query buff
-        if (buf_len < MSGBUS_WORKING_BUF_SIZE /* size of buf */)
-            strcat(prep_buf, buf2);
-
         ++evpn_seq;
     }
 
-    produce(MSGBUS_TOPIC_VAR_EVPN, prep_buf, strlen(prep_buf), vpn.size(), p_hash_str,
-            &peer_list[p_hash_str], peer.peer_as);
+    endRows();
 }
 
 
@@ -979,23 +1271,13 @@ void msgBus_kafka::update_eVPN(obj_bgp_peer &peer, std::vector<obj_evpn> &vpn,
  */
 void msgBus_kafka::update_unicastPrefix(obj_bgp_peer &peer, std::vector<obj_rib> &rib,
                                         obj_path_attr *attr, unicast_prefix_action_code code) {
-    //bzero(prep_buf, MSGBUS_WORKING_BUF_SIZE);
-    prep_buf[0] = 0;
-
-    char    buf2[80000];                         // Second working buffer
-    size_t  buf_len = 0;                         // query buffer length
-
     string rib_hash_str;
     string path_hash_str;
-    string p_hash_str;
-    string r_hash_str;
 
-    hash_toStr(peer.router_hash_id, r_hash_str);
+    const string &r_hash_str = cachedHashStr(peer.router_hash_id, r_hash_cache);
 
-    if (attr != NULL)
-        hash_toStr(attr->hash_id, path_hash_str);
-
-    hash_toStr(peer.hash_id, p_hash_str);
+    peer_context &p_ctx = getPeerContext(peer);
+    const string &p_hash_str = p_ctx.hash_str;
 
     string action = "add";
     switch (code) {
@@ -1007,40 +1289,98 @@ void msgBus_kafka::update_unicastPrefix(obj_bgp_peer &peer, std::vector<obj_rib>
             break;
     }
 
-    string ts;
-    getTimestamp(peer.timestamp_secs, peer.timestamp_us, ts);
+    beginRows(KafkaTopicSelector::MSGBUS_TOPIC_ID_UNICAST_PREFIX, p_hash_str,
+              &p_ctx.peer_group, peer.peer_as, p_ctx.topics);
+
+    /*
+     * Generate the hashes of all prefixes as one batch.  The key of each prefix is the
+     * same data that was previously hashed by separate updates, so the hashes do not change.
+     */
+    if (hash_keys.size() < rib.size() * MSGBUS_HASH_KEY_SIZE) {
+        hash_keys.resize(rib.size() * MSGBUS_HASH_KEY_SIZE);
+        hash_key_ptrs.resize(rib.size());
+        hash_key_lens.resize(rib.size());
+        hash_digests.resize(rib.size());
+    }
 
-    // Loop through the vector array of rib entries
     for (size_t i = 0; i < rib.size(); i++) {
+        unsigned char *key = &hash_keys[i * MSGBUS_HASH_KEY_SIZE];
+        size_t key_len = strnlen(rib[i].prefix, sizeof(rib[i].prefix));
 
-        // Generate the hash
-        MD5 hash;
-
-        hash.update((unsigned char *) rib[i].prefix, strlen(rib[i].prefix));
-        hash.update(&rib[i].prefix_len, sizeof(rib[i].prefix_len));
-        hash.update((unsigned char *) p_hash_str.c_str(), p_hash_str.length());
+        memcpy(key, rib[i].prefix, key_len);
+        key[key_len++] = rib[i].prefix_len;
+        memcpy(key + key_len, p_hash_str.c_str(), p_hash_str.length());
+        key_len += p_hash_str.length();
 
         // Add path ID to hash only if exists
-        if (rib[i].path_id > 0)
-            hash.update((unsigned char *)&rib[i].path_id, sizeof(rib[i].path_id));
+        if (rib[i].path_id > 0) {
+            memcpy(key + key_len, &rib[i].path_id, sizeof(rib[i].path_id));
+            key_len += sizeof(rib[i].path_id);
+        }
 
         /*
          * Add constant "1" to hash if labels are present
          *      Withdrawn and updated NLRI's do not carry the original label, therefore we cannot
          *      hash on the label string.  Instead, we has on a constant value of 1.
          */
-        if (rib[i].labels[0] != 0) {
-            buf2[0] = 1;
-            hash.update((unsigned char *) buf2, 1);
-            buf2[0] = 0;
+        if (rib[i].labels[0] != 0)
+            key[key_len++] = 1;
+
+        hash_key_ptrs[i] = key;
+        hash_key_lens[i] = key_len;
+        hash_digests[i] = rib[i].hash_id;
+    }
+
+    HashId::digestBatch(hash_key_ptrs.data(), hash_key_lens.data(), rib.size(), hash_digests.data());
+
+    if (topic_binary[KafkaTopicSelector::MSGBUS_TOPIC_ID_UNICAST_PREFIX]) {
+        bool add = code == UNICAST_PREFIX_ACTION_ADD;
+
+        if (add) {
+            if (attr == NULL)
+                return;
+
+            bin_attrs.clear();
+            MsgBusV2Writer(bin_attrs).putHash(attr->hash_id);
+            encodeAttrFields(*attr, bin_attrs);
         }
 
-        hash.finalize();
+        uint64_t ts_us = encodePeerFields(peer, p_ctx, bin_peer);
 
-        // Save the hash
-        unsigned char *hash_raw = hash.raw_digest();
-        memcpy(rib[i].hash_id, hash_raw, 16);
-        delete[] hash_raw;
+        for (size_t i = 0; i < rib.size(); i++) {
+            MsgBusV2Writer head(bin_head), w(bin_row);
+
+            bin_head.clear();
+            head.putAction(add ? MSGBUS_V2_ACTION_ADD : MSGBUS_V2_ACTION_DEL);
+            head.putUint(unicast_prefix_seq);
+            head.putHash(rib[i].hash_id);
+
+            bin_row.clear();
+            w.putTime(ts_us);
+            w.putPrefix(rib[i].prefix_bin, rib[i].isIPv4, rib[i].prefix_len);
+            w.putUint(rib[i].path_id);
+            w.putString(rib[i].labels);
+            w.putBool(peer.isPrePolicy);
+            w.putBool(peer.isAdjIn);
+
+            appendBinaryRow(bin_head, bin_row, add);
+
+            ++unicast_prefix_seq;
+            ++ribSeq;
+        }
+
+        endRows();
+        return;
+    }
+
+    if (attr != NULL)
+        hash_toStr(attr->hash_id, path_hash_str);
+
+    string ts;
+    getTimestamp(peer.timestamp_secs, peer.timestamp_us, ts);
+
+    // Loop through the vector array of rib entries
+    for (size_t i = 0; i < rib.size(); i++) {
 
         // Build the query
         hash_toStr(rib[i].hash_id, rib_hash_str);
@@ -1051,44 +1391,37 @@ void msgBus_kafka::update_unicastPrefix(obj_bgp_peer &peer, std::vector<obj_rib>
                 if (attr == NULL)
                     return;
 
-                buf_len += snprintf(buf2, sizeof(buf2),
-                                    "%s\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%d\t%d\t%s\t%s\t%" PRIu16
-                                            "\t%" PRIu32 "\t%s\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%s\t%s\t%d\t%d\t%s\t%" PRIu32
-                                            "\t%s\t%d\t%d\t%s\n",
-                                    action.c_str(), unicast_prefix_seq, rib_hash_str.c_str(), r_hash_str.c_str(),
-                                    router_ip.c_str(),path_hash_str.c_str(), p_hash_str.c_str(),
-                                    peer.peer_addr, peer.peer_as, ts.c_str(), rib[i].prefix, rib[i].prefix_len,
-                                    rib[i].isIPv4, attr->origin,
-                                    attr->as_path.c_str(), attr->as_path_count, attr->origin_as, attr->next_hop, attr->med, attr->local_pref,
-                                    attr->aggregator,
-                                    attr->community_list.c_str(), attr->ext_community_list.c_str(), attr->cluster_list.c_str(),
-                                    attr->atomic_agg, attr->nexthop_isIPv4,
-                                    attr->originator_id, rib[i].path_id, rib[i].labels, peer.isPrePolicy, peer.isAdjIn,
-                                    attr->large_community_list.c_str());
+                appendRow("%s\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%d\t%d\t%s\t%s\t%" PRIu16
+                                  "\t%" PRIu32 "\t%s\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%s\t%s\t%d\t%d\t%s\t%" PRIu32
+                                  "\t%s\t%d\t%d\t%s\n",
+                          action.c_str(), unicast_prefix_seq, rib_hash_str.c_str(), r_hash_str.c_str(),
+                          router_ip.c_str(),path_hash_str.c_str(), p_hash_str.c_str(),
+                          peer.peer_addr, peer.peer_as, ts.c_str(), rib[i].prefix, rib[i].prefix_len,
+                          rib[i].isIPv4, attr->origin,
+                          attr->as_path.c_str(), attr->as_path_count, attr->origin_as, attr->next_hop, attr->med, attr->local_pref,
+                          attr->aggregator,
+                          attr->community_list.c_str(), attr->ext_community_list.c_str(), attr->cluster_list.c_str(),
+                          attr->atomic_agg, attr->nexthop_isIPv4,
+                          attr->originator_id, rib[i].path_id, rib[i].labels, peer.isPrePolicy, peer.isAdjIn,
+                          attr->large_community_list.c_str());
                 break;
 
             case UNICAST_PREFIX_ACTION_DEL:
-                buf_len += snprintf(buf2, sizeof(buf2),
-                                    "%s\t%" PRIu64 "\t%s\t%s\t%s\t\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%d\t%d\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t%" PRIu32
-                                            "\t%s\t%d\t%d\t\n",
-                                    action.c_str(), unicast_prefix_seq, rib_hash_str.c_str(), r_hash_str.c_str(),
-                                    router_ip.c_str(), p_hash_str.c_str(),
-                                    peer.peer_addr, peer.peer_as, ts.c_str(), rib[i].prefix, rib[i].prefix_len,
-                                    rib[i].isIPv4, rib[i].path_id, rib[i].labels, peer.isPrePolicy, peer.isAdjIn);
+                appendRow("%s\t%" PRIu64 "\t%s\t%s\t%s\t\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%d\t%d\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t%" PRIu32
+                                  "\t%s\t%d\t%d\t\n",
+                          action.c_str(), unicast_prefix_seq, rib_hash_str.c_str(), r_hash_str.c_str(),
+                          router_ip.c_str(), p_hash_str.c_str(),
+                          peer.peer_addr, peer.peer_as, ts.c_str(), rib[i].prefix, rib[i].prefix_len,
+                          rib[i].isIPv4, rib[i].path_id, rib[i].labels, peer.isPrePolicy, peer.isAdjIn);
                 break;
         }
 
-        // Cat the entry to the query buff
-        if (buf_len < MSGBUS_WORKING_BUF_SIZE /* size of buf */)
-            strcat(prep_buf, buf2);
-
         ++unicast_prefix_seq;
 	++ribSeq;
     }
 
 
-    produce(MSGBUS_TOPIC_VAR_UNICAST_PREFIX, prep_buf, strlen(prep_buf), rib.size(), p_hash_str,
-            &peer_list[p_hash_str], peer.peer_as);
+    endRows();
 }
 
 /**
@@ -1098,10 +1431,38 @@ void msgBus_kafka::add_StatReport(obj_bgp_peer &peer, obj_stats_report &stats) {
     char buf[4096];                 // Misc working buffer
 
     // Build the query
-    string p_hash_str;
-    string r_hash_str;
-    hash_toStr(peer.hash_id, p_hash_str);
-    hash_toStr(peer.router_hash_id, r_hash_str);
+    peer_context &p_ctx = getPeerContext(peer);
+    const string &p_hash_str = p_ctx.hash_str;
+    const string &r_hash_str = cachedHashStr(peer.router_hash_id, r_hash_cache);
+
+    if (topic_binary[KafkaTopicSelector::MSGBUS_TOPIC_ID_BMP_STAT]) {
+        MsgBusV2Writer w(bin_row);
+        char row_len[MSGBUS_V2_UINT_MAX];
+        uint64_t ts_us = encodePeerFields(peer, p_ctx, bin_peer);
+
+        bin_row.assign(1, 0);                   // Row flags, full row
+        w.putAction(MSGBUS_V2_ACTION_ADD);
+        w.putUint(bmp_stat_seq);
+        w.putFields(bin_peer);
+        w.putTime(ts_us);
+        w.putUint(stats.prefixes_rej);
+        w.putUint(stats.known_dup_prefixes);
+        w.putUint(stats.known_dup_withdraws);
+        w.putUint(stats.invalid_cluster_list);
+        w.putUint(stats.invalid_as_path_loop);
+        w.putUint(stats.invalid_originator_id);
+        w.putUint(stats.invalid_as_confed_loop);
+        w.putUint(stats.routes_adj_rib_in);
+        w.putUint(stats.routes_loc_rib);
+
+        // The message is the one row, prefixed by its length
+        bin_row.insert(0, row_len, MsgBusV2Writer::encodeUint(bin_row.size(), row_len));
+
+        produce(KafkaTopicSelector::MSGBUS_TOPIC_ID_BMP_STAT, &bin_row[0], bin_row.size(), 1, p_hash_str,
+                &p_ctx.peer_group, peer.peer_as, p_ctx.topics);
+        ++bmp_stat_seq;
+        return;
+    }
 
     string ts;
     getTimestamp(peer.timestamp_secs, peer.timestamp_us, ts);
@@ -1115,7 +1476,8 @@ void msgBus_kafka::add_StatReport(obj_bgp_peer &peer, obj_stats_report &stats) {
              stats.routes_adj_rib_in, stats.routes_loc_rib);
 
 
-    produce(MSGBUS_TOPIC_VAR_BMP_STAT, buf, strlen(buf), 1, p_hash_str, &peer_list[p_hash_str], peer.peer_as);
+    produce(KafkaTopicSelector::MSGBUS_TOPIC_ID_BMP_STAT, buf, strlen(buf), 1, p_hash_str, &p_ctx.peer_group, peer.peer_as,
+            p_ctx.topics);
     ++bmp_stat_seq;
 }
 
@@ -1124,20 +1486,16 @@ void msgBus_kafka::add_StatReport(obj_bgp_peer &peer, obj_stats_report &stats) {
  */
 void msgBus_kafka::update_LsNode(obj_bgp_peer &peer, obj_path_attr &attr, std::list<MsgBusInterface::obj_ls_node> &nodes,
                                   ls_action_code code) {
-    bzero(prep_buf, MSGBUS_WORKING_BUF_SIZE);
-
-    char    buf2[8192];                          // Second working buffer
-    int     buf_len = 0;                         // query buffer length
+    char    buf2[8];                             // Working buffer for isis area id
     int     i;
 
     string hash_str;
-    string r_hash_str;
     string path_hash_str;
-    string peer_hash_str;
 
-    hash_toStr(peer.router_hash_id, r_hash_str);
+    const string &r_hash_str = cachedHashStr(peer.router_hash_id, r_hash_cache);
     hash_toStr(attr.hash_id, path_hash_str);
-    hash_toStr(peer.hash_id, peer_hash_str);
+    peer_context &p_ctx = getPeerContext(peer);
+    const string &peer_hash_str = p_ctx.hash_str;
 
     string action = "add";
     switch (code) {
@@ -1158,11 +1516,12 @@ void msgBus_kafka::update_LsNode(obj_bgp_peer &peer, obj_path_attr &attr, std::l
     char isis_area_id[32] = {0};
     char dr[16];
 
+    beginRows(KafkaTopicSelector::MSGBUS_TOPIC_ID_LS_NODE, peer_hash_str,
+              &p_ctx.peer_group, peer.peer_as, p_ctx.topics);
+
     // Loop through the vector array of entries
-    int rows = 0;
     for (std::list<MsgBusInterface::obj_ls_node>::iterator it = nodes.begin();
             it != nodes.end(); it++) {
-        ++rows;
         MsgBusInterface::obj_ls_node &node = (*it);
 
         hash_toStr(node.hash_id, hash_str);
@@ -1212,24 +1571,20 @@ void msgBus_kafka::update_LsNode(obj_bgp_peer &peer, obj_path_attr &attr, std::l
                 }
         }
 
-        buf_len += snprintf(buf2, sizeof(buf2),
-                        "%s\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%s\t%" PRIx64 "\t%" PRIx32 "\t%s"
-                                "\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%d\t%d\t%s\n",
-                        action.c_str(),ls_node_seq, hash_str.c_str(),path_hash_str.c_str(), r_hash_str.c_str(),
-                        router_ip.c_str(), peer_hash_str.c_str(), peer.peer_addr, peer.peer_as, ts.c_str(),
-                        igp_router_id, router_id, node.id, node.bgp_ls_id,node.mt_id, ospf_area_id, isis_area_id,
-                        node.protocol, node.flags, attr.as_path.c_str(), attr.local_pref, attr.med, attr.next_hop, node.name,
-                        peer.isPrePolicy, peer.isAdjIn, node.sr_capabilities_tlv);
+        appendRow("%s\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%s\t%" PRIx64 "\t%" PRIx32 "\t%s"
+                          "\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%d\t%d\t%s\n",
+                  action.c_str(),ls_node_seq, hash_str.c_str(),path_hash_str.c_str(), r_hash_str.c_str(),
+                  router_ip.c_str(), peer_hash_str.c_str(), peer.peer_addr, peer.peer_as, ts.c_str(),
+                  igp_router_id, router_id, node.id, node.bgp_ls_id,node.mt_id, ospf_area_id, isis_area_id,
+                  node.protocol, node.flags, attr.as_path.c_str(), attr.local_pref, attr.med, attr.next_hop, node.name,
+                  peer.isPrePolicy, peer.isAdjIn, node.sr_capabilities_tlv);
 
-        // Cat the entry to the query buff
-        if (buf_len < MSGBUS_WORKING_BUF_SIZE /* size of buf */)
-            strcat(prep_buf, buf2);
 
         ++ls_node_seq;
     }
 
 
-    produce(MSGBUS_TOPIC_VAR_LS_NODE, prep_buf, buf_len, rows, peer_hash_str, &peer_list[peer_hash_str], peer.peer_as);
+    endRows();
 }
 
 /**
@@ -1237,20 +1592,16 @@ void msgBus_kafka::update_LsNode(obj_bgp_peer &peer, obj_path_attr &attr, std::l
  */
 void msgBus_kafka::update_LsLink(obj_bgp_peer &peer, obj_path_attr &attr, std::list<MsgBusInterface::obj_ls_link> &links,
                                  ls_action_code code) {
-    bzero(prep_buf, MSGBUS_WORKING_BUF_SIZE);
-
-    char    buf2[8192];                          // Second working buffer
-    int     buf_len = 0;                         // query buffer length
+    char    buf2[8];                             // Working buffer for isis area id
     int     i;
 
     string hash_str;
-    string r_hash_str;
     string path_hash_str;
-    string peer_hash_str;
 
-    hash_toStr(peer.router_hash_id, r_hash_str);
+    const string &r_hash_str = cachedHashStr(peer.router_hash_id, r_hash_cache);
     hash_toStr(attr.hash_id, path_hash_str);
-    hash_toStr(peer.hash_id, peer_hash_str);
+    peer_context &p_ctx = getPeerContext(peer);
+    const string &peer_hash_str = p_ctx.hash_str;
 
     string action = "add";
     switch (code) {
@@ -1278,15 +1629,18 @@ void msgBus_kafka::update_LsLink(obj_bgp_peer &peer, obj_path_attr &attr, std::l
     char isis_area_id[33] = {0};
     char dr[16];
 
+    beginRows(KafkaTopicSelector::MSGBUS_TOPIC_ID_LS_LINK, peer_hash_str,
+              &p_ctx.peer_group, peer.peer_as, p_ctx.topics);
+
+    HashId hash;                                // Reused for each entry
+
     // Loop through the vector array of entries
-    int rows = 0;
     for (std::list<MsgBusInterface::obj_ls_link>::iterator it = links.begin();
          it != links.end(); it++) {
 
-        ++rows;
         MsgBusInterface::obj_ls_link &link = (*it);
 
-        MD5 hash;
+        hash.reset();
 
         hash.update(link.intf_addr, sizeof(link.intf_addr));
         hash.update(link.nei_addr, sizeof(link.nei_addr));
@@ -1300,9 +1654,7 @@ void msgBus_kafka::update_LsLink(obj_bgp_peer &peer, obj_path_attr &attr, std::l
         hash.finalize();
 
         // Save the hash
-        unsigned char *hash_bin = hash.raw_digest();
-        memcpy(link.hash_id, hash_bin, 16);
-        delete[] hash_bin;
+        hash.raw_digest(link.hash_id);
 
         hash_toStr(link.hash_id, hash_str);
         hash_toStr(link.local_node_hash_id, local_node_hash_id);
@@ -1374,31 +1726,26 @@ void msgBus_kafka::update_LsLink(obj_bgp_peer &peer, obj_path_attr &attr, std::l
         }
 
 
-        buf_len += snprintf(buf2, sizeof(buf2),
-                "%s\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%s\t%" PRIx64 "\t%" PRIx32 "\t%s\t%s\t%s\t%s\t%"
-                        PRIu32 "\t%" PRIu32 "\t%s\t%" PRIx32 "\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%" PRIu32 "\t%" PRIu32
-                        "\t%" PRIu32 "\t%" PRIu32 "\t%s\t%" PRIu32 "\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 ""
-                        "\t%" PRIu32 "\t%s\t%d\t%d\t%s\n",
-                            action.c_str(), ls_link_seq, hash_str.c_str(), path_hash_str.c_str(),r_hash_str.c_str(),
-                            router_ip.c_str(), peer_hash_str.c_str(), peer.peer_addr, peer.peer_as, ts.c_str(),
-                            igp_router_id, router_id, link.id, link.bgp_ls_id, ospf_area_id,
-                            isis_area_id, link.protocol, attr.as_path.c_str(), attr.local_pref, attr.med, attr.next_hop,
-                            link.mt_id, link.local_link_id, link.remote_link_id, intf_ip, nei_ip, link.igp_metric,
-                            link.admin_group, link.max_link_bw, link.max_resv_bw, link.unreserved_bw, link.te_def_metric,
-                            link.protection_type, link.mpls_proto_mask, link.srlg, link.name, remote_node_hash_id.c_str(),
-                            local_node_hash_id.c_str(),remote_igp_router_id, remote_router_id,
-                            link.local_node_asn,link.remote_node_asn, link.peer_node_sid, peer.isPrePolicy, peer.isAdjIn,
-                            link.peer_adj_sid);
-
-        // Cat the entry to the query buff
-        if (buf_len < MSGBUS_WORKING_BUF_SIZE /* size of buf */)
-            strcat(prep_buf, buf2);
+        appendRow("%s\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%s\t%" PRIx64 "\t%" PRIx32 "\t%s\t%s\t%s\t%s\t%"
+                  PRIu32 "\t%" PRIu32 "\t%s\t%" PRIx32 "\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%" PRIu32 "\t%" PRIu32
+                  "\t%" PRIu32 "\t%" PRIu32 "\t%s\t%" PRIu32 "\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 ""
+                  "\t%" PRIu32 "\t%s\t%d\t%d\t%s\n",
+                      action.c_str(), ls_link_seq, hash_str.c_str(), path_hash_str.c_str(),r_hash_str.c_str(),
+                      router_ip.c_str(), peer_hash_str.c_str(), peer.peer_addr, peer.peer_as, ts.c_str(),
+                      igp_router_id, router_id, link.id, link.bgp_ls_id, ospf_area_id,
+                      isis_area_id, link.protocol, attr.as_path.c_str(), attr.local_pref, attr.med, attr.next_hop,
+                      link.mt_id, link.local_link_id, link.remote_link_id, intf_ip, nei_ip, link.igp_metric,
+                      link.admin_group, link.max_link_bw, link.max_resv_bw, link.unreserved_bw, link.te_def_metric,
+                      link.protection_type, link.mpls_proto_mask, link.srlg, link.name, remote_node_hash_id.c_str(),
+                      local_node_hash_id.c_str(),remote_igp_router_id, remote_router_id,
+                      link.local_node_asn,link.remote_node_asn, link.peer_node_sid, peer.isPrePolicy, peer.isAdjIn,
+                      link.peer_adj_sid);
+
 
         ++ls_link_seq;
     }
 
-    produce(MSGBUS_TOPIC_VAR_LS_LINK, prep_buf, strlen(prep_buf), rows, peer_hash_str,
-            &peer_list[peer_hash_str], peer.peer_as);
+    endRows();
 }
 
 /**
@@ -1406,20 +1753,16 @@ void msgBus_kafka::update_LsLink(obj_bgp_peer &peer, obj_path_attr &attr, std::l
  */
 void msgBus_kafka::update_LsPrefix(obj_bgp_peer &peer, obj_path_attr &attr, std::list<MsgBusInterface::obj_ls_prefix> &prefixes,
                                    ls_action_code code) {
-    bzero(prep_buf, MSGBUS_WORKING_BUF_SIZE);
-
-    char    buf2[8192];                          // Second working buffer
-    int     buf_len = 0;                         // query buffer length
+    char    buf2[8];                             // Working buffer for isis area id
     int     i;
 
     string hash_str;
-    string r_hash_str;
     string path_hash_str;
-    string peer_hash_str;
 
-    hash_toStr(peer.router_hash_id, r_hash_str);
+    const string &r_hash_str = cachedHashStr(peer.router_hash_id, r_hash_cache);
     hash_toStr(attr.hash_id, path_hash_str);
-    hash_toStr(peer.hash_id, peer_hash_str);
+    peer_context &p_ctx = getPeerContext(peer);
+    const string &peer_hash_str = p_ctx.hash_str;
 
     string action = "add";
     switch (code) {
@@ -1446,15 +1789,18 @@ void msgBus_kafka::update_LsPrefix(obj_bgp_peer &peer, obj_path_attr &attr, std:
     char isis_area_id[32] = {0};
     char dr[16];
 
+    beginRows(KafkaTopicSelector::MSGBUS_TOPIC_ID_LS_PREFIX, peer_hash_str,
+              &p_ctx.peer_group, peer.peer_as, p_ctx.topics);
+
+    HashId hash;                                // Reused for each entry
+
     // Loop through the vector array of entries
-    int rows = 0;
     for (std::list<MsgBusInterface::obj_ls_prefix>::iterator it = prefixes.begin();
          it != prefixes.end(); it++) {
 
-        ++rows;
         MsgBusInterface::obj_ls_prefix &prefix = (*it);
 
-        MD5 hash;
+        hash.reset();
 
         hash.update(prefix.prefix_bin, sizeof(prefix.prefix_bin));
         hash.update(&prefix.prefix_len, 1);
@@ -1465,9 +1811,7 @@ void msgBus_kafka::update_LsPrefix(obj_bgp_peer &peer, obj_path_attr &attr, std:
         hash.finalize();
 
         // Save the hash
-        unsigned char *hash_bin = hash.raw_digest();
-        memcpy(prefix.hash_id, hash_bin, 16);
-        delete[] hash_bin;
+        hash.raw_digest(prefix.hash_id);
 
         // Build the query
         hash_toStr(prefix.hash_id, hash_str);
@@ -1520,136 +1864,74 @@ void msgBus_kafka::update_LsPrefix(obj_bgp_peer &peer, obj_path_attr &attr, std:
         }
 
 
-        buf_len += snprintf(buf2, sizeof(buf2),
-                "%s\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%s\t%" PRIx64 "\t%" PRIx32
-                        "\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%" PRIx32 "\t%s\t%s\t%" PRIu32 "\t%" PRIx64
-                            "\t%s\t%" PRIu32 "\t%s\t%d\t%d\t%d\t%s\n",
-                            action.c_str(), ls_prefix_seq, hash_str.c_str(), path_hash_str.c_str(), r_hash_str.c_str(),
-                            router_ip.c_str(), peer_hash_str.c_str(), peer.peer_addr, peer.peer_as, ts.c_str(),
-                            igp_router_id, router_id, prefix.id, prefix.bgp_ls_id, ospf_area_id, isis_area_id,
-                            prefix.protocol, attr.as_path.c_str(), attr.local_pref, attr.med, attr.next_hop, local_node_hash_id.c_str(),
-                            prefix.mt_id, prefix.ospf_route_type, prefix.igp_flags, prefix.route_tag, prefix.ext_route_tag,
-                            ospf_fwd_addr, prefix.metric, prefix_ip, prefix.prefix_len, peer.isPrePolicy, peer.isAdjIn,
-                            prefix.sid_tlv);
+        appendRow("%s\t%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%s\t%s\t%s\t%" PRIx64 "\t%" PRIx32
+                  "\t%s\t%s\t%s\t%s\t%" PRIu32 "\t%" PRIu32 "\t%s\t%s\t%" PRIx32 "\t%s\t%s\t%" PRIu32 "\t%" PRIx64
+                      "\t%s\t%" PRIu32 "\t%s\t%d\t%d\t%d\t%s\n",
+                      action.c_str(), ls_prefix_seq, hash_str.c_str(), path_hash_str.c_str(), r_hash_str.c_str(),
+                      router_ip.c_str(), peer_hash_str.c_str(), peer.peer_addr, peer.peer_as, ts.c_str(),
+                      igp_router_id, router_id, prefix.id, prefix.bgp_ls_id, ospf_area_id, isis_area_id,
+                      prefix.protocol, attr.as_path.c_str(), attr.local_pref, attr.med, attr.next_hop, local_node_hash_id.c_str(),
+                      prefix.mt_id, prefix.ospf_route_type, prefix.igp_flags, prefix.route_tag, prefix.ext_route_tag,
+                      ospf_fwd_addr, prefix.metric, prefix_ip, prefix.prefix_len, peer.isPrePolicy, peer.isAdjIn,
+                      prefix.sid_tlv);
 
-        // Cat the entry to the query buff
-        if (buf_len < MSGBUS_WORKING_BUF_SIZE /* size of buf */)
-            strcat(prep_buf, buf2);
 
         ++ls_prefix_seq;
     }
 
-    produce(MSGBUS_TOPIC_VAR_LS_PREFIX, prep_buf, strlen(prep_buf), rows, peer_hash_str,
-            &peer_list[peer_hash_str], peer.peer_as);
+    endRows();
 }
 
 /**
  * Abstract method Implementation - See MsgBusInterface.hpp for details
- *
- * TODO: Consolidate this to single produce method
  */
 void msgBus_kafka::send_bmp_raw(u_char *r_hash, obj_bgp_peer &peer, u_char *data, size_t data_len) {
-    string r_hash_str;
-    string p_hash_str;
-    RdKafka::Topic *topic = NULL;
 
-    hash_toStr(peer.hash_id, p_hash_str);
-    hash_toStr(r_hash, r_hash_str);
+    peer_context &p_ctx = getPeerContext(peer);
+    const string &r_hash_str = cachedHashStr(r_hash, r_hash_cache);
 
     if (data_len == 0)
         return;
 
-    while (isConnected == false) {
-        LOG_WARN("rtr=%s: Not connected to Kafka, attempting to reconnect", router_ip.c_str());
-        connect();
-
-        sleep(2);
-    }
-
     // if topic is disabled, don't bother producing the message
-    if (!topicSel->topicEnabled(MSGBUS_TOPIC_VAR_BMP_RAW))
+    if (!producer->topicEnabled(KafkaTopicSelector::MSGBUS_TOPIC_ID_BMP_RAW))
         return;
 
-    char headers[256];
+    char headers[MSGBUS_HDR_ROOM];
     size_t hdr_len = snprintf(headers, sizeof(headers), "V: %s\nC_HASH_ID: %s\nR_HASH: %s\nR_IP: %s\nL: %lu\n\n",
              MSGBUS_API_VERSION, collector_hash.c_str(), r_hash_str.c_str(), router_ip.c_str(), data_len);
 
-    memcpy(producer_buf, headers, hdr_len);
-    memcpy(producer_buf+hdr_len, data, data_len);
-
-    topic = topicSel->getTopic(MSGBUS_TOPIC_VAR_BMP_RAW, &router_group_name, &peer_list[p_hash_str], peer.peer_as);
-    if (topic != NULL) {
-        SELF_DEBUG("rtr=%s: Producing bmp raw message: topic=%s key=%s, msg size = %lu", router_ip.c_str(),
-                   topic->name().c_str(), r_hash_str.c_str(), data_len);
-
-        RdKafka::ErrorCode resp = producer->produce(topic, RdKafka::Topic::PARTITION_UA,
-                                                    RdKafka::Producer::RK_MSG_COPY /* Copy payload */,
-                                                    producer_buf, data_len + hdr_len,
-                                                    (const std::string *)&r_hash_str, NULL);
-
-        if (resp != RdKafka::ERR_NO_ERROR) {
-            LOG_ERR("rtr=%s: Failed to produce bmp raw message: %s", router_ip.c_str(), RdKafka::err2str(resp).c_str());
-            producer->poll(100);
-        }
-    }
-    else {
-        SELF_DEBUG("rtr=%s: failed to produce bmp raw message because topic couldn't be found: topic=%s key=%s, msg size = %lu",
-                   router_ip.c_str(), MSGBUS_TOPIC_VAR_BMP_RAW, r_hash_str.c_str(), data_len);
-    }
+    // Header and BMP message are copied once, directly into the buffer handed to the producer
+    pool_buffer *buf = pool->acquire(hdr_len + data_len);
+    memcpy(buf->data, headers, hdr_len);
+    memcpy(buf->data + hdr_len, data, data_len);
 
-    producer->poll(0);
+    producer->produce(KafkaTopicSelector::MSGBUS_TOPIC_ID_BMP_RAW, p_ctx.topics, &router_group_name,
+                      &p_ctx.peer_group, peer.peer_as,
+                      r_hash_str, buf, buf->data, hdr_len + data_len, router_ip);
 }
 
 /**
 * \brief Method to resolve the IP address to a hostname
 *
+* \details Does not block; the name is looked up by the shared DNS resolver.
+*
 *  \param [in]   name      String name (ip address)
-*  \param [out]  hostname  String reference for hostname
+*  \param [out]  hostname  String reference for hostname, empty if not known
 *
-*  \returns true if error, false if no error
+*  \returns true if the lookup is pending, false if resolved
 */
-bool msgBus_kafka::resolveIp(string name, string &hostname) {
-    addrinfo *ai;
-    char host[255];
-
-    if (!getaddrinfo(name.c_str(), NULL, NULL, &ai)) {
-
-        if (!getnameinfo(ai->ai_addr,ai->ai_addrlen, host, sizeof(host), NULL, 0, NI_NAMEREQD)) {
-            hostname.assign(host);
-            LOG_INFO("resolve: %s to %s", name.c_str(), hostname.c_str());
-        }
-
-        freeaddrinfo(ai);
-        return false;
-    }
-
-    return true;
+bool msgBus_kafka::resolveIp(const string &name, string &hostname) {
+    return not resolver->lookup(name, hostname);
 }
 
 /*
  * Enable/disable debugs
  */
 void msgBus_kafka::enableDebug() {
-    string value = "all";
-    string errstr;
-
-    disconnect();
-
-    if (conf->set("debug", value, errstr) != RdKafka::Conf::CONF_OK) {
-        LOG_ERR("Failed to enable debug on kafka producer confg: %s", errstr.c_str());
-    }
-
-    connect();
-
     debug = true;
-
 }
-void msgBus_kafka::disableDebug() {
-    string errstr;
-    string value = "";
-
-    if (conf)
-        conf->set("debug", value, errstr);
 
+void msgBus_kafka::disableDebug() {
     debug = false;
 }
@@ -16,16 +16,20 @@
 #include "Logger.h"
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
+#include <cstring>
 #include <ctime>
+#include <chrono>
 
 #include <librdkafka/rdkafkacpp.h>
 
 #include <thread>
 #include "safeQueue.hpp"
-#include "KafkaEventCallback.h"
-#include "KafkaDeliveryReportCallback.h"
 #include "KafkaTopicSelector.h"
+#include "MsgBusV2.h"
+#include "MsgBusSink.h"
+#include "DnsResolver.h"
 
 #include "Config.h"
 
@@ -36,19 +40,25 @@
   */
 class msgBus_kafka: public MsgBusInterface {
 public:
-    #define MSGBUS_WORKING_BUF_SIZE         1800000
+    #define MSGBUS_WORKING_BUF_SIZE         1800000     ///< Max size of the rows of a message
+    #define MSGBUS_ROWS_INIT_SIZE           16384       ///< Initial rows buffer size
+    #define MSGBUS_HDR_ROOM                 256         ///< Room reserved before the rows for the message header
     #define MSGBUS_API_VERSION              "1.7"
+    #define MSGBUS_HASH_KEY_SIZE            96          ///< Max size of a unicast prefix hash key (prefix, len, peer hash, path id, label flag)
 
     /******************************************************************//**
-     * \brief This function will initialize and connect to Kafka.
+     * \brief This function will initialize the per router message bus state
      *
-     * \details It is expected that this class will start off with a new connection.
+     * \details Messages are produced using the shared (process wide) sink.
      *
      *  \param [in] logPtr      Pointer to Logger instance
      *  \param [in] cfg         Pointer to the config instance
+     *  \param [in] producer    Pointer to the shared message bus sink
+     *  \param [in] resolver    Pointer to the shared DNS resolver
      *  \param [in] c_hash_id   Collector Hash ID
      ********************************************************************/
-    msgBus_kafka(Logger *logPtr, Config *cfg, u_char *c_hash_id);
+    msgBus_kafka(Logger *logPtr, Config *cfg, MsgBusSink *producer,
+                 DnsResolver *resolver, u_char *c_hash_id);
     ~msgBus_kafka();
 
     /*
@@ -74,14 +84,57 @@ public:
     void update_eVPN(obj_bgp_peer &peer, std::vector<obj_evpn> &vpn, obj_path_attr *attr, vpn_action_code code);
 
     void send_bmp_raw(u_char *r_hash, obj_bgp_peer &peer, u_char *data, size_t data_len);
+    void flush(bool expired_only);
+
+    /**
+     * Check if coalesced rows are waiting to be produced - see flush()
+     */
+    bool hasPendingRows() const { return pending_batches > 0; }
 
     // Debug methods
     void enableDebug();
     void disableDebug();
 
 private:
-    char            *prep_buf;                  ///< Large working buffer for message preparation
-    unsigned char   *producer_buf;              ///< Producer message buffer
+    BufferPool      *pool;                      ///< Message buffer pool of the producer
+
+    /**
+     * Rows of a topic coalesced into one message
+     *
+     * \details Rows of consecutive updates of the same peer are appended to the batch of the
+     *          topic until the batch reaches the row/byte limit or the linger time, or a row
+     *          of another peer is added.
+     */
+    struct row_batch {
+        pool_buffer     *buf;                   ///< Pooled buffer, handed to the producer on flush - NULL if not used yet
+        char            *rows;                  ///< Rows, MSGBUS_HDR_ROOM bytes into buf
+        size_t          size;                   ///< Size available for rows
+        size_t          size_hint;              ///< Rows size to acquire the next buffer with
+        size_t          len;                    ///< Length of the rows (append position)
+        int             count;                  ///< Number of rows
+        std::string     key;                    ///< Hash key of the rows
+        const std::string *peer_group;          ///< Peer group of the rows
+        uint32_t        peer_asn;               ///< Peer ASN of the rows
+        MsgBusSink::topic_cache *topics;        ///< Topic handles of the rows
+        std::chrono::steady_clock::time_point first_row;   ///< Time the first row was added
+        std::string     bin_peer;               ///< Binary rows: peer fields last included in the message
+        std::string     bin_attrs;              ///< Binary rows: path attribute fields last included in the message
+    };
+
+    row_batch       batches[KafkaTopicSelector::MSGBUS_TOPIC_ID_MAX];  ///< Batches by topic
+    int             batch_topic_id;             ///< Topic of the batch rows are appended to (MSGBUS_TOPIC_ID_*)
+    int             pending_batches;            ///< Number of batches with rows
+
+    bool            topic_binary[KafkaTopicSelector::MSGBUS_TOPIC_ID_MAX];  ///< Topic rows are binary (API 2.0), by topic
+    std::string     bin_head;                   ///< Binary row being encoded - fields before the peer fields
+    std::string     bin_row;                    ///< Binary row being encoded - fields after the peer fields
+    std::string     bin_peer;                   ///< Binary peer fields of the update being encoded
+    std::string     bin_attrs;                  ///< Binary path attribute fields of the update being encoded
+
+    std::vector<unsigned char>          hash_keys;      ///< Unicast prefix hash keys, MSGBUS_HASH_KEY_SIZE bytes each
+    std::vector<const unsigned char *>  hash_key_ptrs;  ///< Pointer to each hash key
+    std::vector<size_t>                 hash_key_lens;  ///< Length of each hash key
+    std::vector<unsigned char *>        hash_digests;   ///< Digest output of each hash key
     bool            debug;                      ///< debug flag to indicate debugging
     Logger          *logger;                    ///< Logging class pointer
 
@@ -101,67 +154,247 @@ private:
 
     Config          *cfg;                       ///< Pointer to config instance
 
+    MsgBusSink      *producer;                  ///< Shared message bus sink (Kafka producer or local sink)
+    DnsResolver     *resolver;                  ///< Shared DNS resolver
+    bool            router_name_pending;        ///< Router hostname lookup is pending
+
     /**
-     * Kafka Configuration object (global)
+     * Peer context key - binary peer address and distinguisher from the BMP per peer header
      */
-    RdKafka::Conf   *conf;
-
-    RdKafka::Producer *producer;                ///< Kafka Producer instance
+    struct peer_key {
+        u_char      addr[16];                   ///< Peer address
+        u_char      rd[8];                      ///< Peer distinguisher
+        u_char      isIPv4;                     ///< Peer address is IPv4 (changes the printed address)
+
+        bool operator==(const peer_key &k) const {
+            return memcmp(this, &k, sizeof(peer_key)) == 0;
+        }
+    };
+
+    struct peer_key_hash {
+        size_t operator()(const peer_key &k) const {
+            // FNV-1a
+            const u_char *p = (const u_char *)&k;
+            size_t h = 14695981039346656037ULL;
+
+            for (size_t i=0; i < sizeof(peer_key); i++) {
+                h ^= p[i];
+                h *= 1099511628211ULL;
+            }
+            return h;
+        }
+    };
 
     /**
-     * Callback handlers
+     * Per peer context - computed once per peer instead of per message
      */
-    KafkaEventCallback              *event_callback;
-    KafkaDeliveryReportCallback     *delivery_callback;
-
-    bool isConnected;                           ///< Indicates if Kafka is connected or not
-
-    // array of hashes
-    std::map<std::string, std::string> peer_list;
-    typedef std::map<std::string, std::string>::iterator peer_list_iter;
+    struct peer_context {
+        u_char      router_hash_id[16];         ///< Router hash the peer hash was generated with
+        u_char      hash_id[16];                ///< Peer hash
+        std::string hash_str;                   ///< Peer hash in printed form
+        std::string peer_group;                 ///< Peer group name - empty if not matched
+        bool        active;                     ///< Peer first/up has been sent and the peer is not down
+        bool        name_pending;               ///< Hostname lookup was pending when the peer was sent
+        MsgBusSink::topic_cache topics;         ///< Topic handles of the peer
+    };
+
+    std::unordered_map<peer_key, peer_context, peer_key_hash> peer_ctx_map;
+    typedef std::unordered_map<peer_key, peer_context, peer_key_hash>::iterator peer_ctx_map_iter;
+
+    peer_context    *last_peer_ctx;             ///< Context of the last peer looked up
+    peer_key        last_peer_key;              ///< Key of the last peer looked up
 
     std::string router_ip;                      ///< Router IP in printed format
     u_char      router_hash[16];                ///< Router Hash in binary format
     std::string router_group_name;              ///< Router group name - if matched
+    MsgBusSink::topic_cache router_topics;      ///< Topic handles of the collector and router topics
 
-
-    std::map<std::string, RdKafka::Topic*> topic;
-
-    KafkaTopicSelector *topicSel;               ///< Kafka topic selector/handler
+    std::string topic_hdr[KafkaTopicSelector::MSGBUS_TOPIC_ID_MAX];   ///< Message header up to the length, by topic
 
     /**
-     * Connects to kafka broker
+     * Printed hash string of the last binary hash converted
      */
-    void connect();
+    struct hash_str_cache {
+        u_char      hash_bin[16];               ///< Binary hash
+        std::string hash_str;                   ///< Hash in printed form
+    };
+
+    hash_str_cache  r_hash_cache;               ///< Router hash string cache
 
-    /**
-     * Disconnects from kafka broker
-     */
-    void disconnect(int wait_ms=2000);
 
     /**
      * produce message to Kafka
      *
-     * \param [in] topic_var     Topic var to use in KafkaTopicSelector::getTopic()
+     * \param [in] topic_id      Topic to produce to, KafkaTopicSelector::MSGBUS_TOPIC_ID_*
      * \param [in] msg           message to produce
      * \param [in] msg_size      Length in bytes of the message
      * \param [in] rows          Number of rows in data
      * \param [in] key           Hash key
      * \param [in] peer_group    Peer group name - empty/NULL if not set or used
      * \param [in] peer_asn      Peer ASN
+     * \param [in/out] topics    Topic handles of the peer/router
+     */
+    void produce(int topic_id, char *msg, size_t msg_size, int rows,
+                 const std::string &key, const std::string *peer_group, uint32_t peer_asn,
+                 MsgBusSink::topic_cache &topics);
+
+    /**
+     * produce message in a pooled buffer to Kafka without copying it
+     *
+     * \param [in] topic_id      Topic to produce to, KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+     * \param [in] buf           Pooled buffer, the message starts at MSGBUS_HDR_ROOM.  Ownership is transferred.
+     * \param [in] msg_size      Length in bytes of the message
+     * \param [in] rows          Number of rows in data
+     * \param [in] key           Hash key
+     * \param [in] peer_group    Peer group name - empty/NULL if not set or used
+     * \param [in] peer_asn      Peer ASN
+     * \param [in/out] topics    Topic handles of the peer/router
+     */
+    void producePooled(int topic_id, pool_buffer *buf, size_t msg_size, int rows,
+                       const std::string &key, const std::string *peer_group, uint32_t peer_asn,
+                       MsgBusSink::topic_cache &topics);
+
+    /**
+     * Get the context of a peer, creating it if needed
+     *
+     * \details The peer hash is generated when the peer is first seen or when the router
+     *          hash changes.  peer.hash_id is updated with the peer hash.
+     *
+     * \param [in/out] peer          Peer entry
+     *
+     * \return Peer context
+     */
+    peer_context &getPeerContext(obj_bgp_peer &peer);
+
+    /**
+     * Get the printed form of a hash, converting it only if it differs from the cached hash
+     *
+     * \details The router hash is the same for most messages of a connection.
+     *          The returned reference is valid until the next call with the same cache.
+     *
+     * \param [in]     hash_bin      16 byte binary hash
+     * \param [in/out] cache         Cache to use
+     *
+     * \return Hash in printed form
+     */
+    const std::string &cachedHashStr(const u_char *hash_bin, hash_str_cache &cache);
+
+    /**
+     * Begin adding the rows of an update to the batch of a topic
+     *
+     * \details The rows are coalesced with the rows in the batch if they are of the same peer,
+     *          otherwise the batch is produced first.
+     *
+     * \param [in] topic_id      Topic to produce to, KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+     * \param [in] key           Hash key
+     * \param [in] peer_group    Peer group name - empty/NULL if not set or used
+     * \param [in] peer_asn      Peer ASN
+     * \param [in/out] topics    Topic handles of the peer
+     */
+    void beginRows(int topic_id, const std::string &key, const std::string *peer_group,
+                   uint32_t peer_asn, MsgBusSink::topic_cache &topics);
+
+    /**
+     * Append a formatted row to the current batch
+     *
+     * \details The row is written in place at the end of the batch.  If the row does not
+     *          fit, the batch moves to a larger buffer up to MSGBUS_WORKING_BUF_SIZE, after
+     *          which the rows already in the batch are produced as one message and the row
+     *          starts the next message.
+     *
+     * \param [in] fmt           printf format of the row
+     */
+    void appendRow(const char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
+
+    /**
+     * Append a binary row (API 2.0) to the current batch
+     *
+     * \details The row is written as its length, flags and fields, growing or producing
+     *          the batch as appendRow() does.  The peer fields (bin_peer) and the path
+     *          attribute fields (bin_attrs) are omitted if the same as in the previous
+     *          row of the message.
+     *
+     * \param [in] head          Fields before the peer fields
+     * \param [in] body          Fields after the peer fields, up to the path attributes
+     * \param [in] with_attrs    Row has the path attribute fields (bin_attrs)
+     */
+    void appendBinaryRow(const std::string &head, const std::string &body, bool with_attrs);
+
+    /**
+     * Make room for a row that does not fit in the current batch
+     *
+     * \details The batch moves to a larger buffer if it can grow to fit the row, otherwise
+     *          the rows already in the batch are produced.
+     *
+     * \param [in/out] batch     Batch
+     * \param [in] len           Length of the row
+     *
+     * \return false if the row can never fit (larger than MSGBUS_WORKING_BUF_SIZE)
+     */
+    bool batchMakeRoom(row_batch &batch, size_t len);
+
+    /**
+     * Account for a row written at the end of the current batch
+     *
+     * \param [in/out] batch     Batch
+     * \param [in] len           Length of the row
+     */
+    void batchAddRow(row_batch &batch, size_t len);
+
+    /**
+     * Encode the binary peer fields (MSGBUS_V2_GROUP_PEER) of an update
+     *
+     * \param [in] peer          Peer entry
+     * \param [in] p_ctx         Peer context
+     * \param [out] out          Encoded fields
+     *
+     * \return Timestamp of the update in microseconds, the timestamp field of the rows
+     */
+    uint64_t encodePeerFields(obj_bgp_peer &peer, peer_context &p_ctx, std::string &out);
+
+    /**
+     * Encode the binary path attribute fields (MSGBUS_V2_ATTR_FIELDS) of an update
+     *
+     * \param [in] attr          Path attributes
+     * \param [in/out] out       Buffer the fields are appended to
+     */
+    static void encodeAttrFields(obj_path_attr &attr, std::string &out);
+
+    /**
+     * End adding the rows of an update
+     *
+     * \details The batch is produced if it reached the coalesce row/byte limit or linger time.
+     *          Other batches past the linger time are produced as well.
+     */
+    void endRows();
+
+    /**
+     * Produce the rows of a batch, if any
+     *
+     * \details The batch buffer is handed to the producer without copy.  A new one is only
+     *          acquired once the next row is added, so idle routers do not hold buffers.
+     *
+     * \param [in] topic_id      Topic of the batch
+     */
+    void flushBatch(int topic_id);
+
+    /**
+     * Get a pooled buffer with room for size bytes of rows
+     *
+     * \param [in/out] batch     Batch, rows in the current buffer are moved to the new buffer
+     * \param [in] size          Minimum size of the rows
      */
-    void produce(const char *topic_var, char *msg, size_t msg_size, int rows,
-                 std::string key, const std::string *peer_group, uint32_t);
+    void batchAcquire(row_batch &batch, size_t size);
 
     /**
     * \brief Method to resolve the IP address to a hostname
     *
     *  \param [in]   name      String name (ip address)
-    *  \param [out]  hostname  String reference for hostname
+    *  \param [out]  hostname  String reference for hostname, empty if not known
     *
-    *  \returns true if error, false if no error
+    *  \returns true if the lookup is pending, false if resolved
     */
-    bool resolveIp(std::string name, std::string &hostname);
+    bool resolveIp(const std::string &name, std::string &hostname);
 
 
 };
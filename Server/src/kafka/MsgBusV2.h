@@ -0,0 +1,653 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef OPENBMP_MSGBUSV2_H
+#define OPENBMP_MSGBUSV2_H
+
+/*
+ * Message bus API 2.0 - binary row encoding
+ *
+ * This header has no dependencies on the rest of openbmp, so it can be copied into a
+ * consumer application.  See docs/MESSAGE_BUS_API_V2.md for the specification.
+ *
+ * A 2.0 message has the same text headers as a 1.7 message (V: 2.0), followed by L bytes of
+ * R rows.  Each row is a uint length, a flags byte (MSGBUS_V2_ROW_*) and the fields of the
+ * row, in the order of the schema of the topic (msgbusV2Schema).
+ *
+ * The peer and path attribute fields (MSGBUS_V2_GROUP_*) are omitted from a row when the row
+ * flags say they are the same as in the previous row of the message that included them;
+ * rows are decoded in order, and each message starts with full rows.
+ *
+ * A row may end before the last field of the schema; the missing fields are absent (delete
+ * rows end before the path attributes).  Fields added in later minor versions are appended
+ * to the schema, so decoders skip any bytes of a row after the last field they know.
+ *
+ * Example:
+ *
+ *      MsgBusV2Decoder dec;
+ *      std::vector<MsgBusV2Decoder::value> row;
+ *
+ *      if (dec.decode(kafka_msg, kafka_msg_len)) {
+ *          while (dec.nextRow(row)) {
+ *              for (size_t i=0; i < row.size(); i++)
+ *                  printf("%s=%s ", dec.getSchema()[i].name, row[i].str().c_str());
+ *          }
+ *      }
+ */
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cctype>
+#include <ctime>
+#include <arpa/inet.h>
+
+#define MSGBUS_V2_VERSION           "2.0"       ///< V: header of binary messages
+#define MSGBUS_V2_HASH_SIZE         16          ///< Size of a binary hash
+#define MSGBUS_V2_UINT_MAX          10          ///< Max size of an encoded uint
+
+/**
+ * Field types
+ */
+enum msgbus_v2_type {
+    MSGBUS_V2_NONE = 0,                         ///< Field not present in the row
+    MSGBUS_V2_ACTION,                           ///< 1 byte, MSGBUS_V2_ACTION_*
+    MSGBUS_V2_UINT,                             ///< Unsigned LEB128 varint, up to 64 bits
+    MSGBUS_V2_BOOL,                             ///< 1 byte, 0 or 1
+    MSGBUS_V2_HASH,                             ///< 16 bytes
+    MSGBUS_V2_STRING,                           ///< uint length followed by the bytes, not terminated
+    MSGBUS_V2_ADDR,                             ///< 1 byte length (0, 4 or 16) followed by the address
+    MSGBUS_V2_PREFIX,                           ///< 1 byte address length (4 or 16), 1 byte prefix length,
+                                                ///<    then the (prefix length + 7) / 8 leading address bytes
+    MSGBUS_V2_TIME                              ///< uint microseconds since the unix epoch (UTC)
+};
+
+/**
+ * Field groups - fields that are omitted together when unchanged from the previous row
+ */
+enum msgbus_v2_group {
+    MSGBUS_V2_GROUP_NONE = 0,
+    MSGBUS_V2_GROUP_PEER,                       ///< Router and peer of the row
+    MSGBUS_V2_GROUP_ATTRS                       ///< Path attributes of the row
+};
+
+#define MSGBUS_V2_ROW_SAME_PEER     0x01        ///< Row flag: peer fields omitted, same as the previous row
+#define MSGBUS_V2_ROW_SAME_ATTRS    0x02        ///< Row flag: path attribute fields omitted, same as the previous row
+
+/**
+ * Row actions
+ */
+enum msgbus_v2_action {
+    MSGBUS_V2_ACTION_ADD = 1,
+    MSGBUS_V2_ACTION_DEL
+};
+
+/**
+ * Schema field
+ */
+struct msgbus_v2_field {
+    const char      *name;                      ///< Field name
+    uint8_t         type;                       ///< msgbus_v2_type
+    uint8_t         group;                      ///< msgbus_v2_group
+};
+
+/*
+ * Peer fields, common to the rows of all topics and followed by the timestamp
+ */
+#define MSGBUS_V2_PEER_FIELDS \
+    { "router_hash",            MSGBUS_V2_HASH,     MSGBUS_V2_GROUP_PEER },     \
+    { "router_ip",              MSGBUS_V2_ADDR,     MSGBUS_V2_GROUP_PEER },     \
+    { "peer_hash",              MSGBUS_V2_HASH,     MSGBUS_V2_GROUP_PEER },     \
+    { "peer_ip",                MSGBUS_V2_ADDR,     MSGBUS_V2_GROUP_PEER },     \
+    { "peer_asn",               MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_PEER },     \
+    { "timestamp",              MSGBUS_V2_TIME,     MSGBUS_V2_GROUP_NONE }
+
+/*
+ * Path attribute fields, last in the rows (add rows only)
+ */
+#define MSGBUS_V2_ATTR_FIELDS \
+    { "origin",                 MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_ATTRS },    \
+    { "as_path",                MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_ATTRS },    \
+    { "as_path_count",          MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_ATTRS },    \
+    { "origin_as",              MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_ATTRS },    \
+    { "next_hop",               MSGBUS_V2_ADDR,     MSGBUS_V2_GROUP_ATTRS },    \
+    { "med",                    MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_ATTRS },    \
+    { "local_pref",             MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_ATTRS },    \
+    { "aggregator",             MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_ATTRS },    \
+    { "community_list",         MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_ATTRS },    \
+    { "ext_community_list",     MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_ATTRS },    \
+    { "cluster_list",           MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_ATTRS },    \
+    { "atomic_agg",             MSGBUS_V2_BOOL,     MSGBUS_V2_GROUP_ATTRS },    \
+    { "originator_id",          MSGBUS_V2_ADDR,     MSGBUS_V2_GROUP_ATTRS },    \
+    { "large_community_list",   MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_ATTRS }
+
+/**
+ * Get the schema of a topic
+ *
+ * \param [in]  topic       Topic type, as in the T: header (e.g. unicast_prefix)
+ * \param [out] count       Number of fields
+ *
+ * \return Fields of the topic, NULL if the topic has no binary encoding
+ */
+inline const msgbus_v2_field *msgbusV2Schema(const std::string &topic, size_t &count) {
+    static const msgbus_v2_field base_attribute[] = {
+        { "action",                 MSGBUS_V2_ACTION,   MSGBUS_V2_GROUP_NONE },
+        { "sequence",               MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "hash",                   MSGBUS_V2_HASH,     MSGBUS_V2_GROUP_NONE },
+        MSGBUS_V2_PEER_FIELDS,
+        MSGBUS_V2_ATTR_FIELDS
+    };
+
+    static const msgbus_v2_field unicast_prefix[] = {
+        { "action",                 MSGBUS_V2_ACTION,   MSGBUS_V2_GROUP_NONE },
+        { "sequence",               MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "hash",                   MSGBUS_V2_HASH,     MSGBUS_V2_GROUP_NONE },
+        MSGBUS_V2_PEER_FIELDS,
+        { "prefix",                 MSGBUS_V2_PREFIX,   MSGBUS_V2_GROUP_NONE },
+        { "path_id",                MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "labels",                 MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_NONE },
+        { "is_pre_policy",          MSGBUS_V2_BOOL,     MSGBUS_V2_GROUP_NONE },
+        { "is_adj_rib_in",          MSGBUS_V2_BOOL,     MSGBUS_V2_GROUP_NONE },
+        { "base_attr_hash",         MSGBUS_V2_HASH,     MSGBUS_V2_GROUP_ATTRS },
+        MSGBUS_V2_ATTR_FIELDS
+    };
+
+    static const msgbus_v2_field l3vpn[] = {
+        { "action",                 MSGBUS_V2_ACTION,   MSGBUS_V2_GROUP_NONE },
+        { "sequence",               MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "hash",                   MSGBUS_V2_HASH,     MSGBUS_V2_GROUP_NONE },
+        MSGBUS_V2_PEER_FIELDS,
+        { "prefix",                 MSGBUS_V2_PREFIX,   MSGBUS_V2_GROUP_NONE },
+        { "path_id",                MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "labels",                 MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_NONE },
+        { "is_pre_policy",          MSGBUS_V2_BOOL,     MSGBUS_V2_GROUP_NONE },
+        { "is_adj_rib_in",          MSGBUS_V2_BOOL,     MSGBUS_V2_GROUP_NONE },
+        { "rd",                     MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_NONE },
+        { "rd_type",                MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "base_attr_hash",         MSGBUS_V2_HASH,     MSGBUS_V2_GROUP_ATTRS },
+        MSGBUS_V2_ATTR_FIELDS
+    };
+
+    static const msgbus_v2_field evpn[] = {
+        { "action",                 MSGBUS_V2_ACTION,   MSGBUS_V2_GROUP_NONE },
+        { "sequence",               MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "hash",                   MSGBUS_V2_HASH,     MSGBUS_V2_GROUP_NONE },
+        MSGBUS_V2_PEER_FIELDS,
+        { "path_id",                MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "is_pre_policy",          MSGBUS_V2_BOOL,     MSGBUS_V2_GROUP_NONE },
+        { "is_adj_rib_in",          MSGBUS_V2_BOOL,     MSGBUS_V2_GROUP_NONE },
+        { "rd",                     MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_NONE },
+        { "rd_type",                MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "orig_router_ip_len",     MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "orig_router_ip",         MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_NONE },
+        { "ethernet_tag_id",        MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_NONE },
+        { "ethernet_segment_id",    MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_NONE },
+        { "mac_len",                MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "mac",                    MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_NONE },
+        { "ip_len",                 MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "ip",                     MSGBUS_V2_STRING,   MSGBUS_V2_GROUP_NONE },
+        { "mpls_label_1",           MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "mpls_label_2",           MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "base_attr_hash",         MSGBUS_V2_HASH,     MSGBUS_V2_GROUP_ATTRS },
+        MSGBUS_V2_ATTR_FIELDS
+    };
+
+    static const msgbus_v2_field bmp_stat[] = {
+        { "action",                 MSGBUS_V2_ACTION,   MSGBUS_V2_GROUP_NONE },
+        { "sequence",               MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        MSGBUS_V2_PEER_FIELDS,
+        { "prefixes_rejected",      MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "known_dup_prefixes",     MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "known_dup_withdraws",    MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "invalid_cluster_list",   MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "invalid_as_path_loop",   MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "invalid_originator_id",  MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "invalid_as_confed_loop", MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "routes_adj_rib_in",      MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+        { "routes_loc_rib",         MSGBUS_V2_UINT,     MSGBUS_V2_GROUP_NONE },
+    };
+
+    #define MSGBUS_V2_SCHEMA(name) \
+        if (topic == #name) { count = sizeof(name) / sizeof(name[0]); return name; }
+
+    MSGBUS_V2_SCHEMA(base_attribute);
+    MSGBUS_V2_SCHEMA(unicast_prefix);
+    MSGBUS_V2_SCHEMA(l3vpn);
+    MSGBUS_V2_SCHEMA(evpn);
+    MSGBUS_V2_SCHEMA(bmp_stat);
+
+    #undef MSGBUS_V2_SCHEMA
+
+    count = 0;
+    return NULL;
+}
+
+/**
+ * \class   MsgBusV2Writer
+ *
+ * \brief   Appends binary fields to a buffer
+ */
+class MsgBusV2Writer {
+public:
+    /**
+     * \param [in/out] buf      Buffer the fields are appended to
+     */
+    explicit MsgBusV2Writer(std::string &buf) : out(buf) {}
+
+    void putAction(uint8_t action) {
+        out.push_back((char)action);
+    }
+
+    void putUint(uint64_t value) {
+        char buf[MSGBUS_V2_UINT_MAX];
+        out.append(buf, encodeUint(value, buf));
+    }
+
+    void putBool(bool value) {
+        out.push_back(value ? 1 : 0);
+    }
+
+    void putHash(const unsigned char *hash) {
+        out.append((const char *)hash, MSGBUS_V2_HASH_SIZE);
+    }
+
+    void putString(const char *str, size_t len) {
+        putUint(len);
+        out.append(str, len);
+    }
+
+    void putString(const char *str) {
+        putString(str, strlen(str));
+    }
+
+    void putString(const std::string &str) {
+        putString(str.data(), str.size());
+    }
+
+    /**
+     * Put a binary address
+     *
+     * \param [in] addr     Address in network byte order, NULL if none
+     * \param [in] len      Address length: 4, 16, or 0 if none
+     */
+    void putAddr(const unsigned char *addr, uint8_t len) {
+        out.push_back((char)len);
+        if (len > 0)
+            out.append((const char *)addr, len);
+    }
+
+    /**
+     * Put an address given in printed form - an empty or invalid address is put as none
+     *
+     * \param [in] addr     Printed address
+     * \param [in] isIPv4   True if IPv4, false if IPv6
+     */
+    void putAddr(const char *addr, bool isIPv4) {
+        unsigned char bin[16];
+
+        if (addr[0] != 0 and inet_pton(isIPv4 ? AF_INET : AF_INET6, addr, bin) == 1)
+            putAddr(bin, isIPv4 ? 4 : 16);
+        else
+            putAddr((const unsigned char *)NULL, 0);
+    }
+
+    /**
+     * Put a prefix
+     *
+     * \param [in] addr         Prefix address in network byte order
+     * \param [in] isIPv4       True if IPv4, false if IPv6
+     * \param [in] prefix_len   Prefix length in bits
+     */
+    void putPrefix(const unsigned char *addr, bool isIPv4, uint8_t prefix_len) {
+        uint8_t addr_len = isIPv4 ? 4 : 16;
+
+        if (prefix_len > addr_len * 8)
+            prefix_len = addr_len * 8;
+
+        out.push_back((char)addr_len);
+        out.push_back((char)prefix_len);
+        out.append((const char *)addr, (prefix_len + 7) / 8);
+    }
+
+    void putTime(uint64_t usecs) {
+        putUint(usecs);
+    }
+
+    /**
+     * Append fields already encoded in another buffer
+     */
+    void putFields(const std::string &fields) {
+        out.append(fields);
+    }
+
+    /**
+     * Encode a uint
+     *
+     * \param [in]  value       Value
+     * \param [out] buf         Buffer of at least MSGBUS_V2_UINT_MAX bytes
+     *
+     * \return Length of the encoded uint
+     */
+    static size_t encodeUint(uint64_t value, char *buf) {
+        size_t len = 0;
+
+        while (value >= 0x80) {
+            buf[len++] = (char)(value | 0x80);
+            value >>= 7;
+        }
+        buf[len++] = (char)value;
+
+        return len;
+    }
+
+private:
+    std::string     &out;                       ///< Buffer
+};
+
+/**
+ * \class   MsgBusV2Decoder
+ *
+ * \brief   Reference decoder of binary (2.x) messages
+ * \details Decodes the headers and rows of one message; the message must stay valid while
+ *          the rows are read.
+ */
+class MsgBusV2Decoder {
+public:
+    /**
+     * Decoded field
+     */
+    struct value {
+        uint8_t         type;                   ///< msgbus_v2_type, MSGBUS_V2_NONE if absent
+        uint64_t        num;                    ///< ACTION, UINT, BOOL and TIME value; prefix length of PREFIX
+        std::string     bytes;                  ///< STRING value; HASH, ADDR and PREFIX bytes
+
+        /**
+         * Get the printed form of the value, as in the 1.7 TSV rows
+         */
+        std::string str() const {
+            char buf[64];
+
+            switch (type) {
+                case MSGBUS_V2_ACTION:
+                    return num == MSGBUS_V2_ACTION_ADD ? "add" : num == MSGBUS_V2_ACTION_DEL ? "del" : "";
+
+                case MSGBUS_V2_UINT:
+                case MSGBUS_V2_BOOL:
+                    snprintf(buf, sizeof(buf), "%llu", (unsigned long long)num);
+                    return buf;
+
+                case MSGBUS_V2_HASH: {
+                    static const char hex[] = "0123456789abcdef";
+                    std::string s;
+
+                    for (size_t i=0; i < bytes.size(); i++) {
+                        s.push_back(hex[(uint8_t)bytes[i] >> 4]);
+                        s.push_back(hex[(uint8_t)bytes[i] & 0xf]);
+                    }
+                    return s;
+                }
+
+                case MSGBUS_V2_ADDR:
+                case MSGBUS_V2_PREFIX: {
+                    unsigned char addr[16] = { 0 };
+
+                    if (bytes.empty())
+                        return "";
+
+                    memcpy(addr, bytes.data(), bytes.size());
+                    inet_ntop(bytes.size() == 4 ? AF_INET : AF_INET6, addr, buf, sizeof(buf));
+
+                    if (type == MSGBUS_V2_ADDR)
+                        return buf;
+
+                    std::string s(buf);
+                    snprintf(buf, sizeof(buf), "/%llu", (unsigned long long)num);
+                    return s + buf;
+                }
+
+                case MSGBUS_V2_TIME: {
+                    time_t secs = num / 1000000;
+                    struct tm tm;
+
+                    gmtime_r(&secs, &tm);
+                    size_t len = strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+                    snprintf(buf + len, sizeof(buf) - len, ".%06u", (unsigned)(num % 1000000));
+                    return buf;
+                }
+
+                case MSGBUS_V2_STRING:
+                    return bytes;
+            }
+
+            return "";
+        }
+    };
+
+    MsgBusV2Decoder() : schema(NULL), field_count(0), rows(NULL), rows_end(NULL), row_count(0) {}
+
+    /**
+     * Decode the headers of a message
+     *
+     * \param [in] msg      Message (headers and rows)
+     * \param [in] len      Length of the message
+     *
+     * \return true if the message is a valid 2.x message of a topic with a schema
+     */
+    bool decode(const char *msg, size_t len) {
+        const char *p = msg, *end = msg + len;
+        size_t data_len = 0;
+        bool have_len = false;
+
+        schema = NULL;
+        version.clear();
+        topic.clear();
+        collector_hash.clear();
+        row_count = 0;
+        prev.clear();
+
+        // Headers are "NAME: VALUE" lines up to an empty line
+        while (true) {
+            const char *eol = (const char *)memchr(p, '\n', end - p);
+
+            if (eol == NULL)
+                return false;
+
+            if (eol == p) {
+                p++;
+                break;
+            }
+
+            const char *colon = (const char *)memchr(p, ':', eol - p);
+            if (colon != NULL) {
+                std::string name(p, colon - p);
+                const char *v = colon + 1;
+
+                while (v < eol and *v == ' ')
+                    v++;
+
+                std::string val(v, eol - v);
+
+                for (size_t i=0; i < name.size(); i++)
+                    name[i] = toupper(name[i]);
+
+                if (name == "V")
+                    version = val;
+                else if (name == "T")
+                    topic = val;
+                else if (name == "C_HASH_ID")
+                    collector_hash = val;
+                else if (name == "L") {
+                    data_len = strtoull(val.c_str(), NULL, 10);
+                    have_len = true;
+                } else if (name == "R")
+                    row_count = strtoul(val.c_str(), NULL, 10);
+            }
+
+            p = eol + 1;
+        }
+
+        if (version.compare(0, 2, "2.") != 0 or not have_len or data_len > (size_t)(end - p))
+            return false;
+
+        if ((schema = msgbusV2Schema(topic, field_count)) == NULL)
+            return false;
+
+        rows = (const uint8_t *)p;
+        rows_end = rows + data_len;
+        prev.resize(field_count);
+
+        return true;
+    }
+
+    /**
+     * Get the next row
+     *
+     * \param [out] row     Fields of the row, one per schema field
+     *
+     * \return true if a row was returned, false at the end of the rows or if a row is malformed
+     */
+    bool nextRow(std::vector<value> &row) {
+        uint64_t row_len;
+
+        if (schema == NULL or rows >= rows_end or not getUint(rows, rows_end, row_len)
+                or row_len < 1 or row_len > (uint64_t)(rows_end - rows))
+            return false;
+
+        const uint8_t *p = rows, *end = rows + row_len;
+        uint8_t flags = *p++;
+        rows = end;
+
+        row.resize(field_count);
+
+        for (size_t i=0; i < field_count; i++) {
+            value &v = row[i];
+
+            // Omitted group, same as the last row that included it
+            if ((schema[i].group == MSGBUS_V2_GROUP_PEER and (flags & MSGBUS_V2_ROW_SAME_PEER))
+                    or (schema[i].group == MSGBUS_V2_GROUP_ATTRS and (flags & MSGBUS_V2_ROW_SAME_ATTRS))) {
+                v = prev[i];
+                continue;
+            }
+
+            v.num = 0;
+            v.bytes.clear();
+            v.type = MSGBUS_V2_NONE;
+
+            if (p >= end)
+                continue;                       // Absent
+
+            switch (schema[i].type) {
+                case MSGBUS_V2_ACTION:
+                case MSGBUS_V2_BOOL:
+                    v.num = *p++;
+                    break;
+
+                case MSGBUS_V2_UINT:
+                case MSGBUS_V2_TIME:
+                    if (not getUint(p, end, v.num))
+                        return false;
+                    break;
+
+                case MSGBUS_V2_HASH:
+                    if (end - p < MSGBUS_V2_HASH_SIZE)
+                        return false;
+                    v.bytes.assign((const char *)p, MSGBUS_V2_HASH_SIZE);
+                    p += MSGBUS_V2_HASH_SIZE;
+                    break;
+
+                case MSGBUS_V2_STRING: {
+                    uint64_t len;
+                    if (not getUint(p, end, len) or len > (uint64_t)(end - p))
+                        return false;
+                    v.bytes.assign((const char *)p, len);
+                    p += len;
+                    break;
+                }
+
+                case MSGBUS_V2_ADDR: {
+                    uint8_t len = *p++;
+                    if ((len != 0 and len != 4 and len != 16) or len > end - p)
+                        return false;
+                    v.bytes.assign((const char *)p, len);
+                    p += len;
+                    break;
+                }
+
+                case MSGBUS_V2_PREFIX: {
+                    if (end - p < 2)
+                        return false;
+
+                    uint8_t addr_len = p[0];
+                    v.num = p[1];
+                    p += 2;
+
+                    size_t len = (v.num + 7) / 8;
+                    if ((addr_len != 4 and addr_len != 16) or v.num > addr_len * 8u or len > (size_t)(end - p))
+                        return false;
+
+                    // Address bytes past the prefix length are zero
+                    v.bytes.assign(addr_len, 0);
+                    memcpy(&v.bytes[0], p, len);
+                    p += len;
+                    break;
+                }
+
+                default:
+                    return false;
+            }
+
+            v.type = schema[i].type;
+
+            if (schema[i].group != MSGBUS_V2_GROUP_NONE)
+                prev[i] = v;
+        }
+
+        return true;
+    }
+
+    const msgbus_v2_field *getSchema() const { return schema; }     ///< Fields of the rows
+    size_t getFieldCount() const { return field_count; }            ///< Number of fields of the rows
+    const std::string &getVersion() const { return version; }       ///< V: header
+    const std::string &getTopic() const { return topic; }           ///< T: header
+    const std::string &getCollectorHash() const { return collector_hash; }  ///< C_HASH_ID: header
+    size_t getRowCount() const { return row_count; }                ///< R: header
+
+private:
+    const msgbus_v2_field *schema;              ///< Schema of the topic
+    size_t              field_count;            ///< Number of fields in the schema
+    const uint8_t       *rows;                  ///< Next row
+    const uint8_t       *rows_end;              ///< End of the rows
+    size_t              row_count;              ///< Number of rows
+    std::string         version;                ///< Message version
+    std::string         topic;                  ///< Topic type
+    std::string         collector_hash;         ///< Collector hash
+    std::vector<value>  prev;                   ///< Last values of the group fields in the message
+
+    /**
+     * Read a uint
+     */
+    static bool getUint(const uint8_t *&p, const uint8_t *end, uint64_t &value) {
+        value = 0;
+
+        for (int shift=0; p < end and shift < 64; shift += 7) {
+            uint8_t b = *p++;
+
+            value |= (uint64_t)(b & 0x7f) << shift;
+            if ((b & 0x80) == 0)
+                return true;
+        }
+
+        return false;
+    }
+};
+
+#endif //OPENBMP_MSGBUSV2_H
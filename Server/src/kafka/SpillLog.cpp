@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include <algorithm>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "SpillLog.h"
+
+/**
+ * Round an offset down to the start of its page, for msync()
+ */
+static size_t pageStart(size_t offset) {
+    static size_t page_size = sysconf(_SC_PAGESIZE);
+
+    return offset - (offset % page_size);
+}
+
+/*********************************************************************//**
+ * Constructor for class - opens the log and recovers existing segments
+ *
+ * \param [in] logPtr           Pointer to Logger instance
+ * \param [in] dir              Directory of the segment files, created if missing
+ * \param [in] segment_size     Size of a segment file in bytes
+ * \param [in] max_size         Max size of all segment files in bytes
+ * \param [in] fsync            fsync_policy
+ ***********************************************************************/
+SpillLog::SpillLog(Logger *logPtr, const std::string &dir, size_t segment_size, size_t max_size, int fsync) {
+    std::vector<uint64_t> seqs;
+    DIR *dp;
+    dirent *ent;
+
+    logger = logPtr;
+    this->dir = dir;
+    this->segment_size = segment_size;
+    this->fsync = fsync;
+    max_segments = std::max(max_size / segment_size, (size_t)2);
+    next_seq = 1;
+    count = 0;
+    bytes = 0;
+
+    if (mkdir(dir.c_str(), 0750) != 0 and errno != EEXIST) {
+        LOG_ERR("Failed to create spill directory %s: %s", dir.c_str(), strerror(errno));
+        throw "Failed to create spill directory";
+    }
+
+    if ((dp = opendir(dir.c_str())) == NULL) {
+        LOG_ERR("Failed to open spill directory %s: %s", dir.c_str(), strerror(errno));
+        throw "Failed to open spill directory";
+    }
+
+    // Segment files are named spill-<seq>.seg
+    while ((ent = readdir(dp)) != NULL) {
+        unsigned long long seq;
+        char suffix[8];
+
+        if (sscanf(ent->d_name, "spill-%llu.%7s", &seq, suffix) == 2 and strcmp(suffix, "seg") == 0)
+            seqs.push_back(seq);
+    }
+
+    closedir(dp);
+
+    std::sort(seqs.begin(), seqs.end());
+
+    for (size_t i=0; i < seqs.size(); i++) {
+        segment *seg = openSegment(seqs[i], false);
+
+        if (seg == NULL)
+            throw "Failed to open existing spill segment";
+
+        recoverSegment(seg);
+
+        if (((segment_hdr *)seg->base)->read_offset >= seg->write_offset)
+            closeSegment(seg, true);            // Nothing left to read
+        else
+            segments.push_back(seg);
+
+        next_seq = seqs[i] + 1;
+    }
+
+    first_write_seq = next_seq;
+
+    if (count > 0)
+        LOG_NOTICE("Recovered %lu spilled messages (%lu bytes) in %lu segments from %s",
+                   count, bytes, segments.size(), dir.c_str());
+}
+
+/*********************************************************************//**
+ * Destructor for class - unmaps the segments, deleting fully read segments
+ ***********************************************************************/
+SpillLog::~SpillLog() {
+    while (not segments.empty()) {
+        segment *seg = segments.front();
+        segments.pop_front();
+
+        if (fsync != SPILL_FSYNC_NEVER)
+            msync(seg->base, seg->write_offset, MS_SYNC);
+
+        closeSegment(seg, ((segment_hdr *)seg->base)->read_offset >= seg->write_offset);
+    }
+}
+
+/*********************************************************************//**
+ * Append a message
+ *
+ * \param [in] topic_id         KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+ * \param [in] peer_asn         Peer ASN
+ * \param [in] router_group     Router group name, empty if none
+ * \param [in] peer_group       Peer group name, empty if none
+ * \param [in] key              Message key
+ * \param [in] key_len          Length of key
+ * \param [in] msg              Message (header and body)
+ * \param [in] msg_size         Length of msg
+ *
+ * \return true if appended, false if the log is full (or a segment could not be created)
+ ***********************************************************************/
+bool SpillLog::append(int topic_id, uint32_t peer_asn, const std::string &router_group,
+                      const std::string &peer_group, const char *key, size_t key_len,
+                      const char *msg, size_t msg_size) {
+    size_t len = (sizeof(record_hdr) + key_len + router_group.size() + peer_group.size() + msg_size + 7) & ~(size_t)7;
+
+    if (len > segment_size - SPILL_SEGMENT_HDR_SIZE or key_len > 0xFFFF
+            or router_group.size() > 0xFFFF or peer_group.size() > 0xFFFF)
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    segment *seg = segments.empty() ? NULL : segments.back();
+
+    if (seg == NULL or seg->seq < first_write_seq or seg->write_offset + len > seg->size) {
+        if (segments.size() >= max_segments)
+            return false;
+
+        if ((seg = openSegment(next_seq, true)) == NULL)
+            return false;
+
+        next_seq++;
+        segments.push_back(seg);
+    }
+
+    record_hdr *hdr = (record_hdr *)(seg->base + seg->write_offset);
+    char *data = (char *)(hdr + 1);
+
+    memcpy(data, key, key_len);
+    data += key_len;
+    memcpy(data, router_group.data(), router_group.size());
+    data += router_group.size();
+    memcpy(data, peer_group.data(), peer_group.size());
+    data += peer_group.size();
+    memcpy(data, msg, msg_size);
+
+    hdr->length             = len;
+    hdr->msg_size           = msg_size;
+    hdr->peer_asn           = peer_asn;
+    hdr->topic_id           = topic_id;
+    hdr->key_len            = key_len;
+    hdr->router_group_len   = router_group.size();
+    hdr->peer_group_len     = peer_group.size();
+    hdr->magic              = SPILL_RECORD_MAGIC;   // Record is complete
+
+    if (fsync == SPILL_FSYNC_ALWAYS) {
+        size_t start = pageStart(seg->write_offset);
+        msync(seg->base + start, seg->write_offset + len - start, MS_SYNC);
+        seg->synced_offset = seg->write_offset + len;
+    }
+
+    seg->write_offset += len;
+    count++;
+    bytes += len;
+
+    return true;
+}
+
+/*********************************************************************//**
+ * Get the oldest record without removing it
+ *
+ * \param [out] rec     Record, valid until pop()
+ *
+ * \return true if a record was returned, false if the log is empty
+ ***********************************************************************/
+bool SpillLog::peek(spill_record &rec) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    while (not segments.empty()) {
+        segment *seg = segments.front();
+        size_t read_offset = ((segment_hdr *)seg->base)->read_offset;
+
+        if (read_offset < seg->write_offset) {
+            record_hdr *hdr = (record_hdr *)(seg->base + read_offset);
+            const char *data = (const char *)(hdr + 1);
+
+            rec.topic_id            = hdr->topic_id;
+            rec.peer_asn            = hdr->peer_asn;
+            rec.key                 = data;
+            rec.key_len             = hdr->key_len;
+            rec.router_group        = rec.key + rec.key_len;
+            rec.router_group_len    = hdr->router_group_len;
+            rec.peer_group          = rec.router_group + rec.router_group_len;
+            rec.peer_group_len      = hdr->peer_group_len;
+            rec.msg                 = rec.peer_group + rec.peer_group_len;
+            rec.msg_size            = hdr->msg_size;
+
+            return true;
+        }
+
+        // The segment being written is kept, even if all of its records are read
+        if (segments.size() == 1)
+            break;
+
+        segments.pop_front();
+        closeSegment(seg, true);
+    }
+
+    return false;
+}
+
+/*********************************************************************//**
+ * Remove the record returned by peek()
+ ***********************************************************************/
+void SpillLog::pop() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (segments.empty())
+        return;
+
+    segment *seg = segments.front();
+    segment_hdr *seg_hdr = (segment_hdr *)seg->base;
+
+    if (seg_hdr->read_offset < seg->write_offset) {
+        record_hdr *hdr = (record_hdr *)(seg->base + seg_hdr->read_offset);
+
+        count--;
+        bytes -= hdr->length;
+        seg_hdr->read_offset += hdr->length;
+    }
+}
+
+/*********************************************************************//**
+ * Flush appended records to disk (SPILL_FSYNC_INTERVAL)
+ ***********************************************************************/
+void SpillLog::sync() {
+    std::vector<std::pair<char *, size_t> > ranges;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Read position of the oldest segment
+        if (not segments.empty())
+            ranges.push_back(std::make_pair(segments.front()->base, (size_t)SPILL_SEGMENT_HDR_SIZE));
+
+        for (size_t i=0; i < segments.size(); i++) {
+            segment *seg = segments[i];
+
+            if (seg->synced_offset < seg->write_offset) {
+                size_t start = pageStart(seg->synced_offset);
+
+                ranges.push_back(std::make_pair(seg->base + start, seg->write_offset - start));
+                seg->synced_offset = seg->write_offset;
+            }
+        }
+    }
+
+    // Segments are only unmapped by the reader thread, which is also the caller
+    for (size_t i=0; i < ranges.size(); i++) {
+        if (msync(ranges[i].first, ranges[i].second, MS_SYNC) != 0)
+            LOG_WARN("Failed to sync spill segment: %s", strerror(errno));
+    }
+}
+
+/*********************************************************************//**
+ * Get the number of records in the log
+ ***********************************************************************/
+uint64_t SpillLog::getCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return count;
+}
+
+/*********************************************************************//**
+ * Get the number of bytes used by records in the log
+ ***********************************************************************/
+uint64_t SpillLog::getBytes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes;
+}
+
+/**
+ * Create or open a segment file and map it
+ *
+ * \param [in] seq      Sequence number
+ * \param [in] create   true to create a new segment, false to open an existing one
+ *
+ * \return Segment or NULL on error
+ */
+SpillLog::segment *SpillLog::openSegment(uint64_t seq, bool create) {
+    char name[64];
+    struct stat st;
+    size_t size = segment_size;
+
+    snprintf(name, sizeof(name), "/spill-%020llu.seg", (unsigned long long)seq);
+
+    std::string path = dir + name;
+    int fd = open(path.c_str(), create ? (O_RDWR | O_CREAT | O_EXCL) : O_RDWR, 0640);
+
+    if (fd < 0) {
+        LOG_ERR("Failed to open spill segment %s: %s", path.c_str(), strerror(errno));
+        return NULL;
+    }
+
+    if (create) {
+        // Reserve the disk space now, so that writing to the mapping cannot fail
+        int err = posix_fallocate(fd, 0, size);
+
+        if (err != 0) {
+            LOG_ERR("Failed to allocate spill segment %s: %s", path.c_str(), strerror(err));
+            close(fd);
+            unlink(path.c_str());
+            return NULL;
+        }
+
+    } else {
+        // Existing segments keep their size, which may differ from the configured size
+        if (fstat(fd, &st) != 0 or st.st_size < SPILL_SEGMENT_HDR_SIZE) {
+            LOG_ERR("Invalid spill segment %s", path.c_str());
+            close(fd);
+            return NULL;
+        }
+
+        size = st.st_size;
+    }
+
+    char *base = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (base == MAP_FAILED) {
+        LOG_ERR("Failed to map spill segment %s: %s", path.c_str(), strerror(errno));
+        close(fd);
+
+        if (create)
+            unlink(path.c_str());
+
+        return NULL;
+    }
+
+    segment_hdr *hdr = (segment_hdr *)base;
+
+    if (create) {
+        hdr->magic = SPILL_SEGMENT_MAGIC;
+        hdr->version = 1;
+        hdr->read_offset = SPILL_SEGMENT_HDR_SIZE;
+
+    } else if (hdr->magic != SPILL_SEGMENT_MAGIC or hdr->version != 1
+               or hdr->read_offset < SPILL_SEGMENT_HDR_SIZE or hdr->read_offset > size) {
+        LOG_ERR("Invalid spill segment header %s", path.c_str());
+        munmap(base, size);
+        close(fd);
+        return NULL;
+    }
+
+    segment *seg = new segment;
+    seg->seq = seq;
+    seg->path = path;
+    seg->fd = fd;
+    seg->base = base;
+    seg->size = size;
+    seg->write_offset = SPILL_SEGMENT_HDR_SIZE;
+    seg->synced_offset = SPILL_SEGMENT_HDR_SIZE;
+
+    return seg;
+}
+
+/**
+ * Unmap a segment, optionally deleting its file
+ */
+void SpillLog::closeSegment(segment *seg, bool remove) {
+    munmap(seg->base, seg->size);
+    close(seg->fd);
+
+    if (remove)
+        unlink(seg->path.c_str());
+
+    delete seg;
+}
+
+/**
+ * Recover the write offset, count and bytes of an existing segment
+ *
+ * \details Records are complete once the magic is set, so the scan stops at the first
+ *          record without it (unused space or a record interrupted by a crash).
+ */
+void SpillLog::recoverSegment(segment *seg) {
+    size_t read_offset = ((segment_hdr *)seg->base)->read_offset;
+    size_t offset = SPILL_SEGMENT_HDR_SIZE;
+
+    while (offset + sizeof(record_hdr) <= seg->size) {
+        record_hdr *hdr = (record_hdr *)(seg->base + offset);
+
+        if (hdr->magic != SPILL_RECORD_MAGIC or hdr->length < sizeof(record_hdr)
+                or offset + hdr->length > seg->size)
+            break;
+
+        if (offset >= read_offset) {
+            count++;
+            bytes += hdr->length;
+        }
+
+        offset += hdr->length;
+    }
+
+    seg->write_offset = offset;
+    seg->synced_offset = offset;
+
+    // Do not read past the recovered records
+    if (read_offset > offset)
+        ((segment_hdr *)seg->base)->read_offset = offset;
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef OPENBMP_SPILLLOG_H
+#define OPENBMP_SPILLLOG_H
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <cstdint>
+
+#include "Logger.h"
+
+/**
+ * \class   SpillLog
+ *
+ * \brief   On-disk append log of messages waiting to be produced
+ * \details The log is a sequence of fixed size segment files in a directory.  Each segment
+ *          is memory mapped; records are appended by copying into the mapping and read back
+ *          in the order appended.  A segment is deleted once all of its records are read.
+ *
+ *          The read position is kept in the segment header, so records left in the log are
+ *          recovered by the next instance opened on the directory (for example after a
+ *          restart while Kafka was unavailable).
+ *
+ *          Records are written to the page cache; fsync_policy controls when they are
+ *          flushed to disk.  Disk space for a segment is reserved when it is created.
+ *
+ *          All methods are thread safe.  peek(), pop() and sync() must be called by the same
+ *          (reader) thread.
+ */
+class SpillLog {
+public:
+    /**
+     * When records are flushed to disk
+     */
+    enum fsync_policy {
+        SPILL_FSYNC_NEVER=0,                    ///< Left to the kernel writeback
+        SPILL_FSYNC_INTERVAL,                   ///< By sync(), called periodically by the reader
+        SPILL_FSYNC_ALWAYS                      ///< On every append (slow)
+    };
+
+    /**
+     * Record read from the log - pointers are into the mapping and valid until pop()
+     */
+    struct spill_record {
+        int             topic_id;               ///< KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+        uint32_t        peer_asn;               ///< Peer ASN
+        const char      *key;                   ///< Message key
+        size_t          key_len;
+        const char      *router_group;          ///< Router group name
+        size_t          router_group_len;
+        const char      *peer_group;            ///< Peer group name
+        size_t          peer_group_len;
+        const char      *msg;                   ///< Message (header and body)
+        size_t          msg_size;
+    };
+
+    /*********************************************************************//**
+     * Constructor for class - opens the log and recovers existing segments
+     *
+     * \param [in] logPtr           Pointer to Logger instance
+     * \param [in] dir              Directory of the segment files, created if missing
+     * \param [in] segment_size     Size of a segment file in bytes
+     * \param [in] max_size         Max size of all segment files in bytes
+     * \param [in] fsync            fsync_policy
+     *
+     * \throws char const* if the directory or an existing segment cannot be opened
+     ***********************************************************************/
+    SpillLog(Logger *logPtr, const std::string &dir, size_t segment_size, size_t max_size, int fsync);
+
+    /*********************************************************************//**
+     * Destructor for class - unmaps the segments, deleting fully read segments
+     ***********************************************************************/
+    ~SpillLog();
+
+    /*********************************************************************//**
+     * Append a message
+     *
+     * \param [in] topic_id         KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+     * \param [in] peer_asn         Peer ASN
+     * \param [in] router_group     Router group name, empty if none
+     * \param [in] peer_group       Peer group name, empty if none
+     * \param [in] key              Message key
+     * \param [in] key_len          Length of key
+     * \param [in] msg              Message (header and body)
+     * \param [in] msg_size         Length of msg
+     *
+     * \return true if appended, false if the log is full (or a segment could not be created)
+     ***********************************************************************/
+    bool append(int topic_id, uint32_t peer_asn, const std::string &router_group, const std::string &peer_group,
+                const char *key, size_t key_len, const char *msg, size_t msg_size);
+
+    /*********************************************************************//**
+     * Get the oldest record without removing it
+     *
+     * \param [out] rec     Record, valid until pop()
+     *
+     * \return true if a record was returned, false if the log is empty
+     ***********************************************************************/
+    bool peek(spill_record &rec);
+
+    /*********************************************************************//**
+     * Remove the record returned by peek()
+     ***********************************************************************/
+    void pop();
+
+    /*********************************************************************//**
+     * Flush appended records to disk (SPILL_FSYNC_INTERVAL)
+     ***********************************************************************/
+    void sync();
+
+    /*********************************************************************//**
+     * Get the number of records in the log
+     ***********************************************************************/
+    uint64_t getCount();
+
+    /*********************************************************************//**
+     * Get the number of bytes used by records in the log
+     ***********************************************************************/
+    uint64_t getBytes();
+
+private:
+    #define SPILL_SEGMENT_MAGIC     0x4f425350  ///< "OBSP" - segment header magic
+    #define SPILL_RECORD_MAGIC      0x4f425352  ///< "OBSR" - record header magic
+    #define SPILL_SEGMENT_HDR_SIZE  64          ///< Records start after the segment header
+
+    /**
+     * Segment file header
+     */
+    struct segment_hdr {
+        uint32_t        magic;                  ///< SPILL_SEGMENT_MAGIC
+        uint32_t        version;                ///< Format version, 1
+        uint64_t        read_offset;            ///< Offset of the next record to read
+    };
+
+    /**
+     * Record header - followed by the key, router group, peer group and message, padded to 8 bytes
+     */
+    struct record_hdr {
+        uint32_t        magic;                  ///< SPILL_RECORD_MAGIC, written last
+        uint32_t        length;                 ///< Length of the record including header and padding
+        uint32_t        msg_size;               ///< Length of the message
+        uint32_t        peer_asn;               ///< Peer ASN
+        uint16_t        topic_id;               ///< KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+        uint16_t        key_len;                ///< Length of the key
+        uint16_t        router_group_len;       ///< Length of the router group name
+        uint16_t        peer_group_len;         ///< Length of the peer group name
+    };
+
+    /**
+     * Mapped segment file
+     */
+    struct segment {
+        uint64_t        seq;                    ///< Sequence number, from the file name
+        std::string     path;                   ///< File path
+        int             fd;                     ///< File descriptor
+        char            *base;                  ///< Mapping of the file
+        size_t          size;                   ///< Size of the file
+        size_t          write_offset;           ///< Offset of the next record to write
+        size_t          synced_offset;          ///< Offset up to which the records are flushed
+    };
+
+    Logger          *logger;                    ///< Logging class pointer
+    std::string     dir;                        ///< Segment directory
+    size_t          segment_size;               ///< Size of a segment file
+    size_t          max_segments;               ///< Max number of segment files
+    int             fsync;                      ///< fsync_policy
+
+    std::mutex      mutex;                      ///< Protects the segments and counters
+    std::deque<segment *> segments;             ///< Segments, oldest (read) first and newest (write) last
+    uint64_t        next_seq;                   ///< Sequence number of the next segment
+    uint64_t        first_write_seq;            ///< First segment appended to - recovered segments are read only
+    uint64_t        count;                      ///< Records in the log
+    uint64_t        bytes;                      ///< Record bytes in the log
+
+    /**
+     * Create or open a segment file and map it
+     *
+     * \param [in] seq      Sequence number
+     * \param [in] create   true to create a new segment, false to open an existing one
+     *
+     * \return Segment or NULL on error
+     */
+    segment *openSegment(uint64_t seq, bool create);
+
+    /**
+     * Unmap a segment, optionally deleting its file
+     */
+    void closeSegment(segment *seg, bool remove);
+
+    /**
+     * Recover the write offset, count and bytes of an existing segment
+     */
+    void recoverSegment(segment *seg);
+};
+
+#endif //OPENBMP_SPILLLOG_H
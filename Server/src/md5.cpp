@@ -255,6 +255,32 @@ unsigned char *MD5::raw_digest(){
 
 
 
+// Copy the 16-byte binary digest to the caller's buffer.  Unlike
+// raw_digest(), nothing is allocated.
+
+void MD5::raw_digest(unsigned char *dest){
+
+  if (!finalized){
+    cerr << "MD5::raw_digest:  Can't get digest if you haven't "<<
+      "finalized the digest!" <<endl;
+    memset(dest, 0, 16);
+    return;
+  }
+
+  memcpy(dest, digest, 16);
+}
+
+
+
+// Reinitialize the context so that it can be used for a new digest.
+
+void MD5::reset(){
+
+  init();
+}
+
+
+
 char *MD5::hex_digest(){
 
   int i;
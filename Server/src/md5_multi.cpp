@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MD5_MULTI_X86
+#endif
+
+#include "md5_multi.h"
+#include "md5.h"
+
+#define MD5_MULTI_LANES_MAX         8           ///< Max lanes of any implementation
+
+/**
+ * Lane implementation - hashes up to lanes messages of at most MD5_MULTI_MAX_LEN bytes
+ *
+ * \param [in]  msgs         Array of n message pointers
+ * \param [in]  lens         Array of n message lengths in bytes
+ * \param [in]  n            Number of messages, must not be larger than the lanes of the implementation
+ * \param [out] digests      Array of n pointers to 16 byte digest buffers
+ */
+typedef void (*md5_lanes_fn)(const unsigned char * const *msgs, const size_t *lens, int n,
+                             unsigned char * const *digests);
+
+/**
+ * Selected implementation
+ */
+struct md5_multi_impl {
+    const char      *name;                      ///< Name of the implementation
+    int             lanes;                      ///< Number of messages hashed at once
+    md5_lanes_fn    fn;                         ///< Lane function, NULL for scalar
+};
+
+/**
+ * Hash a single message using the scalar MD5 class
+ *
+ * \param [in]  msg          Message
+ * \param [in]  len          Length of the message in bytes
+ * \param [out] digest       16 byte digest buffer
+ */
+static void scalarDigest(const unsigned char *msg, size_t len, unsigned char *digest) {
+    MD5 hash;
+
+    hash.update(const_cast<unsigned char *>(msg), len);
+    hash.finalize();
+    hash.raw_digest(digest);
+}
+
+#ifdef MD5_MULTI_X86
+
+static const uint32_t md5_k[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391 };
+
+static const int md5_s[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21 };
+
+static const int md5_x[64] = {
+    0, 1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
+    1, 6, 11,  0,  5, 10, 15,  4,  9, 14,  3,  8, 13,  2,  7, 12,
+    5, 8, 11, 14,  1,  4,  7, 10, 13,  0,  3,  6,  9, 12, 15,  2,
+    0, 7, 14,  5, 12,  3, 10,  1,  8, 15,  6, 13,  4, 11,  2,  9 };
+
+/**
+ * Pad a message as MD5 does (0x80, zeros, 64 bit length in bits)
+ *
+ * \param [in]  msg          Message
+ * \param [in]  len          Length of the message in bytes, at most MD5_MULTI_MAX_LEN
+ * \param [out] blocks       Buffer of MD5_MULTI_MAX_BLOCKS * 64 bytes
+ *
+ * \return Number of 64 byte blocks
+ */
+static int padMessage(const unsigned char *msg, size_t len, unsigned char *blocks) {
+    int nblocks = (int)((len + 8) / 64 + 1);
+    size_t total = nblocks * 64;
+    uint64_t bits = (uint64_t)len << 3;
+
+    memcpy(blocks, msg, len);
+    blocks[len] = 0x80;
+    memset(blocks + len + 1, 0, total - len - 1 - 8);
+
+    for (int i = 0; i < 8; i++)
+        blocks[total - 8 + i] = (unsigned char)(bits >> (8 * i));
+
+    return nblocks;
+}
+
+/**
+ * Load a little endian 32 bit word
+ */
+static inline uint32_t load32(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * MD5 round functions in terms of the V_* vector operations, which are defined
+ * per implementation below.  Each lane of a vector holds the word of a different message.
+ */
+#define V_F(b, c, d)    V_OR(V_AND(b, c), V_ANDNOT(b, d))
+#define V_G(b, c, d)    V_OR(V_AND(b, d), V_ANDNOT(d, c))
+#define V_H(b, c, d)    V_XOR(V_XOR(b, c), d)
+#define V_I(b, c, d)    V_XOR(c, V_OR(b, V_XOR(d, V_SET1(0xffffffff))))
+
+#define V_ROTL(v, s)    V_OR(V_SLL(v, s), V_SRL(v, 32 - (s)))
+
+#define MD5_MULTI_ROUND(FN, start)                                                      \
+    for (int i = start; i < start + 16; i++) {                                          \
+        VEC t = V_ADD(V_ADD(a, FN(b, c, d)), V_ADD(x[md5_x[i]], V_SET1(md5_k[i])));     \
+        a = d;                                                                          \
+        d = c;                                                                          \
+        c = b;                                                                          \
+        b = V_ADD(b, V_ROTL(t, md5_s[i]));                                              \
+    }
+
+/*
+ * Body of a lane function.  Messages are padded, then each block is transposed so
+ * that a vector holds the same word of every lane.  Lanes that have no more blocks
+ * keep their state by masking the update.
+ */
+#define MD5_MULTI_LANES_BODY                                                            \
+    unsigned char blocks[LANES][MD5_MULTI_MAX_BLOCKS * 64];                             \
+    int nblocks[LANES];                                                                 \
+    int max_blocks = 0;                                                                 \
+                                                                                        \
+    for (int l = 0; l < LANES; l++) {                                                   \
+        nblocks[l] = l < n ? padMessage(msgs[l], lens[l], blocks[l]) : 0;               \
+        if (nblocks[l] > max_blocks)                                                    \
+            max_blocks = nblocks[l];                                                    \
+    }                                                                                   \
+                                                                                        \
+    VEC a = V_SET1(0x67452301);                                                         \
+    VEC b = V_SET1(0xefcdab89);                                                         \
+    VEC c = V_SET1(0x98badcfe);                                                         \
+    VEC d = V_SET1(0x10325476);                                                         \
+                                                                                        \
+    for (int blk = 0; blk < max_blocks; blk++) {                                        \
+        uint32_t words[LANES];                                                          \
+        VEC x[16];                                                                      \
+                                                                                        \
+        for (int w = 0; w < 16; w++) {                                                  \
+            for (int l = 0; l < LANES; l++)                                             \
+                words[l] = blk < nblocks[l] ? load32(blocks[l] + blk * 64 + w * 4) : 0; \
+            x[w] = V_LOAD(words);                                                       \
+        }                                                                               \
+                                                                                        \
+        for (int l = 0; l < LANES; l++)                                                 \
+            words[l] = blk < nblocks[l] ? 0xffffffff : 0;                               \
+        VEC mask = V_LOAD(words);                                                       \
+                                                                                        \
+        VEC aa = a, bb = b, cc = c, dd = d;                                             \
+                                                                                        \
+        MD5_MULTI_ROUND(V_F, 0)                                                         \
+        MD5_MULTI_ROUND(V_G, 16)                                                        \
+        MD5_MULTI_ROUND(V_H, 32)                                                        \
+        MD5_MULTI_ROUND(V_I, 48)                                                        \
+                                                                                        \
+        a = V_OR(V_AND(mask, V_ADD(a, aa)), V_ANDNOT(mask, aa));                        \
+        b = V_OR(V_AND(mask, V_ADD(b, bb)), V_ANDNOT(mask, bb));                        \
+        c = V_OR(V_AND(mask, V_ADD(c, cc)), V_ANDNOT(mask, cc));                        \
+        d = V_OR(V_AND(mask, V_ADD(d, dd)), V_ANDNOT(mask, dd));                        \
+    }                                                                                   \
+                                                                                        \
+    uint32_t state[4][LANES];                                                           \
+    V_STORE(state[0], a);                                                               \
+    V_STORE(state[1], b);                                                               \
+    V_STORE(state[2], c);                                                               \
+    V_STORE(state[3], d);                                                               \
+                                                                                        \
+    for (int l = 0; l < n; l++) {                                                       \
+        for (int i = 0; i < 4; i++) {                                                   \
+            digests[l][i * 4]     = (unsigned char)(state[i][l]);                       \
+            digests[l][i * 4 + 1] = (unsigned char)(state[i][l] >> 8);                  \
+            digests[l][i * 4 + 2] = (unsigned char)(state[i][l] >> 16);                 \
+            digests[l][i * 4 + 3] = (unsigned char)(state[i][l] >> 24);                 \
+        }                                                                               \
+    }
+
+/*
+ * SSE2 - 4 lanes
+ */
+#define VEC             __m128i
+#define LANES           4
+#define V_SET1(v)       _mm_set1_epi32((int)(v))
+#define V_LOAD(p)       _mm_loadu_si128((const __m128i *)(p))
+#define V_STORE(p, v)   _mm_storeu_si128((__m128i *)(p), v)
+#define V_ADD(x, y)     _mm_add_epi32(x, y)
+#define V_AND(x, y)     _mm_and_si128(x, y)
+#define V_OR(x, y)      _mm_or_si128(x, y)
+#define V_XOR(x, y)     _mm_xor_si128(x, y)
+#define V_ANDNOT(x, y)  _mm_andnot_si128(x, y)
+#define V_SLL(v, s)     _mm_sll_epi32(v, _mm_cvtsi32_si128(s))
+#define V_SRL(v, s)     _mm_srl_epi32(v, _mm_cvtsi32_si128(s))
+
+__attribute__ ((target ("sse2")))
+static void md5LanesSse2(const unsigned char * const *msgs, const size_t *lens, int n,
+                         unsigned char * const *digests) {
+    MD5_MULTI_LANES_BODY
+}
+
+#undef VEC
+#undef LANES
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_AND
+#undef V_OR
+#undef V_XOR
+#undef V_ANDNOT
+#undef V_SLL
+#undef V_SRL
+
+/*
+ * AVX2 - 8 lanes
+ */
+#define VEC             __m256i
+#define LANES           8
+#define V_SET1(v)       _mm256_set1_epi32((int)(v))
+#define V_LOAD(p)       _mm256_loadu_si256((const __m256i *)(p))
+#define V_STORE(p, v)   _mm256_storeu_si256((__m256i *)(p), v)
+#define V_ADD(x, y)     _mm256_add_epi32(x, y)
+#define V_AND(x, y)     _mm256_and_si256(x, y)
+#define V_OR(x, y)      _mm256_or_si256(x, y)
+#define V_XOR(x, y)     _mm256_xor_si256(x, y)
+#define V_ANDNOT(x, y)  _mm256_andnot_si256(x, y)
+#define V_SLL(v, s)     _mm256_sll_epi32(v, _mm_cvtsi32_si128(s))
+#define V_SRL(v, s)     _mm256_srl_epi32(v, _mm_cvtsi32_si128(s))
+
+__attribute__ ((target ("avx2")))
+static void md5LanesAvx2(const unsigned char * const *msgs, const size_t *lens, int n,
+                         unsigned char * const *digests) {
+    MD5_MULTI_LANES_BODY
+}
+
+#undef VEC
+#undef LANES
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_AND
+#undef V_OR
+#undef V_XOR
+#undef V_ANDNOT
+#undef V_SLL
+#undef V_SRL
+
+#endif /* MD5_MULTI_X86 */
+
+/**
+ * Select the implementation based on the CPU features
+ */
+static md5_multi_impl detectImpl() {
+    md5_multi_impl impl = { "scalar", 1, NULL };
+
+#ifdef MD5_MULTI_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        impl.name = "avx2";
+        impl.lanes = 8;
+        impl.fn = md5LanesAvx2;
+
+    } else if (__builtin_cpu_supports("sse2")) {
+        impl.name = "sse2";
+        impl.lanes = 4;
+        impl.fn = md5LanesSse2;
+    }
+#endif
+
+    return impl;
+}
+
+/**
+ * Get the implementation - detected once on first use
+ */
+static const md5_multi_impl &getImpl() {
+    static const md5_multi_impl impl = detectImpl();
+    return impl;
+}
+
+/**
+ * Compute the MD5 digest of each message
+ *
+ * \param [in]  msgs         Array of count message pointers
+ * \param [in]  lens         Array of count message lengths in bytes
+ * \param [in]  count        Number of messages
+ * \param [out] digests      Array of count pointers to 16 byte digest buffers
+ */
+void MD5Multi::digest(const unsigned char * const *msgs, const size_t *lens, size_t count,
+                      unsigned char * const *digests) {
+    const md5_multi_impl &impl = getImpl();
+
+    const unsigned char *lane_msgs[MD5_MULTI_LANES_MAX];
+    size_t              lane_lens[MD5_MULTI_LANES_MAX];
+    unsigned char       *lane_digests[MD5_MULTI_LANES_MAX];
+    int                 n = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (impl.fn == NULL or lens[i] > MD5_MULTI_MAX_LEN) {
+            scalarDigest(msgs[i], lens[i], digests[i]);
+            continue;
+        }
+
+        lane_msgs[n] = msgs[i];
+        lane_lens[n] = lens[i];
+        lane_digests[n] = digests[i];
+
+        if (++n == impl.lanes) {
+            impl.fn(lane_msgs, lane_lens, n, lane_digests);
+            n = 0;
+        }
+    }
+
+    // Remaining messages - a single message is faster with the scalar MD5
+    if (n == 1)
+        scalarDigest(lane_msgs[0], lane_lens[0], lane_digests[0]);
+    else if (n > 1)
+        impl.fn(lane_msgs, lane_lens, n, lane_digests);
+}
+
+/**
+ * Get the name of the implementation selected for this CPU
+ *
+ * \return "avx2", "sse2" or "scalar"
+ */
+const char *MD5Multi::implementation() {
+    return getImpl().name;
+}
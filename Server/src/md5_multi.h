@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef MD5_MULTI_H_
+#define MD5_MULTI_H_
+
+#include <cstddef>
+
+#define MD5_MULTI_MAX_BLOCKS        4           ///< Max 64 byte blocks per message hashed in a lane
+#define MD5_MULTI_MAX_LEN           (MD5_MULTI_MAX_BLOCKS * 64 - 9)     ///< Max message length hashed in a lane
+
+/**
+ * \class   MD5Multi
+ *
+ * \brief   Multi-buffer MD5 - hashes several independent messages at once
+ * \details Each SIMD lane hashes a different message.  AVX2 (8 lanes) or SSE2 (4 lanes)
+ *          is selected at runtime based on the CPU.  The scalar MD5 class is used when
+ *          neither is available and for messages longer than MD5_MULTI_MAX_LEN.
+ *
+ *          Digests are identical to those of the MD5 class.
+ */
+class MD5Multi {
+public:
+    /**
+     * Compute the MD5 digest of each message
+     *
+     * \param [in]  msgs         Array of count message pointers
+     * \param [in]  lens         Array of count message lengths in bytes
+     * \param [in]  count        Number of messages
+     * \param [out] digests      Array of count pointers to 16 byte digest buffers
+     */
+    static void digest(const unsigned char * const *msgs, const size_t *lens, size_t count,
+                       unsigned char * const *digests);
+
+    /**
+     * Get the name of the implementation selected for this CPU
+     *
+     * \return "avx2", "sse2" or "scalar"
+     */
+    static const char *implementation();
+};
+
+#endif /* MD5_MULTI_H_ */
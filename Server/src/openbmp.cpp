@@ -19,6 +19,13 @@
 #include "MsgBusImpl_kafka.h"
 #include "MsgBusInterface.hpp"
 #include "client_thread.h"
+#include "BMPReactor.h"
+#include "DnsResolver.h"
+#include "KafkaProducerService.h"
+#include "NullSink.h"
+#include "FileSink.h"
+#include "UnixSocketSink.h"
+#include "ShmRingSink.h"
 #include "openbmpd_version.h"
 #include "Config.h"
 
@@ -27,7 +34,8 @@
 #include <csignal>
 #include <cstring>
 #include <sys/stat.h>
-#include "md5.h"
+#include "hash_id.h"
+#include "md5_multi.h"
 
 using namespace std;
 
@@ -155,7 +163,8 @@ void signal_handler(int signum)
         case SIGCHLD : // Handle the child cleanup
 
             for (size_t i=0; i < thr_list.size(); i++) {
-                if (thr_list.at(i)->running) {
+                // Reactor connections do not have a thread to cancel
+                if (thr_list.at(i)->running and not thr_list.at(i)->cfg->reactor_mode) {
                     pthread_cancel(thr_list.at(i)->thr);
                     thr_list.at(i)->running = false;
                     pthread_join(thr_list.at(i)->thr, NULL);
@@ -399,7 +408,10 @@ void collector_update_msg(msgBus_kafka *kafka, Config &cfg,
  * \param [in]  cfg    Reference to the config options
  */
 void runServer(Config &cfg) {
+    MsgBusSink *producer;
+    DnsResolver *resolver;
     msgBus_kafka *kafka;
+    BMPReactor *reactor = NULL;
     int active_connections = 0;                 // Number of active connections/threads
     int concurrent_routers = 0;			// Number of concurrent routers
     time_t last_heartbeat_time = 0;
@@ -407,18 +419,60 @@ void runServer(Config &cfg) {
     LOG_INFO("Initializing server");
 
     try {
+        // Select the hash_id algorithm before any hash is generated
+        HashId::setAlgorithm((HashId::algorithm)cfg.hash_algorithm);
+
+        if (cfg.hash_algorithm == HashId::HASH_ALG_MD5)
+            LOG_INFO("Using md5 hash IDs, %s multi-buffer MD5 for prefix hashes", MD5Multi::implementation());
+        else
+            LOG_INFO("Using %s hash IDs", HashId::algorithmName());
+
         // Define the collector hash
-        MD5 hash;
+        HashId hash;
         hash.update((unsigned char *)cfg.admin_id, strlen(cfg.admin_id));
         hash.finalize();
 
         // Save the hash
-        unsigned char *hash_raw = hash.raw_digest();
-        memcpy(cfg.c_hash_id, hash_raw, 16);
-        delete[] hash_raw;
+        hash.raw_digest(cfg.c_hash_id);
+
+        // Message bus sink (Kafka connection) - shared by the collector and all router threads
+        switch (cfg.sink_type) {
+            case MsgBusSink::SINK_NULL:
+                LOG_INFO("Using null sink, messages are dropped");
+                producer = new NullSink(logger, &cfg);
+                break;
+
+            case MsgBusSink::SINK_FILE:
+                producer = new FileSink(logger, &cfg);
+                break;
+
+            case MsgBusSink::SINK_UNIX:
+                producer = new UnixSocketSink(logger, &cfg);
+                break;
+
+            case MsgBusSink::SINK_SHM:
+                producer = new ShmRingSink(logger, &cfg);
+                break;
+
+            default: {
+                KafkaProducerService *kafka_producer = new KafkaProducerService(logger, &cfg);
+
+                if (cfg.debug_msgbus)
+                    kafka_producer->enableDebug();
+
+                producer = kafka_producer;
+                break;
+            }
+        }
+
+        // Reverse DNS lookups - shared by all routers so names are resolved and cached once
+        resolver = new DnsResolver(logger, &cfg);
 
-        // Kafka connection
-        kafka = new msgBus_kafka(logger, &cfg, cfg.c_hash_id);
+        kafka = new msgBus_kafka(logger, &cfg, producer, resolver, cfg.c_hash_id);
+
+        // Start the reactor and parser threads when not using a thread per router
+        if (cfg.reactor_mode)
+            reactor = new BMPReactor(logger, &cfg, producer, resolver);
 
         // allocate and start a new bmp server
         BMPListener *bmp_svr = new BMPListener(logger, &cfg);
@@ -439,7 +493,8 @@ void runServer(Config &cfg) {
                 if (!thr_list.at(i)->running) {
 
                     // Join the thread to clean up
-                    pthread_join(thr_list.at(i)->thr, NULL);
+                    if (not cfg.reactor_mode)
+                        pthread_join(thr_list.at(i)->thr, NULL);
                     --active_connections;
 
                     if (!thr_list.at(i)->baselineTimeout)
@@ -481,10 +536,12 @@ void runServer(Config &cfg) {
              */
             if(concurrent_routers < cfg.max_concurrent_routers)
             {
-                if (active_connections <= MAX_THREADS) {
+                if (cfg.reactor_mode or active_connections <= MAX_THREADS) {
                     ThreadMgmt *thr = new ThreadMgmt;
                     thr->cfg = &cfg;
                     thr->log = logger;
+                    thr->producer = producer;
+                    thr->resolver = resolver;
 
                     // wait for a new connection and accept
                     if (bmp_svr->wait_and_accept_connection(thr->client, 500)) {
@@ -495,29 +552,36 @@ void runServer(Config &cfg) {
                         ++concurrent_routers;
                         LOG_INFO("Accepted new connection; active connections = %d", active_connections);
 
-                        /*
-                         * Start a new thread for every new router connection
-                         */
                         LOG_INFO("Client Connected => %s:%s, sock = %d",
                                  thr->client.c_ip, thr->client.c_port, thr->client.c_sock);
 
-                        pthread_attr_t thr_attr;            // thread attribute
-                        pthread_attr_init(&thr_attr);
-                        //pthread_attr_setdetachstate(&thr.thr_attr, PTHREAD_CREATE_DETACHED);
-                        pthread_attr_setdetachstate(&thr_attr, PTHREAD_CREATE_JOINABLE);
                         thr->running = 1;
                         thr->baselineTimeout = false;
 
-                        // Start the thread to handle the client connection
-                        pthread_create(&thr->thr, &thr_attr,
-                                       ClientThread, thr);
+                        if (cfg.reactor_mode) {
+                            // Hand the connection to the reactor
+                            reactor->addConnection(&thr->client, &thr->running);
+
+                        } else {
+                            /*
+                             * Start a new thread for every new router connection
+                             */
+                            pthread_attr_t thr_attr;            // thread attribute
+                            pthread_attr_init(&thr_attr);
+                            //pthread_attr_setdetachstate(&thr.thr_attr, PTHREAD_CREATE_DETACHED);
+                            pthread_attr_setdetachstate(&thr_attr, PTHREAD_CREATE_JOINABLE);
+
+                            // Start the thread to handle the client connection
+                            pthread_create(&thr->thr, &thr_attr,
+                                           ClientThread, thr);
+
+                            // Free attribute
+                            pthread_attr_destroy(&thr_attr);
+                        }
 
                         // Add thread to vector
                         thr_list.insert(thr_list.end(), thr);
 
-                        // Free attribute
-                        pthread_attr_destroy(&thr_attr);
-
                         collector_update_msg(kafka, cfg,
                                              MsgBusInterface::COLLECTOR_ACTION_CHANGE);
 
@@ -543,7 +607,13 @@ void runServer(Config &cfg) {
 	    }
 
         collector_update_msg(kafka, cfg, MsgBusInterface::COLLECTOR_ACTION_STOPPED);
+
+        if (reactor != NULL)
+            delete reactor;
+
         delete kafka;
+        delete resolver;
+        delete producer;
 
     } catch (char const *str) {
         LOG_WARN(str);
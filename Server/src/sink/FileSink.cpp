@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "FileSink.h"
+
+/*********************************************************************//**
+ * Constructor for class - opens (appends to) the file
+ *
+ * \param [in] logPtr   Pointer to Logger instance
+ * \param [in] cfg      Pointer to the config instance
+ *
+ * \throws char const* if the file cannot be opened
+ ***********************************************************************/
+FileSink::FileSink(Logger *logPtr, Config *cfg) : LocalSink(logPtr, cfg, "file") {
+    path = cfg->sink_file_path;
+    rotate_bytes = (size_t)cfg->sink_file_rotate_mbytes << 20;
+    rotate_count = cfg->sink_file_rotate_count;
+    fd = -1;
+    size = 0;
+
+    if (not openFile())
+        throw "ERROR: Failed to open the sink file";
+
+    LOG_INFO("Writing messages to %s", path.c_str());
+}
+
+FileSink::~FileSink() {
+    if (fd >= 0)
+        close(fd);
+}
+
+/**
+ * Open the file for append - mutex must be held
+ *
+ * \return true if opened, false on error
+ */
+bool FileSink::openFile() {
+    struct stat st;
+
+    if ((fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)) < 0) {
+        LOG_ERR("Failed to open sink file %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    size = fstat(fd, &st) == 0 ? st.st_size : 0;
+
+    return true;
+}
+
+/**
+ * Rotate the file and open a new one - mutex must be held
+ */
+void FileSink::rotate() {
+    char from[PATH_MAX], to[PATH_MAX];
+
+    close(fd);
+    fd = -1;
+
+    // The oldest file is replaced by the rename
+    for (int i=rotate_count - 1; i > 0; i--) {
+        snprintf(from, sizeof(from), "%s.%d", path.c_str(), i);
+        snprintf(to, sizeof(to), "%s.%d", path.c_str(), i + 1);
+        rename(from, to);
+    }
+
+    snprintf(to, sizeof(to), "%s.1", path.c_str());
+    if (rename(path.c_str(), to) != 0)
+        LOG_WARN("Failed to rotate sink file %s: %s", path.c_str(), strerror(errno));
+
+    SELF_DEBUG("Rotated sink file %s", path.c_str());
+
+    openFile();
+}
+
+bool FileSink::write(const std::string &topic, const char *key, size_t key_len,
+                     const char *msg, size_t msg_size) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Retry opening if a rotation failed to open the new file
+    if (fd < 0 and not openFile())
+        return false;
+
+    ssize_t n = writeFrame(fd, false, topic, key, key_len, msg, msg_size);
+
+    if (n < 0) {
+        LOG_ERR("Failed to write to sink file %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    size += n;
+
+    if (size >= rotate_bytes)
+        rotate();
+
+    return true;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef OPENBMP_FILESINK_H
+#define OPENBMP_FILESINK_H
+
+#include <string>
+#include <mutex>
+
+#include "LocalSink.h"
+
+/**
+ * \class   FileSink
+ *
+ * \brief   Sink that appends the messages as frames (see LocalSink) to a rotating file
+ * \details Once the file reaches the rotate size it is renamed to <path>.1, the previous
+ *          <path>.1 to <path>.2 and so on; files beyond the rotate count are removed.
+ */
+class FileSink : public LocalSink {
+public:
+    /*********************************************************************//**
+     * Constructor for class - opens (appends to) the file
+     *
+     * \param [in] logPtr   Pointer to Logger instance
+     * \param [in] cfg      Pointer to the config instance
+     *
+     * \throws char const* if the file cannot be opened
+     ***********************************************************************/
+    FileSink(Logger *logPtr, Config *cfg);
+
+    ~FileSink();
+
+protected:
+    bool write(const std::string &topic, const char *key, size_t key_len,
+               const char *msg, size_t msg_size);
+
+private:
+    std::string     path;                       ///< File path
+    size_t          rotate_bytes;               ///< Size at which the file is rotated
+    int             rotate_count;               ///< Number of rotated files kept
+
+    std::mutex      mutex;                      ///< Serializes writes and rotation
+    int             fd;                         ///< File descriptor, -1 if not open
+    size_t          size;                       ///< Current size of the file
+
+    /**
+     * Open the file for append - mutex must be held
+     *
+     * \return true if opened, false on error
+     */
+    bool openFile();
+
+    /**
+     * Rotate the file and open a new one - mutex must be held
+     */
+    void rotate();
+};
+
+#endif //OPENBMP_FILESINK_H
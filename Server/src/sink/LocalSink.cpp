@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "LocalSink.h"
+
+/*********************************************************************//**
+ * Constructor for class
+ *
+ * \param [in] logPtr   Pointer to Logger instance
+ * \param [in] cfg      Pointer to the config instance
+ * \param [in] name     Sink name for logging
+ ***********************************************************************/
+LocalSink::LocalSink(Logger *logPtr, Config *cfg, const char *name) : MsgBusSink(cfg) {
+    logger = logPtr;
+    this->cfg = cfg;
+    this->name = name;
+    debug = cfg->debug_msgbus;
+
+    selector = new KafkaTopicSelector(logger, cfg, NULL);
+
+    sent_msgs = 0;
+    sent_bytes = 0;
+    dropped = 0;
+    last_msgs = 0;
+    last_stats = time(NULL);
+    next_stats = last_stats + LOCAL_SINK_STATS_INTERVAL;
+}
+
+LocalSink::~LocalSink() {
+    LOG_INFO("%s sink: sent %lu messages/%lu bytes, dropped %lu messages", name,
+             (uint64_t)sent_msgs, (uint64_t)sent_bytes, (uint64_t)dropped);
+
+    delete selector;
+}
+
+/*********************************************************************//**
+ * Produce message - See MsgBusSink::produce()
+ *
+ * \details The topic handles in cache are the resolved topic names (std::string).
+ ***********************************************************************/
+void LocalSink::produce(int topic_id, topic_cache &cache,
+                        const std::string *router_group, const std::string *peer_group,
+                        uint32_t peer_asn, const std::string &key,
+                        pool_buffer *buf, const char *msg, size_t msg_size,
+                        const std::string &router_ip) {
+
+    // Names are never removed, so resolved names remain valid
+    if (cache.generation == 0) {
+        bzero(cache.topics, sizeof(cache.topics));
+        cache.generation = 1;
+    }
+
+    if (cache.topics[topic_id] == NULL) {
+        std::lock_guard<std::mutex> lock(names_mutex);
+
+        std::string topic = selector->getTopicName(KafkaTopicSelector::topic_vars[topic_id], router_group,
+                                                   peer_group, peer_asn);
+        cache.topics[topic_id] = (void *)&(*names.insert(topic).first);
+    }
+
+    const std::string &topic = *(const std::string *)cache.topics[topic_id];
+
+    if (write(topic, key.data(), key.size(), msg, msg_size)) {
+        sent_msgs++;
+        sent_bytes += msg_size;
+    } else {
+        SELF_DEBUG("rtr=%s: %s sink dropped message: topic=%s size=%lu", router_ip.c_str(), name,
+                   topic.c_str(), msg_size);
+        dropped++;
+    }
+
+    buffer_pool.release(buf);
+
+    time_t now = time(NULL);
+    if (now >= next_stats)
+        logStats(now);
+}
+
+/**
+ * Log the counters and message rate since the last log
+ */
+void LocalSink::logStats(time_t now) {
+    std::unique_lock<std::mutex> lock(stats_mutex, std::try_to_lock);
+
+    // Another thread is logging
+    if (not lock.owns_lock() or now < next_stats)
+        return;
+
+    uint64_t msgs = sent_msgs;
+    time_t elapsed = now > last_stats ? now - last_stats : 1;
+
+    LOG_INFO("%s sink: %lu msgs/sec, sent %lu messages/%lu bytes, dropped %lu messages", name,
+             (msgs - last_msgs) / elapsed, msgs, (uint64_t)sent_bytes, (uint64_t)dropped);
+
+    logSinkStats();
+
+    last_msgs = msgs;
+    last_stats = now;
+    next_stats = now + LOCAL_SINK_STATS_INTERVAL;
+}
+
+/*********************************************************************//**
+ * Lookup router group - See KafkaTopicSelector::lookupRouterGroup()
+ ***********************************************************************/
+void LocalSink::lookupRouterGroup(std::string hostname, std::string ip_addr, std::string &router_group_name) {
+    selector->lookupRouterGroup(hostname, ip_addr, router_group_name);
+}
+
+/*********************************************************************//**
+ * Lookup peer group - See KafkaTopicSelector::lookupPeerGroup()
+ ***********************************************************************/
+void LocalSink::lookupPeerGroup(std::string hostname, std::string ip_addr, uint32_t peer_asn,
+                                std::string &peer_group_name) {
+    selector->lookupPeerGroup(hostname, ip_addr, peer_asn, peer_group_name);
+}
+
+/**
+ * Write a message as a frame to fd, handling partial writes
+ *
+ * \param [in] fd           File or stream socket descriptor
+ * \param [in] is_socket    True if fd is a socket (SIGPIPE is suppressed)
+ * \param [in] topic        Topic name
+ * \param [in] key          Message key
+ * \param [in] key_len      Length of key
+ * \param [in] msg          Message (header and body)
+ * \param [in] msg_size     Length of msg
+ *
+ * \return number of bytes written or -1 on error (errno is set)
+ */
+ssize_t LocalSink::writeFrame(int fd, bool is_socket, const std::string &topic, const char *key, size_t key_len,
+                              const char *msg, size_t msg_size) {
+    frame_hdr hdr;
+    struct iovec iov[4];
+    int iovcnt = 4;
+    struct iovec *vec = iov;
+    size_t total;
+
+    hdr.magic       = htonl(LOCAL_SINK_FRAME_MAGIC);
+    hdr.topic_len   = htons((uint16_t)topic.size());
+    hdr.key_len     = htons((uint16_t)key_len);
+    hdr.msg_len     = htonl((uint32_t)msg_size);
+
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len  = sizeof(hdr);
+    iov[1].iov_base = (void *)topic.data();
+    iov[1].iov_len  = topic.size();
+    iov[2].iov_base = (void *)key;
+    iov[2].iov_len  = key_len;
+    iov[3].iov_base = (void *)msg;
+    iov[3].iov_len  = msg_size;
+
+    total = sizeof(hdr) + topic.size() + key_len + msg_size;
+
+    while (iovcnt > 0) {
+        ssize_t n;
+
+        if (is_socket) {
+            struct msghdr mh;
+
+            bzero(&mh, sizeof(mh));
+            mh.msg_iov = vec;
+            mh.msg_iovlen = iovcnt;
+
+            n = sendmsg(fd, &mh, MSG_NOSIGNAL);
+        } else
+            n = writev(fd, vec, iovcnt);
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+
+            return -1;
+        }
+
+        // Skip the fully written vectors and advance within the partially written one
+        while (iovcnt > 0 and (size_t)n >= vec->iov_len) {
+            n -= vec->iov_len;
+            vec++;
+            iovcnt--;
+        }
+
+        if (iovcnt > 0) {
+            vec->iov_base = (char *)vec->iov_base + n;
+            vec->iov_len -= n;
+        }
+    }
+
+    return total;
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef OPENBMP_LOCALSINK_H
+#define OPENBMP_LOCALSINK_H
+
+#include <string>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <ctime>
+#include <sys/uio.h>
+
+#include "MsgBusSink.h"
+#include "Logger.h"
+
+/**
+ * \class   LocalSink
+ *
+ * \brief   Base of the sinks that do not use Kafka (null, file and unix)
+ * \details Topic names are resolved the same way as for Kafka (router/peer group and peer ASN
+ *          variables are replaced), but no topic is created.  Sent and dropped message counters
+ *          are logged every LOCAL_SINK_STATS_INTERVAL seconds.
+ *
+ *          The file and unix sinks write each message as a frame:
+ *
+ *              frame_hdr       magic, topic, key and message lengths in network byte order
+ *              topic           topic name
+ *              key             message key (hash)
+ *              message         message (header and body) as produced to Kafka
+ */
+class LocalSink : public MsgBusSink {
+public:
+    #define LOCAL_SINK_STATS_INTERVAL   60          ///< Seconds between stats logs
+    #define LOCAL_SINK_FRAME_MAGIC      0x4f424d46  ///< "OBMF" - frame header magic
+
+    /**
+     * Frame header - fields are in network byte order
+     */
+    struct frame_hdr {
+        uint32_t        magic;                  ///< LOCAL_SINK_FRAME_MAGIC
+        uint16_t        topic_len;              ///< Length of the topic name
+        uint16_t        key_len;                ///< Length of the key
+        uint32_t        msg_len;                ///< Length of the message
+    } __attribute__ ((__packed__));
+
+    /*********************************************************************//**
+     * Constructor for class
+     *
+     * \param [in] logPtr   Pointer to Logger instance
+     * \param [in] cfg      Pointer to the config instance
+     * \param [in] name     Sink name for logging
+     ***********************************************************************/
+    LocalSink(Logger *logPtr, Config *cfg, const char *name);
+
+    virtual ~LocalSink();
+
+    /*********************************************************************//**
+     * Produce message - See MsgBusSink::produce()
+     *
+     * \details The topic handles in cache are the resolved topic names (std::string).
+     ***********************************************************************/
+    void produce(int topic_id, topic_cache &cache,
+                 const std::string *router_group, const std::string *peer_group,
+                 uint32_t peer_asn, const std::string &key,
+                 pool_buffer *buf, const char *msg, size_t msg_size,
+                 const std::string &router_ip);
+
+    void lookupRouterGroup(std::string hostname, std::string ip_addr, std::string &router_group_name);
+
+    void lookupPeerGroup(std::string hostname, std::string ip_addr, uint32_t peer_asn,
+                         std::string &peer_group_name);
+
+protected:
+    Config          *cfg;                       ///< Pointer to config instance
+    Logger          *logger;                    ///< Logging class pointer
+    bool            debug;                      ///< debug flag to indicate debugging
+    const char      *name;                      ///< Sink name for logging
+
+    /**
+     * Write a message
+     *
+     * \param [in] topic        Topic name
+     * \param [in] key          Message key
+     * \param [in] key_len      Length of key
+     * \param [in] msg          Message (header and body)
+     * \param [in] msg_size     Length of msg
+     *
+     * \return true if written, false if dropped
+     */
+    virtual bool write(const std::string &topic, const char *key, size_t key_len,
+                       const char *msg, size_t msg_size) = 0;
+
+    /**
+     * Write a message as a frame to fd, handling partial writes
+     *
+     * \param [in] fd           File or stream socket descriptor
+     * \param [in] is_socket    True if fd is a socket (SIGPIPE is suppressed)
+     * \param [in] topic        Topic name
+     * \param [in] key          Message key
+     * \param [in] key_len      Length of key
+     * \param [in] msg          Message (header and body)
+     * \param [in] msg_size     Length of msg
+     *
+     * \return number of bytes written or -1 on error (errno is set)
+     */
+    static ssize_t writeFrame(int fd, bool is_socket, const std::string &topic, const char *key, size_t key_len,
+                              const char *msg, size_t msg_size);
+
+    /**
+     * Log sink specific stats - called after the counters are logged
+     */
+    virtual void logSinkStats() { }
+
+private:
+    KafkaTopicSelector      *selector;          ///< Topic names and group lookups, no producer
+    std::mutex              names_mutex;        ///< Protects selector and names
+    std::set<std::string>   names;              ///< Resolved topic names, referenced by the topic caches
+
+    std::atomic<uint64_t>   sent_msgs;          ///< Messages written
+    std::atomic<uint64_t>   sent_bytes;         ///< Message bytes written
+    std::atomic<uint64_t>   dropped;            ///< Messages dropped
+    std::mutex              stats_mutex;        ///< Serializes logStats()
+    std::atomic<time_t>     next_stats;         ///< Time of the next stats log
+    time_t                  last_stats;         ///< Time of the last stats log
+    uint64_t                last_msgs;          ///< Messages at the last stats log
+
+    /**
+     * Log the counters and message rate since the last log
+     */
+    void logStats(time_t now);
+};
+
+#endif //OPENBMP_LOCALSINK_H
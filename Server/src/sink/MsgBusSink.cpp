@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include "MsgBusSink.h"
+
+/*********************************************************************//**
+ * Constructor for class
+ *
+ * \param [in] cfg      Pointer to the config instance
+ ***********************************************************************/
+MsgBusSink::MsgBusSink(Config *cfg) {
+
+    // Topics with an empty name are disabled
+    enabled_topics = 0;
+    for (int i=0; i < KafkaTopicSelector::MSGBUS_TOPIC_ID_MAX; i++) {
+        Config::topic_names_map_iter it = cfg->topic_names_map.find(KafkaTopicSelector::topic_vars[i]);
+
+        if (it != cfg->topic_names_map.end() and it->second.length() > 0)
+            enabled_topics |= 1U << i;
+    }
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef OPENBMP_MSGBUSSINK_H
+#define OPENBMP_MSGBUSSINK_H
+
+#include <string>
+#include <cstdint>
+
+#include "Config.h"
+#include "KafkaTopicSelector.h"
+#include "BufferPool.h"
+
+/**
+ * \class   MsgBusSink
+ *
+ * \brief   Destination of the messages encoded by the message bus (msgBus_kafka)
+ * \details A single instance is created by the server and shared by the collector and all
+ *          routers; all methods are thread safe.  The sink is selected by the sink type in
+ *          the configuration:
+ *
+ *              kafka   KafkaProducerService - produces to Kafka
+ *              null    NullSink - encodes and drops, to measure parse and encode throughput
+ *              file    FileSink - appends framed messages to a rotating file
+ *              unix    UnixSocketSink - streams framed messages to a local forwarder
+ *              shm     ShmRingSink - publishes to a shared memory ring for local consumers
+ */
+class MsgBusSink {
+public:
+    /**
+     * Sink types - Config::sink_type
+     */
+    enum sink_type {
+        SINK_KAFKA=0,
+        SINK_NULL,
+        SINK_FILE,
+        SINK_UNIX,
+        SINK_SHM
+    };
+
+    /**
+     * Resolved topic handles of a peer or router, indexed by KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+     *
+     * \details Handles are sink specific.  They are resolved on first use and remain valid
+     *          until the generation changes (for example when the Kafka producer reconnects).
+     *          Set generation to zero to drop the handles, for example when the router or peer
+     *          group changes.
+     */
+    struct topic_cache {
+        void            *topics[KafkaTopicSelector::MSGBUS_TOPIC_ID_MAX];
+        uint32_t        generation;             ///< Topic generation of the handles, zero if none
+
+        topic_cache() : generation(0) {}
+    };
+
+    /*********************************************************************//**
+     * Constructor for class
+     *
+     * \param [in] cfg      Pointer to the config instance
+     ***********************************************************************/
+    MsgBusSink(Config *cfg);
+
+    virtual ~MsgBusSink() {}
+
+    /*********************************************************************//**
+     * Produce message to the sink
+     *
+     * \details Ownership of buf is transferred; it is returned to the buffer pool once the
+     *      message is sent (or dropped).
+     *
+     * \param [in] topic_id      Topic to produce to, KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+     * \param [in/out] cache     Topic handles of the peer/router, updated if the handle is not resolved
+     * \param [in] router_group  Router group name - empty/NULL if not set or used
+     * \param [in] peer_group    Peer group name - empty/NULL if not set or used
+     * \param [in] peer_asn      Peer ASN
+     * \param [in] key           Hash key
+     * \param [in] buf           Pooled buffer containing the message (header and body)
+     * \param [in] msg           Start of the message within buf
+     * \param [in] msg_size      Length in bytes of the message
+     * \param [in] router_ip     Router IP address - used for logging
+     ***********************************************************************/
+    virtual void produce(int topic_id, topic_cache &cache,
+                         const std::string *router_group, const std::string *peer_group,
+                         uint32_t peer_asn, const std::string &key,
+                         pool_buffer *buf, const char *msg, size_t msg_size,
+                         const std::string &router_ip) = 0;
+
+    /*********************************************************************//**
+     * Lookup router group - See KafkaTopicSelector::lookupRouterGroup()
+     ***********************************************************************/
+    virtual void lookupRouterGroup(std::string hostname, std::string ip_addr, std::string &router_group_name) = 0;
+
+    /*********************************************************************//**
+     * Lookup peer group - See KafkaTopicSelector::lookupPeerGroup()
+     ***********************************************************************/
+    virtual void lookupPeerGroup(std::string hostname, std::string ip_addr, uint32_t peer_asn,
+                                 std::string &peer_group_name) = 0;
+
+    /*********************************************************************//**
+     * Get the pool that message buffers passed to produce() are acquired from
+     ***********************************************************************/
+    inline BufferPool *getBufferPool() {
+        return &buffer_pool;
+    }
+
+    /*********************************************************************//**
+     * Check if a topic is enabled
+     *
+     * \param [in]  topic_id        KafkaTopicSelector::MSGBUS_TOPIC_ID_*
+     *
+     * \return bool true if the topic is enabled, false otherwise
+     ***********************************************************************/
+    inline bool topicEnabled(int topic_id) const {
+        return (enabled_topics & (1U << topic_id)) != 0;
+    }
+
+protected:
+    BufferPool      buffer_pool;                ///< Message buffers, released by the sink once sent
+    uint32_t        enabled_topics;             ///< Bitmask of enabled topics by MSGBUS_TOPIC_ID_*
+};
+
+#endif //OPENBMP_MSGBUSSINK_H
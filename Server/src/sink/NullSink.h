@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef OPENBMP_NULLSINK_H
+#define OPENBMP_NULLSINK_H
+
+#include "LocalSink.h"
+
+/**
+ * \class   NullSink
+ *
+ * \brief   Sink that drops the encoded messages
+ * \details Used to measure the parse and encode throughput without a broker; the message
+ *          rate is logged periodically.
+ */
+class NullSink : public LocalSink {
+public:
+    /*********************************************************************//**
+     * Constructor for class
+     *
+     * \param [in] logPtr   Pointer to Logger instance
+     * \param [in] cfg      Pointer to the config instance
+     ***********************************************************************/
+    NullSink(Logger *logPtr, Config *cfg) : LocalSink(logPtr, cfg, "null") {}
+
+protected:
+    bool write(const std::string & /*topic*/, const char * /*key*/, size_t /*key_len*/,
+               const char * /*msg*/, size_t /*msg_size*/) {
+        return true;
+    }
+};
+
+#endif //OPENBMP_NULLSINK_H
@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef OPENBMP_SHMRING_H
+#define OPENBMP_SHMRING_H
+
+/*
+ * Shared memory message ring - layout and consumer
+ *
+ * This header has no dependencies on the rest of openbmp, so it can be copied into a
+ * consumer application.  Link with -lrt on older glibc (shm_open).
+ *
+ * The ring is a POSIX shared memory object (/dev/shm/<name>) written by a single producer,
+ * the openbmp shm sink.  Any number of consumers (up to SHM_RING_MAX_CONSUMERS) read it
+ * independently; each registers a slot holding its read cursor, so the producer can report
+ * the lag of each consumer.
+ *
+ * The producer never waits for consumers.  A consumer that falls more than the ring size
+ * behind is overrun; it skips to the newest messages and counts the lost messages from
+ * the gap in the message sequence numbers.
+ *
+ * Layout:
+ *      shm_ring_hdr        SHM_RING_HDR_SIZE bytes
+ *      data                data_size bytes (power of 2) of records
+ *
+ * Positions are byte offsets that only increase; the data offset is pos & (data_size - 1).
+ * Each record is an shm_ring_record followed by the topic name, key and message, padded to
+ * SHM_RING_ALIGN.  A record never wraps; the end of the data is filled by a pad record, or
+ * skipped if shorter than a record header.
+ *
+ * Writing a record (producer):
+ *      1. claim_pos is set to the end of the record (and pad), then the data is written
+ *      2. write_pos is set to claim_pos, then write_seq is incremented
+ *
+ * Reading a record (consumer):
+ *      1. A record is available if read_pos < write_pos
+ *      2. The record is copied out; it is valid only if claim_pos - read_pos <= data_size
+ *         after copying (it was not overwritten while being copied)
+ *      3. On overrun, write_seq is read before write_pos and the messages up to write_seq are
+ *         counted as lost; write_seq never runs ahead of write_pos, so the rest of the gap is
+ *         counted from the sequence number of the next record read
+ *
+ * Example:
+ *
+ *      ShmRingConsumer ring;
+ *      ShmRingConsumer::message msg;
+ *
+ *      if (ring.open("openbmp", "rib-analysis")) {
+ *          while (not ring.closed()) {
+ *              if (ring.next(msg))
+ *                  process(msg.topic, msg.key, msg.data);
+ *              else
+ *                  usleep(1000);
+ *          }
+ *      }
+ */
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SHM_RING_MAGIC              0x4f425247  ///< "OBRG" - ring header magic
+#define SHM_RING_VERSION            1           ///< Layout version
+#define SHM_RING_HDR_SIZE           4096        ///< Data starts after the header
+#define SHM_RING_MAX_CONSUMERS      16          ///< Consumer slots
+#define SHM_RING_ALIGN              8           ///< Record alignment
+#define SHM_RING_FLAG_PAD           0x1         ///< Pad record at the end of the data, no message
+
+#if ATOMIC_LLONG_LOCK_FREE != 2
+#error "shared memory ring requires lock free 64 bit atomics"
+#endif
+
+/**
+ * Consumer slot - written by the consumer, read by the producer for lag reporting
+ */
+struct shm_ring_consumer {
+    std::atomic<uint32_t>   state;              ///< 0 if free, 1 if in use
+    uint32_t                pid;                ///< Process ID of the consumer
+    char                    name[32];           ///< Consumer name, NUL terminated
+    std::atomic<uint64_t>   read_pos;           ///< Position of the next record to read
+    std::atomic<uint64_t>   read_seq;           ///< Sequence number of the next message expected
+    std::atomic<uint64_t>   lost;               ///< Messages lost because the consumer was overrun
+    std::atomic<uint64_t>   updated;            ///< Time (unix seconds) of the last read
+    char                    pad[56];
+};
+
+/**
+ * Ring header
+ */
+struct shm_ring_hdr {
+    uint32_t                magic;              ///< SHM_RING_MAGIC
+    uint32_t                version;            ///< SHM_RING_VERSION
+    uint64_t                data_size;          ///< Size of the data in bytes, power of 2
+    uint32_t                producer_pid;       ///< Process ID of the producer
+    std::atomic<uint32_t>   closed;             ///< Set when the producer stops - consumers should reopen
+    char                    pad1[40];
+
+    std::atomic<uint64_t>   claim_pos;          ///< End of the record being written
+    std::atomic<uint64_t>   write_pos;          ///< End of the last complete record
+    std::atomic<uint64_t>   write_seq;          ///< Sequence number of the next message
+    char                    pad2[40];
+
+    shm_ring_consumer       consumers[SHM_RING_MAX_CONSUMERS];
+};
+
+static_assert(sizeof(shm_ring_consumer) == 128, "unexpected shm_ring_consumer size");
+static_assert(sizeof(shm_ring_hdr) <= SHM_RING_HDR_SIZE, "shm_ring_hdr larger than SHM_RING_HDR_SIZE");
+
+/**
+ * Record header
+ */
+struct shm_ring_record {
+    uint32_t                length;             ///< Length of the record including header and padding
+    uint32_t                flags;              ///< SHM_RING_FLAG_*
+    uint64_t                seq;                ///< Message sequence number
+    uint16_t                topic_len;          ///< Length of the topic name
+    uint16_t                key_len;            ///< Length of the key
+    uint32_t                msg_len;            ///< Length of the message
+};
+
+/**
+ * \class   ShmRingConsumer
+ *
+ * \brief   Reads messages from a shared memory ring
+ * \details Not thread safe; use one instance per reading thread.
+ */
+class ShmRingConsumer {
+public:
+    /**
+     * Message copied out of the ring
+     */
+    struct message {
+        uint64_t        seq;                    ///< Message sequence number
+        std::string     topic;                  ///< Topic name
+        std::string     key;                    ///< Message key (hash)
+        std::string     data;                   ///< Message (header and body)
+    };
+
+    ShmRingConsumer() : hdr(NULL), map_size(0), slot(NULL), read_pos(0), read_seq(0), lost(0), synced(false) {}
+
+    ~ShmRingConsumer() {
+        close();
+    }
+
+    /**
+     * Open the ring and register a consumer slot - reading starts at the newest message
+     *
+     * \param [in] ring_name    Name of the ring (shm object name without the leading /)
+     * \param [in] name         Consumer name, reported by the producer
+     *
+     * \return true if opened, false on error (errno is set; ENOSPC if no free slot)
+     */
+    bool open(const std::string &ring_name, const std::string &name) {
+        std::string path = "/" + ring_name;
+        struct stat st;
+        int fd;
+
+        close();
+
+        if ((fd = shm_open(path.c_str(), O_RDWR, 0)) < 0)
+            return false;
+
+        if (fstat(fd, &st) != 0 or (size_t)st.st_size < SHM_RING_HDR_SIZE) {
+            ::close(fd);
+            errno = EINVAL;
+            return false;
+        }
+
+        void *base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if (base == MAP_FAILED)
+            return false;
+
+        hdr = (shm_ring_hdr *)base;
+        map_size = st.st_size;
+
+        if (hdr->magic != SHM_RING_MAGIC or hdr->version != SHM_RING_VERSION
+                or hdr->data_size + SHM_RING_HDR_SIZE > map_size) {
+            close();
+            errno = EINVAL;
+            return false;
+        }
+
+        data = (const char *)base + SHM_RING_HDR_SIZE;
+
+        // Take a free slot, or the slot of a consumer that no longer exists
+        for (int i=0; i < SHM_RING_MAX_CONSUMERS and slot == NULL; i++) {
+            shm_ring_consumer &c = hdr->consumers[i];
+            uint32_t state = c.state.load();
+
+            if (state == 1 and kill(c.pid, 0) != 0 and errno == ESRCH)
+                c.state.compare_exchange_strong(state, 0);
+
+            state = 0;
+            if (c.state.compare_exchange_strong(state, 1))
+                slot = &c;
+        }
+
+        if (slot == NULL) {
+            close();
+            errno = ENOSPC;
+            return false;
+        }
+
+        slot->pid = getpid();
+        strncpy(slot->name, name.c_str(), sizeof(slot->name) - 1);
+        slot->name[sizeof(slot->name) - 1] = 0;
+        slot->lost = 0;
+
+        // The sequence number is taken from the first record read
+        read_seq = hdr->write_seq.load(std::memory_order_acquire);
+        read_pos = hdr->write_pos.load(std::memory_order_acquire);
+        lost = 0;
+        synced = false;
+        publish();
+
+        return true;
+    }
+
+    /**
+     * Release the consumer slot and unmap the ring
+     */
+    void close() {
+        if (slot != NULL)
+            slot->state.store(0);
+
+        if (hdr != NULL)
+            munmap((void *)hdr, map_size);
+
+        hdr = NULL;
+        slot = NULL;
+    }
+
+    /**
+     * Check if the producer stopped (or the ring is not open) - the ring should be reopened
+     */
+    bool closed() const {
+        return hdr == NULL or hdr->closed.load(std::memory_order_acquire) != 0;
+    }
+
+    /**
+     * Get the next message
+     *
+     * \param [out] msg     Message, copied out of the ring
+     *
+     * \return true if a message was returned, false if no message is available
+     */
+    bool next(message &msg) {
+        if (hdr == NULL)
+            return false;
+
+        const uint64_t size = hdr->data_size;
+
+        while (true) {
+            uint64_t wpos = hdr->write_pos.load(std::memory_order_acquire);
+            shm_ring_record rec;
+
+            if (read_pos == wpos)
+                return false;
+
+            // Overrun - skip to the newest record
+            if (wpos - read_pos > size) {
+                skip();
+                continue;
+            }
+
+            uint64_t off = read_pos & (size - 1);
+
+            // End of the data too short for a pad record
+            if (size - off < sizeof(rec)) {
+                read_pos += size - off;
+                continue;
+            }
+
+            memcpy(&rec, data + off, sizeof(rec));
+
+            bool valid = rec.length >= sizeof(rec) and rec.length % SHM_RING_ALIGN == 0
+                         and off + rec.length <= size
+                         and (rec.flags & SHM_RING_FLAG_PAD
+                              or sizeof(rec) + rec.topic_len + rec.key_len + rec.msg_len <= rec.length);
+
+            if (valid and not (rec.flags & SHM_RING_FLAG_PAD)) {
+                const char *p = data + off + sizeof(rec);
+
+                msg.seq = rec.seq;
+                msg.topic.assign(p, rec.topic_len);
+                msg.key.assign(p + rec.topic_len, rec.key_len);
+                msg.data.assign(p + rec.topic_len + rec.key_len, rec.msg_len);
+            }
+
+            // The copy is only valid if the record was not overwritten meanwhile
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (hdr->claim_pos.load(std::memory_order_relaxed) - read_pos > size or not valid) {
+                skip();
+                continue;
+            }
+
+            read_pos += rec.length;
+
+            if (rec.flags & SHM_RING_FLAG_PAD)
+                continue;
+
+            if (synced and rec.seq > read_seq)
+                lost += rec.seq - read_seq;
+
+            synced = true;
+
+            read_seq = rec.seq + 1;
+            publish();
+
+            return true;
+        }
+    }
+
+    /**
+     * Get the number of messages written but not yet read
+     */
+    uint64_t lag() const {
+        return hdr != NULL ? hdr->write_seq.load(std::memory_order_relaxed) - read_seq : 0;
+    }
+
+    /**
+     * Get the number of messages lost because the consumer was overrun
+     */
+    uint64_t getLost() const {
+        return lost;
+    }
+
+private:
+    shm_ring_hdr        *hdr;                   ///< Mapping of the ring, NULL if not open
+    size_t              map_size;               ///< Size of the mapping
+    const char          *data;                  ///< Record data
+    shm_ring_consumer   *slot;                  ///< Consumer slot
+    uint64_t            read_pos;               ///< Position of the next record to read
+    uint64_t            read_seq;               ///< Sequence number of the next message expected
+    uint64_t            lost;                   ///< Messages lost by overruns
+    bool                synced;                 ///< read_seq is the sequence number at read_pos
+
+    /**
+     * Skip to the newest record after an overrun and count the messages skipped
+     */
+    void skip() {
+        uint64_t seq = hdr->write_seq.load(std::memory_order_acquire);
+
+        if (synced and seq > read_seq) {
+            lost += seq - read_seq;
+            read_seq = seq;
+        }
+
+        read_pos = hdr->write_pos.load(std::memory_order_acquire);
+        publish();
+    }
+
+    /**
+     * Update the consumer slot for the producer lag reporting
+     */
+    void publish() {
+        slot->read_pos.store(read_pos, std::memory_order_relaxed);
+        slot->read_seq.store(read_seq, std::memory_order_relaxed);
+        slot->lost.store(lost, std::memory_order_relaxed);
+        slot->updated.store(time(NULL), std::memory_order_relaxed);
+    }
+};
+
+#endif //OPENBMP_SHMRING_H
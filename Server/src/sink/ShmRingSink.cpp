@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "ShmRingSink.h"
+
+/*********************************************************************//**
+ * Constructor for class - creates the ring
+ *
+ * \param [in] logPtr   Pointer to Logger instance
+ * \param [in] cfg      Pointer to the config instance
+ *
+ * \throws char const* if the ring cannot be created
+ ***********************************************************************/
+ShmRingSink::ShmRingSink(Logger *logPtr, Config *cfg) : LocalSink(logPtr, cfg, "shm") {
+    int fd;
+
+    path = "/" + cfg->sink_shm_name;
+    write_pos = 0;
+    write_seq = 0;
+
+    // Largest power of 2 not above the configured size, so the data offset is a mask
+    data_size = 1;
+    while ((data_size << 1) <= ((uint64_t)cfg->sink_shm_mbytes << 20))
+        data_size <<= 1;
+
+    map_size = SHM_RING_HDR_SIZE + data_size;
+
+    // Consumers of a previous ring keep their mapping until they reopen
+    shm_unlink(path.c_str());
+
+    if ((fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644)) < 0) {
+        LOG_ERR("Failed to create shared memory ring %s: %s", path.c_str(), strerror(errno));
+        throw "ERROR: Failed to create the shared memory ring";
+    }
+
+    if (ftruncate(fd, map_size) != 0) {
+        LOG_ERR("Failed to size shared memory ring %s to %lu bytes: %s", path.c_str(), map_size, strerror(errno));
+        close(fd);
+        shm_unlink(path.c_str());
+        throw "ERROR: Failed to create the shared memory ring";
+    }
+
+    void *base = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED) {
+        LOG_ERR("Failed to map shared memory ring %s: %s", path.c_str(), strerror(errno));
+        shm_unlink(path.c_str());
+        throw "ERROR: Failed to create the shared memory ring";
+    }
+
+    // The new object is zero filled, which is the initial state of the positions and slots
+    hdr = (shm_ring_hdr *)base;
+    data = (char *)base + SHM_RING_HDR_SIZE;
+
+    hdr->version = SHM_RING_VERSION;
+    hdr->data_size = data_size;
+    hdr->producer_pid = getpid();
+
+    // Consumers check the magic last
+    std::atomic_thread_fence(std::memory_order_release);
+    hdr->magic = SHM_RING_MAGIC;
+
+    LOG_INFO("Publishing messages to shared memory ring /dev/shm%s (%lu MB)", path.c_str(), data_size >> 20);
+}
+
+/*********************************************************************//**
+ * Destructor for class - marks the ring closed and removes it
+ ***********************************************************************/
+ShmRingSink::~ShmRingSink() {
+    hdr->closed.store(1, std::memory_order_release);
+
+    munmap(hdr, map_size);
+    shm_unlink(path.c_str());
+}
+
+bool ShmRingSink::write(const std::string &topic, const char *key, size_t key_len,
+                        const char *msg, size_t msg_size) {
+    shm_ring_record rec;
+    size_t len = (sizeof(rec) + topic.size() + key_len + msg_size + SHM_RING_ALIGN - 1)
+                 & ~(size_t)(SHM_RING_ALIGN - 1);
+
+    // A record larger than half the ring could never be read before being overwritten
+    if (len > data_size / 2)
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint64_t off = write_pos & (data_size - 1);
+    uint64_t pad = off + len > data_size ? data_size - off : 0;
+
+    // Claim the space before overwriting it, so readers of the old records detect the overwrite
+    hdr->claim_pos.store(write_pos + pad + len, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (pad > 0) {
+        if (pad >= sizeof(rec)) {
+            bzero(&rec, sizeof(rec));
+            rec.length = pad;
+            rec.flags = SHM_RING_FLAG_PAD;
+            memcpy(data + off, &rec, sizeof(rec));
+        }
+
+        write_pos += pad;
+        off = 0;
+    }
+
+    rec.length      = len;
+    rec.flags       = 0;
+    rec.seq         = write_seq;
+    rec.topic_len   = topic.size();
+    rec.key_len     = key_len;
+    rec.msg_len     = msg_size;
+
+    char *p = data + off;
+    memcpy(p, &rec, sizeof(rec));
+    p += sizeof(rec);
+    memcpy(p, topic.data(), topic.size());
+    p += topic.size();
+    memcpy(p, key, key_len);
+    p += key_len;
+    memcpy(p, msg, msg_size);
+
+    write_pos += len;
+    write_seq++;
+
+    // write_seq after write_pos, so a consumer reading write_seq first never skips past it
+    hdr->write_pos.store(write_pos, std::memory_order_release);
+    hdr->write_seq.store(write_seq, std::memory_order_release);
+
+    return true;
+}
+
+void ShmRingSink::logSinkStats() {
+    uint64_t seq = hdr->write_seq.load(std::memory_order_relaxed);
+    uint64_t pos = hdr->write_pos.load(std::memory_order_relaxed);
+    time_t now = time(NULL);
+
+    for (int i=0; i < SHM_RING_MAX_CONSUMERS; i++) {
+        shm_ring_consumer &c = hdr->consumers[i];
+
+        if (c.state.load() != 1)
+            continue;
+
+        char name[sizeof(c.name) + 1];
+        memcpy(name, c.name, sizeof(c.name));
+        name[sizeof(c.name)] = 0;
+
+        uint64_t read_seq = c.read_seq.load(std::memory_order_relaxed);
+        uint64_t read_pos = c.read_pos.load(std::memory_order_relaxed);
+
+        LOG_INFO("shm ring consumer %s (pid %u): lag=%lu msgs/%lu bytes lost=%lu idle=%ld sec", name, c.pid,
+                 seq > read_seq ? seq - read_seq : 0, pos > read_pos ? pos - read_pos : 0,
+                 c.lost.load(std::memory_order_relaxed), (long)(now - c.updated.load(std::memory_order_relaxed)));
+    }
+}
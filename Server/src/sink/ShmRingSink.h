@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef OPENBMP_SHMRINGSINK_H
+#define OPENBMP_SHMRINGSINK_H
+
+#include <string>
+#include <mutex>
+
+#include "LocalSink.h"
+#include "ShmRing.h"
+
+/**
+ * \class   ShmRingSink
+ *
+ * \brief   Sink that publishes the messages to a shared memory ring for co-located consumers
+ * \details See ShmRing.h for the ring layout and the consumer (ShmRingConsumer).  The sink
+ *          never waits for consumers; a consumer that falls behind by more than the ring size
+ *          loses messages.  The lag and lost messages of each consumer are logged periodically.
+ *
+ *          The ring is recreated when the sink starts and removed when it stops.
+ */
+class ShmRingSink : public LocalSink {
+public:
+    /*********************************************************************//**
+     * Constructor for class - creates the ring
+     *
+     * \param [in] logPtr   Pointer to Logger instance
+     * \param [in] cfg      Pointer to the config instance
+     *
+     * \throws char const* if the ring cannot be created
+     ***********************************************************************/
+    ShmRingSink(Logger *logPtr, Config *cfg);
+
+    /*********************************************************************//**
+     * Destructor for class - marks the ring closed and removes it
+     ***********************************************************************/
+    ~ShmRingSink();
+
+protected:
+    bool write(const std::string &topic, const char *key, size_t key_len,
+               const char *msg, size_t msg_size);
+
+    void logSinkStats();
+
+private:
+    std::string     path;                       ///< Shared memory object name (/<name>)
+    shm_ring_hdr    *hdr;                       ///< Mapping of the ring
+    size_t          map_size;                   ///< Size of the mapping
+    char            *data;                      ///< Record data
+    uint64_t        data_size;                  ///< Size of the data, power of 2
+
+    std::mutex      mutex;                      ///< Serializes writers
+    uint64_t        write_pos;                  ///< Position of the next record
+    uint64_t        write_seq;                  ///< Sequence number of the next message
+};
+
+#endif //OPENBMP_SHMRINGSINK_H
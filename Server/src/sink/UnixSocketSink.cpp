@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "UnixSocketSink.h"
+
+/*********************************************************************//**
+ * Constructor for class - connects to the socket (retried on first write if it fails)
+ *
+ * \param [in] logPtr   Pointer to Logger instance
+ * \param [in] cfg      Pointer to the config instance
+ ***********************************************************************/
+UnixSocketSink::UnixSocketSink(Logger *logPtr, Config *cfg) : LocalSink(logPtr, cfg, "unix") {
+    path = cfg->sink_unix_path;
+    sock = -1;
+    run = true;
+
+    if (path.size() >= sizeof(((struct sockaddr_un *)0)->sun_path))
+        throw "ERROR: Sink unix socket path is too long";
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (connectSocket(true))
+        LOG_INFO("Connected to sink socket %s", path.c_str());
+}
+
+/*********************************************************************//**
+ * Destructor for class - writers blocked on a reconnect drop their message
+ ***********************************************************************/
+UnixSocketSink::~UnixSocketSink() {
+    run = false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (sock >= 0)
+        close(sock);
+}
+
+/**
+ * Connect to the socket - mutex must be held
+ *
+ * \param [in] log_err      Log the error if the connect fails
+ *
+ * \return true if connected, false on error
+ */
+bool UnixSocketSink::connectSocket(bool log_err) {
+    struct sockaddr_un addr;
+
+    if ((sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+        LOG_ERR("Failed to create sink socket: %s", strerror(errno));
+        return false;
+    }
+
+    bzero(&addr, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        if (log_err)
+            LOG_WARN("Failed to connect to sink socket %s, will retry: %s", path.c_str(), strerror(errno));
+
+        close(sock);
+        sock = -1;
+        return false;
+    }
+
+    return true;
+}
+
+bool UnixSocketSink::write(const std::string &topic, const char *key, size_t key_len,
+                           const char *msg, size_t msg_size) {
+    std::unique_lock<std::mutex> lock(mutex);
+    bool logged = false;
+
+    while (true) {
+        if (sock >= 0) {
+            if (writeFrame(sock, true, topic, key, key_len, msg, msg_size) >= 0)
+                return true;
+
+            /*
+             * The forwarder may have received part of the frame; it discards the partial
+             *      frame on disconnect and the whole frame is resent on the new connection.
+             */
+            LOG_WARN("Failed to write to sink socket %s, reconnecting: %s", path.c_str(), strerror(errno));
+            close(sock);
+            sock = -1;
+            logged = true;
+        }
+
+        if (not run)
+            return false;
+
+        if (connectSocket(not logged)) {
+            LOG_INFO("Connected to sink socket %s", path.c_str());
+            continue;
+        }
+
+        logged = true;
+
+        // Backpressure - other writers wait on the mutex until reconnected
+        lock.unlock();
+        sleep(1);
+        lock.lock();
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef OPENBMP_UNIXSOCKETSINK_H
+#define OPENBMP_UNIXSOCKETSINK_H
+
+#include <string>
+#include <mutex>
+
+#include "LocalSink.h"
+
+/**
+ * \class   UnixSocketSink
+ *
+ * \brief   Sink that streams the messages as frames (see LocalSink) to a UNIX domain socket
+ * \details The sink connects to a local forwarder listening on a SOCK_STREAM socket.  While
+ *          the forwarder is not available, produce() blocks (backpressure) and reconnects every
+ *          second, the same as a full Kafka producer queue.  A frame is never split across
+ *          connections; a frame that failed to be written is resent after reconnecting.
+ */
+class UnixSocketSink : public LocalSink {
+public:
+    /*********************************************************************//**
+     * Constructor for class - connects to the socket (retried on first write if it fails)
+     *
+     * \param [in] logPtr   Pointer to Logger instance
+     * \param [in] cfg      Pointer to the config instance
+     ***********************************************************************/
+    UnixSocketSink(Logger *logPtr, Config *cfg);
+
+    /*********************************************************************//**
+     * Destructor for class - writers blocked on a reconnect drop their message
+     ***********************************************************************/
+    ~UnixSocketSink();
+
+protected:
+    bool write(const std::string &topic, const char *key, size_t key_len,
+               const char *msg, size_t msg_size);
+
+private:
+    std::string     path;                       ///< Socket path
+
+    std::mutex      mutex;                      ///< Serializes writes and reconnects
+    int             sock;                       ///< Socket, -1 if not connected
+    bool            run;                        ///< False when stopping, writers do not wait to reconnect
+
+    /**
+     * Connect to the socket - mutex must be held
+     *
+     * \param [in] log_err      Log the error if the connect fails
+     *
+     * \return true if connected, false on error
+     */
+    bool connectSocket(bool log_err);
+};
+
+#endif //OPENBMP_UNIXSOCKETSINK_H
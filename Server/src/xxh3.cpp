@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ * XXH3 algorithm by Yann Collet (xxHash, BSD 2-Clause License).
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "xxh3.h"
+
+#define XXH_PRIME32_1   0x9E3779B1U
+#define XXH_PRIME32_2   0x85EBCA77U
+#define XXH_PRIME32_3   0xC2B2AE3DU
+
+#define XXH_PRIME64_1   0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2   0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3   0x165667B19E3779F9ULL
+#define XXH_PRIME64_4   0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5   0x27D4EB2F165667C5ULL
+
+#define XXH_PRIME_MX1   0x165667919E3779F9ULL
+#define XXH_PRIME_MX2   0x9FB21C651E98DF25ULL
+
+#define XXH_SECRET_SIZE             192
+#define XXH_STRIPE_LEN              64
+#define XXH_SECRET_CONSUME_RATE     8
+#define XXH_MIDSIZE_MAX             240
+#define XXH_MIDSIZE_STARTOFFSET     3
+#define XXH_MIDSIZE_LASTOFFSET      17
+#define XXH_SECRET_SIZE_MIN         136
+#define XXH_SECRET_LASTACC_START    7
+#define XXH_SECRET_MERGEACCS_START  11
+
+/**
+ * 128 bit value
+ */
+struct xxh_u128 {
+    uint64_t    low64;
+    uint64_t    high64;
+};
+
+/**
+ * Default secret
+ */
+static const unsigned char xxh_secret[XXH_SECRET_SIZE] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e };
+
+static inline uint32_t read32(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t read64(const unsigned char *p) {
+    return (uint64_t)read32(p) | ((uint64_t)read32(p + 4) << 32);
+}
+
+static inline uint32_t swap32(uint32_t x) {
+    return __builtin_bswap32(x);
+}
+
+static inline uint64_t swap64(uint64_t x) {
+    return __builtin_bswap64(x);
+}
+
+static inline uint32_t rotl32(uint32_t x, int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+static inline uint64_t xorshift64(uint64_t v, int shift) {
+    return v ^ (v >> shift);
+}
+
+static inline xxh_u128 mult64to128(uint64_t lhs, uint64_t rhs) {
+    unsigned __int128 product = (unsigned __int128)lhs * rhs;
+    xxh_u128 r128;
+
+    r128.low64 = (uint64_t)product;
+    r128.high64 = (uint64_t)(product >> 64);
+    return r128;
+}
+
+static inline uint64_t mul128_fold64(uint64_t lhs, uint64_t rhs) {
+    xxh_u128 product = mult64to128(lhs, rhs);
+    return product.low64 ^ product.high64;
+}
+
+static inline uint64_t xxh64_avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+static inline uint64_t xxh3_avalanche(uint64_t h) {
+    h = xorshift64(h, 37);
+    h *= XXH_PRIME_MX1;
+    h = xorshift64(h, 32);
+    return h;
+}
+
+static inline uint64_t mix16B(const unsigned char *input, const unsigned char *secret, uint64_t seed) {
+    uint64_t input_lo = read64(input);
+    uint64_t input_hi = read64(input + 8);
+
+    return mul128_fold64(input_lo ^ (read64(secret) + seed),
+                         input_hi ^ (read64(secret + 8) - seed));
+}
+
+static inline xxh_u128 mix32B(xxh_u128 acc, const unsigned char *input_1, const unsigned char *input_2,
+                              const unsigned char *secret, uint64_t seed) {
+    acc.low64  += mix16B(input_1, secret, seed);
+    acc.low64  ^= read64(input_2) + read64(input_2 + 8);
+    acc.high64 += mix16B(input_2, secret + 16, seed);
+    acc.high64 ^= read64(input_1) + read64(input_1 + 8);
+    return acc;
+}
+
+static xxh_u128 len_0(const unsigned char *secret, uint64_t seed) {
+    xxh_u128 h128;
+
+    h128.low64 = xxh64_avalanche(seed ^ (read64(secret + 64) ^ read64(secret + 72)));
+    h128.high64 = xxh64_avalanche(seed ^ (read64(secret + 80) ^ read64(secret + 88)));
+    return h128;
+}
+
+static xxh_u128 len_1to3(const unsigned char *input, size_t len, const unsigned char *secret, uint64_t seed) {
+    uint8_t c1 = input[0];
+    uint8_t c2 = input[len >> 1];
+    uint8_t c3 = input[len - 1];
+
+    uint32_t combinedl = ((uint32_t)c1 << 16) | ((uint32_t)c2 << 24) | ((uint32_t)c3 << 0) | ((uint32_t)len << 8);
+    uint32_t combinedh = rotl32(swap32(combinedl), 13);
+
+    uint64_t bitflipl = (read32(secret) ^ read32(secret + 4)) + seed;
+    uint64_t bitfliph = (read32(secret + 8) ^ read32(secret + 12)) - seed;
+
+    xxh_u128 h128;
+    h128.low64 = xxh64_avalanche((uint64_t)combinedl ^ bitflipl);
+    h128.high64 = xxh64_avalanche((uint64_t)combinedh ^ bitfliph);
+    return h128;
+}
+
+static xxh_u128 len_4to8(const unsigned char *input, size_t len, const unsigned char *secret, uint64_t seed) {
+    seed ^= (uint64_t)swap32((uint32_t)seed) << 32;
+
+    uint32_t input_lo = read32(input);
+    uint32_t input_hi = read32(input + len - 4);
+    uint64_t input_64 = input_lo + ((uint64_t)input_hi << 32);
+    uint64_t bitflip = (read64(secret + 16) ^ read64(secret + 24)) + seed;
+    uint64_t keyed = input_64 ^ bitflip;
+
+    xxh_u128 m128 = mult64to128(keyed, XXH_PRIME64_1 + (len << 2));
+
+    m128.high64 += (m128.low64 << 1);
+    m128.low64  ^= (m128.high64 >> 3);
+
+    m128.low64 = xorshift64(m128.low64, 35);
+    m128.low64 *= XXH_PRIME_MX2;
+    m128.low64 = xorshift64(m128.low64, 28);
+    m128.high64 = xxh3_avalanche(m128.high64);
+    return m128;
+}
+
+static xxh_u128 len_9to16(const unsigned char *input, size_t len, const unsigned char *secret, uint64_t seed) {
+    uint64_t bitflipl = (read64(secret + 32) ^ read64(secret + 40)) - seed;
+    uint64_t bitfliph = (read64(secret + 48) ^ read64(secret + 56)) + seed;
+    uint64_t input_lo = read64(input);
+    uint64_t input_hi = read64(input + len - 8);
+
+    xxh_u128 m128 = mult64to128(input_lo ^ input_hi ^ bitflipl, XXH_PRIME64_1);
+
+    m128.low64 += (uint64_t)(len - 1) << 54;
+    input_hi   ^= bitfliph;
+    m128.high64 += input_hi + (uint64_t)(uint32_t)input_hi * (XXH_PRIME32_2 - 1);
+    m128.low64  ^= swap64(m128.high64);
+
+    xxh_u128 h128 = mult64to128(m128.low64, XXH_PRIME64_2);
+    h128.high64 += m128.high64 * XXH_PRIME64_2;
+
+    h128.low64  = xxh3_avalanche(h128.low64);
+    h128.high64 = xxh3_avalanche(h128.high64);
+    return h128;
+}
+
+static xxh_u128 len_17to128(const unsigned char *input, size_t len, const unsigned char *secret, uint64_t seed) {
+    xxh_u128 acc;
+    acc.low64 = len * XXH_PRIME64_1;
+    acc.high64 = 0;
+
+    if (len > 32) {
+        if (len > 64) {
+            if (len > 96)
+                acc = mix32B(acc, input + 48, input + len - 64, secret + 96, seed);
+            acc = mix32B(acc, input + 32, input + len - 48, secret + 64, seed);
+        }
+        acc = mix32B(acc, input + 16, input + len - 32, secret + 32, seed);
+    }
+    acc = mix32B(acc, input, input + len - 16, secret, seed);
+
+    xxh_u128 h128;
+    h128.low64  = acc.low64 + acc.high64;
+    h128.high64 = (acc.low64 * XXH_PRIME64_1) + (acc.high64 * XXH_PRIME64_4) + ((len - seed) * XXH_PRIME64_2);
+    h128.low64  = xxh3_avalanche(h128.low64);
+    h128.high64 = (uint64_t)0 - xxh3_avalanche(h128.high64);
+    return h128;
+}
+
+static xxh_u128 len_129to240(const unsigned char *input, size_t len, const unsigned char *secret, uint64_t seed) {
+    int nbRounds = (int)len / 32;
+    xxh_u128 acc;
+
+    acc.low64 = len * XXH_PRIME64_1;
+    acc.high64 = 0;
+
+    for (int i = 0; i < 4; i++)
+        acc = mix32B(acc, input + (32 * i), input + (32 * i) + 16, secret + (32 * i), seed);
+
+    acc.low64 = xxh3_avalanche(acc.low64);
+    acc.high64 = xxh3_avalanche(acc.high64);
+
+    for (int i = 4; i < nbRounds; i++)
+        acc = mix32B(acc, input + (32 * i), input + (32 * i) + 16,
+                     secret + XXH_MIDSIZE_STARTOFFSET + (32 * (i - 4)), seed);
+
+    // last bytes
+    acc = mix32B(acc, input + len - 16, input + len - 32,
+                 secret + XXH_SECRET_SIZE_MIN - XXH_MIDSIZE_LASTOFFSET - 16, (uint64_t)0 - seed);
+
+    xxh_u128 h128;
+    h128.low64  = acc.low64 + acc.high64;
+    h128.high64 = (acc.low64 * XXH_PRIME64_1) + (acc.high64 * XXH_PRIME64_4) + ((len - seed) * XXH_PRIME64_2);
+    h128.low64  = xxh3_avalanche(h128.low64);
+    h128.high64 = (uint64_t)0 - xxh3_avalanche(h128.high64);
+    return h128;
+}
+
+static inline void accumulate_512(uint64_t *acc, const unsigned char *input, const unsigned char *secret) {
+    for (int i = 0; i < 8; i++) {
+        uint64_t data_val = read64(input + 8 * i);
+        uint64_t data_key = data_val ^ read64(secret + 8 * i);
+
+        acc[i ^ 1] += data_val;
+        acc[i] += (uint64_t)(uint32_t)data_key * (data_key >> 32);
+    }
+}
+
+static inline void scramble(uint64_t *acc, const unsigned char *secret) {
+    for (int i = 0; i < 8; i++) {
+        uint64_t acc64 = acc[i];
+
+        acc64 = xorshift64(acc64, 47);
+        acc64 ^= read64(secret + 8 * i);
+        acc64 *= XXH_PRIME32_1;
+        acc[i] = acc64;
+    }
+}
+
+static inline void accumulate(uint64_t *acc, const unsigned char *input, const unsigned char *secret,
+                              size_t nbStripes) {
+    for (size_t n = 0; n < nbStripes; n++)
+        accumulate_512(acc, input + n * XXH_STRIPE_LEN, secret + n * XXH_SECRET_CONSUME_RATE);
+}
+
+static uint64_t mergeAccs(const uint64_t *acc, const unsigned char *secret, uint64_t start) {
+    uint64_t result64 = start;
+
+    for (int i = 0; i < 4; i++)
+        result64 += mul128_fold64(acc[2 * i] ^ read64(secret + 16 * i),
+                                  acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+
+    return xxh3_avalanche(result64);
+}
+
+static xxh_u128 hashLong(const unsigned char *input, size_t len, const unsigned char *secret) {
+    uint64_t acc[8] = { XXH_PRIME32_3, XXH_PRIME64_1, XXH_PRIME64_2, XXH_PRIME64_3,
+                        XXH_PRIME64_4, XXH_PRIME32_2, XXH_PRIME64_5, XXH_PRIME32_1 };
+
+    size_t nbStripesPerBlock = (XXH_SECRET_SIZE - XXH_STRIPE_LEN) / XXH_SECRET_CONSUME_RATE;
+    size_t block_len = XXH_STRIPE_LEN * nbStripesPerBlock;
+    size_t nb_blocks = (len - 1) / block_len;
+
+    for (size_t n = 0; n < nb_blocks; n++) {
+        accumulate(acc, input + n * block_len, secret, nbStripesPerBlock);
+        scramble(acc, secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN);
+    }
+
+    // last partial block
+    size_t nbStripes = ((len - 1) - (block_len * nb_blocks)) / XXH_STRIPE_LEN;
+    accumulate(acc, input + nb_blocks * block_len, secret, nbStripes);
+
+    // last stripe
+    accumulate_512(acc, input + len - XXH_STRIPE_LEN,
+                   secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN - XXH_SECRET_LASTACC_START);
+
+    xxh_u128 h128;
+    h128.low64 = mergeAccs(acc, secret + XXH_SECRET_MERGEACCS_START, (uint64_t)len * XXH_PRIME64_1);
+    h128.high64 = mergeAccs(acc, secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN - XXH_SECRET_MERGEACCS_START,
+                            ~((uint64_t)len * XXH_PRIME64_2));
+    return h128;
+}
+
+/**
+ * Compute the XXH3 128 bit hash (seed 0, default secret)
+ *
+ * \param [in]  input        Data to hash
+ * \param [in]  len          Length of the data in bytes
+ * \param [out] digest       16 byte digest buffer
+ */
+void xxh3_128(const unsigned char *input, size_t len, unsigned char *digest) {
+    xxh_u128 h128;
+
+    if (len == 0)
+        h128 = len_0(xxh_secret, 0);
+    else if (len <= 3)
+        h128 = len_1to3(input, len, xxh_secret, 0);
+    else if (len <= 8)
+        h128 = len_4to8(input, len, xxh_secret, 0);
+    else if (len <= 16)
+        h128 = len_9to16(input, len, xxh_secret, 0);
+    else if (len <= 128)
+        h128 = len_17to128(input, len, xxh_secret, 0);
+    else if (len <= XXH_MIDSIZE_MAX)
+        h128 = len_129to240(input, len, xxh_secret, 0);
+    else
+        h128 = hashLong(input, len, xxh_secret);
+
+    // Canonical form - high 64 bits first, big endian
+    for (int i = 0; i < 8; i++) {
+        digest[i] = (unsigned char)(h128.high64 >> (56 - 8 * i));
+        digest[8 + i] = (unsigned char)(h128.low64 >> (56 - 8 * i));
+    }
+}
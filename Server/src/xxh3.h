@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2013-2016 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ *
+ */
+
+#ifndef XXH3_H_
+#define XXH3_H_
+
+#include <cstddef>
+
+/**
+ * Compute the XXH3 128 bit hash (seed 0, default secret)
+ *
+ * \details The result is compatible with XXH3_128bits() of the xxHash library.  The
+ *          digest is in canonical (big endian) form, the same as XXH128_canonicalFromHash(),
+ *          so the printed hash matches the xxhsum output.
+ *
+ * \param [in]  input        Data to hash
+ * \param [in]  len          Length of the data in bytes
+ * \param [out] digest       16 byte digest buffer
+ */
+void xxh3_128(const unsigned char *input, size_t len, unsigned char *digest);
+
+#endif /* XXH3_H_ */